@@ -53,8 +53,8 @@ void Viewer3D_Panel::Draw(
     auto& transforms        = QueueTransformUpdateTask(dispatcher);
     auto& cameras           = CameraComponent::GetComponent().QueueCameraUpdate(dispatcher);
     auto& cameraConstants   = MakeHeapCopy(Camera::ConstantBuffer{}, core.GetTempMemory());
-    auto& PVS               = GatherScene(dispatcher, scene, camera, core.GetTempMemory());
-    auto& Skinned           = GatherSkinned(dispatcher, scene, camera, core.GetTempMemory());
+    auto& PVS               = GatherScene(dispatcher, scene, camera);
+    auto& Skinned           = GatherSkinned(dispatcher, scene, camera);
 
     PVS.AddInput(cameras);
     PVS.AddInput(transforms);
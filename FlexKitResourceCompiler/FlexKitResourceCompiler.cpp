@@ -22,6 +22,7 @@
 #include "..\coreutilities\memoryutilities.cpp"
 #include "..\coreutilities\Logging.cpp"
 #include "..\coreutilities\MathUtils.cpp"
+#include "..\coreutilities\BlockCompression.cpp"
 #include "..\coreutilities\ThreadUtilities.h"
 
 #include <algorithm>
@@ -51,6 +52,7 @@ public:
 int main(int argc, char* argv[])
 {
 	bool FileChosen = false;
+	bool Compress	= false;
 
 	static_vector<char*, 24> Inputs;
 	static_vector<char*, 24> MetaDataFiles;
@@ -98,6 +100,10 @@ int main(int argc, char* argv[])
 		{
 			Mode = TOOL_MODE::ETOOLMODE_COMPILERESOURCE;
 		}
+		else if (!strcmp(argv[I], "compress") || !strcmp(argv[I], "-z"))
+		{
+			Compress = true;
+		}
 		else if (!strcmp(argv[I], "help") || !strcmp(argv[I], "-h"))
 		{
 			Mode = TOOL_MODE::ETOOLMODE_HELP;
@@ -292,22 +298,74 @@ int main(int argc, char* argv[])
 
 			memset(&Table, 0, TableSize);
 			Table.MagicNumber	= 0xF4F3F2F1F4F3F2F1;
-			Table.Version       = 0x0000000000000002;
+			Table.Version       = 0x0000000000000003;
 			Table.ResourceCount = resources.size();
 
 			std::cout << "Resources Found: " << resources.size() << "\n";
 
+			// Blobs that shrink are stored as independently decompressible blocks, the rest stay raw
+			std::vector<std::vector<FlexKit::byte>> compressed{ blobs.size() };
+
+			size_t rawBytes[EResource_Count]	= {};
+			size_t storedBytes[EResource_Count]	= {};
+
+			for (size_t I = 0; I < blobs.size(); ++I)
+			{
+				const size_t rawSize	= blobs[I].bufferSize;
+				size_t storedSize		= rawSize;
+
+				if (Compress)
+				{
+					compressed[I].resize(GetCompressedBlobBound(rawSize));
+
+					const size_t compressedSize = CompressBlob(blobs[I].buffer, rawSize, compressed[I].data(), compressed[I].size());
+
+					if (compressedSize && compressedSize < rawSize)
+					{
+						compressed[I].resize(compressedSize);
+						storedSize = compressedSize;
+					}
+					else
+						compressed[I].clear();
+				}
+
+				if (blobs[I].resourceType < EResource_Count)
+				{
+					rawBytes[blobs[I].resourceType]		+= rawSize;
+					storedBytes[blobs[I].resourceType]	+= storedSize;
+				}
+			}
+
 			size_t Position = TableSize;
 
+			// Blobs start aligned so the runtime can use them straight out of the mapped file
+			auto AlignPosition = [](const size_t position) { return (position + ResourceBlobAlignment - 1) / ResourceBlobAlignment * ResourceBlobAlignment; };
+
 			for(size_t I = 0; I < blobs.size(); ++I)
 			{
+				Position = AlignPosition(Position);
+
 				Table.Entries[I].ResourcePosition	= Position;
 				Table.Entries[I].GUID				= blobs[I].GUID;
 				Table.Entries[I].Type				= blobs[I].resourceType;
+
+				const size_t storedSize = compressed[I].size() ? compressed[I].size() : blobs[I].bufferSize;
+
+				// StoredSize fills the 8 byte slot of the old ResouceLOC pointer with Compression, it can't grow
+				if (storedSize > UINT32_MAX)
+				{
+					std::cout << "Resource Too Large: " << blobs[I].ID << " stores " << storedSize << " bytes, the limit is " << UINT32_MAX << "\n";
+					return -1;
+				}
+
+				if (compressed[I].size())
+					Table.Entries[I].Compression	= EResourceCompression_Blocks;
+
+				Table.Entries[I].StoredSize			= (uint32_t)storedSize;
 					
 				memcpy(Table.Entries[I].ID, blobs[I].ID.c_str(), ID_LENGTH);
 
-				Position += blobs[I].bufferSize;
+				Position += Table.Entries[I].StoredSize;
 				std::cout << "Resource Found: " << blobs[I].ID << " ID: " << Table.Entries[I].GUID << "\n";
 			}
 
@@ -321,8 +379,36 @@ int main(int argc, char* argv[])
 
 			std::cout << "writing resource " << Out << '\n';
 
-			for (auto& blob : blobs)
-				fwrite(blob.buffer, sizeof(char), blob.bufferSize, F);
+			const char padding[ResourceBlobAlignment] = {};
+
+			Position = TableSize;
+			for (size_t I = 0; I < blobs.size(); ++I)
+			{
+				const size_t		paddingSize = AlignPosition(Position) - Position;
+				const size_t		storedSize	= Table.Entries[I].StoredSize;
+				const FlexKit::byte* stored		= compressed[I].size() ? compressed[I].data() : blobs[I].buffer;
+
+				fwrite(padding, sizeof(char), paddingSize, F);
+				fwrite(stored, sizeof(char), storedSize, F);
+
+				Position += paddingSize + storedSize;
+			}
+
+			if (Compress)
+			{
+				const char* typeNames[] = {
+					"Collider", "Font", "GameDB", "Skeleton", "SkeletalAnimation", "Shader",
+					"Scene", "TriMesh", "TerrainCollider", "Texture", "TextureSet", "CubeMapTexture" };
+
+				for (size_t I = 0; I < EResource_Count; ++I)
+				{
+					if (!rawBytes[I])
+						continue;
+
+					std::cout << typeNames[I] << ": " << rawBytes[I] / KILOBYTE << " KB -> " << storedBytes[I] / KILOBYTE
+						<< " KB, ratio " << double(rawBytes[I]) / double(storedBytes[I]) << "\n";
+				}
+			}
 	}	break;
 	case TOOL_MODE::ETOOLMODE_LISTCONTENTS:
 	{	if (FileChosen)
@@ -349,6 +435,10 @@ int main(int argc, char* argv[])
 				for (size_t I = 0; I < RT->ResourceCount; ++I)
 				{
 					std::cout << "Resource Found: " << RT->Entries[I].ID << " ID: " << RT->Entries[I].GUID;
+
+					if (RT->Entries[I].Compression == EResourceCompression_Blocks)
+						std::cout << " Compressed: " << RT->Entries[I].StoredSize << " bytes";
+
 					switch (RT->Entries[I].Type)
 					{
 					case EResourceType::EResource_Collider:
@@ -383,6 +473,7 @@ int main(int argc, char* argv[])
 	{	std::cout << "COMPILES RESOURCE FILES FOR RUNTIME ENGINE\n"
 			"compile or -c to set it to compile mode\n"
 			"target or -f Species a FBX file for COMPILING\n"
+			"compress or -z stores resources as compressed blocks\n"
 			"list or -ls will Print the Targeted Resource File\n";
 	}	break;
 	default:
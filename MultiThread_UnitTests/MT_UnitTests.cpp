@@ -27,6 +27,20 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "CppUnitTest.h"
 
 #include "..\coreutilities\ThreadUtilities.cpp"
+#include "..\coreutilities\MathUtils.cpp"
+#include "..\coreutilities\Components.cpp"
+#include "..\coreutilities\Transforms.cpp"
+#include "..\coreutilities\TransformKernels.cpp"
+#include "..\coreutilities\LooseOctree.cpp"
+#include "..\coreutilities\CullingKernels.cpp"
+#include "..\coreutilities\LightClustering.cpp"
+#include "..\coreutilities\AssetLoader.cpp"
+#include "..\coreutilities\BlockCompression.cpp"
+#include "..\graphicsutilities\DrawBatching.cpp"
+#include "..\graphicsutilities\TextureResidency.cpp"
+#include "..\coreutilities\Assets.h"
+#include "..\coreutilities\ParallelMerge.h"
+#include "..\coreutilities\RadixSort.h"
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -459,4 +473,3116 @@ namespace UnitTests
 		}
 
 	};
+
+
+	TEST_CLASS(StealingQueueUnitTests)
+	{
+	public:
+		using Queue = FlexKit::CircularStealingQueue<uint32_t>;
+
+
+		TEST_METHOD(StealingQueue_OwnerOnly)
+		{
+			Queue queue{ FlexKit::SystemAllocator, 4 };
+
+			Assert::IsTrue(!queue.pop_back().has_value(), L"Empty queue returned an element!\n");
+
+			// Grows past the initial ring several times
+			for (uint32_t I = 0; I < 1000; ++I)
+				queue.push_back(I);
+
+			Assert::IsTrue(queue.size() == 1000, L"Queue size mismatch!\n");
+
+			for (uint32_t I = 1000; I > 0; --I)
+			{
+				auto res = queue.pop_back();
+				Assert::IsTrue(res.has_value() && res.value() == I - 1, L"pop_back returned the wrong element!\n");
+			}
+
+			Assert::IsTrue(queue.empty(), L"Queue is not empty\n");
+
+			for (uint32_t I = 0; I < 100; ++I)
+				queue.push_back(I);
+
+			for (uint32_t I = 0; I < 100; ++I)
+			{
+				auto res = queue.Steal();
+				Assert::IsTrue(res.has_value() && res.value() == I, L"Steal returned the wrong element!\n");
+			}
+
+			Assert::IsTrue(!queue.Steal().has_value(), L"Empty queue returned an element!\n");
+		}
+
+
+		TEST_METHOD(StealingQueue_MultiProducerStealStress)
+		{
+			const size_t	ownerCount		= 4;
+			const size_t	thiefCount		= 4;
+			const uint32_t	tasksPerOwner	= 250000;
+
+			std::vector<std::atomic_int>	runCounts(ownerCount * tasksPerOwner);
+			std::vector<std::unique_ptr<Queue>>	queues;
+
+			for (size_t I = 0; I < ownerCount; ++I)
+				queues.emplace_back(std::make_unique<Queue>(FlexKit::SystemAllocator, 64));
+
+			std::atomic_size_t			ownersFinished	= 0;
+			std::vector<std::thread>	threads;
+
+			for (size_t owner = 0; owner < ownerCount; ++owner)
+			{
+				threads.emplace_back(
+					[&, owner]
+					{
+						std::default_random_engine generator{ uint32_t(owner) };
+
+						auto& queue		= *queues[owner];
+						uint32_t next	= 0;
+
+						// Bursts well past 64 entries force the ring to grow while thieves are reading it
+						while (next < tasksPerOwner)
+						{
+							const uint32_t burst = 1 + generator() % 512;
+							for (uint32_t I = 0; I < burst && next < tasksPerOwner; ++I)
+								queue.push_back(uint32_t(owner * tasksPerOwner + next++));
+
+							const uint32_t pops = generator() % 256;
+							for (uint32_t I = 0; I < pops; ++I)
+								if (auto res = queue.pop_back(); res)
+									runCounts[res.value()]++;
+						}
+
+						while (auto res = queue.pop_back())
+							runCounts[res.value()]++;
+
+						ownersFinished++;
+					});
+			}
+
+			for (size_t thief = 0; thief < thiefCount; ++thief)
+			{
+				threads.emplace_back(
+					[&, thief]
+					{
+						auto Remaining = [&]
+						{
+							for (auto& queue : queues)
+								if (!queue->empty())
+									return true;
+
+							return false;
+						};
+
+						size_t idx = thief;
+						while (ownersFinished < ownerCount || Remaining())
+						{
+							if (auto res = queues[idx++ % ownerCount]->Steal(); res)
+								runCounts[res.value()]++;
+						}
+					});
+			}
+
+			for (auto& thread : threads)
+				thread.join();
+
+			for (auto& runCount : runCounts)
+			{
+				Assert::IsTrue(runCount != 0, L"Missing Element Detected\n");
+				Assert::IsTrue(runCount == 1, L"Double Element Detected\n");
+			}
+		}
+
+
+		TEST_METHOD(StealingQueue_Throughput)
+		{
+			const uint32_t	opCount		= 1 << 22;
+			const auto		thiefCount	= std::max<uint32_t>(std::min<uint32_t>(std::thread::hardware_concurrency(), MAXTHREADCOUNT), 2) - 1;
+
+			auto Report = [&](const char* label, std::chrono::duration<double, std::milli> duration)
+			{
+				std::stringstream SS;
+				SS << label << " : " << double(opCount) / duration.count() << " ops/ms\n";
+				Logger::WriteMessage(SS.str().c_str());
+			};
+
+			Queue queue{ FlexKit::SystemAllocator, opCount };
+
+			{
+				const auto begin = std::chrono::high_resolution_clock::now();
+
+				for (uint32_t I = 0; I < opCount; ++I)
+					queue.push_back(I);
+
+				Report("push_back", std::chrono::high_resolution_clock::now() - begin);
+			}
+
+			{
+				const auto begin = std::chrono::high_resolution_clock::now();
+
+				for (uint32_t I = 0; I < opCount; ++I)
+					(void)queue.pop_back();
+
+				Report("pop_back", std::chrono::high_resolution_clock::now() - begin);
+			}
+
+			for (uint32_t I = 0; I < opCount; ++I)
+				queue.push_back(I);
+
+			{
+				const auto begin = std::chrono::high_resolution_clock::now();
+
+				for (uint32_t I = 0; I < opCount; ++I)
+					(void)queue.Steal();
+
+				Report("Steal, uncontended", std::chrono::high_resolution_clock::now() - begin);
+			}
+
+			for (uint32_t I = 0; I < opCount; ++I)
+				queue.push_back(I);
+
+			{
+				std::atomic_size_t			stolen = 0;
+				std::vector<std::thread>	thieves;
+
+				const auto begin = std::chrono::high_resolution_clock::now();
+
+				for (uint32_t I = 0; I < thiefCount; ++I)
+				{
+					thieves.emplace_back(
+						[&]
+						{
+							size_t localCount = 0;
+							while (!queue.empty())
+								if (queue.Steal())
+									localCount++;
+
+							stolen += localCount;
+						});
+				}
+
+				for (auto& thief : thieves)
+					thief.join();
+
+				std::stringstream SS;
+				SS << "Steal, " << thiefCount << " thieves : " << double(stolen) / std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - begin).count() << " ops/ms\n";
+				Logger::WriteMessage(SS.str().c_str());
+
+				Assert::IsTrue(stolen == opCount, L"Missing Element Detected\n");
+			}
+		}
+	};
+
+
+	TEST_CLASS(ThreadManagerUnitTests)
+	{
+	public:
+		static bool WaitForParkedWorkers(FlexKit::ThreadManager& threads, std::chrono::milliseconds timeout)
+		{
+			const auto begin = std::chrono::high_resolution_clock::now();
+
+			while (threads.GetParkedThreadCount() < threads.GetThreadCount())
+			{
+				if (std::chrono::high_resolution_clock::now() - begin > timeout)
+					return false;
+
+				std::this_thread::yield();
+			}
+
+			return true;
+		}
+
+
+		TEST_METHOD(ThreadManager_IdleWorkersPark)
+		{
+			FlexKit::ThreadManager threads{ 4 };
+
+			Assert::IsTrue(WaitForParkedWorkers(threads, std::chrono::milliseconds{ 1000 }), L"Idle workers never parked!\n");
+
+			// Parked workers must still pick up new work
+			std::atomic_int completed = 0;
+
+			for (size_t I = 0; I < 64; ++I)
+			{
+				auto& work = FlexKit::CreateWorkItem([&] { completed++; }, FlexKit::SystemAllocator, FlexKit::SystemAllocator);
+				threads.AddWork(&work);
+			}
+
+			const auto begin = std::chrono::high_resolution_clock::now();
+			while (completed < 64 && std::chrono::high_resolution_clock::now() - begin < std::chrono::milliseconds{ 1000 })
+				std::this_thread::yield();
+
+			Assert::IsTrue(completed == 64, L"Parked workers missed a wake up!\n");
+
+			threads.Release();
+		}
+
+
+		TEST_METHOD(ThreadManager_PingPongLatency)
+		{
+			FlexKit::ThreadManager threads{ 2 };
+
+			using Duration = std::chrono::duration<double, std::micro>;
+
+			std::atomic_bool ponged = false;
+
+			auto PingPong = [&]() -> Duration
+			{
+				ponged = false;
+
+				auto& work = FlexKit::CreateWorkItem([&] { ponged = true; }, FlexKit::SystemAllocator, FlexKit::SystemAllocator);
+
+				const auto begin = std::chrono::high_resolution_clock::now();
+
+				threads.AddWork(&work);
+				while (!ponged)
+					_mm_pause();
+
+				return std::chrono::high_resolution_clock::now() - begin;
+			};
+
+			auto Report = [&](const char* label, std::vector<Duration>& samples)
+			{
+				std::sort(samples.begin(), samples.end());
+
+				std::stringstream SS;
+				SS << label << " round trip : median " << samples[samples.size() / 2].count() << "us, p99 "
+					<< samples[samples.size() * 99 / 100].count() << "us, max "
+					<< samples.back().count() << "us\n";
+
+				Logger::WriteMessage(SS.str().c_str());
+			};
+
+			// Back to back, workers are still spinning
+			{
+				std::vector<Duration> samples;
+				for (size_t I = 0; I < 10000; ++I)
+					samples.push_back(PingPong());
+
+				Report("Hot", samples);
+			}
+
+			// Every ping has to wake a parked worker
+			{
+				std::vector<Duration> samples;
+				for (size_t I = 0; I < 200; ++I)
+				{
+					WaitForParkedWorkers(threads, std::chrono::milliseconds{ 100 });
+					samples.push_back(PingPong());
+				}
+
+				Report("Parked", samples);
+			}
+
+			threads.Release();
+		}
+	};
+
+
+	TEST_CLASS(FrameArenaUnitTests)
+	{
+	public:
+		TEST_METHOD(FrameArena_ConcurrentAllocations)
+		{
+			const size_t threadCount		= 8;
+			const size_t allocationCount	= 2000;
+
+			// Small enough that every frame spills into the backing allocator
+			FlexKit::FrameArena arena{ FlexKit::SystemAllocator, MEGABYTE };
+
+			for (size_t frame = 0; frame < 2 * FlexKit::FrameArena::FrameCount; ++frame)
+			{
+				std::atomic_int				errors = 0;
+				std::vector<std::thread>	threads;
+
+				for (size_t T = 0; T < threadCount; ++T)
+				{
+					threads.emplace_back(
+						[&, T]
+						{
+							const auto pattern = uint8_t(T * 16 + frame);
+
+							std::vector<std::pair<uint8_t*, size_t>> allocations;
+
+							for (size_t I = 0; I < allocationCount; ++I)
+							{
+								const size_t size		= 1 + (I * 7 + T) % 200;
+								const size_t alignment	= size_t(1) << (I % 7);
+
+								auto memory = (uint8_t*)arena._aligned_malloc(size, alignment);
+
+								if ((size_t)memory % alignment)
+									errors++;
+
+								memset(memory, pattern, size);
+								allocations.emplace_back(memory, size);
+							}
+
+							// Anything overlapping another thread's allocation would have been overwritten
+							for (auto [memory, size] : allocations)
+							{
+								for (size_t I = 0; I < size; ++I)
+								{
+									if (memory[I] != pattern)
+									{
+										errors++;
+										break;
+									}
+								}
+							}
+						});
+				}
+
+				for (auto& thread : threads)
+					thread.join();
+
+				Assert::IsTrue(errors == 0,										L"Frame arena handed out overlapping or misaligned memory!\n");
+				Assert::IsTrue(arena.GetUsed() > arena.GetFrameSize(),			L"Overflow missing from the frame usage!\n");
+				Assert::IsTrue(arena.GetHighWaterMark() >= arena.GetUsed(),		L"High water mark below the current frame!\n");
+
+				arena.NextFrame();
+			}
+
+			Assert::IsTrue(arena.GetOverflowCount() > 0,	L"Expected allocations to overflow!\n");
+			Assert::IsTrue(arena.GetUsed() == 0,			L"NextFrame did not reset the arena!\n");
+
+			std::stringstream SS;
+			SS << "Frame arena high water mark: " << arena.GetHighWaterMark() / KILOBYTE << "KB, " << arena.GetOverflowCount() << " overflowed allocations\n";
+			Logger::WriteMessage(SS.str().c_str());
+		}
+	};
+
+
+	TEST_CLASS(BlockAllocatorUnitTests)
+	{
+	public:
+		static FlexKit::BlockAllocator& GetTestAllocator()
+		{
+			static FlexKit::BlockAllocator allocator;
+			static bool initiated = false;
+
+			if (!initiated)
+			{
+				FlexKit::BlockAllocator_desc desc;
+				desc.SmallBlock		= MEGABYTE * 32;
+				desc.MediumBlock	= MEGABYTE * 64;
+				desc.LargeBlock		= MEGABYTE * 64;
+
+				allocator.Init(desc);
+				initiated = true;
+			}
+
+			return allocator;
+		}
+
+
+		TEST_METHOD(BlockAllocator_CrossThreadFrees)
+		{
+			auto& allocator = GetTestAllocator();
+
+			const size_t threadCount		= 8;
+			const size_t allocationCount	= 20000;
+
+			struct Allocation
+			{
+				uint8_t*	memory;
+				size_t		size;
+				uint8_t		pattern;
+			};
+
+			std::atomic_int				errors = 0;
+			std::mutex					mailboxLock;
+			std::vector<Allocation>		mailbox;
+			std::vector<std::thread>	threads;
+
+			auto Check = [&](const Allocation& allocation)
+			{
+				for (size_t I = 0; I < allocation.size; ++I)
+				{
+					if (allocation.memory[I] != allocation.pattern)
+					{
+						errors++;
+						break;
+					}
+				}
+			};
+
+			// Every thread frees some of its own blocks and some of everyone else's
+			for (size_t T = 0; T < threadCount; ++T)
+			{
+				threads.emplace_back(
+					[&, T]
+					{
+						std::default_random_engine	generator{ (unsigned int)T };
+						std::vector<Allocation>		live;
+
+						for (size_t I = 0; I < allocationCount; ++I)
+						{
+							const size_t size = (I % 16 == 0) ? 1 + generator() % 2048 : 1 + generator() % 64;
+
+							Allocation allocation{ allocator.malloc(size), size, uint8_t(generator()) };
+							memset(allocation.memory, allocation.pattern, size);
+							live.push_back(allocation);
+
+							if (live.size() > 64)
+							{
+								const size_t idx = generator() % live.size();
+								const auto freed = live[idx];
+
+								live[idx] = live.back();
+								live.pop_back();
+
+								Check(freed);
+
+								if (generator() % 4 == 0)
+								{
+									std::scoped_lock lock{ mailboxLock };
+									mailbox.push_back(freed);
+								}
+								else
+									allocator.free(freed.memory);
+							}
+
+							if (I % 64 == 0)
+							{
+								std::vector<Allocation> received;
+
+								{
+									std::scoped_lock lock{ mailboxLock };
+									received.swap(mailbox);
+								}
+
+								for (auto& allocation : received)
+								{
+									Check(allocation);
+									allocator.free(allocation.memory);
+								}
+							}
+						}
+
+						for (auto& allocation : live)
+							allocator.free(allocation.memory);
+					});
+			}
+
+			for (auto& thread : threads)
+				thread.join();
+
+			for (auto& allocation : mailbox)
+				allocator.free(allocation.memory);
+
+			Assert::IsTrue(errors == 0, L"Block allocator handed out a block that was still in use!\n");
+		}
+
+
+		TEST_METHOD(BlockAllocator_ThreadExitFlushesCache)
+		{
+			auto& allocator = GetTestAllocator();
+
+			const size_t generations	= 16;
+			const size_t threadCount	= 8;
+			const size_t blockCount		= 256;
+
+			// Constructed before the thread claims a cache so it is destroyed after the claim,
+			// its frees land after the cache was flushed and its index released
+			struct LateFrees
+			{
+				~LateFrees()
+				{
+					for (auto block : blocks)
+						allocator->free(block);
+				}
+
+				FlexKit::BlockAllocator*	allocator = nullptr;
+				std::vector<uint8_t*>		blocks;
+			};
+
+			std::atomic_int errors = 0;
+
+			for (size_t G = 0; G < generations; ++G)
+			{
+				std::vector<std::thread> threads;
+
+				for (size_t T = 0; T < threadCount; ++T)
+				{
+					threads.emplace_back(
+						[&, T]
+						{
+							thread_local LateFrees lateFrees;
+							lateFrees.allocator = &allocator;
+
+							std::vector<uint8_t*> live;
+							const uint8_t pattern = uint8_t(G * threadCount + T);
+
+							for (size_t I = 0; I < blockCount; ++I)
+							{
+								const size_t size = 1 + (I * 37) % 1024;
+
+								auto block = allocator.malloc(size);
+								memset(block, pattern, size);
+								live.push_back(block);
+							}
+
+							for (size_t I = 0; I < blockCount; ++I)
+							{
+								const size_t size = 1 + (I * 37) % 1024;
+
+								for (size_t J = 0; J < size; ++J)
+								{
+									if (live[I][J] != pattern)
+									{
+										errors++;
+										break;
+									}
+								}
+							}
+
+							// Half go back to this thread's cache, the rest are freed as the thread exits
+							for (size_t I = 0; I < blockCount; ++I)
+							{
+								if (I % 2)
+									allocator.free(live[I]);
+								else
+									lateFrees.blocks.push_back(live[I]);
+							}
+						});
+				}
+
+				for (auto& thread : threads)
+					thread.join();
+			}
+
+			Assert::IsTrue(errors == 0, L"Block allocator handed out a block still in use by an exiting thread!\n");
+		}
+
+
+		// Drives the tracker directly, so it runs with the allocator hooks compiled out too
+		TEST_METHOD(AllocationTelemetry_TagTotalsAcrossThreads)
+		{
+			const size_t threadCount		= 8;
+			const size_t allocationCount	= 1024;
+			const size_t allocationSize		= 64;
+
+			auto FindTag = [](const char* tag)
+			{
+				FlexKit::AllocationTagStats tags[FlexKit::MaxAllocationTags];
+				const size_t				tagCount = FlexKit::GetAllocationTagStats(tags, FlexKit::MaxAllocationTags);
+
+				for (size_t I = 0; I < tagCount; ++I)
+					if (!strcmp(tags[I].tag, tag))
+						return tags[I];
+
+				return FlexKit::AllocationTagStats{ nullptr };
+			};
+
+			// Only the addresses are used as keys, never touched
+			std::vector<uint8_t>	memory(threadCount * allocationCount * allocationSize);
+			const auto				totalsBefore = FlexKit::GetAllocationTotals();
+
+			{
+				std::vector<std::thread> threads;
+
+				for (size_t I = 0; I < threadCount; ++I)
+				{
+					threads.emplace_back(
+						[&, I]
+						{
+							FlexKit::AllocationTagScope tag{ "Telemetry Test Outer" };
+
+							for (size_t J = 0; J < allocationCount; ++J)
+							{
+								const void* ptr = memory.data() + (I * allocationCount + J) * allocationSize;
+
+								if (J % 2)
+								{
+									FlexKit::AllocationTagScope innerTag{ "Telemetry Test Inner" };
+									FlexKit::TrackAllocation(ptr, allocationSize, "Telemetry Test Allocator");
+								}
+								else
+									FlexKit::TrackAllocation(ptr, allocationSize, "Telemetry Test Allocator");
+							}
+
+							FlexKit::TrackTransient(allocationSize, "Telemetry Test Allocator");
+						});
+				}
+
+				for (auto& thread : threads)
+					thread.join();
+			}
+
+			const size_t perTag = threadCount * allocationCount / 2;
+
+			const auto outer = FindTag("Telemetry Test Outer");
+			const auto inner = FindTag("Telemetry Test Inner");
+
+			Assert::IsTrue(outer.tag && inner.tag,									L"Tags missing from the stats table!\n");
+			Assert::IsTrue(FindTag("Telemetry Test Allocator").tag == nullptr,		L"Tagged allocations charged to the allocator name!\n");
+			Assert::IsTrue(inner.liveCount == int64_t(perTag),						L"Innermost tag miscounted!\n");
+			Assert::IsTrue(outer.liveCount == int64_t(perTag),						L"Outer tag miscounted!\n");
+			Assert::IsTrue(outer.liveBytes == int64_t(perTag * allocationSize),		L"Outer tag's live bytes wrong!\n");
+			Assert::IsTrue(outer.totalAllocations == perTag + threadCount,			L"Transient allocations not counted!\n");
+			Assert::IsTrue(FlexKit::GetAllocationTotals().liveCount - totalsBefore.liveCount == int64_t(2 * perTag), L"Totals miss tracked allocations!\n");
+
+			FlexKit::AllocationTelemetryNextFrame();
+
+			Assert::IsTrue(FindTag("Telemetry Test Outer").lastFrameAllocations == perTag + threadCount, L"Frame counters not advanced!\n");
+
+			const char* fileName = "AllocationTelemetryTest.txt";
+			Assert::IsTrue(FlexKit::DumpAllocationTelemetry(fileName), L"Failed to write the telemetry dump!\n");
+
+			{
+				FILE* F = nullptr;
+				fopen_s(&F, fileName, "rb");
+				Assert::IsTrue(F != nullptr, L"Failed to read the telemetry dump!\n");
+
+				std::string dump;
+				char		buffer[4096];
+
+				for (size_t read = fread(buffer, 1, sizeof(buffer), F); read; read = fread(buffer, 1, sizeof(buffer), F))
+					dump.append(buffer, read);
+
+				fclose(F);
+				remove(fileName);
+
+				Assert::IsTrue(dump.find("Telemetry Test Inner") != std::string::npos, L"Tag missing from the dump!\n");
+			}
+
+			// Frees come from other threads and outside any tag, they still land on the allocating tag
+			{
+				std::vector<std::thread> threads;
+
+				for (size_t I = 0; I < threadCount; ++I)
+				{
+					threads.emplace_back(
+						[&, I]
+						{
+							const size_t source = (I + 1) % threadCount;
+
+							for (size_t J = 0; J < allocationCount; ++J)
+								FlexKit::TrackFree(memory.data() + (source * allocationCount + J) * allocationSize);
+
+							FlexKit::TrackFree(memory.data() + 1); // never tracked, ignored
+						});
+				}
+
+				for (auto& thread : threads)
+					thread.join();
+			}
+
+			const auto outerFreed = FindTag("Telemetry Test Outer");
+			const auto innerFreed = FindTag("Telemetry Test Inner");
+
+			Assert::IsTrue(outerFreed.liveCount == 0 && innerFreed.liveCount == 0,	L"Freed allocations still live!\n");
+			Assert::IsTrue(outerFreed.liveBytes == 0 && innerFreed.liveBytes == 0,	L"Freed bytes still live!\n");
+			Assert::IsTrue(outerFreed.peakBytes == int64_t(perTag * allocationSize),	L"Peak not kept after the frees!\n");
+			Assert::IsTrue(FlexKit::GetAllocationTotals().liveCount == totalsBefore.liveCount, L"Totals still hold freed allocations!\n");
+		}
+
+
+#if USING(ALLOCATIONTELEMETRY)
+
+		TEST_METHOD(BlockAllocator_TaggedAllocationTracked)
+		{
+			auto& allocator = GetTestAllocator();
+
+			auto FindTag = [](const char* tag)
+			{
+				FlexKit::AllocationTagStats tags[FlexKit::MaxAllocationTags];
+				const size_t				tagCount = FlexKit::GetAllocationTagStats(tags, FlexKit::MaxAllocationTags);
+
+				for (size_t I = 0; I < tagCount; ++I)
+					if (!strcmp(tags[I].tag, tag))
+						return tags[I];
+
+				return FlexKit::AllocationTagStats{ nullptr };
+			};
+
+			const size_t size = 4096;
+			uint8_t* memory = nullptr;
+
+			{
+				FK_ALLOCATION_TAG("Tagged Allocation Test");
+				memory = allocator.malloc(size);
+			}
+
+			const auto allocated = FindTag("Tagged Allocation Test");
+
+			Assert::IsTrue(allocated.tag != nullptr,			L"Tagged allocation missing from the stats table!\n");
+			Assert::IsTrue(allocated.liveCount == 1,			L"Tagged allocation not counted as live!\n");
+			Assert::IsTrue(allocated.liveBytes >= int64_t(size),	L"Tagged allocation's bytes not counted!\n");
+
+			// Freed outside the tag, the free is still charged to the tag it was allocated under
+			allocator.free(memory);
+
+			const auto freed = FindTag("Tagged Allocation Test");
+
+			Assert::IsTrue(freed.liveCount == 0,			L"Freed tagged allocation still live!\n");
+			Assert::IsTrue(freed.liveBytes == 0,			L"Freed tagged allocation's bytes still live!\n");
+			Assert::IsTrue(freed.totalAllocations == 1,	L"Tagged allocation count lost on free!\n");
+			Assert::IsTrue(freed.peakBytes >= int64_t(size),	L"Tagged allocation peak not kept!\n");
+		}
+
+#endif
+
+
+		TEST_METHOD(LargeBlockAllocator_FragmentedPool)
+		{
+			const size_t	poolSize	= 256 * MEGABYTE;
+			const size_t	blockSize	= sizeof(FlexKit::LargeBlockAllocator::Block);
+			auto			buffer		= (byte*)::_aligned_malloc(poolSize, 0x40);
+
+			FlexKit::LargeBlockAllocator pool;
+			pool.Initialise(poolSize, buffer);
+
+			std::default_random_engine	generator{ 1234 };
+			std::vector<byte*>			live;
+			std::vector<byte*>			holes;
+
+			// Fill the pool with runs of random lengths, then free every other one to leave it full of holes
+			for (size_t used = 0, I = 0; used + 4 <= pool.Size; ++I)
+			{
+				const size_t runLength = 1 + generator() % 4;
+				used += runLength;
+
+				(I % 2 ? holes : live).push_back(pool.malloc(runLength * blockSize));
+			}
+
+			for (auto memory : holes)
+				pool.free(memory);
+
+			// Allocation time should not depend on how many holes sit in front of a fit
+			const size_t passCount	= 100000;
+			const auto	 begin		= std::chrono::high_resolution_clock::now();
+
+			for (size_t I = 0; I < passCount; ++I)
+			{
+				auto memory = pool.malloc(blockSize);
+				Assert::IsTrue(memory != nullptr, L"Failed to allocate from a fragmented pool!\n");
+				pool.free(memory);
+			}
+
+			const std::chrono::duration<double, std::nano> duration = std::chrono::high_resolution_clock::now() - begin;
+
+			std::stringstream SS;
+			SS << "Fragmented large pool, " << holes.size() << " holes : " << duration.count() / passCount << "ns per alloc+free\n";
+			Logger::WriteMessage(SS.str().c_str());
+
+			// Everything freed has to merge back into a single run
+			for (auto memory : live)
+				pool.free(memory);
+
+			Assert::IsTrue(pool.BlockTable[0].state == FlexKit::LargeBlockAllocator::BlockData::Free,	L"Pool not free after releasing everything!\n");
+			Assert::IsTrue(pool.BlockTable[0].AllocationSize == pool.Size,								L"Freed blocks did not coalesce!\n");
+
+			::_aligned_free(buffer);
+		}
+
+
+		TEST_METHOD(BlockAllocator_ScalingBenchmark)
+		{
+			auto& allocator = GetTestAllocator();
+
+			const size_t	operationCount	= 200000;
+			const auto		maxWorkers		= std::min<uint32_t>(std::thread::hardware_concurrency(), MAXTHREADCOUNT);
+
+			for (uint32_t workerCount = 1; workerCount <= maxWorkers; ++workerCount)
+			{
+				std::vector<std::thread> threads;
+
+				const auto begin = std::chrono::high_resolution_clock::now();
+
+				for (uint32_t T = 0; T < workerCount; ++T)
+				{
+					threads.emplace_back(
+						[&, T]
+						{
+							std::default_random_engine	generator{ T };
+							uint8_t*					live[64] = {};
+
+							for (size_t I = 0; I < operationCount; ++I)
+							{
+								auto& slot = live[I % 64];
+
+								if (slot)
+									allocator.free(slot);
+
+								const size_t size = (I % 8 == 0) ? 1 + generator() % 2048 : 1 + generator() % 64;
+
+								slot	= allocator.malloc(size);
+								slot[0]	= uint8_t(I);
+							}
+
+							for (auto memory : live)
+								allocator.free(memory);
+						});
+				}
+
+				for (auto& thread : threads)
+					thread.join();
+
+				const std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - begin;
+
+				std::stringstream SS;
+				SS << "Block allocator threads: " << workerCount << " : " << double(operationCount * workerCount) / duration.count() << " alloc+free/ms\n";
+				Logger::WriteMessage(SS.str().c_str());
+			}
+		}
+	};
+
+
+	TEST_CLASS(UpdateDispatcherUnitTests)
+	{
+	public:
+		TEST_METHOD(UpdateDispatcher_CriticalPath)
+		{
+			FlexKit::ThreadManager		threads{ 4 };
+			FlexKit::UpdateDispatcher	dispatcher{ &threads, FlexKit::SystemAllocator };
+
+			struct SleepData
+			{
+				std::chrono::milliseconds	duration;
+				std::atomic_int*			completed;
+			};
+
+			std::atomic_int completed = 0;
+
+			auto AddSleep = [&](const char* name, std::chrono::milliseconds duration, FlexKit::UpdateTask* input) -> FlexKit::UpdateTask&
+			{
+				return dispatcher.Add<SleepData>(
+					[&](auto& builder, SleepData& data)
+					{
+						builder.SetDebugString(name);
+
+						if (input)
+							builder.AddInput(*input);
+
+						data.duration	= duration;
+						data.completed	= &completed;
+					},
+					[](auto& data)
+					{
+						std::this_thread::sleep_for(data.duration);
+						(*data.completed)++;
+					});
+			};
+
+			// Diamond with a long left side, a few independent short tasks on the side
+			for (size_t frame = 0; frame < 3; ++frame)
+			{
+				completed = 0;
+
+				auto& A = AddSleep("A", std::chrono::milliseconds{ 1 },		nullptr);
+				auto& B = AddSleep("B", std::chrono::milliseconds{ 10 },	&A);
+				auto& C = AddSleep("C", std::chrono::milliseconds{ 1 },		&A);
+				auto& D = AddSleep("D", std::chrono::milliseconds{ 1 },		&B);
+				D.AddInput(C);
+
+				for (size_t I = 0; I < 4; ++I)
+					AddSleep("Side", std::chrono::milliseconds{ 1 }, nullptr);
+
+				dispatcher.Execute();
+
+				Assert::IsTrue(completed == 8, L"Dispatcher skipped a task!\n");
+
+				const auto& records	= dispatcher.GetFrameRecords();
+				const auto& path	= dispatcher.GetCriticalPath();
+
+				Assert::IsTrue(path.size() == 3,						L"Unexpected critical path length!\n");
+				Assert::IsTrue(!strcmp(records[path[0]].name, "A"),		L"Critical path should start at A!\n");
+				Assert::IsTrue(!strcmp(records[path[1]].name, "B"),		L"Critical path should run through B!\n");
+				Assert::IsTrue(!strcmp(records[path[2]].name, "D"),		L"Critical path should end at D!\n");
+
+				for (auto idx : path)
+					Assert::IsTrue(records[idx].critical, L"Critical path task not flagged!\n");
+
+				Assert::IsTrue(dispatcher.GetCriticalPathTime() >= 12.0,					L"Critical path shorter than its sleeps!\n");
+				Assert::IsTrue(dispatcher.GetGraphTime() >= dispatcher.GetCriticalPathTime(),	L"Graph finished before its critical path!\n");
+			}
+
+			for (const auto& stats : dispatcher.GetTaskStats())
+			{
+				if (!strcmp(stats.name, "B"))
+					Assert::IsTrue(stats.samples == 3 && stats.criticalCount == 3, L"Timings not kept across frames!\n");
+				else if (!strcmp(stats.name, "Side"))
+					Assert::IsTrue(stats.samples == 12 && stats.criticalCount == 0, L"Side tasks should never be critical!\n");
+			}
+
+			Assert::IsTrue(dispatcher.ExportTrace("UpdateDispatcher_CriticalPath.json"), L"Failed to export the frame trace!\n");
+
+			std::stringstream SS;
+			SS << "Critical path: " << dispatcher.GetCriticalPathTime() << "ms, graph: " << dispatcher.GetGraphTime() << "ms\n";
+			Logger::WriteMessage(SS.str().c_str());
+
+			threads.Release();
+		}
+
+
+		TEST_METHOD(UpdateDispatcher_StatsKeyedByTaskID)
+		{
+			FlexKit::ThreadManager		threads{ 2 };
+			FlexKit::UpdateDispatcher	dispatcher{ &threads, FlexKit::SystemAllocator };
+
+			struct EmptyData {};
+
+			auto AddTask = [&](const uint32_t taskID, const char* name)
+			{
+				auto Setup	= [&](auto& builder, EmptyData&) { builder.SetDebugString(name); };
+				auto Update	= [](auto&) {};
+
+				if (taskID)
+					dispatcher.Add<EmptyData>(taskID, Setup, Update);
+				else
+					dispatcher.Add<EmptyData>(Setup, Update);
+			};
+
+			// Two IDs sharing a debug string, plus two untagged tasks that share theirs
+			for (size_t frame = 0; frame < 4; ++frame)
+			{
+				AddTask(1001, "Shared");
+				AddTask(1002, "Shared");
+				AddTask(0, "Untagged");
+				AddTask(0, "Untagged");
+
+				dispatcher.Execute();
+			}
+
+			const auto& stats = dispatcher.GetTaskStats();
+
+			Assert::IsTrue(stats.size() == 3, L"Unexpected number of task stats!\n");
+
+			for (const auto& entry : stats)
+			{
+				if (!strcmp(entry.name, "Shared"))
+					Assert::IsTrue(entry.samples == 4, L"Tasks with their own ID shared timings!\n");
+				else
+					Assert::IsTrue(entry.samples == 8, L"Untagged tasks with one debug string not merged!\n");
+			}
+
+			threads.Release();
+		}
+	};
+
+
+	TEST_CLASS(ComponentUnitTests)
+	{
+	public:
+		static constexpr FlexKit::ComponentID HealthComponentID	= GetTypeGUID(QueryTestHealth);
+		static constexpr FlexKit::ComponentID SpeedComponentID	= GetTypeGUID(QueryTestSpeed);
+
+		using HealthHandle		= FlexKit::Handle_t<32, HealthComponentID>;
+		using SpeedHandle		= FlexKit::Handle_t<32, SpeedComponentID>;
+		using HealthComponent	= FlexKit::BasicComponent_t<int,	HealthHandle,	HealthComponentID>;
+		using SpeedComponent	= FlexKit::BasicComponent_t<float,	SpeedHandle,	SpeedComponentID>;
+		using HealthView		= FlexKit::BasicComponentView_t<HealthComponent>;
+		using SpeedView			= FlexKit::BasicComponentView_t<SpeedComponent>;
+
+
+		TEST_METHOD(ComponentQuery_JoinsByGameObject)
+		{
+			FlexKit::ThreadManager	threads{ 4 };
+
+			HealthComponent	health	{ FlexKit::SystemAllocator };
+			SpeedComponent	speed	{ FlexKit::SystemAllocator };
+
+			const size_t objectCount = 10000;
+
+			{
+				auto objects = std::make_unique<FlexKit::GameObject[]>(objectCount);
+
+				// Every object has health, every third one also has speed, added in reverse so the arrays disagree on order
+				for (size_t I = 0; I < objectCount; ++I)
+					objects[I].AddView<HealthView>(int(I));
+
+				for (size_t I = objectCount; I-- > 0;)
+					if (I % 3 == 0)
+						objects[I].AddView<SpeedView>(float(I) * 2.0f);
+
+				FlexKit::ComponentQuery<HealthView, SpeedView> query{ FlexKit::SystemAllocator };
+
+				Assert::IsTrue(query.size() == (objectCount + 2) / 3, L"Query matched the wrong number of objects!\n");
+
+				query.ForEach(
+					[&](FlexKit::GameObject& gameObject, auto& health, auto& speed)
+					{
+						const size_t idx = &gameObject - objects.get();
+
+						Assert::IsTrue(health.componentData == int(idx),					L"Health joined to the wrong object!\n");
+						Assert::IsTrue(speed.componentData == float(idx) * 2.0f,			L"Speed joined to the wrong object!\n");
+						Assert::IsTrue(FlexKit::GetView<SpeedView>(gameObject).handle == speed.handle, L"Element does not belong to its view!\n");
+					});
+
+				// Removing views has to show up on the next pass
+				for (size_t I = 0; I < objectCount; I += 6)
+					objects[I].RemoveView(objects[I].GetView(SpeedComponentID));
+
+				Assert::IsTrue(query.size() == (objectCount + 5) / 6, L"Query kept removed views!\n");
+
+				std::atomic_int64_t parallelSum = 0;
+				int64_t				serialSum	= 0;
+
+				query.ForEach(
+					[&](FlexKit::GameObject&, auto& health, auto&)
+					{
+						serialSum += health.componentData;
+					});
+
+				query.ParallelForEach(threads, FlexKit::SystemAllocator,
+					[&](FlexKit::GameObject&, auto& health, auto&)
+					{
+						parallelSum += health.componentData;
+					}, 64);
+
+				Assert::IsTrue(serialSum == parallelSum, L"Parallel pass skipped or repeated rows!\n");
+
+				query.Release();
+			}
+
+			threads.Release();
+		}
+
+
+		TEST_METHOD(ComponentQuery_ConcurrentRefresh)
+		{
+			HealthComponent	health	{ FlexKit::SystemAllocator };
+			SpeedComponent	speed	{ FlexKit::SystemAllocator };
+
+			const size_t objectCount	= 4000;
+			const size_t threadCount	= 8;
+
+			auto objects = std::make_unique<FlexKit::GameObject[]>(objectCount);
+
+			for (size_t I = 0; I < objectCount; ++I)
+			{
+				objects[I].AddView<HealthView>(int(I));
+
+				if (I % 2 == 0)
+					objects[I].AddView<SpeedView>(float(I));
+			}
+
+			FlexKit::ComponentQuery<HealthView, SpeedView> query{ FlexKit::SystemAllocator };
+
+			for (size_t round = 0; round < 8; ++round)
+			{
+				// Each round changes the layout, every thread then races to be the first to iterate
+				objects[2 * round + 1].AddView<SpeedView>(float(round));
+
+				const size_t expected = objectCount / 2 + round + 1;
+
+				std::atomic_int				errors = 0;
+				std::vector<std::thread>	workers;
+
+				for (size_t T = 0; T < threadCount; ++T)
+				{
+					workers.emplace_back(
+						[&]
+						{
+							size_t count = 0;
+							query.ForEach([&](FlexKit::GameObject&, auto&, auto&) { count++; });
+
+							if (count != expected)
+								errors++;
+						});
+				}
+
+				for (auto& worker : workers)
+					worker.join();
+
+				Assert::IsTrue(errors == 0, L"Concurrent passes saw a partly rebuilt query!\n");
+			}
+
+			query.Release();
+		}
+
+
+		TEST_METHOD(GameObjectBatches_LoadUnload)
+		{
+			HealthComponent	health	{ FlexKit::SystemAllocator };
+			SpeedComponent	speed	{ FlexKit::SystemAllocator };
+
+			auto& allocator = BlockAllocatorUnitTests::GetTestAllocator();
+
+			const size_t objectCount	= 2000;
+			const size_t baseline		= allocator.GetPoolStats().largePool.used;
+
+			FlexKit::GameObjectBatches loaded{ FlexKit::SystemAllocator };
+
+			// Same shape as a scene load followed by ClearScene, repeated so a leaked batch would add up
+			for (size_t load = 0; load < 32; ++load)
+			{
+				for (size_t batch = 0; batch < 2; ++batch)
+				{
+					auto objects = loaded.Create(objectCount, allocator);
+
+					for (size_t I = 0; I < objectCount; ++I)
+					{
+						objects[I].AddView<HealthView>(int(I));
+						objects[I].AddView<SpeedView>(float(I));
+					}
+				}
+
+				Assert::IsTrue(loaded.size() == 2,							L"Batch not kept!\n");
+				Assert::IsTrue(health.elements.size() == 2 * objectCount,	L"Views missing after load!\n");
+
+				loaded.Release();
+
+				Assert::IsTrue(loaded.size() == 0,							L"Batches kept after release!\n");
+				Assert::IsTrue(health.elements.size() == 0,					L"Views left behind after unload!\n");
+				Assert::IsTrue(speed.elements.size() == 0,					L"Views left behind after unload!\n");
+				Assert::IsTrue(allocator.GetPoolStats().largePool.used == baseline, L"Batch memory leaked on unload!\n");
+			}
+		}
+
+
+		TEST_METHOD(GameObject_BatchCreation)
+		{
+			HealthComponent	health	{ FlexKit::SystemAllocator };
+			SpeedComponent	speed	{ FlexKit::SystemAllocator };
+
+			const size_t objectCount = 20000;
+
+			auto inlineView = [](FlexKit::GameObject& gameObject, FlexKit::ComponentID id)
+			{
+				auto view = (std::byte*)gameObject.GetView(id);
+				return view > (std::byte*)&gameObject && view < (std::byte*)(&gameObject + 1);
+			};
+
+			// One allocation per object, the old path also allocated each view
+			const auto individualBegin = std::chrono::high_resolution_clock::now();
+
+			FlexKit::Vector<FlexKit::GameObject*> individual{ FlexKit::SystemAllocator, objectCount };
+
+			for (size_t I = 0; I < objectCount; ++I)
+			{
+				auto& gameObject = FlexKit::SystemAllocator->allocate<FlexKit::GameObject>(FlexKit::SystemAllocator);
+				gameObject.AddView<HealthView>(int(I));
+				gameObject.AddView<SpeedView>(float(I));
+
+				individual.push_back(&gameObject);
+			}
+
+			for (auto gameObject : individual)
+				FlexKit::SystemAllocator->release(gameObject);
+
+			const auto individualEnd	= std::chrono::high_resolution_clock::now();
+			const auto batchBegin		= individualEnd;
+
+			auto objects = FlexKit::CreateGameObjects(objectCount, FlexKit::SystemAllocator);
+
+			for (size_t I = 0; I < objectCount; ++I)
+			{
+				objects[I].AddView<HealthView>(int(I));
+				objects[I].AddView<SpeedView>(float(I));
+			}
+
+			for (size_t I = 0; I < objectCount; ++I)
+			{
+				Assert::IsTrue(inlineView(objects[I], HealthComponentID) && inlineView(objects[I], SpeedComponentID), L"Views were not placed inline!\n");
+				Assert::IsTrue(FlexKit::GetView<HealthView>(objects[I]).GetData() == int(I), L"View lost its data!\n");
+			}
+
+			FlexKit::ReleaseGameObjects(objects, objectCount, FlexKit::SystemAllocator);
+
+			const auto batchEnd = std::chrono::high_resolution_clock::now();
+
+			std::stringstream SS;
+			SS << "GameObjects, individual: "
+				<< std::chrono::duration<double, std::milli>(individualEnd - individualBegin).count() << "ms, batched: "
+				<< std::chrono::duration<double, std::milli>(batchEnd - batchBegin).count() << "ms\n";
+			Logger::WriteMessage(SS.str().c_str());
+		}
+	};
+
+
+	TEST_CLASS(SpatialIndexUnitTests)
+	{
+	public:
+		static const size_t entityCount = 100000;
+
+
+		// Axis aligned box as a frustum, planes face outward
+		static FlexKit::Frustum BoxFrustum(const FlexKit::float3 min, const FlexKit::float3 max)
+		{
+			FlexKit::Frustum frustum;
+			frustum.Planes[FlexKit::EPlane_RIGHT]	= { {  1,  0,  0 }, { max.x, 0, 0 } };
+			frustum.Planes[FlexKit::EPlane_LEFT]	= { { -1,  0,  0 }, { min.x, 0, 0 } };
+			frustum.Planes[FlexKit::EPlane_TOP]		= { {  0,  1,  0 }, { 0, max.y, 0 } };
+			frustum.Planes[FlexKit::EPlane_BOTTOM]	= { {  0, -1,  0 }, { 0, min.y, 0 } };
+			frustum.Planes[FlexKit::EPlane_FAR]		= { {  0,  0,  1 }, { 0, 0, max.z } };
+			frustum.Planes[FlexKit::EPlane_NEAR]	= { {  0,  0, -1 }, { 0, 0, min.z } };
+
+			return frustum;
+		}
+
+
+		struct TestScene
+		{
+			TestScene() :
+				octree	{ FlexKit::SystemAllocator, { 0, 0, 0 }, 2048.0f },
+				spheres	{ FlexKit::SystemAllocator, entityCount },
+				entries	{ FlexKit::SystemAllocator, entityCount }
+			{
+				std::default_random_engine				generator	{ 1234 };
+				std::uniform_real_distribution<float>	position	{ -2500.0f, 2500.0f }; // some outside the root
+				std::uniform_real_distribution<float>	radius		{ 0.5f, 10.0f };
+
+				for (uint32_t I = 0; I < entityCount; ++I)
+				{
+					const FlexKit::BoundingSphere sphere{ position(generator), position(generator) / 10.0f, position(generator), (I % 500) ? radius(generator) : 800.0f };
+
+					spheres.push_back(sphere);
+					entries.push_back(octree.Insert(sphere, I));
+				}
+			}
+
+			FlexKit::LooseOctree					octree;
+			FlexKit::Vector<FlexKit::BoundingSphere>	spheres;
+			FlexKit::Vector<uint32_t>				entries;
+		};
+
+
+		static bool MatchesBruteForce(TestScene& scene, const FlexKit::Frustum& frustum, const FlexKit::Vector<bool>& live)
+		{
+			FlexKit::Vector<uint32_t> hits{ FlexKit::SystemAllocator, entityCount, 0u };
+
+			scene.octree.Query(frustum, [&](const uint32_t value, const FlexKit::BoundingSphere&) { hits[value]++; });
+
+			for (uint32_t I = 0; I < entityCount; ++I)
+			{
+				const uint32_t expected = (live[I] && FlexKit::Intersects(frustum, scene.spheres[I])) ? 1 : 0;
+
+				if (hits[I] != expected)
+					return false;
+			}
+
+			return true;
+		}
+
+
+		// Scene spheres split into x/y/z/r arrays, padded out to a multiple of 64
+		struct PackedSpheres
+		{
+			PackedSpheres(const FlexKit::Vector<FlexKit::BoundingSphere>& spheres) :
+				count	{ spheres.size() },
+				x		{ FlexKit::SystemAllocator, (spheres.size() + 63) / 64 * 64, 0.0f },
+				y		{ FlexKit::SystemAllocator, (spheres.size() + 63) / 64 * 64, 0.0f },
+				z		{ FlexKit::SystemAllocator, (spheres.size() + 63) / 64 * 64, 0.0f },
+				r		{ FlexKit::SystemAllocator, (spheres.size() + 63) / 64 * 64, 0.0f }
+			{
+				for (size_t I = 0; I < count; ++I)
+				{
+					x[I] = spheres[I].x;
+					y[I] = spheres[I].y;
+					z[I] = spheres[I].z;
+					r[I] = spheres[I].w;
+				}
+			}
+
+			size_t					count;
+			FlexKit::Vector<float>	x, y, z, r;
+		};
+
+
+		TEST_METHOD(LooseOctree_QueryMatchesBruteForce)
+		{
+			TestScene scene;
+
+			FlexKit::Vector<bool> live{ FlexKit::SystemAllocator, entityCount, true };
+
+			const auto small	= BoxFrustum({ -100, -50, -100 }, { 100, 50, 100 });
+			const auto large	= BoxFrustum({ -3000, -3000, -3000 }, { 3000, 3000, 3000 });
+			const auto offset	= BoxFrustum({ 1500, -100, -2600 }, { 2600, 100, -1200 });
+
+			Assert::IsTrue(MatchesBruteForce(scene, small, live),	L"Octree query diverged!\n");
+			Assert::IsTrue(MatchesBruteForce(scene, large, live),	L"Octree query diverged!\n");
+			Assert::IsTrue(MatchesBruteForce(scene, offset, live),	L"Octree query diverged!\n");
+
+			// Move, remove and re-add entries, then check again
+			std::default_random_engine				generator	{ 4321 };
+			std::uniform_real_distribution<float>	step		{ -50.0f, 50.0f };
+
+			for (size_t pass = 0; pass < 4; ++pass)
+			{
+				for (uint32_t I = 0; I < entityCount; ++I)
+				{
+					if (!live[I])
+					{
+						scene.entries[I]	= scene.octree.Insert(scene.spheres[I], I);
+						live[I]				= true;
+					}
+					else if (I % 7 == pass)
+					{
+						scene.octree.Remove(scene.entries[I]);
+						live[I] = false;
+					}
+					else if (I % 3 == 0)
+					{
+						auto& sphere = scene.spheres[I];
+						sphere.x += step(generator);
+						sphere.z += step(generator) * 10.0f;
+
+						scene.octree.Move(scene.entries[I], sphere);
+					}
+				}
+
+				Assert::IsTrue(MatchesBruteForce(scene, small, live),	L"Octree query diverged after updates!\n");
+				Assert::IsTrue(MatchesBruteForce(scene, offset, live),	L"Octree query diverged after updates!\n");
+			}
+		}
+
+
+		TEST_METHOD(LooseOctree_CellQueryCullsToBruteForce)
+		{
+			TestScene		scene;
+			PackedSpheres	packed{ scene.spheres };
+
+			FlexKit::Vector<uint32_t> hits{ FlexKit::SystemAllocator, entityCount, 0u };
+
+			const FlexKit::Frustum frustums[] = {
+				BoxFrustum({ -100, -50, -100 }, { 100, 50, 100 }),
+				BoxFrustum({ -3000, -3000, -3000 }, { 3000, 3000, 3000 }),
+				BoxFrustum({ 1500, -100, -2600 }, { 2600, 100, -1200 }) };
+
+			for (const auto& frustum : frustums)
+			{
+				const auto planes = FlexKit::GetCullingPlanes(frustum);
+
+				bool chunksInRange = true;
+
+				// Same shape as the scene's fine pass, inside cells are taken whole and the rest tested 8 wide
+				scene.octree.QueryCells(frustum,
+					[&](const uint32_t* values, const size_t count, const bool fullyInside)
+					{
+						chunksInRange &= count > 0 && count <= 64;
+
+						uint64_t visible = count == 64 ? ~uint64_t(0) : (uint64_t(1) << count) - 1;
+
+						if (!fullyInside)
+						{
+							float x[64], y[64], z[64], r[64];
+
+							for (size_t I = 0; I < count; ++I)
+							{
+								x[I] = packed.x[values[I]];
+								y[I] = packed.y[values[I]];
+								z[I] = packed.z[values[I]];
+								r[I] = packed.r[values[I]];
+							}
+
+							FlexKit::CullSpheres(planes, x, y, z, r, count, &visible);
+						}
+
+						for (size_t I = 0; I < count; ++I)
+							hits[values[I]] += (visible >> I) & 1;
+					});
+
+				bool matches = true;
+				for (uint32_t I = 0; I < entityCount; ++I)
+				{
+					matches &= hits[I] == (FlexKit::Intersects(frustum, scene.spheres[I]) ? 1u : 0u);
+					hits[I]  = 0;
+				}
+
+				Assert::IsTrue(chunksInRange,	L"Cell chunk out of range!\n");
+				Assert::IsTrue(matches,			L"Cell query cull diverged from brute force!\n");
+			}
+
+			size_t insideCells = 0;
+			scene.octree.QueryCells(frustums[1], [&](const uint32_t*, const size_t, const bool fullyInside) { insideCells += fullyInside; });
+
+			Assert::IsTrue(insideCells > 0, L"No cell reported fully inside an enclosing frustum!\n");
+		}
+
+
+		TEST_METHOD(LooseOctree_ShapeQueriesMatchBruteForce)
+		{
+			TestScene scene;
+
+			FlexKit::Vector<uint32_t> hits		{ FlexKit::SystemAllocator, entityCount, 0u };
+			FlexKit::Vector<uint32_t> gathered	{ FlexKit::SystemAllocator };
+
+			auto Matches = [&](auto test) -> bool
+			{
+				for (uint32_t I = 0; I < entityCount; ++I)
+				{
+					if (hits[I] != (test(scene.spheres[I]) ? 1u : 0u))
+						return false;
+
+					hits[I] = 0;
+				}
+
+				return true;
+			};
+
+			const FlexKit::BoundingSphere spheres[] = {
+				{ 0, 0, 0, 150 },
+				{ 1800, 20, -2200, 600 },
+				{ 0, 0, 0, 10000 },	// holds every cell
+				{ 2400, 0, 2400, 50 } };
+
+			for (const auto& querySphere : spheres)
+			{
+				scene.octree.Query(querySphere, [&](const uint32_t value, const FlexKit::BoundingSphere&) { hits[value]++; });
+				Assert::IsTrue(Matches([&](auto& sphere) { return FlexKit::Intersects(querySphere, sphere); }), L"Sphere query diverged!\n");
+			}
+
+			FlexKit::AABB boxes[3];
+			boxes[0].min = { -200, -20, -200 };		boxes[0].max = { 200, 20, 200 };
+			boxes[1].min = { 1000, -250, -2600 };	boxes[1].max = { 2600, 250, -900 };
+			boxes[2].min = { -3000, -3000, -3000 };	boxes[2].max = { 3000, 3000, 3000 };
+
+			for (const auto& box : boxes)
+			{
+				scene.octree.Query(box, [&](const uint32_t value, const FlexKit::BoundingSphere&) { hits[value]++; });
+				Assert::IsTrue(Matches([&](auto& sphere) { return FlexKit::Intersects(box, sphere); }), L"AABB query diverged!\n");
+			}
+
+			const FlexKit::Ray rays[] = {
+				{ { -2600, 0, 0 },		{ 1, 0, 0 } },
+				{ { 0, 100, 0 },		{ 0.3f, -0.1f, 0.7f } },
+				{ { 2000, 10, -2000 },	{ -1, 0, 1 } } };
+
+			for (const auto& ray : rays)
+			{
+				const float maxDistance = 3000.0f;
+
+				scene.octree.Query(ray, maxDistance,
+					[&](const uint32_t value, const FlexKit::BoundingSphere&, const float distance)
+					{
+						hits[value]++;
+						Assert::IsTrue(distance <= maxDistance, L"Ray hit past its max distance!\n");
+					});
+
+				Assert::IsTrue(Matches(
+					[&](auto& sphere)
+					{
+						float distance;
+						return FlexKit::Intersects(ray, sphere, distance) && distance <= maxDistance;
+					}), L"Ray query diverged!\n");
+			}
+
+			// Gather appends the same set the visitor sees
+			const size_t count = scene.octree.Gather(spheres[0], gathered);
+
+			for (auto value : gathered)
+				hits[value]++;
+
+			Assert::IsTrue(count == gathered.size(), L"Gather miscounted!\n");
+			Assert::IsTrue(Matches([&](auto& sphere) { return FlexKit::Intersects(spheres[0], sphere); }), L"Gather diverged!\n");
+		}
+
+
+		TEST_METHOD(CullingKernel_MatchesPerSphereTest)
+		{
+			TestScene		scene;
+			PackedSpheres	packed{ scene.spheres };
+
+			const FlexKit::Frustum frustums[] = {
+				BoxFrustum({ -100, -50, -100 }, { 100, 50, 100 }),
+				BoxFrustum({ -3000, -3000, -3000 }, { 3000, 3000, 3000 }),
+				BoxFrustum({ 1500, -100, -2600 }, { 2600, 100, -1200 }) };
+
+			using KernelFN = void (*)(const FlexKit::CullingPlanes&, const float*, const float*, const float*, const float*, const size_t, uint64_t*) noexcept;
+
+			FlexKit::Vector<KernelFN> kernels{ FlexKit::SystemAllocator };
+			kernels.push_back(FlexKit::CullSpheres_Scalar);
+
+			if (FlexKit::CPUSupportsAVX2())
+				kernels.push_back(FlexKit::CullSpheres_AVX2);
+			else
+				Logger::WriteMessage("AVX2 not supported, only testing the scalar kernel\n");
+
+			for (auto& frustum : frustums)
+			{
+				const auto planes = FlexKit::GetCullingPlanes(frustum);
+
+				for (auto kernel : kernels)
+				{
+					FlexKit::Vector<uint64_t> bits{ FlexKit::SystemAllocator, packed.x.size() / 64, ~0ull };
+
+					// Whole range in one call, and again in uneven pieces as workers would split it
+					for (const size_t split : { entityCount, size_t(64 * 37) })
+					{
+						for (size_t begin = 0; begin < entityCount; begin += split)
+						{
+							const size_t count = std::min(split, entityCount - begin);
+							kernel(planes, &packed.x[begin], &packed.y[begin], &packed.z[begin], &packed.r[begin], count, &bits[begin / 64]);
+						}
+
+						for (size_t I = 0; I < entityCount; ++I)
+						{
+							const bool visible = (bits[I / 64] >> (I % 64)) & 1;
+							Assert::IsTrue(visible == FlexKit::Intersects(frustum, scene.spheres[I]), L"Batched culling diverged!\n");
+						}
+
+						const size_t tail = entityCount % 64;
+						Assert::IsTrue((bits.back() >> tail) == 0, L"Padding lanes marked visible!\n");
+					}
+				}
+			}
+		}
+
+
+		TEST_METHOD(LooseOctree_CullingBenchmark)
+		{
+			TestScene		scene;
+			PackedSpheres	packed{ scene.spheres };
+
+			FlexKit::Vector<uint64_t> bits{ FlexKit::SystemAllocator, packed.x.size() / 64, 0ull };
+
+			const size_t passCount = 100;
+
+			auto Report = [&](const char* label, size_t visible, std::chrono::duration<double, std::milli> duration)
+			{
+				std::stringstream SS;
+				SS << label << " : " << duration.count() / passCount << "ms per query, " << visible << " visible of " << entityCount << "\n";
+				Logger::WriteMessage(SS.str().c_str());
+			};
+
+			for (const float span : { 50.0f, 250.0f, 1000.0f })
+			{
+				const auto frustum = BoxFrustum({ -span, -span, -span }, { span, span, span });
+
+				size_t visible = 0;
+				{
+					const auto begin = std::chrono::high_resolution_clock::now();
+
+					for (size_t pass = 0; pass < passCount; ++pass)
+					{
+						visible = 0;
+						for (auto& sphere : scene.spheres)
+							visible += FlexKit::Intersects(frustum, sphere) ? 1 : 0;
+					}
+
+					Report("Brute force", visible, std::chrono::high_resolution_clock::now() - begin);
+				}
+
+				{
+					const auto begin = std::chrono::high_resolution_clock::now();
+
+					for (size_t pass = 0; pass < passCount; ++pass)
+					{
+						visible = 0;
+						scene.octree.Query(frustum, [&](auto, auto&) { visible++; });
+					}
+
+					Report("Loose octree", visible, std::chrono::high_resolution_clock::now() - begin);
+				}
+
+				{
+					const auto planes = FlexKit::GetCullingPlanes(frustum);
+					const auto begin = std::chrono::high_resolution_clock::now();
+
+					for (size_t pass = 0; pass < passCount; ++pass)
+					{
+						FlexKit::CullSpheres(planes, packed.x.begin(), packed.y.begin(), packed.z.begin(), packed.r.begin(), packed.count, bits.begin());
+
+						visible = 0;
+						for (auto word : bits)
+						{
+							for (; word; word &= word - 1)
+								visible++;
+						}
+					}
+
+					Report("Batched SoA", visible, std::chrono::high_resolution_clock::now() - begin);
+				}
+			}
+
+			// Incremental update cost, a tenth of the scene moves every frame
+			{
+				std::default_random_engine				generator	{ 4321 };
+				std::uniform_real_distribution<float>	step		{ -1.0f, 1.0f };
+
+				const auto begin = std::chrono::high_resolution_clock::now();
+
+				for (size_t pass = 0; pass < passCount; ++pass)
+				{
+					for (uint32_t I = pass % 10; I < entityCount; I += 10)
+					{
+						auto& sphere = scene.spheres[I];
+						sphere.x += step(generator);
+						sphere.z += step(generator);
+
+						scene.octree.Move(scene.entries[I], sphere);
+					}
+				}
+
+				std::stringstream SS;
+				SS << "Moving " << entityCount / 10 << " entries : " << std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - begin).count() / passCount << "ms per frame\n";
+				Logger::WriteMessage(SS.str().c_str());
+			}
+		}
+	};
+
+
+	TEST_CLASS(TransformUnitTests)
+	{
+	public:
+		static const size_t nodeCount = 32000;
+
+
+		static FlexKit::Vector<FlexKit::NodeHandle> BuildTestHierarchy()
+		{
+			FlexKit::InitiateSceneNodeBuffer(FlexKit::SystemAllocator);
+
+			FlexKit::Vector<FlexKit::NodeHandle> handles{ FlexKit::SystemAllocator };
+			handles.reserve(nodeCount);
+			handles.push_back(FlexKit::GetZeroedNode()); // root
+
+			std::default_random_engine				generator{ 1234 };
+			std::uniform_real_distribution<float>	offset{ -10.0f, 10.0f };
+
+			for (size_t I = 1; I < nodeCount; ++I)
+			{
+				// Mostly shallow, wide trees with the occasional deep chain
+				const size_t parent = (I % 16 == 0) ? I - 1 : generator() % I;
+
+				auto node = FlexKit::GetZeroedNode();
+				FlexKit::SetParentNode(handles[parent], node);
+				FlexKit::SetPositionL(node, { offset(generator), offset(generator), offset(generator) });
+
+				handles.push_back(node);
+			}
+
+			return handles;
+		}
+
+
+		static void MarkAllDirty(FlexKit::Vector<FlexKit::NodeHandle>& handles)
+		{
+			for (auto handle : handles)
+				FlexKit::SetFlag(handle, FlexKit::SceneNodes::DIRTY);
+		}
+
+
+		// The layered path runs through the batched kernel, which rounds differently to DirectXMath
+		static bool NearlyEqual(const FlexKit::float4x4& lhs, const FlexKit::float4x4& rhs, const float epsilon = 1e-4f)
+		{
+			for (size_t row = 0; row < 4; ++row)
+				for (size_t column = 0; column < 4; ++column)
+					if (std::abs(lhs[row][column] - rhs[row][column]) > epsilon * std::max(1.0f, std::abs(rhs[row][column])))
+						return false;
+
+			return true;
+		}
+
+
+		TEST_METHOD(TransformUpdate_ParallelMatchesSerial)
+		{
+			FlexKit::StackAllocator	temp	{ FlexKit::SystemAllocator, 64 * MEGABYTE };
+			FlexKit::ThreadManager	threads	{ 4 };
+
+			auto handles = BuildTestHierarchy();
+
+			FlexKit::UpdateTransforms();
+
+			FlexKit::Vector<FlexKit::float4x4> serialResults{ FlexKit::SystemAllocator, nodeCount };
+			for (auto handle : handles)
+				serialResults.push_back(FlexKit::GetWT(handle));
+
+			MarkAllDirty(handles);
+			FlexKit::UpdateTransforms(threads, temp);
+
+			for (size_t I = 0; I < handles.size(); ++I)
+			{
+				const auto WT = FlexKit::GetWT(handles[I]);
+				Assert::IsTrue(NearlyEqual(WT, serialResults[I]), L"Parallel transform update diverged!\n");
+			}
+
+			temp.clear();
+
+			// Nothing changed, nothing should be touched
+			auto cleanLayers = FlexKit::BuildTransformUpdateLayers(temp);
+			Assert::IsTrue(cleanLayers.nodes.size() == 0, L"Clean nodes were scheduled for update!\n");
+
+			// Only the moved subtree should be touched
+			FlexKit::TranslateLocal(handles[1], { 1, 0, 0 });
+
+			size_t subtreeSize = 0;
+			for (size_t I = 1; I < handles.size(); ++I)
+			{
+				for (auto node = handles[I]; node != handles[0]; node = FlexKit::GetParentNode(node))
+				{
+					if (node == handles[1])
+					{
+						subtreeSize++;
+						break;
+					}
+				}
+			}
+
+			auto dirtyLayers = FlexKit::BuildTransformUpdateLayers(temp);
+			Assert::IsTrue(dirtyLayers.nodes.size() == subtreeSize, L"Dirty subtree size mismatch!\n");
+
+			threads.Release();
+			FlexKit::ReleaseSceneNodeBuffer();
+		}
+
+
+		TEST_METHOD(TransformUpdate_ScalingBenchmark)
+		{
+			FlexKit::StackAllocator	temp{ FlexKit::SystemAllocator, 64 * MEGABYTE };
+
+			auto handles = BuildTestHierarchy();
+
+			const size_t passCount	= 50;
+			const auto	 maxWorkers	= std::min<uint32_t>(std::thread::hardware_concurrency(), MAXTHREADCOUNT);
+
+			auto Report = [&](const char* label, uint32_t workerCount, std::chrono::duration<double, std::milli> duration)
+			{
+				const double nodesPerMS = double(nodeCount * passCount) / duration.count();
+
+				std::stringstream SS;
+				SS << label << " workers: " << workerCount << " : " << nodesPerMS << " nodes/ms\n";
+				Logger::WriteMessage(SS.str().c_str());
+			};
+
+			{
+				const auto begin = std::chrono::high_resolution_clock::now();
+
+				for (size_t I = 0; I < passCount; ++I)
+				{
+					MarkAllDirty(handles);
+					FlexKit::UpdateTransforms();
+				}
+
+				Report("Serial", 0, std::chrono::high_resolution_clock::now() - begin);
+			}
+
+			for (uint32_t workerCount = 1; workerCount <= maxWorkers; ++workerCount)
+			{
+				FlexKit::ThreadManager threads{ workerCount };
+
+				const auto begin = std::chrono::high_resolution_clock::now();
+
+				for (size_t I = 0; I < passCount; ++I)
+				{
+					MarkAllDirty(handles);
+					FlexKit::UpdateTransforms(threads, temp);
+					temp.clear();
+				}
+
+				Report("Layered", workerCount, std::chrono::high_resolution_clock::now() - begin);
+
+				threads.Release();
+			}
+
+			FlexKit::ReleaseSceneNodeBuffer();
+		}
+
+
+		TEST_METHOD(TransformKernel_BatchedMatchesPerNode)
+		{
+			// One flat layer under a rotated, scaled parent so every term of the kernel is exercised. The
+			// parent can't be the root, its world transform is forced to identity.
+			const size_t layerSize = 4099; // leaves a tail for the per node path
+
+			FlexKit::InitiateSceneNodeBuffer(FlexKit::SystemAllocator);
+
+			std::default_random_engine				generator	{ 4321 };
+			std::uniform_real_distribution<float>	offset		{ -10.0f, 10.0f };
+			std::uniform_real_distribution<float>	angle		{ -180.0f, 180.0f };
+			std::uniform_real_distribution<float>	scale		{ 0.5f, 2.0f };
+
+			auto root	= FlexKit::GetZeroedNode();
+			auto pivot	= FlexKit::GetZeroedNode();
+			FlexKit::SetParentNode(root, pivot);
+			FlexKit::SetPositionL(pivot, { 1, 2, 3 });
+			FlexKit::Quaternion pivotOrientation(30.0f, 45.0f, 0.0f);
+			FlexKit::SetOrientationL(pivot, pivotOrientation);
+			FlexKit::SetScale(pivot, { 1.5f, 0.75f, 2.0f });
+
+			FlexKit::Vector<FlexKit::NodeHandle> handles{ FlexKit::SystemAllocator, layerSize };
+			for (size_t I = 0; I < layerSize; ++I)
+			{
+				auto node = FlexKit::GetZeroedNode();
+				FlexKit::SetParentNode(pivot, node);
+				FlexKit::SetPositionL(node, { offset(generator), offset(generator), offset(generator) });
+				FlexKit::Quaternion orientation(angle(generator), angle(generator), angle(generator));
+				FlexKit::SetOrientationL(node, orientation);
+
+				if (I % 2)
+					FlexKit::SetScale(node, { scale(generator), scale(generator), scale(generator) });
+
+				handles.push_back(node);
+			}
+
+			FlexKit::UpdateTransforms();
+
+			Assert::IsTrue(!NearlyEqual(FlexKit::GetWT(pivot), FlexKit::GetWT(root)), L"Parent transform is identity, the parent multiply goes untested!\n");
+
+			FlexKit::Vector<uint32_t>			nodes			{ FlexKit::SystemAllocator, layerSize };
+			FlexKit::Vector<FlexKit::float4x4>	perNodeResults	{ FlexKit::SystemAllocator, layerSize };
+
+			for (auto handle : handles)
+			{
+				nodes.push_back(FlexKit::_SNHandleToIndex(handle));
+				perNodeResults.push_back(FlexKit::GetWT(handle));
+			}
+
+			FlexKit::_UpdateNodeWTs(nodes.begin(), nodes.size());
+
+			for (size_t I = 0; I < handles.size(); ++I)
+				Assert::IsTrue(NearlyEqual(FlexKit::GetWT(handles[I]), perNodeResults[I]), L"Batched transform kernel diverged!\n");
+
+			// Both kernels must agree with each other regardless of which one the dispatch picks
+			if (FlexKit::CPUSupportsAVX2())
+			{
+				FlexKit::TRSBlock		local;
+				FlexKit::MatrixBlock	parent;
+				FlexKit::MatrixBlock	scalarOut;
+				FlexKit::MatrixBlock	avx2Out;
+
+				for (size_t lane = 0; lane < FlexKit::TransformBlockWidth; ++lane)
+				{
+					const FlexKit::Quaternion q(angle(generator), angle(generator), angle(generator));
+
+					for (size_t I = 0; I < 3; ++I)
+					{
+						local.T[I][lane] = offset(generator);
+						local.S[I][lane] = scale(generator);
+					}
+
+					local.R[0][lane] = q.x;
+					local.R[1][lane] = q.y;
+					local.R[2][lane] = q.z;
+					local.R[3][lane] = q.w;
+
+					for (size_t I = 0; I < 16; ++I)
+						parent.m[I][lane] = offset(generator);
+				}
+
+				FlexKit::TRSBlockToWorld_Scalar(local, parent, scalarOut);
+				FlexKit::TRSBlockToWorld_AVX2(local, parent, avx2Out);
+
+				for (size_t I = 0; I < 16; ++I)
+					for (size_t lane = 0; lane < FlexKit::TransformBlockWidth; ++lane)
+						Assert::IsTrue(std::abs(scalarOut.m[I][lane] - avx2Out.m[I][lane]) < 1e-3f, L"AVX2 kernel diverged from scalar kernel!\n");
+			}
+
+			FlexKit::ReleaseSceneNodeBuffer();
+		}
+
+
+		TEST_METHOD(TransformKernel_Benchmark)
+		{
+			const size_t layerSize	= 1024 * 64;
+			const size_t passCount	= 50;
+
+			FlexKit::InitiateSceneNodeBuffer(FlexKit::SystemAllocator);
+
+			auto root = FlexKit::GetZeroedNode();
+
+			FlexKit::Vector<uint32_t> nodes{ FlexKit::SystemAllocator, layerSize };
+			for (size_t I = 0; I < layerSize; ++I)
+			{
+				auto node = FlexKit::GetZeroedNode();
+				FlexKit::SetParentNode(root, node);
+				FlexKit::SetPositionL(node, { float(I % 7), float(I % 5), float(I % 3) });
+				FlexKit::Quaternion orientation(float(I % 90), 0.0f, 0.0f);
+				FlexKit::SetOrientationL(node, orientation);
+
+				nodes.push_back(FlexKit::_SNHandleToIndex(node));
+			}
+
+			auto Report = [&](const char* label, std::chrono::duration<double, std::milli> duration)
+			{
+				const double nodesPerMS = double(layerSize * passCount) / duration.count();
+
+				std::stringstream SS;
+				SS << label << " : " << nodesPerMS << " nodes/ms\n";
+				Logger::WriteMessage(SS.str().c_str());
+			};
+
+			{
+				const auto begin = std::chrono::high_resolution_clock::now();
+
+				for (size_t I = 0; I < passCount; ++I)
+					for (auto node : nodes)
+						FlexKit::_UpdateNodeWT(node);
+
+				Report("Per node", std::chrono::high_resolution_clock::now() - begin);
+			}
+
+			{
+				const auto begin = std::chrono::high_resolution_clock::now();
+
+				for (size_t I = 0; I < passCount; ++I)
+					FlexKit::_UpdateNodeWTs(nodes.begin(), nodes.size());
+
+				Report(FlexKit::CPUSupportsAVX2() ? "Batched AVX2" : "Batched scalar", std::chrono::high_resolution_clock::now() - begin);
+			}
+
+			FlexKit::ReleaseSceneNodeBuffer();
+		}
+
+
+		TEST_METHOD(SceneNodes_GrowAndCompact)
+		{
+			// Grows well past the old 16-bit ceiling, one page at a time
+			const size_t largeNodeCount = 70000;
+
+			FlexKit::InitiateSceneNodeBuffer(FlexKit::SystemAllocator);
+
+			FlexKit::Vector<FlexKit::NodeHandle> handles{ FlexKit::SystemAllocator, largeNodeCount };
+			handles.push_back(FlexKit::GetZeroedNode());
+
+			for (size_t I = 1; I < largeNodeCount; ++I)
+			{
+				auto node = FlexKit::GetZeroedNode();
+				FlexKit::SetParentNode(handles[(I - 1) / 4], node);
+				FlexKit::SetPositionL(node, { float(I % 7), float(I % 5), float(I % 3) });
+
+				handles.push_back(node);
+			}
+
+			FlexKit::UpdateTransforms();
+
+			// Release leaf nodes only, every third one
+			FlexKit::Vector<FlexKit::NodeHandle>	liveHandles	{ FlexKit::SystemAllocator, largeNodeCount };
+			FlexKit::Vector<FlexKit::float4x4>		liveWT		{ FlexKit::SystemAllocator, largeNodeCount };
+
+			for (size_t I = 0; I < largeNodeCount; ++I)
+			{
+				const bool leaf = (I * 4 + 1) >= largeNodeCount;
+
+				if (leaf && I % 3 == 0)
+					FlexKit::ReleaseNode(handles[I]);
+				else
+				{
+					liveHandles.push_back(handles[I]);
+					liveWT.push_back(FlexKit::GetWT(handles[I]));
+				}
+			}
+
+			while (FlexKit::CompactNodes(FlexKit::TransformCompactionBudget));
+
+			Assert::IsTrue(FlexKit::SceneNodeTable.used == liveHandles.size(), L"Compaction left holes in the node table!\n");
+
+			for (size_t I = 0; I < liveHandles.size(); ++I)
+			{
+				const auto handle		= liveHandles[I];
+				const auto nodeIndex	= FlexKit::_SNHandleToIndex(handle);
+				const auto parent		= FlexKit::GetParentNode(handle);
+
+				Assert::IsTrue(FlexKit::SceneNodeTable.Nodes[nodeIndex].TH == handle, L"Handle points at the wrong node!\n");
+
+				if (I > 0)
+					Assert::IsTrue(FlexKit::_SNHandleToIndex(parent) < nodeIndex, L"Child moved in front of its parent!\n");
+
+				const auto WT = FlexKit::GetWT(handle);
+				for (size_t row = 0; row < 4; ++row)
+					for (size_t column = 0; column < 4; ++column)
+						Assert::IsTrue(WT[row][column] == liveWT[I][row][column], L"Node data was not moved with its handle!\n");
+			}
+
+			FlexKit::ReleaseSceneNodeBuffer();
+		}
+
+
+		TEST_METHOD(SceneNodes_ReleaseReparentsChildren)
+		{
+			FlexKit::InitiateSceneNodeBuffer(FlexKit::SystemAllocator);
+
+			auto root		= FlexKit::GetZeroedNode();
+			auto parent		= FlexKit::GetZeroedNode();
+			auto released	= FlexKit::GetZeroedNode();
+			auto child		= FlexKit::GetZeroedNode();
+
+			FlexKit::SetParentNode(root,		parent);
+			FlexKit::SetParentNode(parent,		released);
+			FlexKit::SetParentNode(released,	child);
+
+			FlexKit::SetPositionL(parent,	{ 1, 0, 0 });
+			FlexKit::SetPositionL(released,	{ 0, 2, 0 });
+			FlexKit::SetPositionL(child,	{ 0, 0, 3 });
+
+			FlexKit::UpdateTransforms();
+			FlexKit::ReleaseNode(released);
+
+			// Recycles the released handle, the child must not pick it up as its parent
+			auto stranger = FlexKit::GetZeroedNode();
+			FlexKit::SetParentNode(root, stranger);
+			FlexKit::SetPositionL(stranger, { 100, 100, 100 });
+
+			FlexKit::UpdateTransforms();
+
+			const auto position = FlexKit::GetPositionW(child);
+
+			Assert::IsTrue(FlexKit::GetParentNode(child) == parent,				L"Child not moved up to its grandparent!\n");
+			Assert::IsTrue(position.x == 1 && position.y == 0 && position.z == 3,	L"Child world transform not rebuilt from its new parent!\n");
+
+			FlexKit::ReleaseSceneNodeBuffer();
+		}
+
+
+		TEST_METHOD(SceneNodes_UpdatedNodesListsChangedSubtree)
+		{
+			FlexKit::InitiateSceneNodeBuffer(FlexKit::SystemAllocator);
+
+			auto root		= FlexKit::GetZeroedNode();
+			auto moved		= FlexKit::GetZeroedNode();
+			auto child		= FlexKit::GetZeroedNode();
+			auto untouched	= FlexKit::GetZeroedNode();
+
+			FlexKit::SetParentNode(root,	moved);
+			FlexKit::SetParentNode(moved,	child);
+			FlexKit::SetParentNode(root,	untouched);
+
+			FlexKit::UpdateTransforms();
+
+			const auto updateCount = FlexKit::GetTransformUpdateCount();
+
+			FlexKit::SetPositionL(moved, { 1, 2, 3 });
+			FlexKit::UpdateTransforms();
+
+			auto& updated	= FlexKit::GetUpdatedNodes();
+			auto Listed		= [&](FlexKit::NodeHandle node)
+			{
+				return std::find(updated.begin(), updated.end(), node) != updated.end();
+			};
+
+			Assert::IsTrue(FlexKit::GetTransformUpdateCount() == updateCount + 1,	L"Transform update not counted!\n");
+			Assert::IsTrue(updated.size() == 2,										L"Unexpected number of updated nodes!\n");
+			Assert::IsTrue(Listed(moved) && Listed(child),							L"Moved node or its child missing from the updated list!\n");
+			Assert::IsTrue(!Listed(untouched),										L"Unchanged node listed as updated!\n");
+
+			FlexKit::UpdateTransforms();
+
+			Assert::IsTrue(FlexKit::GetUpdatedNodes().size() == 0, L"Updated list not cleared by the next update!\n");
+
+			FlexKit::ReleaseSceneNodeBuffer();
+		}
+	};
+
+
+	TEST_CLASS(HandleTableUnitTests)
+	{
+	public:
+		using TestHandle = FlexKit::Handle_t<32, GetTypeGUID(HandleTableUnitTests)>;
+
+		TEST_METHOD(HandleTable_StaleHandlesRejected)
+		{
+			FlexKit::HandleUtilities::HandleTable<TestHandle> table{ FlexKit::SystemAllocator };
+
+			const size_t handleCount = 1024;
+
+			FlexKit::Vector<TestHandle> handles{ FlexKit::SystemAllocator, handleCount };
+
+			for (size_t I = 0; I < handleCount; ++I)
+			{
+				auto handle		= table.GetNewHandle();
+				table[handle]	= FlexKit::index_t(I);
+
+				handles.push_back(handle);
+			}
+
+			// Release every other handle and hand the slots straight back out
+			FlexKit::Vector<TestHandle> reissued{ FlexKit::SystemAllocator, handleCount };
+
+			for (size_t I = 0; I < handleCount; I += 2)
+				table.RemoveHandle(handles[I]);
+
+			for (size_t I = 0; I < handleCount; I += 2)
+			{
+				auto handle		= table.GetNewHandle();
+				table[handle]	= FlexKit::index_t(handleCount + I);
+
+				reissued.push_back(handle);
+			}
+
+			Assert::IsTrue(table.size() == handleCount, L"Free slots were not reused!\n");
+
+			for (size_t I = 0; I < handleCount; ++I)
+			{
+				FlexKit::index_t idx;
+
+				if (I % 2)
+					Assert::IsTrue(table.TryGet(handles[I], idx) && idx == I,	L"Live handle lost its index!\n");
+				else
+					Assert::IsTrue(!table.Has(handles[I]),						L"Stale handle aliased a new one!\n");
+			}
+
+			for (auto handle : reissued)
+				Assert::IsTrue(table.Has(handle) && table[handle] >= handleCount, L"Reissued handle is not valid!\n");
+
+			// Releasing the tail lets compaction shrink the table, old handles into it stay invalid
+			for (size_t I = 0; I < reissued.size() / 2; ++I)
+				table.RemoveHandle(reissued[I]);
+
+			for (size_t I = 1; I < handleCount; I += 2)
+				table.RemoveHandle(handles[I]);
+
+			table.Compact();
+
+			Assert::IsTrue(table.size() < handleCount, L"Compaction did not trim free slots!\n");
+
+			for (size_t I = 0; I < reissued.size() / 2; ++I)
+				Assert::IsTrue(!table.Has(reissued[I]), L"Handle into a trimmed slot is still valid!\n");
+
+			for (size_t I = 0; I < handleCount; ++I)
+			{
+				auto handle = table.GetNewHandle();
+
+				Assert::IsTrue(table.Has(handle), L"New handle is not valid!\n");
+
+				for (auto& old : handles)
+					Assert::IsTrue(old != handle, L"New handle matches a released one!\n");
+			}
+
+			table.Release();
+		}
+	};
+
+	/************************************************************************************************/
+
+
+	TEST_CLASS(DrawBatchingUnitTests)
+	{
+	public:
+		TEST_METHOD(DrawBatching_CollapsesRepeatedDraws)
+		{
+			FlexKit::InitiateSceneNodeBuffer(FlexKit::SystemAllocator);
+
+			static const size_t meshCount		= 4;
+			static const size_t materialCount	= 3;
+			static const size_t drawCount		= 2000;
+
+			std::default_random_engine				generator{ 1234 };
+			std::uniform_real_distribution<float>	offset{ -100.0f, 100.0f };
+
+			FlexKit::Vector<FlexKit::Drawable>	drawables	{ FlexKit::SystemAllocator };
+			FlexKit::PVS						pvs			{ FlexKit::SystemAllocator };
+			drawables.reserve(drawCount);
+
+			for (size_t I = 0; I < drawCount; ++I)
+			{
+				FlexKit::Drawable drawable;
+				drawable.Node					= FlexKit::GetZeroedNode();
+				drawable.MeshHandle				= FlexKit::TriMeshHandle(size_t(generator() % meshCount));
+				drawable.MatProperties.roughness	= 0.25f * float(generator() % materialCount);
+				drawable.Skinned				= (I % 100) == 0;
+
+				FlexKit::SetPositionW(drawable.Node, { offset(generator), offset(generator), offset(generator) });
+
+				drawables.push_back(drawable);
+			}
+
+			FlexKit::UpdateTransforms();
+
+			for (auto& drawable : drawables)
+			{
+				const float distance = FlexKit::GetPositionW(drawable.Node).magnitude();
+				pvs.push_back(FlexKit::PVEntry{ drawable, pvs.size(), FlexKit::CreateDrawKey(drawable, distance) });
+			}
+
+			std::sort(pvs.begin(), pvs.end(), [](auto& lhs, auto& rhs) { return lhs.SortID < rhs.SortID; });
+
+			// Key orders by PSO, then material and mesh, and only then by depth
+			for (size_t I = 1; I < pvs.size(); ++I)
+			{
+				const auto lhs = pvs[I - 1].SortID;
+				const auto rhs = pvs[I].SortID;
+
+				if ((lhs & FlexKit::DrawKey::BatchMask) == (rhs & FlexKit::DrawKey::BatchMask))
+					Assert::IsTrue(FlexKit::DrawKey::GetDepth(lhs) <= FlexKit::DrawKey::GetDepth(rhs), L"Draws in a run are not front to back!\n");
+			}
+
+			const size_t maxInstances = 64;
+
+			FlexKit::DrawBatchList batches{ FlexKit::SystemAllocator };
+			FlexKit::BuildDrawBatches(pvs, batches, maxInstances);
+
+			Assert::IsTrue(batches.transforms.size() == pvs.size(), L"Every draw needs an instance transform!\n");
+
+			// Skinned draws stay single, everything else only splits on the instance limit
+			const size_t skinnedCount	= drawCount / 100;
+			const size_t maxBatches		= skinnedCount + meshCount * materialCount * (drawCount / maxInstances + 1);
+
+			Assert::IsTrue(batches.size() < maxBatches, L"Repeated draws were not collapsed!\n");
+
+			size_t instanceIdx = 0;
+			for (auto& batch : batches.batches)
+			{
+				Assert::IsTrue(batch.firstInstance == instanceIdx, L"Instance transforms are not packed!\n");
+				Assert::IsTrue(batch.instanceCount >= 1 && batch.instanceCount <= maxInstances, L"Bad instance count!\n");
+				Assert::IsTrue(!batch.drawable->Skinned || batch.instanceCount == 1, L"Skinned draw was instanced!\n");
+
+				for (size_t I = 0; I < batch.instanceCount; ++I)
+				{
+					const auto& entry = pvs[instanceIdx + I];
+
+					Assert::IsTrue(entry.D->MeshHandle == batch.drawable->MeshHandle, L"Batch mixes meshes!\n");
+					Assert::IsTrue(entry.D->MatProperties.roughness == batch.drawable->MatProperties.roughness, L"Batch mixes materials!\n");
+
+					const auto expected = FlexKit::GetWT(entry.D->Node).Transpose();
+					Assert::IsTrue(!memcmp(&batches.transforms[instanceIdx + I], &expected, sizeof(expected)), L"Instance transform does not match its draw!\n");
+				}
+
+				instanceIdx += batch.instanceCount;
+			}
+
+			std::stringstream SS;
+			SS << "Draws: " << pvs.size() << ", batches: " << batches.size() << "\n";
+			Logger::WriteMessage(SS.str().c_str());
+
+			batches.clear();
+			FlexKit::BuildDrawBatches(FlexKit::PVS{ FlexKit::SystemAllocator }, batches);
+
+			Assert::IsTrue(batches.size() == 0 && batches.transforms.size() == 0, L"Empty PVS produced batches!\n");
+		}
+	};
+
+	/************************************************************************************************/
+
+
+	TEST_CLASS(RadixSortUnitTests)
+	{
+	public:
+		// Keys shaped like draw keys, a few PSOs, materials and meshes over a full range of depths
+		static FlexKit::Vector<FlexKit::PVEntry> BuildEntries(const size_t count, const unsigned int seed)
+		{
+			std::default_random_engine generator{ seed };
+
+			FlexKit::Vector<FlexKit::PVEntry> entries{ FlexKit::SystemAllocator, count };
+
+			for (size_t I = 0; I < count; ++I)
+			{
+				FlexKit::PVEntry entry;
+				entry.SortID		= FlexKit::DrawKey::Create(0, generator() % 3, generator() % 64, generator() % 32, generator());
+				entry.OcclusionID	= I;
+				entry.D				= nullptr;
+
+				entries.push_back(entry);
+			}
+
+			return entries;
+		}
+
+
+		TEST_METHOD(RadixSort_MatchesStableSort)
+		{
+			auto GetSortID	= [](const FlexKit::PVEntry& entry) { return entry.SortID; };
+			auto Less		= [](const FlexKit::PVEntry& lhs, const FlexKit::PVEntry& rhs) { return lhs.SortID < rhs.SortID; };
+
+			for (const size_t count : { 0, 1, 2, 100, 5000, 70000 })
+			{
+				auto entries	= BuildEntries(count, 1234);
+				auto expected	= BuildEntries(count, 1234);
+
+				FlexKit::RadixSort(entries.begin(), entries.size(), GetSortID, FlexKit::SystemAllocator);
+				std::stable_sort(expected.begin(), expected.end(), Less);
+
+				for (size_t I = 0; I < count; ++I)
+				{
+					Assert::IsTrue(entries[I].SortID == expected[I].SortID, L"Radix sort order does not match!\n");
+					Assert::IsTrue(entries[I].OcclusionID == expected[I].OcclusionID, L"Radix sort is not stable!\n");
+				}
+			}
+
+			// Transparent keys come out back to front, DrawLast entries after the rest
+			FlexKit::Drawable drawLast;
+			FlexKit::Drawable drawable;
+			drawLast.DrawLast = true;
+
+			Assert::IsTrue(FlexKit::CreateTransparentDrawKey(drawable, 10.0f) < FlexKit::CreateTransparentDrawKey(drawable, 1.0f), L"Transparent key is not back to front!\n");
+			Assert::IsTrue(FlexKit::CreateTransparentDrawKey(drawable, 1.0f) < FlexKit::CreateTransparentDrawKey(drawLast, 10.0f), L"DrawLast key sorts before other entries!\n");
+		}
+
+
+		// GatherSceneParallel's fan in against a serial gather, PushPV into one PVS then SortPVS.
+		// Block counts cover odd runs left over in each merge round, and empty blocks repeat run boundaries.
+		TEST_METHOD(GatherMerge_ParallelMatchesSerial)
+		{
+			const size_t blockSize = 4096; // GatherSceneBlockSize
+
+			FlexKit::StackAllocator	temp	{ FlexKit::SystemAllocator, 64 * MEGABYTE };
+			FlexKit::ThreadManager	threads	{ 4 };
+
+			auto GetSortID	= [](const FlexKit::PVEntry& entry) { return entry.SortID; };
+			auto Less		= [](const FlexKit::PVEntry& lhs, const FlexKit::PVEntry& rhs) { return lhs.SortID < rhs.SortID; };
+
+			std::default_random_engine generator{ 1234 };
+
+			for (const size_t blockCount : { 2, 3, 5, 7, 8, 13 })
+			{
+				temp.clear();
+
+				const size_t base = blockCount; // entries already in the PVS before the gather
+
+				FlexKit::PVS					serial{ FlexKit::SystemAllocator };
+				FlexKit::Vector<FlexKit::PVS>	blocks{ temp, blockCount };
+
+				for (size_t I = 0; I < base; ++I)
+					serial.push_back(FlexKit::PVEntry{});
+
+				for (size_t I = 0; I < blockCount; ++I)
+				{
+					blocks.emplace_back(temp, blockSize);
+
+					// Every third block empty, the rest part or fully used
+					const size_t count = (I % 3 == 1) ? 0 : blockSize - (generator() % 2) * (generator() % blockSize);
+
+					for (size_t J = 0; J < count; ++J)
+					{
+						// Coarse depths so plenty of keys tie across blocks
+						FlexKit::PVEntry entry;
+						entry.SortID	= FlexKit::DrawKey::Create(0, generator() % 3, generator() % 16, generator() % 8, generator() % 32);
+						entry.D			= nullptr;
+
+						entry.OcclusionID = serial.size();
+						serial.push_back(entry);
+
+						entry.OcclusionID = blocks[I].size();
+						blocks[I].push_back(entry);
+					}
+
+					FlexKit::RadixSort(blocks[I].begin(), blocks[I].size(), GetSortID, FlexKit::SystemAllocator);
+				}
+
+				FlexKit::RadixSort(serial.begin() + base, serial.size() - base, GetSortID, FlexKit::SystemAllocator);
+
+				const size_t solidCount = serial.size() - base;
+
+				FlexKit::PVS parallel{ FlexKit::SystemAllocator, serial.size(), FlexKit::PVEntry{} };
+				FlexKit::Vector<FlexKit::PVEntry> scratch{ FlexKit::SystemAllocator, solidCount + 1, FlexKit::PVEntry{} };
+
+				FlexKit::MergeSortedBlocks(
+					threads, blockCount,
+					[&](const size_t I) -> FlexKit::PVS& { return blocks[I]; },
+					[&](FlexKit::PVEntry& entry, const size_t offset) { entry.OcclusionID += base + offset; },
+					Less,
+					parallel.begin() + base, scratch.begin(), temp);
+
+				bool matches = true;
+				for (size_t I = base; I < serial.size(); ++I)
+					matches &= parallel[I].SortID == serial[I].SortID && parallel[I].OcclusionID == serial[I].OcclusionID;
+
+				Assert::IsTrue(matches, L"Parallel gather merge diverged from the serial gather!\n");
+			}
+		}
+
+
+		TEST_METHOD(RadixSort_Benchmark)
+		{
+			const size_t passCount = 20;
+
+			auto GetSortID	= [](const FlexKit::PVEntry& entry) { return entry.SortID; };
+			auto Less		= [](const FlexKit::PVEntry& lhs, const FlexKit::PVEntry& rhs) { return lhs.SortID < rhs.SortID; };
+
+			for (const size_t count : { 1000, 10000, 100000 })
+			{
+				const auto	source	= BuildEntries(count, 4321);
+				auto		entries	= BuildEntries(count, 4321);
+
+				void* scratch = FlexKit::SystemAllocator._aligned_malloc(FlexKit::GetRadixSortScratchSize<FlexKit::PVEntry>(count));
+
+				auto Time = [&](auto&& sort)
+				{
+					std::chrono::duration<double, std::milli> total{ 0 };
+
+					for (size_t pass = 0; pass < passCount; ++pass)
+					{
+						memcpy(entries.begin(), source.begin(), sizeof(FlexKit::PVEntry) * count);
+
+						const auto begin = std::chrono::high_resolution_clock::now();
+						sort();
+						total += std::chrono::high_resolution_clock::now() - begin;
+					}
+
+					return total.count() / passCount;
+				};
+
+				const auto stdSortTime	= Time([&] { std::sort(entries.begin(), entries.end(), Less); });
+				const auto radixTime	= Time([&] { FlexKit::RadixSort(entries.begin(), count, GetSortID, scratch); });
+
+				FlexKit::SystemAllocator._aligned_free(scratch);
+
+				for (size_t I = 1; I < count; ++I)
+					Assert::IsTrue(entries[I - 1].SortID <= entries[I].SortID, L"Entries are not sorted!\n");
+
+				std::stringstream SS;
+				SS << count << " entries : std::sort " << stdSortTime << "ms, radix sort " << radixTime << "ms\n";
+				Logger::WriteMessage(SS.str().c_str());
+			}
+		}
+	};
+
+
+	/************************************************************************************************/
+
+
+	TEST_CLASS(LightClusteringUnitTests)
+	{
+	public:
+		static const size_t lightCount = 4000;
+
+
+		static FlexKit::LightClusterGrid BuildGrid()
+		{
+			const float angle = 0.3f;
+
+			FlexKit::LightClusterGrid grid;
+			grid.position		= { 3.0f, 1.0f, -2.0f };
+			grid.orientation	= FlexKit::Quaternion{ 0.0f, sinf(angle / 2), 0.0f, cosf(angle / 2) };
+			grid.fovY			= 1.2f;
+			grid.aspectRatio	= 1920.0f / 1080.0f;
+			grid.nearZ			= 0.1f;
+			grid.farZ			= 200.0f;
+			grid.screenWH		= { 1920, 1080 };
+
+			return grid;
+		}
+
+
+		static FlexKit::Vector<FlexKit::BoundingSphere> BuildLights(const unsigned int seed)
+		{
+			std::default_random_engine				generator	{ seed };
+			std::uniform_real_distribution<float>	position	{ -150.0f, 150.0f };
+			std::uniform_real_distribution<float>	radius		{ 1.0f, 10.0f };
+
+			FlexKit::Vector<FlexKit::BoundingSphere> lights{ FlexKit::SystemAllocator, lightCount };
+
+			for (size_t I = 0; I < lightCount; ++I)
+				lights.push_back({ position(generator), position(generator) / 10.0f, position(generator), radius(generator) });
+
+			return lights;
+		}
+
+
+		static bool ListsLight(const FlexKit::LightClusterList& clusters, const FlexKit::LightCluster& cluster, const uint32_t visibleIdx)
+		{
+			for (uint32_t I = 0; I < cluster.count; ++I)
+			{
+				if (clusters.lightIndices[cluster.offset + I] == visibleIdx)
+					return true;
+			}
+
+			return false;
+		}
+
+
+		TEST_METHOD(LightClusters_ParallelMatchesSerial)
+		{
+			FlexKit::StackAllocator	temp	{ FlexKit::SystemAllocator, 64 * MEGABYTE };
+			FlexKit::ThreadManager	threads	{ 4 };
+
+			const auto grid		= BuildGrid();
+			const auto lights	= BuildLights(1234);
+
+			FlexKit::LightClusterList serial	{ FlexKit::SystemAllocator };
+			FlexKit::LightClusterList parallel	{ FlexKit::SystemAllocator };
+
+			FlexKit::BuildLightClusters(grid, lights.begin(), lights.size(), serial, nullptr, temp);
+			temp.clear();
+
+			const auto begin = std::chrono::high_resolution_clock::now();
+			FlexKit::BuildLightClusters(grid, lights.begin(), lights.size(), parallel, &threads, temp);
+			const std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - begin;
+
+			Assert::IsTrue(serial.visibleLights.size() == parallel.visibleLights.size(),	L"Parallel light culling diverged!\n");
+			Assert::IsTrue(serial.lightIndices.size() == parallel.lightIndices.size(),		L"Parallel light clustering diverged!\n");
+			Assert::IsTrue(serial.clusters.size() == grid.GetClusterCount(),				L"Unexpected cluster count!\n");
+
+			for (size_t I = 0; I < serial.clusters.size(); ++I)
+			{
+				Assert::IsTrue(serial.clusters[I].offset == parallel.clusters[I].offset,	L"Parallel light clustering diverged!\n");
+				Assert::IsTrue(serial.clusters[I].count == parallel.clusters[I].count,		L"Parallel light clustering diverged!\n");
+			}
+
+			for (size_t I = 0; I < serial.lightIndices.size(); ++I)
+				Assert::IsTrue(serial.lightIndices[I] == parallel.lightIndices[I], L"Parallel light clustering diverged!\n");
+
+			std::stringstream SS;
+			SS << lights.size() << " lights, " << parallel.visibleLights.size() << " visible, " << parallel.lightIndices.size() << " cluster entries in " << duration.count() << "ms\n";
+			Logger::WriteMessage(SS.str().c_str());
+		}
+
+
+		// Samples points inside every light, any sample on screen has to find its light in the sample's cluster
+		TEST_METHOD(LightClusters_AreConservative)
+		{
+			FlexKit::StackAllocator	temp	{ FlexKit::SystemAllocator, 64 * MEGABYTE };
+			FlexKit::ThreadManager	threads	{ 4 };
+
+			const auto grid		= BuildGrid();
+			const auto lights	= BuildLights(4321);
+			const auto tiles	= grid.GetTileCount();
+
+			FlexKit::LightClusterList clusters{ FlexKit::SystemAllocator };
+			FlexKit::BuildLightClusters(grid, lights.begin(), lights.size(), clusters, &threads, temp);
+
+			FlexKit::Vector<int64_t> visibleIdx{ FlexKit::SystemAllocator, lightCount, int64_t(-1) };
+			for (size_t I = 0; I < clusters.visibleLights.size(); ++I)
+				visibleIdx[clusters.visibleLights[I]] = I;
+
+			for (auto& cluster : clusters.clusters)
+			{
+				for (uint32_t I = 1; I < cluster.count; ++I)
+					Assert::IsTrue(clusters.lightIndices[cluster.offset + I - 1] < clusters.lightIndices[cluster.offset + I], L"Cluster light list is not sorted!\n");
+			}
+
+			const auto	inverseOrientation	= grid.orientation.Inverse();
+			const float	tanY				= tanf(grid.fovY / 2);
+			const float	tanX				= tanY * grid.aspectRatio;
+
+			std::default_random_engine				generator	{ 1234 };
+			std::uniform_real_distribution<float>	offset		{ -1.0f, 1.0f };
+
+			size_t sampleCount = 0;
+
+			for (size_t I = 0; I < lights.size(); ++I)
+			{
+				for (size_t sample = 0; sample < 64; ++sample)
+				{
+					const FlexKit::float3 direction{ offset(generator), offset(generator), offset(generator) };
+					if (direction.magnitude() > 1.0f)
+						continue;
+
+					const FlexKit::float3	point	= lights[I].xyz() + direction * lights[I].w;
+					const FlexKit::float3	view	= inverseOrientation * (point - grid.position);
+					const float				depth	= -view.z;
+
+					if (depth < grid.nearZ || depth > grid.farZ)
+						continue;
+
+					const float x = view.x / (depth * tanX);
+					const float y = view.y / (depth * tanY);
+
+					if (fabsf(x) > 1.0f || fabsf(y) > 1.0f)
+						continue;
+
+					const uint32_t tileX	= std::min(uint32_t((x + 1.0f) / 2.0f * grid.screenWH[0] / grid.tileSize), tiles[0] - 1);
+					const uint32_t tileY	= std::min(uint32_t((1.0f - y) / 2.0f * grid.screenWH[1] / grid.tileSize), tiles[1] - 1);
+					const uint32_t slice	= grid.GetSlice(FlexKit::float3(point - grid.position).magnitude());
+
+					const auto& cluster = clusters.clusters[grid.GetClusterIndex(tileX, tileY, slice)];
+
+					Assert::IsTrue(visibleIdx[I] != -1,									L"Visible light was culled!\n");
+					Assert::IsTrue(ListsLight(clusters, cluster, (uint32_t)visibleIdx[I]),	L"Light missing from a cluster it touches!\n");
+
+					sampleCount++;
+				}
+			}
+
+			Assert::IsTrue(sampleCount > 0, L"No samples landed on screen!\n");
+		}
+	};
+
+
+	/************************************************************************************************/
+
+
+	TEST_CLASS(AssetLoaderUnitTests)
+	{
+	public:
+		// Hands out fake blobs, Read blocks while the gate is closed so tests can line up the queue
+		class TestReader final : public FlexKit::iAssetReader
+		{
+		public:
+			FlexKit::AssetReadResult Read(const FlexKit::GUID_t guid) override
+			{
+				std::unique_lock lock{ m };
+
+				reading++;
+				cv.notify_all();
+				cv.wait(lock, [&] { return open; });
+				reading--;
+
+				readOrder.push_back(guid);
+
+				return { guid, reinterpret_cast<FlexKit::Resource*>(blobs + guid) };
+			}
+
+
+			void Release(const FlexKit::AssetReadResult& asset) override
+			{
+				released++;
+			}
+
+
+			void Open()
+			{
+				{
+					std::scoped_lock lock{ m };
+					open = true;
+				}
+
+				cv.notify_all();
+			}
+
+
+			void WaitForRead()
+			{
+				std::unique_lock lock{ m };
+				cv.wait(lock, [&] { return reading > 0; });
+			}
+
+
+			std::mutex						m;
+			std::condition_variable			cv;
+			bool							open		= false;
+			int								reading		= 0;
+			std::vector<FlexKit::GUID_t>	readOrder;
+			std::atomic_int					released	= 0;
+			uint64_t						blobs[128];
+		};
+
+
+		TEST_METHOD(AssetLoader_CoalescesRequests)
+		{
+			FlexKit::ThreadManager threads{ 4 };
+
+			{
+				TestReader			reader;
+				FlexKit::AssetLoader	loader{ threads, reader, FlexKit::SystemAllocator };
+
+				std::atomic_int calls		= 0;
+				std::atomic_int mismatches	= 0;
+
+				std::vector<FlexKit::AssetRequestHandle> handles;
+				std::vector<std::thread> requesters;
+				std::mutex handleLock;
+
+				for (size_t T = 0; T < 4; ++T)
+				{
+					requesters.emplace_back(
+						[&, T]
+						{
+							for (FlexKit::GUID_t guid = 0; guid < 64; ++guid)
+							{
+								auto handle = loader.Request(guid, FlexKit::AssetLoadPriority((guid + T) % 3),
+									[&, guid](FlexKit::AssetHandle asset, FlexKit::Resource* resource)
+									{
+										calls++;
+
+										if (asset != guid || resource != reinterpret_cast<FlexKit::Resource*>(reader.blobs + guid))
+											mismatches++;
+									});
+
+								std::scoped_lock lock{ handleLock };
+								handles.push_back(std::move(handle));
+							}
+						});
+				}
+
+				for (auto& requester : requesters)
+					requester.join();
+
+				reader.Open();
+
+				for (auto& handle : handles)
+				{
+					handle.Wait();
+					Assert::IsTrue(handle.GetState() == FlexKit::AssetLoadState::Loaded, L"Request failed to load!\n");
+				}
+
+				Assert::IsTrue(calls == 256,					L"Callback count mismatch!\n");
+				Assert::IsTrue(mismatches == 0,					L"Callback given the wrong asset!\n");
+				Assert::IsTrue(reader.readOrder.size() == 64,	L"Coalesced requests read more than once!\n");
+
+				handles.clear();
+
+				Assert::IsTrue(reader.released == 64, L"Asset references leaked!\n");
+			}
+
+			threads.Release();
+		}
+
+
+		TEST_METHOD(AssetLoader_PriorityAndCancellation)
+		{
+			FlexKit::ThreadManager threads{ 2 };
+
+			{
+				TestReader			reader;
+				FlexKit::AssetLoader	loader{ threads, reader, FlexKit::SystemAllocator };
+
+				std::atomic_int calls = 0;
+				auto OnLoaded = [&](FlexKit::AssetHandle, FlexKit::Resource*) { calls++; };
+
+				// Keeps the I/O thread busy while the rest queue up behind it
+				auto first = loader.Request(1, FlexKit::AssetLoadPriority::Prefetch, OnLoaded);
+				reader.WaitForRead();
+
+				auto prefetch	= loader.Request(2, FlexKit::AssetLoadPriority::Prefetch,	OnLoaded);
+				auto visible	= loader.Request(3, FlexKit::AssetLoadPriority::Visible,	OnLoaded);
+				auto immediate	= loader.Request(4, FlexKit::AssetLoadPriority::Immediate,	OnLoaded);
+				auto cancelled	= loader.Request(5, FlexKit::AssetLoadPriority::Immediate,	OnLoaded);
+				auto upgraded	= loader.Request(2, FlexKit::AssetLoadPriority::Immediate,	OnLoaded);
+
+				cancelled.Cancel();
+				first.Cancel();
+
+				Assert::IsTrue(cancelled.GetState() == FlexKit::AssetLoadState::Cancelled, L"Queued request not cancelled!\n");
+
+				reader.Open();
+
+				immediate.Wait();
+				upgraded.Wait();
+				visible.Wait();
+				first.Wait();
+
+				const std::vector<FlexKit::GUID_t> expected{ 1, 4, 2, 3 };
+
+				Assert::IsTrue(reader.readOrder == expected,								L"Requests read out of priority order!\n");
+				Assert::IsTrue(first.GetState() == FlexKit::AssetLoadState::Cancelled,		L"Request cancelled mid read still delivered!\n");
+				Assert::IsTrue(prefetch.GetState() == FlexKit::AssetLoadState::Loaded,		L"Upgraded request lost!\n");
+				Assert::IsTrue(calls == 4,													L"Callback count mismatch!\n");
+			}
+
+			threads.Release();
+		}
+	};
+
+
+	/************************************************************************************************/
+
+
+	TEST_CLASS(AssetTableUnitTests)
+	{
+	public:
+		struct TestBlob : FlexKit::Resource
+		{
+			uint64_t payload;
+		};
+
+
+		TEST_METHOD(AssetLookupTable_CollisionsAndGrowth)
+		{
+			FlexKit::AssetLookupTable table{ FlexKit::SystemAllocator };
+
+			const uint32_t assetCount = 1000;
+
+			// Every key is shared by four assets, only the predicate tells them apart
+			for (uint32_t I = 0; I < assetCount; ++I)
+				table.Insert(I / 4, I);
+
+			Assert::IsTrue(table.count == assetCount,				L"Lost inserts!\n");
+			Assert::IsTrue(table.values.size() >= 2 * assetCount,	L"Table did not grow!\n");
+
+			for (uint32_t I = 0; I < assetCount; ++I)
+				Assert::IsTrue(table.Find(I / 4, [&](const uint32_t asset) { return asset == I; }) == I, L"Lookup missed a colliding key!\n");
+
+			Assert::IsTrue(table.Find(assetCount, [](const uint32_t) { return true; }) == FlexKit::AssetLookupTable::Empty,	L"Found a key never inserted!\n");
+			Assert::IsTrue(table.Find(0, [](const uint32_t asset) { return asset > 3; }) == FlexKit::AssetLookupTable::Empty,	L"Predicate ignored!\n");
+
+			table.clear();
+
+			Assert::IsTrue(table.Find(1, [](const uint32_t) { return true; }) == FlexKit::AssetLookupTable::Empty, L"Cleared table still finds keys!\n");
+
+			table.keys.Release();
+			table.values.Release();
+		}
+
+
+		TEST_METHOD(AssetTable_MappedLookupByIDAndGUID)
+		{
+			const char*		fileName	= "AssetTable_Test.gameres";
+			const uint32_t	assetCount	= 200; // past the lookup tables' first size
+			const size_t	alignment	= FlexKit::ResourceBlobAlignment;
+			const size_t	blobStride	= (sizeof(TestBlob) + alignment - 1) & ~(alignment - 1);
+			const size_t	tableSize	= sizeof(FlexKit::ResourceTable) + sizeof(FlexKit::ResourceEntry) * (assetCount + 1);
+			const size_t	blobsBegin	= (tableSize + alignment - 1) & ~(alignment - 1);
+
+			auto AssetID = [](char (&ID)[FlexKit::ID_LENGTH], const uint32_t I) { sprintf_s(ID, "TestAsset_%u", I); };
+
+			// Sequential GUIDs, the extra asset at the end is written off alignment so it is copied instead of used in place
+			std::vector<uint8_t>	file(blobsBegin + blobStride * (assetCount + 1) + 8);
+			auto*					table = reinterpret_cast<FlexKit::ResourceTable*>(file.data());
+
+			table->Version			= 3;
+			table->ResourceCount	= assetCount + 1;
+
+			for (uint32_t I = 0; I <= assetCount; ++I)
+			{
+				const size_t position = blobsBegin + blobStride * I + (I == assetCount ? 8 : 0);
+
+				TestBlob blob;
+				memset(&blob, 0, sizeof(blob));
+				blob.ResourceSize	= sizeof(TestBlob);
+				blob.Type			= FlexKit::EResource_GameDB;
+				blob.GUID			= 5000 + I;
+				blob.payload		= I * 7;
+				AssetID(blob.ID, I);
+
+				memcpy(file.data() + position, &blob, sizeof(blob));
+
+				auto& entry = table->Entries[I];
+				entry.GUID				= blob.GUID;
+				entry.ResourcePosition	= position;
+				entry.StoredSize		= sizeof(blob);
+				entry.Compression		= FlexKit::EResourceCompression_None;
+				entry.Type				= blob.Type;
+				memcpy(entry.ID, blob.ID, FlexKit::ID_LENGTH);
+			}
+
+			FILE* F = nullptr;
+			fopen_s(&F, fileName, "wb");
+			Assert::IsTrue(F != nullptr, L"Failed to write the test asset file!\n");
+
+			fwrite(file.data(), 1, file.size(), F);
+			fclose(F);
+
+			FlexKit::InitiateAssetTable(FlexKit::SystemAllocator);
+			FlexKit::AddAssetFile(const_cast<char*>(fileName));
+
+			for (uint32_t I = 0; I < assetCount; ++I)
+			{
+				char ID[FlexKit::ID_LENGTH];
+				AssetID(ID, I);
+
+				const auto byGUID	= FlexKit::LoadGameAsset(FlexKit::GUID_t(5000 + I));
+				const auto byID		= FlexKit::LoadGameAsset(ID);
+
+				Assert::IsTrue(byGUID != INVALIDHANDLE && byGUID == byID, L"GUID and ID lookups disagree!\n");
+
+				auto resource = reinterpret_cast<TestBlob*>(FlexKit::GetAsset(byGUID));
+
+				Assert::IsTrue(resource && resource->GUID == 5000 + I && resource->payload == I * 7,	L"Lookup returned the wrong blob!\n");
+				Assert::IsTrue(FlexKit::Resources.Assets[byGUID].mapped,								L"Aligned blob was copied!\n");
+				Assert::IsTrue(!strcmp(FlexKit::GetAssetID(byGUID), ID),								L"Asset ID does not match!\n");
+
+				FlexKit::FreeAsset(byGUID);
+			}
+
+			Assert::IsTrue(!FlexKit::isAssetAvailable(FlexKit::GUID_t(4999)),	L"Found a GUID never added!\n");
+			Assert::IsTrue(!FlexKit::isAssetAvailable("TestAsset_None"),		L"Found an ID never added!\n");
+
+			// Loaded without a reference, freeing the handle still releases the copy
+			const auto copied = FlexKit::LoadGameAsset(FlexKit::GUID_t(5000 + assetCount));
+
+			Assert::IsTrue(FlexKit::Resources.Assets[copied].resource && !FlexKit::Resources.Assets[copied].mapped, L"Unaligned blob not copied!\n");
+
+			FlexKit::FreeAsset(copied);
+
+			Assert::IsTrue(FlexKit::Resources.Assets[copied].resource == nullptr, L"Blob loaded without a reference never released!\n");
+
+			auto reloaded = reinterpret_cast<TestBlob*>(FlexKit::GetAsset(copied));
+
+			Assert::IsTrue(reloaded && reloaded->payload == assetCount * 7, L"Evicted blob did not reload!\n");
+
+			FlexKit::FreeAsset(copied);
+
+			Assert::IsTrue(FlexKit::Resources.Assets[copied].resource == nullptr, L"Copied blob kept after its last reference!\n");
+
+			FlexKit::ReleaseAssetTable();
+			remove(fileName);
+		}
+	};
+
+
+	TEST_CLASS(BlockCompressionUnitTests)
+	{
+	public:
+		// Runs of repeated words with some noise, roughly how mesh and texture blobs compress
+		static std::vector<FlexKit::byte> BuildBlob(const size_t size, uint32_t seed)
+		{
+			std::vector<FlexKit::byte> blob(size);
+
+			for (size_t I = 0; I < size; ++I)
+			{
+				seed = seed * 1664525u + 1013904223u;
+				blob[I] = (seed >> 28) ? FlexKit::byte((I / 8) & 0x3f) : FlexKit::byte(seed >> 16);
+			}
+
+			return blob;
+		}
+
+
+		TEST_METHOD(BlockCompression_ParallelDecodeMatchesSource)
+		{
+			FlexKit::ThreadManager threads{ 4 };
+
+			for (const size_t size : { 0, 1, 100, 4096, 200000, 1000000 })
+			{
+				const auto source = BuildBlob(size, 1234);
+
+				std::vector<FlexKit::byte> compressed(FlexKit::GetCompressedBlobBound(size, 16 * KILOBYTE));
+				const size_t compressedSize = FlexKit::CompressBlob(source.data(), size, compressed.data(), compressed.size(), 16 * KILOBYTE);
+
+				Assert::IsTrue(compressedSize != 0, L"Failed to compress blob!\n");
+				Assert::IsTrue(FlexKit::GetDecompressedSize(compressed.data(), compressedSize) == size, L"Decompressed size mismatch!\n");
+
+				std::vector<FlexKit::byte> serial(size + 1);
+				std::vector<FlexKit::byte> parallel(size + 1);
+
+				Assert::IsTrue(FlexKit::DecompressBlob(compressed.data(), compressedSize, serial.data(), size), L"Serial decode failed!\n");
+				Assert::IsTrue(FlexKit::DecompressBlob(compressed.data(), compressedSize, parallel.data(), size, &threads), L"Parallel decode failed!\n");
+
+				Assert::IsTrue(std::equal(source.begin(), source.end(), serial.begin()),	L"Serial decode does not match source!\n");
+				Assert::IsTrue(std::equal(source.begin(), source.end(), parallel.begin()),	L"Parallel decode does not match source!\n");
+
+				// Truncated blobs fail instead of overrunning
+				if (compressedSize > sizeof(FlexKit::CompressedBlobHeader) + 8)
+					Assert::IsTrue(!FlexKit::DecompressBlob(compressed.data(), compressedSize - 8, parallel.data(), size, &threads), L"Truncated blob decoded!\n");
+			}
+
+			threads.Release();
+		}
+	};
+
+
+	/************************************************************************************************/
+
+
+	TEST_CLASS(TextureResidencyUnitTests)
+	{
+	public:
+		// Tiles of one texture at one mip, packed the way the feedback pass writes them
+		static std::vector<uint64_t> BuildRequests(const uint32_t texture, const uint32_t mipInverted, const uint32_t first, const uint32_t count)
+		{
+			std::vector<uint64_t> requests;
+
+			for (uint32_t I = first; I < first + count; ++I)
+				requests.push_back(FlexKit::CreateTileKey(texture, (mipInverted << 24) | ((I % 64) << 12) | (I / 64)));
+
+			return requests;
+		}
+
+
+		static bool AllResident(const FlexKit::TileResidencyManager& residency, const std::vector<uint64_t>& tiles)
+		{
+			return std::all_of(tiles.begin(), tiles.end(), [&](auto tile) { return residency.IsResident(tile); });
+		}
+
+
+		TEST_METHOD(TileResidency_BudgetAndPriority)
+		{
+			FlexKit::TileResidencyDesc desc;
+			desc.slotCount		= 16;
+			desc.uploadBudget	= 4 * desc.tileSize;
+
+			FlexKit::TileResidencyManager residency{ desc, FlexKit::SystemAllocator };
+
+			const auto fine		= BuildRequests(1, 5, 0, 6);
+			const auto coarse	= BuildRequests(1, 2, 0, 2);
+
+			std::vector<uint64_t> feedback;
+			feedback.insert(feedback.end(), fine.begin(), fine.end());
+			feedback.insert(feedback.end(), coarse.begin(), coarse.end());
+			feedback.push_back(fine[5]);
+			feedback.push_back(fine[5]); // Covers more of the screen than the other fine tiles
+
+			auto update = residency.Update(feedback.data(), feedback.data() + feedback.size(), FlexKit::SystemAllocator);
+
+			Assert::IsTrue(update.uploads.size() == 4,						L"Upload budget not respected!\n");
+			Assert::IsTrue(AllResident(residency, coarse),					L"Coarse tiles not uploaded first!\n");
+			Assert::IsTrue(residency.IsResident(fine[5]),					L"Most requested tile not prioritized!\n");
+			Assert::IsTrue(residency.GetStats().deferred == 4,				L"Deferred count mismatch!\n");
+
+			update = residency.Update(feedback.data(), feedback.data() + feedback.size(), FlexKit::SystemAllocator);
+
+			Assert::IsTrue(update.uploads.size() == 4,						L"Deferred tiles not uploaded!\n");
+			Assert::IsTrue(AllResident(residency, fine),					L"Deferred tiles not uploaded!\n");
+
+			update = residency.Update(feedback.data(), feedback.data() + feedback.size(), FlexKit::SystemAllocator);
+
+			const auto& stats = residency.GetStats();
+
+			Assert::IsTrue(update.uploads.size() == 0 && update.evictions.size() == 0,	L"Resident tiles uploaded again!\n");
+			Assert::IsTrue(stats.hits == 4 + 8 && stats.misses == 8 + 4,				L"Hit and miss counts mismatch!\n");
+			Assert::IsTrue(stats.uploadedBytes == 8 * desc.tileSize,					L"Uploaded byte count mismatch!\n");
+			Assert::IsTrue(residency.GetFreeSlotCount() == 8,							L"Slot leaked!\n");
+		}
+
+
+		TEST_METHOD(TileResidency_HysteresisPreventsThrashing)
+		{
+			// Two working sets of 12 tiles alternating over 16 slots
+			const auto setA = BuildRequests(1, 4, 0, 12);
+			const auto setB = BuildRequests(2, 4, 0, 12);
+
+			auto Run = [&](const uint32_t hysteresis, const size_t updateCount)
+			{
+				FlexKit::TileResidencyDesc desc;
+				desc.slotCount			= 16;
+				desc.hysteresisUpdates	= hysteresis;
+
+				FlexKit::TileResidencyManager residency{ desc, FlexKit::SystemAllocator };
+
+				for (size_t I = 0; I < updateCount; ++I)
+				{
+					const auto& set = I % 2 ? setB : setA;
+					residency.Update(set.data(), set.data() + set.size(), FlexKit::SystemAllocator);
+				}
+
+				return residency.GetStats().evictions;
+			};
+
+			Assert::IsTrue(Run(0, 20) >= 19 * 8,	L"Working sets expected to thrash without hysteresis!\n");
+			Assert::IsTrue(Run(4, 20) == 0,			L"Recently requested tiles evicted!\n");
+
+			// Once a working set stops being requested it ages out, least recently requested first
+			FlexKit::TileResidencyDesc desc;
+			desc.slotCount			= 16;
+			desc.hysteresisUpdates	= 4;
+
+			FlexKit::TileResidencyManager residency{ desc, FlexKit::SystemAllocator };
+
+			residency.Update(setA.data(), setA.data() + setA.size(), FlexKit::SystemAllocator);
+
+			for (size_t I = 0; I < desc.hysteresisUpdates; ++I)
+			{
+				residency.Update(setB.data(), setB.data() + setB.size(), FlexKit::SystemAllocator);
+				Assert::IsTrue(AllResident(residency, setA), L"Tile evicted within the hysteresis window!\n");
+			}
+
+			residency.Update(setB.data(), setB.data() + setB.size(), FlexKit::SystemAllocator);
+
+			Assert::IsTrue(AllResident(residency, setB),			L"Stale tiles not evicted!\n");
+			Assert::IsTrue(residency.GetResidentCount() == 16,		L"Resident count mismatch!\n");
+		}
+
+
+		TEST_METHOD(DecodedTileCache_HitMissAndRecycling)
+		{
+			const size_t tileCount = 64;
+
+			FlexKit::DecodedTileCache cache{ tileCount, 256, FlexKit::SystemAllocator };
+
+			auto Key = [](const uint32_t I) { return FlexKit::TileCacheKey{ 1000 + I / 16, I / 4 % 4, I % 4 }; };
+
+			Assert::IsTrue(cache.Find(Key(0)) == nullptr, L"Hit in an empty cache!\n");
+
+			// Keys differ in one field at a time, every tile gets its own buffer
+			std::vector<char*> buffers;
+
+			for (uint32_t I = 0; I < tileCount; ++I)
+			{
+				auto buffer = cache.Insert(Key(I));
+				memset(buffer, int(I), cache.GetTileSize());
+				buffers.push_back(buffer);
+			}
+
+			Assert::IsTrue(cache.size() == tileCount, L"Cache not filled!\n");
+
+			for (uint32_t I = 0; I < tileCount; ++I)
+			{
+				auto buffer = cache.Find(Key(I));
+				Assert::IsTrue(buffer == buffers[I] && buffer[0] == char(I), L"Hit returned the wrong tile!\n");
+			}
+
+			Assert::IsTrue(cache.Find(FlexKit::TileCacheKey{ 1000, 0, 4 }) == nullptr,	L"Hit on a tile never inserted!\n");
+			Assert::IsTrue(cache.Find(FlexKit::TileCacheKey{ 999, 0, 0 }) == nullptr,	L"Hit on a tile never inserted!\n");
+
+			// Touch the even tiles, the odd ones are now the least recently used, oldest first
+			for (uint32_t I = 0; I < tileCount; I += 2)
+				cache.Find(Key(I));
+
+			for (uint32_t I = 0; I < tileCount / 2; ++I)
+			{
+				const auto key		= FlexKit::TileCacheKey{ 2000, 0, I };
+				auto buffer			= cache.Insert(key);
+
+				Assert::IsTrue(buffer == buffers[2 * I + 1],		L"Recycled a tile out of use order!\n");
+				Assert::IsTrue(cache.Find(Key(2 * I + 1)) == nullptr,	L"Recycled tile still found under its old key!\n");
+				Assert::IsTrue(cache.Find(key) == buffer,				L"Recycled tile not found under its new key!\n");
+			}
+
+			Assert::IsTrue(cache.size() == tileCount, L"Cache grew past its tile count!\n");
+
+			for (uint32_t I = 0; I < tileCount; I += 2)
+				Assert::IsTrue(cache.Find(Key(I)) == buffers[I], L"Recently used tile was recycled!\n");
+		}
+	};
 }
\ No newline at end of file
@@ -130,9 +130,9 @@ void LocalPlayerState::Draw(EngineCore& core, UpdateDispatcher& dispatcher, doub
     auto& transforms		= QueueTransformUpdateTask	(dispatcher);
     auto& cameras			= CameraComponent::GetComponent().QueueCameraUpdate(dispatcher);
     auto& cameraConstants	= MakeHeapCopy				(Camera::ConstantBuffer{}, core.GetTempMemory());
-    auto& PVS				= GatherScene               (dispatcher, scene, activeCamera, core.GetTempMemory());
-    auto& skinnedObjects    = GatherSkinned             (dispatcher, scene, activeCamera, core.GetTempMemory());
-    auto& updatedPoses      = UpdatePoses               (dispatcher, skinnedObjects, core.GetTempMemory());
+    auto& PVS				= GatherScene               (dispatcher, scene, activeCamera);
+    auto& skinnedObjects    = GatherSkinned             (dispatcher, scene, activeCamera);
+    auto& updatedPoses      = UpdatePoses               (dispatcher, skinnedObjects);
     auto& cameraControllers = UpdateThirdPersonCameraControllers(dispatcher, framework.MouseState.Normalized_dPos, dT);
 
     transforms.AddInput(cameraControllers);
@@ -272,6 +272,7 @@ void LocalPlayerState::Draw(EngineCore& core, UpdateDispatcher& dispatcher, doub
                 activeCamera,
                 scene,
                 sceneDesc,
+                targets.RenderTarget,
                 reserveCB,
                 core.GetTempMemory(),
                 &debugDraw);
@@ -116,7 +116,9 @@ inline void StartTestState(FlexKit::FKApplication& app, BaseState& base, TestSce
             uint2           WH;
             DeviceFormat    format;
 
-            Vector<TextureBuffer> radiance   = LoadCubeMapAsset(2, MIPCount, WH, format, allocator);
+            AssetHandle     cubeMapAsset;
+
+            Vector<TextureBuffer> radiance   = LoadCubeMapAsset(2, MIPCount, WH, format, cubeMapAsset, allocator);
             base.GGXMap = MoveTextureBuffersToVRAM(
                 renderSystem,
                 upload,
@@ -125,7 +127,9 @@ inline void StartTestState(FlexKit::FKApplication& app, BaseState& base, TestSce
                 6,
                 format);
 
-            Vector<TextureBuffer> irradience = LoadCubeMapAsset(1, MIPCount, WH, format, allocator);
+            FreeAsset(cubeMapAsset);
+
+            Vector<TextureBuffer> irradience = LoadCubeMapAsset(1, MIPCount, WH, format, cubeMapAsset, allocator);
             base.irradianceMap = MoveTextureBuffersToVRAM(
                 renderSystem,
                 upload,
@@ -134,6 +138,8 @@ inline void StartTestState(FlexKit::FKApplication& app, BaseState& base, TestSce
                 6,
                 format);
 
+            FreeAsset(cubeMapAsset);
+
 			renderSystem.SetDebugName(base.irradianceMap, "irradiance Map");
 			renderSystem.SetDebugName(base.GGXMap,        "GGX Map");
 			renderSystem.SubmitUploadQueues(SYNC_Graphics, &upload);
@@ -53,6 +53,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define DEBUGGRAPHICS		ON
 #define DEBUGHANDLES		OFF
 #define DEBUGMEMORY			OFF
+#define ALLOCATIONTELEMETRY	OFF
 #define FATALERROR			OFF
 #define EDITSHADERCONTINUE	ON
 #define STL					OFF
@@ -71,6 +72,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define DEBUGGRAPHICS		OFF
 #define DEBUGHANDLES		OFF
 #define DEBUGMEMORY			OFF
+#define ALLOCATIONTELEMETRY	OFF
 #define FATALERROR			ON
 #define EDITSHADERCONTINUE 	ON
 #define STL					OFF
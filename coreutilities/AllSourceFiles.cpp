@@ -26,6 +26,9 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
 
+#include "..\coreutilities\AllocationTelemetry.cpp"
+#include "..\coreutilities\AssetLoader.cpp"
+#include "..\coreutilities\BlockCompression.cpp"
 #include "..\coreutilities\CameraUtilities.cpp"
 #include "..\coreutilities\Console.cpp"
 #include "..\coreutilities\DebugPanel.cpp"
@@ -38,12 +41,16 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "..\coreutilities\GraphicScene.cpp"
 #include "..\coreutilities\Handle.cpp"
 #include "..\coreutilities\intersection.cpp"
+#include "..\coreutilities\LooseOctree.cpp"
 #include "..\coreutilities\MathUtils.cpp"
 #include "..\coreutilities\memoryutilities.cpp"
 #include "..\coreutilities\ProfilingUtilities.cpp"
 #include "..\coreutilities\assets.cpp"
 #include "..\coreutilities\ThreadUtilities.cpp"
 #include "..\coreutilities\Transforms.cpp"
+#include "..\coreutilities\TransformKernels.cpp"
+#include "..\coreutilities\CullingKernels.cpp"
+#include "..\coreutilities\LightClustering.cpp"
 #include "..\coreutilities\timeutilities.cpp"
 #include "..\coreutilities\type.cpp"
 #include "..\coreutilities\WorldRender.cpp"
@@ -53,6 +60,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "..\graphicsutilities\AnimationRuntimeUtilities.cpp"
 #include "..\graphicsutilities\CoreSceneObjects.cpp"
 #include "..\graphicsutilities\DDSUtilities.cpp"
+#include "..\graphicsutilities\DrawBatching.cpp"
 #include "..\graphicsutilities\defaultpipelinestates.cpp"
 #include "..\graphicsutilities\geometry.cpp"
 #include "..\graphicsutilities\FrameGraph.cpp"
@@ -60,6 +68,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "..\graphicsutilities\graphics.cpp"
 #include "..\graphicsutilities\GuiUtilities.cpp"
 #include "..\graphicsutilities\TextureUtilities.cpp"
+#include "..\graphicsutilities\TextureResidency.cpp"
 #include "..\graphicsutilities\TextureStreamingUtilities.cpp"
 #include "..\graphicsutilities\TextRendering.cpp"
 #include "..\graphicsutilities\Meshutils.cpp"
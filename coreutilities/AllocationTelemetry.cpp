@@ -0,0 +1,362 @@
+/**********************************************************************
+
+Copyright (c) 2015 - 2019 Robert May
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************/
+
+#include "AllocationTelemetry.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <unordered_map>
+#include <vector>
+
+namespace FlexKit
+{
+	/************************************************************************************************/
+
+
+	struct TagEntry
+	{
+		const char*				tag				= nullptr;
+		std::atomic<int64_t>	liveBytes		= 0;
+		std::atomic<int64_t>	liveCount		= 0;
+		std::atomic<int64_t>	peakBytes		= 0;
+		std::atomic<uint64_t>	frameAllocations	= 0;
+		std::atomic<uint64_t>	frameBytes			= 0;
+		std::atomic<uint64_t>	totalAllocations	= 0;
+		uint64_t				lastFrameAllocations	= 0;
+		uint64_t				lastFrameBytes			= 0;
+
+
+		void OnAllocation(const size_t size, const bool live) noexcept
+		{
+			frameAllocations.fetch_add(1, std::memory_order_relaxed);
+			frameBytes.fetch_add(size, std::memory_order_relaxed);
+			totalAllocations.fetch_add(1, std::memory_order_relaxed);
+
+			if (!live)
+				return;
+
+			liveCount.fetch_add(1, std::memory_order_relaxed);
+
+			const int64_t current	= liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+			int64_t		  peak		= peakBytes.load(std::memory_order_relaxed);
+
+			while (peak < current && !peakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed));
+		}
+
+
+		void OnFree(const size_t size) noexcept
+		{
+			liveCount.fetch_sub(1, std::memory_order_relaxed);
+			liveBytes.fetch_sub(size, std::memory_order_relaxed);
+		}
+
+
+		AllocationTagStats GetStats() const noexcept
+		{
+			return {
+				tag,
+				liveBytes.load(std::memory_order_relaxed),
+				liveCount.load(std::memory_order_relaxed),
+				peakBytes.load(std::memory_order_relaxed),
+				lastFrameAllocations,
+				lastFrameBytes,
+				totalAllocations.load(std::memory_order_relaxed) };
+		}
+	};
+
+
+	struct LiveAllocation
+	{
+		size_t		size;
+		uint32_t	tagIdx;
+	};
+
+
+	struct TelemetryState
+	{
+		static const size_t ShardCount = 32;
+
+		struct Shard
+		{
+			std::mutex									lock;
+			std::unordered_map<const void*, LiveAllocation>	allocations;
+		};
+
+
+		Shard& GetShard(const void* _ptr) noexcept
+		{
+			return shards[((size_t)_ptr >> 6) % ShardCount];
+		}
+
+
+		TagEntry				totals;
+		TagEntry				tags[MaxAllocationTags];
+		std::atomic_uint32_t	tagCount	= 0;
+		std::mutex				tagLock;
+		Shard					shards[ShardCount];
+	};
+
+
+	// Allocators can be used before and after any static in this file is alive, so the state is never destroyed
+	static TelemetryState& GetTelemetryState() noexcept
+	{
+		static TelemetryState& state = *new TelemetryState;
+		return state;
+	}
+
+
+	thread_local const char* currentAllocationTag = nullptr;
+
+
+	/************************************************************************************************/
+
+
+	static uint32_t GetTagIdx(TelemetryState& state, const char* tag) noexcept
+	{
+		thread_local const char*	lastTag = nullptr;
+		thread_local uint32_t		lastIdx = 0;
+
+		if (tag == lastTag)
+			return lastIdx;
+
+		auto Find = [&](const uint32_t count) -> uint32_t
+		{
+			for (uint32_t I = 0; I < count; ++I)
+				if (!strcmp(state.tags[I].tag, tag))
+					return I;
+
+			return uint32_t(-1);
+		};
+
+		auto idx = Find(state.tagCount.load(std::memory_order_acquire));
+
+		if (idx == uint32_t(-1))
+		{
+			std::scoped_lock lock{ state.tagLock };
+
+			const auto count = state.tagCount.load(std::memory_order_relaxed);
+			idx = Find(count);
+
+			if (idx == uint32_t(-1))
+			{
+				// Last entry collects every tag that did not fit
+				idx = count < MaxAllocationTags - 1 ? count : MaxAllocationTags - 1;
+
+				if (idx == count)
+				{
+					state.tags[idx].tag = idx < MaxAllocationTags - 1 ? tag : "Untracked Tags";
+					state.tagCount.store(count + 1, std::memory_order_release);
+				}
+			}
+		}
+
+		lastTag = tag;
+		lastIdx = idx;
+
+		return idx;
+	}
+
+
+	/************************************************************************************************/
+
+
+	AllocationTagScope::AllocationTagScope(const char* tag) noexcept :
+		previous{ currentAllocationTag }
+	{
+		currentAllocationTag = tag;
+	}
+
+
+	AllocationTagScope::~AllocationTagScope() noexcept
+	{
+		currentAllocationTag = previous;
+	}
+
+
+	/************************************************************************************************/
+
+
+	void TrackAllocation(const void* _ptr, const size_t size, const char* allocatorName) noexcept
+	{
+		if (!_ptr)
+			return;
+
+		auto&		state	= GetTelemetryState();
+		const auto	tagIdx	= GetTagIdx(state, currentAllocationTag ? currentAllocationTag : allocatorName);
+
+		state.totals.OnAllocation(size, true);
+		state.tags[tagIdx].OnAllocation(size, true);
+
+		auto& shard = state.GetShard(_ptr);
+		std::scoped_lock lock{ shard.lock };
+		shard.allocations[_ptr] = { size, tagIdx };
+	}
+
+
+	void TrackFree(const void* _ptr) noexcept
+	{
+		if (!_ptr)
+			return;
+
+		auto& state = GetTelemetryState();
+		auto& shard = state.GetShard(_ptr);
+
+		LiveAllocation allocation;
+
+		{
+			std::scoped_lock lock{ shard.lock };
+
+			auto res = shard.allocations.find(_ptr);
+			if (res == shard.allocations.end())
+				return; // Allocated before tracking started, or by an untracked path
+
+			allocation = res->second;
+			shard.allocations.erase(res);
+		}
+
+		state.totals.OnFree(allocation.size);
+		state.tags[allocation.tagIdx].OnFree(allocation.size);
+	}
+
+
+	void TrackTransient(const size_t size, const char* allocatorName) noexcept
+	{
+		auto&		state	= GetTelemetryState();
+		const auto	tagIdx	= GetTagIdx(state, currentAllocationTag ? currentAllocationTag : allocatorName);
+
+		state.totals.OnAllocation(size, false);
+		state.tags[tagIdx].OnAllocation(size, false);
+	}
+
+
+	/************************************************************************************************/
+
+
+	void AllocationTelemetryNextFrame() noexcept
+	{
+		auto& state = GetTelemetryState();
+
+		auto Advance = [](TagEntry& entry)
+		{
+			entry.lastFrameAllocations	= entry.frameAllocations.exchange(0, std::memory_order_relaxed);
+			entry.lastFrameBytes		= entry.frameBytes.exchange(0, std::memory_order_relaxed);
+		};
+
+		Advance(state.totals);
+
+		const auto count = state.tagCount.load(std::memory_order_acquire);
+		for (uint32_t I = 0; I < count; ++I)
+			Advance(state.tags[I]);
+	}
+
+
+	/************************************************************************************************/
+
+
+	AllocationTagStats GetAllocationTotals() noexcept
+	{
+		auto stats	= GetTelemetryState().totals.GetStats();
+		stats.tag	= "Total";
+
+		return stats;
+	}
+
+
+	size_t GetAllocationTagStats(AllocationTagStats* out, const size_t maxCount) noexcept
+	{
+		auto&		state = GetTelemetryState();
+		const auto	count = state.tagCount.load(std::memory_order_acquire);
+
+		size_t written = 0;
+		for (; written < count && written < maxCount; ++written)
+			out[written] = state.tags[written].GetStats();
+
+		return written;
+	}
+
+
+	/************************************************************************************************/
+
+
+	bool DumpAllocationTelemetry(const char* fileName)
+	{
+		FILE* file = nullptr;
+
+		if (fopen_s(&file, fileName, "w") || !file)
+			return false;
+
+		auto& state = GetTelemetryState();
+
+		std::vector<AllocationTagStats> tags(MaxAllocationTags);
+		tags.resize(GetAllocationTagStats(tags.data(), tags.size()));
+
+		std::sort(tags.begin(), tags.end(), [](auto& lhs, auto& rhs) { return lhs.liveBytes > rhs.liveBytes; });
+
+		const auto totals = GetAllocationTotals();
+
+		fprintf(file, "%-32s %14s %10s %14s %12s %14s %12s\n", "Tag", "Live Bytes", "Live", "Peak Bytes", "Frame Allocs", "Frame Bytes", "Total Allocs");
+
+		auto PrintTag = [&](const AllocationTagStats& stats)
+		{
+			fprintf(file, "%-32s %14lld %10lld %14lld %12llu %14llu %12llu\n",
+				stats.tag,
+				(long long)stats.liveBytes,
+				(long long)stats.liveCount,
+				(long long)stats.peakBytes,
+				(unsigned long long)stats.lastFrameAllocations,
+				(unsigned long long)stats.lastFrameBytes,
+				(unsigned long long)stats.totalAllocations);
+		};
+
+		PrintTag(totals);
+
+		for (auto& stats : tags)
+			PrintTag(stats);
+
+		// Everything still alive, biggest first, anything unexpected here at shutdown is a leak
+		std::vector<std::pair<const void*, LiveAllocation>> live;
+
+		for (auto& shard : state.shards)
+		{
+			std::scoped_lock lock{ shard.lock };
+			live.insert(live.end(), shard.allocations.begin(), shard.allocations.end());
+		}
+
+		std::sort(live.begin(), live.end(), [](auto& lhs, auto& rhs) { return lhs.second.size > rhs.second.size; });
+
+		fprintf(file, "\nLive Allocations: %zu\n", live.size());
+
+		for (auto& [address, allocation] : live)
+			fprintf(file, "%p %12zu %s\n", address, allocation.size, state.tags[allocation.tagIdx].tag);
+
+		fclose(file);
+
+		return true;
+	}
+
+
+}	/************************************************************************************************/
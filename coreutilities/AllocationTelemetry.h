@@ -0,0 +1,103 @@
+/**********************************************************************
+
+Copyright (c) 2015 - 2019 Robert May
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************/
+
+#ifndef ALLOCATIONTELEMETRY_H
+#define ALLOCATIONTELEMETRY_H
+
+#include "..\buildsettings.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Opt in allocation tracking, turn on ALLOCATIONTELEMETRY in buildsettings.h.
+// Allocations are counted under the innermost FK_ALLOCATION_TAG on the calling thread, or under the
+// allocator's own name outside of any tag. Block and system allocations are tracked until freed, stack
+// and frame arena allocations only count towards the per frame totals.
+// With the setting off every hook and FK_ALLOCATION_TAG compile away, the tracking functions below
+// are still built but nothing calls them.
+
+#if USING(ALLOCATIONTELEMETRY)
+
+#define FK_ALLOCATION_TAG_CONCAT2(A, B)	A##B
+#define FK_ALLOCATION_TAG_CONCAT(A, B)	FK_ALLOCATION_TAG_CONCAT2(A, B)
+#define FK_ALLOCATION_TAG(TAG)			FlexKit::AllocationTagScope FK_ALLOCATION_TAG_CONCAT(_allocationTag, __LINE__){ TAG }
+
+#else
+
+#define FK_ALLOCATION_TAG(TAG)
+
+#endif
+
+namespace FlexKit
+{
+	/************************************************************************************************/
+
+
+	static const size_t MaxAllocationTags = 256; // tags past this are counted under "Untracked Tags"
+
+
+	// Tags are compared by contents, they have to outlive the program, so string literals
+	class FLEXKITAPI AllocationTagScope
+	{
+	public:
+		AllocationTagScope(const char* tag) noexcept;
+		~AllocationTagScope() noexcept;
+
+		AllocationTagScope				(const AllocationTagScope&) = delete;
+		AllocationTagScope& operator =	(const AllocationTagScope&) = delete;
+
+	private:
+		const char* previous;
+	};
+
+
+	struct AllocationTagStats
+	{
+		const char*	tag;
+		int64_t		liveBytes;
+		int64_t		liveCount;
+		int64_t		peakBytes;
+		uint64_t	lastFrameAllocations;
+		uint64_t	lastFrameBytes;
+		uint64_t	totalAllocations;
+	};
+
+
+	FLEXKITAPI void TrackAllocation		(const void* _ptr, const size_t size, const char* allocatorName) noexcept;
+	FLEXKITAPI void TrackFree			(const void* _ptr) noexcept;
+	FLEXKITAPI void TrackTransient		(const size_t size, const char* allocatorName) noexcept;
+
+	// Moves the per frame counters into lastFrame, call once per frame
+	FLEXKITAPI void AllocationTelemetryNextFrame() noexcept;
+
+	FLEXKITAPI AllocationTagStats	GetAllocationTotals		() noexcept;
+	FLEXKITAPI size_t				GetAllocationTagStats	(AllocationTagStats* out, const size_t maxCount) noexcept;
+
+	// Writes the per tag table followed by every live tracked allocation, largest first
+	FLEXKITAPI bool					DumpAllocationTelemetry	(const char* fileName);
+
+
+}	/************************************************************************************************/
+
+#endif
@@ -0,0 +1,512 @@
+/**********************************************************************
+
+Copyright (c) 2015 - 2019 Robert May
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************/
+
+#include "AssetLoader.h"
+
+namespace FlexKit
+{
+	/************************************************************************************************/
+
+
+	static bool IsFinished(const AssetLoadState state)
+	{
+		return	state == AssetLoadState::Loaded ||
+				state == AssetLoadState::Failed ||
+				state == AssetLoadState::Cancelled;
+	}
+
+
+	/************************************************************************************************/
+
+
+	AssetRequestHandle::AssetRequestHandle(AssetRequest* IN_request, const uint32_t IN_subscriber) :
+		request		{ IN_request	},
+		subscriber	{ IN_subscriber	} {}
+
+
+	AssetRequestHandle::AssetRequestHandle(const AssetRequestHandle& rhs) :
+		request		{ rhs.request		},
+		subscriber	{ rhs.subscriber	}
+	{
+		if (request)
+			request->refCount++;
+	}
+
+
+	AssetRequestHandle::AssetRequestHandle(AssetRequestHandle&& rhs) noexcept :
+		request		{ rhs.request		},
+		subscriber	{ rhs.subscriber	}
+	{
+		rhs.request = nullptr;
+	}
+
+
+	AssetRequestHandle::~AssetRequestHandle()
+	{
+		Release();
+	}
+
+
+	AssetRequestHandle& AssetRequestHandle::operator = (const AssetRequestHandle& rhs)
+	{
+		if (rhs.request)
+			rhs.request->refCount++;
+
+		Release();
+
+		request		= rhs.request;
+		subscriber	= rhs.subscriber;
+
+		return *this;
+	}
+
+
+	AssetRequestHandle& AssetRequestHandle::operator = (AssetRequestHandle&& rhs) noexcept
+	{
+		if (this != &rhs)
+		{
+			Release();
+
+			request		= rhs.request;
+			subscriber	= rhs.subscriber;
+
+			rhs.request = nullptr;
+		}
+
+		return *this;
+	}
+
+
+	/************************************************************************************************/
+
+
+	AssetLoadState AssetRequestHandle::GetState() const
+	{
+		return request ? request->state.load() : AssetLoadState::Failed;
+	}
+
+
+	bool AssetRequestHandle::IsReady() const
+	{
+		return IsFinished(GetState());
+	}
+
+
+	void AssetRequestHandle::Wait()
+	{
+		if (request)
+			request->loader._Wait(request);
+	}
+
+
+	void AssetRequestHandle::Cancel()
+	{
+		if (request)
+			request->loader._Cancel(request, subscriber);
+	}
+
+
+	AssetHandle AssetRequestHandle::GetAsset() const
+	{
+		return GetState() == AssetLoadState::Loaded ? request->result.handle : INVALIDHANDLE;
+	}
+
+
+	Resource* AssetRequestHandle::GetResource() const
+	{
+		return GetState() == AssetLoadState::Loaded ? request->result.resource : nullptr;
+	}
+
+
+	void AssetRequestHandle::Release()
+	{
+		if (request)
+			request->loader._ReleaseRequest(request);
+
+		request = nullptr;
+	}
+
+
+	/************************************************************************************************/
+
+
+	AssetLoader::AssetLoader(ThreadManager& IN_threads, iAssetReader& IN_reader, iAllocator* IN_allocator, const AssetLoaderDesc& IN_desc) :
+		threads		{ IN_threads	},
+		reader		{ IN_reader		},
+		allocator	{ IN_allocator	},
+		desc		{ IN_desc		},
+		active		{ IN_allocator	}
+	{
+		for (auto& queue : queues)
+			queue = Vector<AssetRequest*>{ IN_allocator, desc.queueSize };
+
+		ioThread = std::thread{ [&] { _IOThread(); } };
+	}
+
+
+	AssetLoader::~AssetLoader()
+	{
+		Shutdown();
+
+		for (auto& queue : queues)
+			queue.Release();
+
+		active.Release();
+	}
+
+
+	/************************************************************************************************/
+
+
+	AssetRequestHandle AssetLoader::Request(const GUID_t guid, const AssetLoadPriority priority, AssetLoadCallback callback)
+	{
+		std::scoped_lock localLock{ lock };
+
+		if (!running)
+			return {};
+
+		AssetRequest* request = _FindActive(guid);
+
+		if (request)
+		{
+			if (priority < request->priority)
+			{
+				const bool queued = request->state == AssetLoadState::Queued;
+
+				if (queued)
+					_Dequeue(request);
+
+				request->priority = priority;
+
+				if (queued)
+					_Enqueue(request);
+			}
+		}
+		else
+		{
+			request = &allocator->allocate<AssetRequest>(*this, guid, priority, allocator);
+			active.push_back(request);
+
+			if (queuedCount < desc.queueSize)
+				_Enqueue(request);
+			else
+			{
+				// Full, make room by dropping the newest of the least important requests, if this one outranks it
+				AssetRequest* dropped = nullptr;
+
+				for (size_t I = (size_t)AssetLoadPriority::Count - 1; I > (size_t)priority && !dropped; --I)
+				{
+					if (queues[I].size())
+						dropped = queues[I].back();
+				}
+
+				if (dropped)
+				{
+					_Dequeue(dropped);
+					_Enqueue(request);
+
+					inFlight++;
+					_Dispatch(dropped);
+				}
+				else
+				{
+					FK_LOG_9("Asset request queue full, refusing request");
+
+					inFlight++;
+					_Dispatch(request);
+				}
+			}
+		}
+
+		const auto subscriber = (uint32_t)request->subscribers.emplace_back(AssetRequest::Subscriber{ std::move(callback), false });
+
+		request->interested++;
+		request->refCount++;
+
+		return { request, subscriber };
+	}
+
+
+	/************************************************************************************************/
+
+
+	void AssetLoader::Shutdown()
+	{
+		if (!ioThread.joinable())
+			return;
+
+		{
+			std::scoped_lock localLock{ lock };
+
+			running = false;
+
+			for (auto& queue : queues)
+			{
+				while (queue.size())
+				{
+					auto request = queue.pop_back();
+					_Retire(request, AssetLoadState::Cancelled);
+				}
+			}
+
+			queuedCount = 0;
+		}
+
+		ioCV.notify_all();
+		ioThread.join();
+
+		std::unique_lock localLock{ lock };
+		doneCV.wait(localLock, [&] { return inFlight == 0; });
+	}
+
+
+	/************************************************************************************************/
+
+
+	size_t AssetLoader::GetQueuedCount() const
+	{
+		std::scoped_lock localLock{ lock };
+		return queuedCount;
+	}
+
+
+	size_t AssetLoader::GetInFlightCount() const
+	{
+		std::scoped_lock localLock{ lock };
+		return inFlight;
+	}
+
+
+	/************************************************************************************************/
+
+
+	void AssetLoader::_IOThread()
+	{
+		std::unique_lock localLock{ lock };
+
+		while (true)
+		{
+			ioCV.wait(localLock, [&] { return !running || (queuedCount && inFlight < desc.maxInFlight); });
+
+			if (!running)
+				return;
+
+			AssetRequest* request = _PopNext();
+			request->state = AssetLoadState::Reading;
+			inFlight++;
+
+			localLock.unlock();
+			const auto result = reader.Read(request->guid);
+			localLock.lock();
+
+			request->result = result;
+
+			if (!request->interested)
+			{	// Everyone cancelled while the read was in progress
+				inFlight--;
+				_Retire(request, AssetLoadState::Cancelled);
+			}
+			else
+				_Dispatch(request);
+		}
+	}
+
+
+	/************************************************************************************************/
+
+
+	// Subscribers can still join while the callbacks run, the request only retires once none are left
+	void AssetLoader::_Decode(AssetRequest* request)
+	{
+		std::unique_lock localLock{ lock };
+
+		for (size_t I = 0; I < request->subscribers.size(); ++I)
+		{
+			auto& subscriber = request->subscribers[I];
+
+			if (subscriber.cancelled)
+				continue;
+
+			AssetLoadCallback callback = std::move(subscriber.callback);
+			const auto result = request->result;
+
+			localLock.unlock();
+			callback(result.handle, result.resource);
+			localLock.lock();
+		}
+
+		inFlight--;
+		_Retire(request, request->result.resource ? AssetLoadState::Loaded : AssetLoadState::Failed);
+
+		ioCV.notify_one();
+	}
+
+
+	/************************************************************************************************/
+
+
+	void AssetLoader::_Enqueue(AssetRequest* request)
+	{
+		queues[(size_t)request->priority].push_back(request);
+		queuedCount++;
+
+		ioCV.notify_one();
+	}
+
+
+	void AssetLoader::_Dequeue(AssetRequest* request)
+	{
+		auto& queue = queues[(size_t)request->priority];
+
+		for (auto itr = queue.begin(); itr != queue.end(); ++itr)
+		{
+			if (*itr == request)
+			{
+				queue.remove_stable(itr);
+				queuedCount--;
+				return;
+			}
+		}
+	}
+
+
+	AssetRequest* AssetLoader::_PopNext()
+	{
+		for (auto& queue : queues)
+		{
+			if (queue.size())
+			{
+				auto request = queue.front();
+				queue.remove_stable(queue.begin());
+				queuedCount--;
+
+				return request;
+			}
+		}
+
+		return nullptr;
+	}
+
+
+	AssetRequest* AssetLoader::_FindActive(const GUID_t guid)
+	{
+		for (auto request : active)
+		{
+			if (request->guid == guid)
+				return request;
+		}
+
+		return nullptr;
+	}
+
+
+	/************************************************************************************************/
+
+
+	void AssetLoader::_Retire(AssetRequest* request, const AssetLoadState finalState)
+	{
+		for (auto itr = active.begin(); itr != active.end(); ++itr)
+		{
+			if (*itr == request)
+			{
+				active.remove_unstable(itr);
+				break;
+			}
+		}
+
+		request->state = finalState;
+		doneCV.notify_all();
+
+		_ReleaseRequest(request);
+	}
+
+
+	// Expects the request to already be counted in inFlight
+	void AssetLoader::_Dispatch(AssetRequest* request)
+	{
+		request->state = AssetLoadState::Decoding;
+
+		auto& work = CreateWorkItem(
+			[this, request]
+			{
+				_Decode(request);
+			}, allocator, allocator);
+
+		// Called from the I/O thread and whichever thread made the request, neither has a local work queue
+		threads.AddBackgroundWork(work);
+	}
+
+
+	/************************************************************************************************/
+
+
+	void AssetLoader::_Wait(AssetRequest* request)
+	{
+		std::unique_lock localLock{ lock };
+
+		if (request->state == AssetLoadState::Queued && request->priority != AssetLoadPriority::Immediate)
+		{
+			_Dequeue(request);
+			request->priority = AssetLoadPriority::Immediate;
+			_Enqueue(request);
+		}
+
+		doneCV.wait(localLock, [&] { return IsFinished(request->state); });
+	}
+
+
+	void AssetLoader::_Cancel(AssetRequest* request, const uint32_t subscriber)
+	{
+		std::scoped_lock localLock{ lock };
+
+		auto& entry = request->subscribers[subscriber];
+
+		if (entry.cancelled)
+			return;
+
+		entry.cancelled = true;
+		request->interested--;
+
+		if (!request->interested && request->state == AssetLoadState::Queued)
+		{
+			_Dequeue(request);
+			_Retire(request, AssetLoadState::Cancelled);
+		}
+	}
+
+
+	void AssetLoader::_ReleaseRequest(AssetRequest* request)
+	{
+		if (request->refCount.fetch_sub(1) != 1)
+			return;
+
+		if (request->result.handle != INVALIDHANDLE)
+			reader.Release(request->result);
+
+		request->subscribers.Release();
+		allocator->release(request);
+	}
+
+
+}	/************************************************************************************************/
@@ -0,0 +1,230 @@
+/**********************************************************************
+
+Copyright (c) 2015 - 2019 Robert May
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************/
+
+#ifndef ASSETLOADER_H_INCLUDED
+#define ASSETLOADER_H_INCLUDED
+
+#include "..\buildsettings.h"
+#include "..\coreutilities\containers.h"
+#include "..\coreutilities\ThreadUtilities.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Asynchronous asset requests. Reads run on the loader's own I/O thread, one at a time, highest priority
+// first. Once an asset is read its callbacks run on a ThreadManager worker, which is where decoding
+// belongs. Requests for a GUID already in flight are folded into the existing request.
+
+namespace FlexKit
+{
+	struct Resource;
+
+
+	/************************************************************************************************/
+
+
+	enum class AssetLoadPriority : uint32_t
+	{
+		Immediate,	// Needed this frame
+		Visible,	// Needed soon, in view but can draw with a fallback
+		Prefetch,	// Speculative, first to be dropped when the queue is full
+		Count
+	};
+
+
+	enum class AssetLoadState : uint32_t
+	{
+		Queued,
+		Reading,
+		Decoding,	// Callbacks are running
+		Loaded,
+		Failed,
+		Cancelled
+	};
+
+
+	struct AssetReadResult
+	{
+		AssetHandle	handle		= INVALIDHANDLE;
+		Resource*	resource	= nullptr;
+	};
+
+
+	// The I/O step, Read runs on the loader's I/O thread and should leave the blob resident with a
+	// reference held. Release drops that reference, from whichever thread drops the last request handle.
+	class iAssetReader
+	{
+	public:
+		virtual ~iAssetReader() {}
+
+		virtual AssetReadResult	Read	(const GUID_t guid)				= 0;
+		virtual void			Release	(const AssetReadResult& asset)	= 0;
+	};
+
+
+	// Runs on a worker, handle and resource are INVALIDHANDLE and nullptr when the read failed or the
+	// request was dropped to make room in the queue. Not called for cancelled requests.
+	using AssetLoadCallback = TypeErasedCallable<48, void, AssetHandle, Resource*>;
+
+
+	/************************************************************************************************/
+
+
+	class AssetLoader;
+
+	struct AssetRequest
+	{
+		struct Subscriber
+		{
+			AssetLoadCallback	callback;
+			bool				cancelled;
+		};
+
+		AssetRequest(AssetLoader& IN_loader, const GUID_t IN_guid, const AssetLoadPriority IN_priority, iAllocator* allocator) :
+			loader		{ IN_loader		},
+			guid		{ IN_guid		},
+			priority	{ IN_priority	},
+			subscribers	{ allocator		} {}
+
+		AssetLoader&				loader;
+		const GUID_t				guid;
+		AssetLoadPriority			priority;		// guarded by the loader's lock
+		std::atomic<AssetLoadState>	state		= AssetLoadState::Queued;
+		std::atomic_uint32_t		refCount	= 1;	// the loader's, until the request retires
+		uint32_t					interested	= 0;	// subscribers not yet cancelled, guarded by the loader's lock
+		AssetReadResult				result;
+		Vector<Subscriber>			subscribers;	// guarded by the loader's lock
+	};
+
+
+	// One subscription to a request. Copies share the subscription, the request and its asset reference
+	// live until the last handle to it is gone. Handles must not outlive their loader.
+	class FLEXKITAPI AssetRequestHandle
+	{
+	public:
+		AssetRequestHandle() = default;
+		AssetRequestHandle(AssetRequest* IN_request, const uint32_t IN_subscriber);
+
+		AssetRequestHandle(const AssetRequestHandle& rhs);
+		AssetRequestHandle(AssetRequestHandle&& rhs) noexcept;
+		~AssetRequestHandle();
+
+		AssetRequestHandle& operator = (const AssetRequestHandle& rhs);
+		AssetRequestHandle& operator = (AssetRequestHandle&& rhs) noexcept;
+
+		AssetLoadState	GetState	() const;
+		bool			IsReady		() const; // Loaded, Failed or Cancelled
+		bool			IsValid		() const { return request != nullptr; }
+
+		// Blocks until the request finishes, bumping it to Immediate first. Do not call from a worker,
+		// the callbacks it would be waiting on may need that worker.
+		void			Wait		();
+
+		// Drops this subscription, the read is skipped if nothing else wants the asset. Once the
+		// request is decoding the callback may already be running.
+		void			Cancel		();
+
+		// Valid once Loaded, for as long as the handle is held
+		AssetHandle		GetAsset	() const;
+		Resource*		GetResource	() const;
+
+		void			Release		();
+
+	private:
+		AssetRequest*	request		= nullptr;
+		uint32_t		subscriber	= 0;
+	};
+
+
+	/************************************************************************************************/
+
+
+	struct AssetLoaderDesc
+	{
+		size_t queueSize	= 256;	// queued requests, beyond this lower priority requests are dropped or refused
+		size_t maxInFlight	= 8;	// read but not finished decoding, the I/O thread stalls until one finishes
+	};
+
+
+	class FLEXKITAPI AssetLoader
+	{
+	public:
+		AssetLoader(ThreadManager& IN_threads, iAssetReader& IN_reader, iAllocator* IN_allocator, const AssetLoaderDesc& desc = {});
+		~AssetLoader();
+
+		AssetLoader				(const AssetLoader&) = delete;
+		AssetLoader& operator =	(const AssetLoader&) = delete;
+
+		// Never blocks on I/O. Requests for a GUID already queued or reading share one read and can only
+		// raise its priority.
+		AssetRequestHandle Request(const GUID_t guid, const AssetLoadPriority priority, AssetLoadCallback callback = [](AssetHandle, Resource*) {});
+
+		// Cancels everything still queued, waits for reads and callbacks in flight and stops the I/O thread
+		void Shutdown();
+
+		size_t GetQueuedCount	() const;
+		size_t GetInFlightCount	() const;
+
+	private:
+		friend class AssetRequestHandle;
+
+		void _IOThread	();
+		void _Decode	(AssetRequest* request);
+
+		// All of these expect lock to be held
+		void			_Enqueue		(AssetRequest* request);
+		void			_Dequeue		(AssetRequest* request);
+		AssetRequest*	_PopNext		();
+		AssetRequest*	_FindActive		(const GUID_t guid);
+		void			_Retire			(AssetRequest* request, const AssetLoadState finalState);
+		void			_Dispatch		(AssetRequest* request);
+
+		void			_Wait			(AssetRequest* request);
+		void			_Cancel			(AssetRequest* request, const uint32_t subscriber);
+		void			_ReleaseRequest	(AssetRequest* request);
+
+		ThreadManager&				threads;
+		iAssetReader&				reader;
+		iAllocator*					allocator;
+		const AssetLoaderDesc		desc;
+
+		mutable std::mutex			lock;
+		std::condition_variable		ioCV;		// work queued, space freed or shutting down
+		std::condition_variable		doneCV;		// a request retired
+
+		Vector<AssetRequest*>		queues[(size_t)AssetLoadPriority::Count]; // FIFO per priority
+		Vector<AssetRequest*>		active;		// queued, reading or decoding, what new requests coalesce against
+		size_t						queuedCount	= 0;
+		size_t						inFlight	= 0;
+		bool						running		= true;
+
+		std::thread					ioThread;
+	};
+
+
+}	/************************************************************************************************/
+
+#endif
@@ -25,81 +25,380 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Assets.h"
 #include "..\graphicsutilities\graphics.h"
 
+#include <chrono>
+
 namespace FlexKit
 {
 	/************************************************************************************************/
 
 
-	void InitiateAssetTable(iAllocator* Memory)
+	void AssetLookupTable::Insert(const uint64_t key, const uint32_t asset)
 	{
-		Resources.Tables			= Vector<ResourceTable*>(Memory);
-		Resources.ResourceFiles		= Vector<ResourceDirectory>(Memory);
-		Resources.ResourcesLoaded	= Vector<Resource*>(Memory);
-		Resources.ResourceGUIDs		= Vector<GUID_t>(Memory);
-		Resources.ResourceMemory	= Memory;
+		if ((count + 1) * 2 > values.size())
+			_Grow();
+
+		const size_t mask = values.size() - 1;
+
+		size_t slot = _GetSlot(key);
+		while (values[slot] != Empty)
+			slot = (slot + 1) & mask;
+
+		keys[slot]		= key;
+		values[slot]	= asset;
+		count++;
 	}
 
-	
+
+	void AssetLookupTable::clear()
+	{
+		for (auto& value : values)
+			value = Empty;
+
+		count = 0;
+	}
+
+
+	size_t AssetLookupTable::_GetSlot(const uint64_t key) const
+	{
+		// GUIDs are often sequential, mix them before masking
+		uint64_t h = key;
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdull;
+		h ^= h >> 33;
+
+		return size_t(h) & (values.size() - 1);
+	}
+
+
+	void AssetLookupTable::_Grow()
+	{
+		const size_t newSize = values.size() ? values.size() * 2 : 64;
+
+		Vector<uint64_t> oldKeys	= std::move(keys);
+		Vector<uint32_t> oldValues	= std::move(values);
+
+		keys	= Vector<uint64_t>{ oldKeys.Allocator, newSize, uint64_t(0) };
+		values	= Vector<uint32_t>{ oldValues.Allocator, newSize, Empty };
+		count	= 0;
+
+		for (size_t I = 0; I < oldValues.size(); ++I)
+		{
+			if (oldValues[I] != Empty)
+				Insert(oldKeys[I], oldValues[I]);
+		}
+	}
+
+
 	/************************************************************************************************/
 
 
-	void ReleaseAssetTable()
+	static uint64_t HashAssetID(const char* ID)
 	{
-		for (auto* Table : Resources.Tables)
-			Resources.ResourceMemory->free(Table);
+		// FNV-1a
+		uint64_t hash = 14695981039346656037ull;
 
-		for (auto* Resource : Resources.ResourcesLoaded)
-			Resources.ResourceMemory->free(Resource);
+		for (size_t I = 0; I < ID_LENGTH && ID[I]; ++I)
+			hash = (hash ^ uint8_t(ID[I])) * 1099511628211ull;
 
-		Resources.Tables.Release();
-		Resources.ResourceFiles.Release();
-		Resources.ResourcesLoaded.Release();
-		Resources.ResourceGUIDs.Release();
+		return hash;
 	}
 
 
+	static const ResourceEntry& GetResourceEntry(const AssetEntry& asset)
+	{
+		return Resources.Files[asset.file].GetTable()->Entries[asset.entry];
+	}
 
-	void AddAssetFile(char* FILELOC)
+
+	static uint32_t FindAsset(const GUID_t guid)
+	{
+		return Resources.GUIDLookup.Find(guid,
+			[&](const uint32_t asset) { return GetResourceEntry(Resources.Assets[asset]).GUID == guid; });
+	}
+
+
+	static uint32_t FindAsset(const char* ID)
+	{
+		return Resources.IDLookup.Find(HashAssetID(ID),
+			[&](const uint32_t asset) { return !strncmp(GetResourceEntry(Resources.Assets[asset]).ID, ID, ID_LENGTH); });
+	}
+
+
+	/************************************************************************************************/
+
+
+	static bool MapResourceFile(const char* fileLoc, ResourceFile& out)
+	{
+		out.file = CreateFileA(fileLoc, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+
+		if (out.file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER fileSize;
+		if (GetFileSizeEx(out.file, &fileSize) && size_t(fileSize.QuadPart) >= sizeof(ResourceTable))
+		{
+			out.mapping = CreateFileMappingA(out.file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+
+			if (out.mapping)
+			{
+				out.view		= (byte*)MapViewOfFile(out.mapping, FILE_MAP_COPY, 0, 0, 0);
+				out.viewSize	= size_t(fileSize.QuadPart);
+
+				const auto* table = out.GetTable();
+
+				if (out.view && table->ResourceCount * sizeof(ResourceEntry) + sizeof(ResourceTable) <= out.viewSize)
+					return true;
+			}
+		}
+
+		if (out.view)
+			UnmapViewOfFile(out.view);
+
+		if (out.mapping)
+			CloseHandle(out.mapping);
+
+		CloseHandle(out.file);
+
+		out = ResourceFile{};
+
+		return false;
+	}
+
+
+	static void UnmapResourceFile(ResourceFile& file)
+	{
+		UnmapViewOfFile(file.view);
+		CloseHandle(file.mapping);
+		CloseHandle(file.file);
+
+		file = ResourceFile{};
+	}
+
+
+	/************************************************************************************************/
+
+
+	static void RecordAssetLoad(const EResourceType type, const size_t storedBytes, const size_t loadedBytes, const double seconds)
+	{
+		if (type >= EResource_Count)
+			return;
+
+		auto& stats = Resources.LoadStats[type];
+		stats.loadCount++;
+		stats.storedBytes	+= storedBytes;
+		stats.loadedBytes	+= loadedBytes;
+		stats.loadSeconds	+= seconds;
+	}
+
+
+	// Drops the lock while decoding so other assets stay available, two threads loading the same
+	// asset can both decode it and the loser frees its copy
+	static Resource* DecompressAssetBlob(const uint32_t assetIdx, std::unique_lock<std::mutex>& lock)
+	{
+		const auto&		file		= Resources.Files[Resources.Assets[assetIdx].file];
+		const auto&		entry		= GetResourceEntry(Resources.Assets[assetIdx]);
+		const auto		type		= entry.Type;
+		const size_t	storedSize	= entry.StoredSize;
+
+		if (entry.ResourcePosition + storedSize > file.viewSize)
+			return nullptr;
+
+		const byte*		stored		= file.view + entry.ResourcePosition;
+		const size_t	rawSize		= GetDecompressedSize(stored, storedSize);
+
+		if (rawSize < sizeof(Resource))
+			return nullptr;
+
+		Resource* resource = (Resource*)Resources.ResourceMemory->_aligned_malloc(rawSize);
+		FK_ASSERT(resource, "OUT OF MEMORY!");
+
+		lock.unlock();
+
+		const auto	begin	= std::chrono::high_resolution_clock::now();
+		const bool	decoded	= DecompressBlob(stored, storedSize, (byte*)resource, rawSize, Resources.Threads, Resources.ResourceMemory);
+		const auto	end		= std::chrono::high_resolution_clock::now();
+
+		lock.lock();
+
+		auto& asset = Resources.Assets[assetIdx];
+
+		if (!decoded || asset.resource)
+		{
+			Resources.ResourceMemory->_aligned_free(resource);
+			return decoded ? asset.resource : nullptr;
+		}
+
+		RecordAssetLoad(type, storedSize, rawSize, std::chrono::duration<double>(end - begin).count());
+
+		resource->State		= Resource::EResourceState_LOADED;
+		resource->RefCount	= 0; // Not used, AssetEntry holds the count
+		asset.resource		= resource;
+		asset.mapped		= false;
+
+		return resource;
+	}
+
+
+	// Expects lock to be held
+	static Resource* LoadAssetBlob(const uint32_t assetIdx, std::unique_lock<std::mutex>& lock)
 	{
-		ResourceDirectory Dir;
-		strcpy_s(Dir.str, FILELOC);
+		FK_ALLOCATION_TAG("Assets");
+
+		auto&		asset		= Resources.Assets[assetIdx];
+		auto&		file		= Resources.Files[asset.file];
+		const auto&	entry		= GetResourceEntry(asset);
+		const size_t position	= entry.ResourcePosition;
+
+		FK_LOG_INFO("Loading Resource: %s : ResourceID: %u", entry.ID, entry.GUID);
+
+		if (entry.Compression == EResourceCompression_Blocks)
+			return DecompressAssetBlob(assetIdx, lock);
+
+		size_t resourceSize = 0;
 
-		FILE* F = 0;
-		int S   = fopen_s(&F, FILELOC, "rb");
+		if (position + sizeof(resourceSize) <= file.viewSize)
+			memcpy(&resourceSize, file.view + position, sizeof(resourceSize));
 
-		size_t TableSize	 = ReadAssetTableSize(F);
-		ResourceTable* Table = (ResourceTable*)Resources.ResourceMemory->_aligned_malloc(TableSize);
+		if (resourceSize < sizeof(Resource) || position + resourceSize > file.viewSize)
+			return nullptr;
+
+		Resource*	resource	= nullptr;
+		double		seconds		= 0.0;
 
-		if (ReadAssetTable(F, Table, TableSize))
+		if (position % ResourceBlobAlignment == 0)
 		{
-			Resources.ResourceFiles.push_back(Dir);
-			Resources.Tables.push_back(Table);
+			resource		= reinterpret_cast<Resource*>(file.view + position);
+			asset.mapped	= true;
 		}
 		else
-			Resources.ResourceMemory->_aligned_free(Table);
+		{	// Files written before blobs were padded
+			resource = (Resource*)Resources.ResourceMemory->_aligned_malloc(resourceSize);
+			FK_ASSERT(resource, "OUT OF MEMORY!");
+
+			const auto begin = std::chrono::high_resolution_clock::now();
+			memcpy(resource, file.view + position, resourceSize);
+			seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - begin).count();
+
+			asset.mapped = false;
+		}
+
+		RecordAssetLoad(entry.Type, resourceSize, resourceSize, seconds);
+
+		resource->State		= Resource::EResourceState_LOADED;
+		resource->RefCount	= 0; // Not used, AssetEntry holds the count
+		asset.resource		= resource;
+
+		return resource;
 	}
 
 
-	Pair<GUID_t, bool>	FindAssetGUID(char* Str)
+	static void EvictAsset(AssetEntry& asset)
 	{
-		bool Found = false;
-		GUID_t Guid = INVALIDHANDLE;
+		if (asset.resource && !asset.mapped)
+			Resources.ResourceMemory->_aligned_free(asset.resource);
 
-		for (auto T : Resources.Tables)
+		asset.resource = nullptr;
+		asset.refCount = 0;
+	}
+
+
+	static AssetHandle LoadAssetIndex(const uint32_t assetIdx, std::unique_lock<std::mutex>& lock)
+	{
+		if (assetIdx == AssetLookupTable::Empty)
+			return INVALIDHANDLE;
+
+		if (!Resources.Assets[assetIdx].resource && !LoadAssetBlob(assetIdx, lock))
 		{
-			auto end = T->ResourceCount;
-			for (size_t I = 0; I < end; ++I)
-			{
-				if (!strncmp(T->Entries[I].ID, Str, 64))
-				{
-					Found = true;
-					Guid = T->Entries[I].GUID;
-					return{ Guid, Found };
-				}
-			}
+			FK_ASSERT(false, "FAILED TO LOAD RESOURCE!");
+			return INVALIDHANDLE;
 		}
 
-		return{ Guid, Found };
+		return assetIdx;
+	}
+
+
+	/************************************************************************************************/
+
+
+	void InitiateAssetTable(iAllocator* Memory, ThreadManager* threads)
+	{
+		Resources.Files				= Vector<ResourceFile>(Memory);
+		Resources.Assets			= Vector<AssetEntry>(Memory);
+		Resources.GUIDLookup		= AssetLookupTable{ Memory };
+		Resources.IDLookup			= AssetLookupTable{ Memory };
+		Resources.ResourceMemory	= Memory;
+		Resources.Threads			= threads;
+
+		for (auto& stats : Resources.LoadStats)
+			stats = AssetLoadStats{};
+	}
+
+	
+	/************************************************************************************************/
+
+
+	void ReleaseAssetTable()
+	{
+		FreeAllAssetFiles();
+
+		Resources.Files.Release();
+		Resources.Assets.Release();
+		Resources.GUIDLookup.keys.Release();
+		Resources.GUIDLookup.values.Release();
+		Resources.IDLookup.keys.Release();
+		Resources.IDLookup.values.Release();
+	}
+
+
+	/************************************************************************************************/
+
+
+	void AddAssetFile(char* FILELOC)
+	{
+		std::scoped_lock lock{ Resources.lock };
+
+		ResourceFile file;
+		strcpy_s(file.path.str, FILELOC);
+
+		if (!MapResourceFile(FILELOC, file))
+		{
+			FK_LOG_ERROR("Failed to open resource file: %s", FILELOC);
+			return;
+		}
+
+		const auto	fileIdx = (uint32_t)Resources.Files.push_back(file);
+		const auto* table	= file.GetTable();
+
+		for (uint32_t I = 0; I < table->ResourceCount; ++I)
+		{
+			const auto& entry = table->Entries[I];
+
+			if (FindAsset(entry.GUID) != AssetLookupTable::Empty)
+				continue;
+
+			const auto assetIdx = (uint32_t)Resources.Assets.push_back(AssetEntry{ fileIdx, I, 0, nullptr, false });
+
+			Resources.GUIDLookup.Insert(entry.GUID, assetIdx);
+
+			if (FindAsset(entry.ID) == AssetLookupTable::Empty)
+				Resources.IDLookup.Insert(HashAssetID(entry.ID), assetIdx);
+		}
+	}
+
+
+	/************************************************************************************************/
+
+
+	Pair<GUID_t, bool>	FindAssetGUID(char* Str)
+	{
+		std::scoped_lock lock{ Resources.lock };
+
+		const auto assetIdx = FindAsset(Str);
+
+		if (assetIdx == AssetLookupTable::Empty)
+			return{ INVALIDHANDLE, false };
+
+		return{ GetResourceEntry(Resources.Assets[assetIdx]).GUID, true };
 	}
 
 
@@ -111,8 +410,29 @@ namespace FlexKit
 		if (RHandle == INVALIDHANDLE)
 			return nullptr;
 
-		Resources.ResourcesLoaded[RHandle]->RefCount++;
-		return Resources.ResourcesLoaded[RHandle];
+		std::unique_lock lock{ Resources.lock };
+
+		if (!Resources.Assets[RHandle].resource && !LoadAssetBlob((uint32_t)RHandle, lock))
+			return nullptr;
+
+		auto& asset = Resources.Assets[RHandle];
+
+		asset.refCount++;
+		return asset.resource;
+	}
+
+
+	/************************************************************************************************/
+
+
+	const char* GetAssetID(AssetHandle RHandle)
+	{
+		if (RHandle == INVALIDHANDLE)
+			return nullptr;
+
+		std::scoped_lock lock{ Resources.lock };
+
+		return GetResourceEntry(Resources.Assets[RHandle]).ID;
 	}
 
 
@@ -121,8 +441,10 @@ namespace FlexKit
 
 	void FreeAllAssets()
 	{
-		for (auto R : Resources.ResourcesLoaded)
-			if(Resources.ResourceMemory) Resources.ResourceMemory->_aligned_free(R);
+		std::scoped_lock lock{ Resources.lock };
+
+		for (auto& asset : Resources.Assets)
+			EvictAsset(asset);
 	}
 
 
@@ -131,8 +453,17 @@ namespace FlexKit
 
 	void FreeAllAssetFiles()
 	{
-		for (auto T : Resources.Tables)
-			Resources.ResourceMemory->_aligned_free(T);
+		FreeAllAssets();
+
+		std::scoped_lock lock{ Resources.lock };
+
+		for (auto& file : Resources.Files)
+			UnmapResourceFile(file);
+
+		Resources.Files.clear();
+		Resources.Assets.clear();
+		Resources.GUIDLookup.clear();
+		Resources.IDLookup.clear();
 	}
 
 
@@ -141,12 +472,25 @@ namespace FlexKit
 
 	void FreeAsset(AssetHandle RHandle)
 	{
-		Resources.ResourcesLoaded[RHandle]->RefCount--;
-		if (Resources.ResourcesLoaded[RHandle]->RefCount == 0)
+		if (RHandle == INVALIDHANDLE)
+			return;
+
+		std::scoped_lock lock{ Resources.lock };
+
+		auto& asset = Resources.Assets[RHandle];
+
+		// Loaded by LoadGameAsset with no GetAsset after it, nothing references it
+		if (!asset.refCount)
 		{
-			// Evict
-			// TODO: Resource Eviction
+			if (!asset.mapped)
+				EvictAsset(asset);
+
+			return;
 		}
+
+		// Mapped blobs cost nothing to keep, and stay valid as long as the file is mapped
+		if (!--asset.refCount && !asset.mapped)
+			EvictAsset(asset);
 	}
 
 
@@ -155,152 +499,107 @@ namespace FlexKit
 
 	AssetHandle LoadGameAsset(GUID_t guid)
 	{
-		for (size_t I = 0; I < Resources.ResourcesLoaded.size(); ++I)
-			if (Resources.ResourceGUIDs[I] == guid)
-				return I;
+		std::unique_lock lock{ Resources.lock };
 
-        AssetHandle RHandle = INVALIDHANDLE;
-		for (size_t TI = 0; TI < Resources.Tables.size(); ++TI)
-		{
-			auto& t = Resources.Tables[TI];
-			for (size_t I = 0; I < t->ResourceCount; ++I)
-			{
-				if (t->Entries[I].GUID == guid)
-				{
-
-					FILE* F             = 0;
-					int S               = fopen_s(&F, Resources.ResourceFiles[TI].str, "rb");
-					size_t ResourceSize = ReadAssetSize(F, t, I);
+		return LoadAssetIndex(FindAsset(guid), lock);
+	}
 
-					Resource* NewResource = (Resource*)Resources.ResourceMemory->_aligned_malloc(ResourceSize);
-					if (!NewResource)
-					{
-						// Memory Full
-						// Evict A Unused Resource
-						// TODO: Handle running out of memory
-						FK_ASSERT(false, "OUT OF MEMORY!");
-					}
 
-					if (!ReadResource(F, t, I, NewResource))
-					{
-						Resources.ResourceMemory->_aligned_free(NewResource);
+	/************************************************************************************************/
 
-						FK_ASSERT(false, "FAILED TO LOAD RESOURCE!");
-					}
-					else
-					{
-						NewResource->State		= Resource::EResourceState_LOADED;
-						NewResource->RefCount	= 0;
-						RHandle					= Resources.ResourcesLoaded.size();
-						Resources.ResourcesLoaded.push_back(NewResource);
-						Resources.ResourceGUIDs.push_back(NewResource->GUID);
-					}
 
-					::fclose(F);
-					return RHandle;
-				}
-			}
-		}
+    AssetHandle LoadGameAsset(const char* ID)
+	{
+		std::unique_lock lock{ Resources.lock };
 
-		return RHandle;
+		return LoadAssetIndex(FindAsset(ID), lock);
 	}
 
 
 	/************************************************************************************************/
 
 
-    AssetHandle LoadGameAsset(const char* ID)
+	bool isAssetAvailable(GUID_t ID)
 	{
-		for (size_t I = 0; I < Resources.ResourcesLoaded.size(); ++I)
-			if (!strcmp(Resources.ResourcesLoaded[I]->ID, ID))
-				return I;
-
-        AssetHandle RHandle = 0xFFFFFFFFFFFFFFFF;
-		for (size_t TI = 0; TI < Resources.Tables.size(); ++TI)
-		{
-			auto& t = Resources.Tables[TI];
-			for (size_t I = 0; I < t->ResourceCount; ++I)
-			{
-				if (!strcmp(t->Entries[I].ID, ID))
-				{
-					FILE* F             = 0;
-					int S               = fopen_s(&F, Resources.ResourceFiles[TI].str, "rb");
-					size_t ResourceSize = FlexKit::ReadAssetSize(F, t, I);
+		std::scoped_lock lock{ Resources.lock };
 
-					Resource* NewResource = (Resource*)Resources.ResourceMemory->_aligned_malloc(ResourceSize);
-					if (!NewResource)
-					{
-						// Memory Full
-						// Evict A Unused Resource
-						// TODO: THIS
-						FK_ASSERT(false, "OUT OF MEMORY!");
-					}
+		return FindAsset(ID) != AssetLookupTable::Empty;
+	}
 
-					if (!FlexKit::ReadResource(F, t, I, NewResource))
-					{
-						FK_ASSERT(false, "FAILED TO LOAD RESOURCE!");
-					}
-					else
-					{
-						NewResource->State		= Resource::EResourceState_LOADED;
-						NewResource->RefCount	= 0;
-						RHandle					= Resources.ResourcesLoaded.size();
-						Resources.ResourcesLoaded.push_back(NewResource);
-						Resources.ResourceGUIDs.push_back(NewResource->GUID);
-					}
 
-					::fclose(F);
-					return RHandle;
-				}
-			}
-		}
+	bool isAssetAvailable(const char* ID)
+	{
+		std::scoped_lock lock{ Resources.lock };
 
-		return RHandle;
+		return FindAsset(ID) != AssetLookupTable::Empty;
 	}
 
 
 	/************************************************************************************************/
 
 
-	bool isAssetAvailable(GUID_t ID)
+	AssetLoadStats GetAssetLoadStats(EResourceType type)
 	{
-		for (size_t I = 0; I < Resources.ResourcesLoaded.size(); ++I)
-			if (Resources.ResourcesLoaded[I]->GUID == ID)
-				return true;
-
-        AssetHandle RHandle = 0xFFFFFFFFFFFFFFFF;
-		for (size_t TI = 0; TI < Resources.Tables.size(); ++TI)
-		{
-			auto& t = Resources.Tables[TI];
-			for (size_t I = 0; I < t->ResourceCount; ++I)
-			{
-				if (t->Entries[I].GUID == ID)
-					return true;
-			}
-		}
+		std::scoped_lock lock{ Resources.lock };
 
-		return false;
+		return type < EResource_Count ? Resources.LoadStats[type] : AssetLoadStats{};
 	}
 
 
-	bool isAssetAvailable(const char* ID)
+	void LogAssetLoadStats()
 	{
-			for (size_t I = 0; I < Resources.ResourcesLoaded.size(); ++I)
-			if (!strcmp(Resources.ResourcesLoaded[I]->ID, ID))
-				return true;
+		static const char* typeNames[] = {
+			"Collider", "Font", "GameDB", "Skeleton", "SkeletalAnimation", "Shader",
+			"Scene", "TriMesh", "TerrainCollider", "Texture", "TextureSet", "CubeMapTexture" };
+
+		static_assert(sizeof(typeNames) / sizeof(typeNames[0]) == EResource_Count, "Missing resource type name!");
 
-        AssetHandle RHandle = 0xFFFFFFFFFFFFFFFF;
-		for (size_t TI = 0; TI < Resources.Tables.size(); ++TI)
+		for (size_t I = 0; I < EResource_Count; ++I)
 		{
-			auto& t = Resources.Tables[TI];
-			for (size_t I = 0; I < t->ResourceCount; ++I)
-			{
-				if (!strcmp(t->Entries[I].ID, ID))
-					return true;
-			}
+			const auto stats = GetAssetLoadStats(EResourceType(I));
+
+			if (!stats.loadCount)
+				continue;
+
+			FK_LOG_INFO("%s: %u loads, %u KB stored, %u KB loaded, ratio %.2f, %.1f MB/s",
+				typeNames[I],
+				(uint32_t)stats.loadCount,
+				(uint32_t)(stats.storedBytes / KILOBYTE),
+				(uint32_t)(stats.loadedBytes / KILOBYTE),
+				stats.GetCompressionRatio(),
+				stats.GetThroughput() / MEGABYTE);
 		}
+	}
 
-		return false;
+
+	/************************************************************************************************/
+
+
+	AssetReadResult GameResourceReader::Read(const GUID_t guid)
+	{
+		const AssetHandle handle = LoadGameAsset(guid);
+
+		if (handle == INVALIDHANDLE)
+			return {};
+
+		Resource* resource = GetAsset(handle);
+
+		if (!resource)
+			return {};
+
+		const volatile byte*	bytes	= reinterpret_cast<const byte*>(resource);
+		byte					touched	= 0;
+
+		for (size_t offset = 0; offset < resource->ResourceSize; offset += 4 * KILOBYTE)
+			touched += bytes[offset];
+
+		return { handle, resource };
+	}
+
+
+	void GameResourceReader::Release(const AssetReadResult& asset)
+	{
+		FreeAsset(asset.handle);
 	}
 
 
@@ -310,6 +609,9 @@ namespace FlexKit
 	bool Asset2TriMesh(RenderSystem* RS, CopyContextHandle handle, AssetHandle RHandle, iAllocator* Memory, TriMesh* Out, bool ClearBuffers)
 	{
 		Resource* R = GetAsset(RHandle);
+		if (!R)
+			return false;
+
 		if (R->State == Resource::EResourceState_LOADED && R->Type == EResource_TriMesh)
 		{
 			TriMeshAssetBlob* Blob = (TriMeshAssetBlob*)R;
@@ -360,6 +662,9 @@ namespace FlexKit
 
 			CreateVertexBuffer(RS, handle, Out->Buffers, Out->Buffers.size(), Out->VertexBuffer);
 
+			Out->TriMeshID = R->GUID;
+
+			// Otherwise the buffers still point into the blob, the reference is kept until the caller frees RHandle
 			if (ClearBuffers)
 			{
 				for (size_t I = 0; I < 16; ++I)
@@ -370,10 +675,11 @@ namespace FlexKit
 				}
 				FreeAsset(RHandle);
 			}
-		
-			Out->TriMeshID = R->GUID;
+
 			return true;
 		}
+
+		FreeAsset(RHandle);
 		return false;
 	}
 
@@ -404,12 +710,16 @@ namespace FlexKit
     /************************************************************************************************/
 
 
-    Vector<TextureBuffer> LoadCubeMapAsset(GUID_t resourceID, size_t& OUT_MIPCount, uint2& OUT_WH, DeviceFormat& OUT_format, iAllocator* allocator)
+    Vector<TextureBuffer> LoadCubeMapAsset(GUID_t resourceID, size_t& OUT_MIPCount, uint2& OUT_WH, DeviceFormat& OUT_format, AssetHandle& OUT_asset, iAllocator* allocator)
     {
         Vector<TextureBuffer> textureArray{ allocator };
 
-        auto assetHandle            = LoadGameAsset(resourceID);
-        CubeMapAssetBlob* resource  = reinterpret_cast<CubeMapAssetBlob*>(FlexKit::GetAsset(assetHandle));
+        OUT_asset = LoadGameAsset(resourceID);
+
+        CubeMapAssetBlob* resource = reinterpret_cast<CubeMapAssetBlob*>(FlexKit::GetAsset(OUT_asset));
+
+        if (!resource)
+            return textureArray;
 
         OUT_MIPCount    = resource->GetFace(0)->MipCount;
         OUT_WH          = { (uint32_t)resource->Width, (uint32_t)resource->Height };
@@ -489,15 +799,16 @@ namespace FlexKit
 			auto GameRes = GetAsset(RHandle);
 			if( Asset2TriMesh(RS, handle, RHandle, GeometryTable.Memory, &GeometryTable.Geometry[Index]))
 			{
-				FreeAsset(RHandle);
-
 				GeometryTable.Handles[Handle]			= (index_t)Index;
-				GeometryTable.GeometryIDs[Index]		= GameRes->ID;
+				GeometryTable.GeometryIDs[Index]		= GetAssetID(RHandle);
 				GeometryTable.Guids[Index]				= GUID;
 				GeometryTable.ReferenceCounts[Index]	= 1;
+
+				FreeAsset(RHandle);
 			}
 			else
 			{
+				FreeAsset(RHandle);
 				Handle = InvalidHandle_t;
 			}
 		}
@@ -516,16 +827,17 @@ namespace FlexKit
 			
 			if(Asset2TriMesh(RS, handle, RHandle, GeometryTable.Memory, &GeometryTable.Geometry[Index]))
 			{
-				FreeAsset(RHandle);
-
 				GeometryTable.Handles			[Handle]	= Index;
-				GeometryTable.GeometryIDs		[Index]		= GameRes->ID;
+				GeometryTable.GeometryIDs		[Index]		= GetAssetID(RHandle);
 				GeometryTable.Guids				[Index]		= GUID;
 				GeometryTable.ReferenceCounts	[Index]		= 1;
 				GeometryTable.Handle			[Index]		= Handle;
+
+				FreeAsset(RHandle);
 			}
 			else
 			{
+				FreeAsset(RHandle);
 				Handle = InvalidHandle_t;
 			}
 		}
@@ -559,15 +871,16 @@ namespace FlexKit
 			
 			if(Asset2TriMesh(RS, handle, RHandle, GeometryTable.Memory, &GeometryTable.Geometry[Index]))
 			{
-				FreeAsset(RHandle);
-
 				GeometryTable.Handles[Handle]			= (index_t)Index;
 				GeometryTable.GeometryIDs[Index]		= ID;
 				GeometryTable.Guids[Index]				= GameRes->GUID;
 				GeometryTable.ReferenceCounts[Index]	= 1;
+
+				FreeAsset(RHandle);
 			}
 			else
 			{
+				FreeAsset(RHandle);
 				Handle = InvalidHandle_t;
 			}
 		}
@@ -586,15 +899,16 @@ namespace FlexKit
 
 			if(Asset2TriMesh(RS, handle, RHandle, GeometryTable.Memory, &GeometryTable.Geometry[Index]))
 			{
-				FreeAsset(RHandle);
-
 				GeometryTable.Handles[Handle]			= Index;
-				GeometryTable.GeometryIDs[Index]		= GameRes->ID;
+				GeometryTable.GeometryIDs[Index]		= GetAssetID(RHandle);
 				GeometryTable.Guids[Index]				= GameRes->GUID;
 				GeometryTable.ReferenceCounts[Index]	= 1;
+
+				FreeAsset(RHandle);
 			}
 			else
 			{
+				FreeAsset(RHandle);
 				Handle = InvalidHandle_t;
 			}
 		}
@@ -30,9 +30,12 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "..\coreutilities\memoryutilities.h"
 #include "..\graphicsutilities\Fonts.h"
 #include "..\coreutilities\ResourceHandles.h"
+#include "..\coreutilities\AssetLoader.h"
+#include "..\coreutilities\BlockCompression.h"
 #include "TextureUtilities.h"
 
 #include <iostream>
+#include <mutex>
 
 
 /************************************************************************************************/
@@ -61,6 +64,7 @@ namespace FlexKit
 		EResource_Texture,
         EResource_TextureSet,
         EResource_CubeMapTexture,
+		EResource_Count
 	};
 
 	struct Resource
@@ -91,11 +95,18 @@ namespace FlexKit
 	/************************************************************************************************/
 
 
+	enum EResourceCompression : uint32_t
+	{
+		EResourceCompression_None,
+		EResourceCompression_Blocks, // See BlockCompression.h
+	};
+
 	struct ResourceEntry
 	{
 		GUID_t					GUID;
 		size_t					ResourcePosition;
-		char*					ResouceLOC; // Not Used in File
+		uint32_t				StoredSize;		// Bytes in the file when compressed
+		EResourceCompression	Compression;	// Was an unused pointer written as 0, so version 2 files read as uncompressed
 		EResourceType			Type;
 		char					ID[ID_LENGTH];
 	};
@@ -116,50 +127,148 @@ namespace FlexKit
 	{
 		char str[256];
 	};
-	
+
+
+	/************************************************************************************************/
+
+
+	// A memory mapped .gameres. The table and every blob are read straight out of the view, which is mapped
+	// copy on write so a blob's runtime members can still be written without touching the file.
+	struct ResourceFile
+	{
+		ResourceDirectory	path;
+		HANDLE				file		= INVALID_HANDLE_VALUE;
+		HANDLE				mapping		= nullptr;
+		byte*				view		= nullptr;
+		size_t				viewSize	= 0;
+
+		const ResourceTable* GetTable() const { return reinterpret_cast<const ResourceTable*>(view); }
+	};
+
+
+	// Per resource type, totals since the asset table was initiated
+	struct AssetLoadStats
+	{
+		size_t	loadCount		= 0;
+		size_t	storedBytes		= 0;	// as read from the file
+		size_t	loadedBytes		= 0;	// after decompression
+		double	loadSeconds		= 0.0;	// decompressing or copying, blobs used in place cost nothing here
+
+		double GetCompressionRatio	() const { return storedBytes ? double(loadedBytes) / double(storedBytes) : 1.0; }
+		double GetThroughput		() const { return loadSeconds > 0.0 ? double(loadedBytes) / loadSeconds : 0.0; } // bytes per second
+	};
+
+
+	// Every asset in every added file gets one of these, an AssetHandle indexes them
+	struct AssetEntry
+	{
+		uint32_t	file;
+		uint32_t	entry;		// into the file's ResourceTable
+		uint32_t	refCount;
+		Resource*	resource;	// nullptr while unloaded
+		bool		mapped;		// resource points into the file's view, otherwise it is a copy in ResourceMemory
+	};
+
+
+	// Open addressed hash from a 64 bit key to an asset index. String IDs are keyed by their hash,
+	// so Find takes a predicate to confirm the match.
+	struct AssetLookupTable
+	{
+		static constexpr uint32_t Empty = 0xffffffff;
+
+		AssetLookupTable(iAllocator* allocator = nullptr) :
+			keys	{ allocator },
+			values	{ allocator } {}
+
+		void Insert	(const uint64_t key, const uint32_t asset);
+		void clear	();
+
+		template<typename TY_PRED>
+		uint32_t Find(const uint64_t key, TY_PRED&& isMatch) const
+		{
+			if (!values.size())
+				return Empty;
+
+			const size_t mask = values.size() - 1;
+
+			for (size_t slot = _GetSlot(key); values[slot] != Empty; slot = (slot + 1) & mask)
+			{
+				if (keys[slot] == key && isMatch(values[slot]))
+					return values[slot];
+			}
+
+			return Empty;
+		}
+
+		size_t _GetSlot	(const uint64_t key) const;
+		void   _Grow	();
+
+		Vector<uint64_t>	keys;
+		Vector<uint32_t>	values;
+		size_t				count = 0;
+	};
+
+
 	struct GlobalResourceTable
 	{
 		~GlobalResourceTable()
 		{
-			Tables.A			= nullptr;
-			ResourceFiles.A		= nullptr;
-			ResourcesLoaded.A	= nullptr;
-			ResourceGUIDs.A		= nullptr;
-
-			Tables.Allocator			= nullptr;
-			ResourceFiles.Allocator		= nullptr;
-			ResourcesLoaded.Allocator	= nullptr;
-			ResourceGUIDs.Allocator		= nullptr;
+			Abandon(Files);
+			Abandon(Assets);
+			Abandon(GUIDLookup.keys);
+			Abandon(GUIDLookup.values);
+			Abandon(IDLookup.keys);
+			Abandon(IDLookup.values);
+		}
+
+		// Static destruction can run after ResourceMemory is gone
+		template<typename TY>
+		static void Abandon(Vector<TY>& v)
+		{
+			v.A			= nullptr;
+			v.Allocator	= nullptr;
 		}
 
-		Vector<ResourceTable*>		Tables;
-		Vector<ResourceDirectory>	ResourceFiles;
-		Vector<Resource*>			ResourcesLoaded;
-		Vector<GUID_t>				ResourceGUIDs;
-		iAllocator*					ResourceMemory;
+		Vector<ResourceFile>	Files;
+		Vector<AssetEntry>		Assets;
+		AssetLookupTable		GUIDLookup;
+		AssetLookupTable		IDLookup;
+		AssetLoadStats			LoadStats[EResource_Count];
+		iAllocator*				ResourceMemory;
+		ThreadManager*			Threads = nullptr; // helps decompress when set
+		std::mutex				lock;
 	}inline Resources;
 
 
 	/************************************************************************************************/
 
 
-	FLEXKITAPI void			InitiateAssetTable	(iAllocator* Memory);
+	FLEXKITAPI void			InitiateAssetTable	(iAllocator* Memory, ThreadManager* threads = nullptr);
 	FLEXKITAPI void			ReleaseAssetTable	();
 
 	FLEXKITAPI size_t		ReadAssetTableSize	    (FILE* F);
 	FLEXKITAPI size_t		ReadAssetSize		    (FILE* F, ResourceTable* Table, size_t Index);
 
+	// Maps the file and indexes its assets by GUID and ID, earlier files win when two hold the same asset
 	FLEXKITAPI void					AddAssetFile	(char* FILELOC);
+
+	// Adds a reference, reloading the asset if it was evicted. Every GetAsset needs a matching FreeAsset.
 	FLEXKITAPI Resource*			GetAsset		(AssetHandle RHandle);
 	FLEXKITAPI Pair<GUID_t, bool>	FindAssetGUID	(char* Str);
 
+	// Lives as long as the asset's file is added, unlike the ID inside the blob
+	FLEXKITAPI const char*			GetAssetID		(AssetHandle RHandle);
+
 
 	FLEXKITAPI bool			ReadAssetTable	(FILE* F, ResourceTable* Out, size_t TableSize);
 	FLEXKITAPI bool			ReadResource		(FILE* F, ResourceTable* Table, size_t Index, Resource* out);
 
+	// Blobs are handed out in place when the file keeps them aligned, otherwise they are copied.
+	// Loading does not add a reference, FreeAsset on a handle nothing took a reference through releases the blob.
 	FLEXKITAPI AssetHandle LoadGameAsset (const char* ID);
 	FLEXKITAPI AssetHandle LoadGameAsset (GUID_t GUID);
 
+	// Drops a reference, copied blobs are freed once nothing references them
 	FLEXKITAPI void FreeAsset			    (AssetHandle RHandle);
 	FLEXKITAPI void FreeAllAssets		();
 	FLEXKITAPI void FreeAllAssetFiles	();
@@ -167,10 +276,29 @@ namespace FlexKit
 	FLEXKITAPI bool isAssetAvailable		(GUID_t ID);
 	FLEXKITAPI bool isAssetAvailable		(const char* ID);
 
+	FLEXKITAPI AssetLoadStats	GetAssetLoadStats	(EResourceType type);
+	FLEXKITAPI void				LogAssetLoadStats	();
+
+
+	/************************************************************************************************/
+
+
+	// Feeds an AssetLoader from the added .gameres files. Read faults the blob's pages in on the I/O
+	// thread, a mapped blob would otherwise go to disk on first touch from whichever thread decodes it.
+	class FLEXKITAPI GameResourceReader final : public iAssetReader
+	{
+	public:
+		AssetReadResult	Read	(const GUID_t guid) override;
+		void			Release	(const AssetReadResult& asset) override;
+	};
+
 
 	/************************************************************************************************/
 
 
+	// Blob alignment the resource compiler pads to, blobs on this alignment are used straight from the file
+	const size_t ResourceBlobAlignment = 16;
+
 	const size_t GUIDMASK		= 0x00000000FFFFFFFF;
 
 
@@ -439,9 +567,12 @@ namespace FlexKit
 	/************************************************************************************************/
 
 
+	// With ClearBuffers false Out's buffers point into the blob and RHandle keeps a reference, free it once they are released
 	FLEXKITAPI bool				        Asset2TriMesh		( RenderSystem* RS, CopyContextHandle handle, AssetHandle RHandle, iAllocator* Memory, TriMesh* Out, bool ClearBuffers = true );
 	FLEXKITAPI TextureSet*		        Asset2TextureSet	( AssetHandle RHandle, iAllocator* Memory );
-    FLEXKITAPI Vector<TextureBuffer>    LoadCubeMapAsset    ( GUID_t resourceID, size_t& OUT_MIPCount, uint2& OUT_WH, DeviceFormat& OUT_format, iAllocator* );
+
+    // The buffers point into the blob, FreeAsset(OUT_asset) once they have been uploaded
+    FLEXKITAPI Vector<TextureBuffer>    LoadCubeMapAsset    ( GUID_t resourceID, size_t& OUT_MIPCount, uint2& OUT_WH, DeviceFormat& OUT_format, AssetHandle& OUT_asset, iAllocator* );
 
 	FLEXKITAPI TextureSet*		LoadTextureSet	 ( GUID_t ID, iAllocator* Memory );
 	FLEXKITAPI void				LoadTriangleMesh ( GUID_t ID, iAllocator* Memory, TriMesh* out );
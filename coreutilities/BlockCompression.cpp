@@ -0,0 +1,391 @@
+/**********************************************************************
+
+Copyright (c) 2015 - 2019 Robert May
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************/
+
+#include "BlockCompression.h"
+#include "..\coreutilities\containers.h"
+#include "..\coreutilities\ThreadUtilities.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string.h>
+
+namespace FlexKit
+{
+	/************************************************************************************************/
+
+
+	constexpr size_t LZMinMatch		= 4;
+	constexpr size_t LZMaxOffset	= 0xffff;
+	constexpr size_t LZHashBits		= 12;
+
+
+	static uint32_t ReadLZ32(const byte* ptr)
+	{
+		uint32_t value;
+		memcpy(&value, ptr, sizeof(value));
+
+		return value;
+	}
+
+
+	static size_t HashLZ32(const uint32_t sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - LZHashBits);
+	}
+
+
+	// Saturated nibbles carry on in bytes of 255, the first byte under 255 ends the run
+	static bool WriteLZLength(size_t length, byte* dst, size_t& out, const size_t dstCapacity)
+	{
+		while (length >= 255)
+		{
+			if (out >= dstCapacity)
+				return false;
+
+			dst[out++] = byte(255);
+			length -= 255;
+		}
+
+		if (out >= dstCapacity)
+			return false;
+
+		dst[out++] = byte(length);
+
+		return true;
+	}
+
+
+	static bool ReadLZLength(const byte* src, size_t& in, const size_t srcSize, size_t& length)
+	{
+		uint8_t b;
+
+		do
+		{
+			if (in >= srcSize)
+				return false;
+
+			b		 = uint8_t(src[in++]);
+			length	+= b;
+		} while (b == 255);
+
+		return true;
+	}
+
+
+	static bool WriteLZSequence(const byte* literals, const size_t literalCount, const size_t offset, const size_t matchLength, byte* dst, size_t& out, const size_t dstCapacity)
+	{
+		if (out >= dstCapacity)
+			return false;
+
+		const size_t	matchCode	= matchLength ? matchLength - LZMinMatch : 0;
+		byte&			token		= dst[out++];
+
+		token = byte((std::min(literalCount, size_t(15)) << 4) | std::min(matchCode, size_t(15)));
+
+		if (literalCount >= 15 && !WriteLZLength(literalCount - 15, dst, out, dstCapacity))
+			return false;
+
+		if (out + literalCount > dstCapacity)
+			return false;
+
+		memcpy(dst + out, literals, literalCount);
+		out += literalCount;
+
+		if (!matchLength) // Last sequence
+			return true;
+
+		if (out + 2 > dstCapacity)
+			return false;
+
+		dst[out++] = byte(offset & 0xff);
+		dst[out++] = byte(offset >> 8);
+
+		return matchCode < 15 || WriteLZLength(matchCode - 15, dst, out, dstCapacity);
+	}
+
+
+	/************************************************************************************************/
+
+
+	size_t CompressBlock(const byte* src, const size_t srcSize, byte* dst, const size_t dstCapacity)
+	{
+		uint32_t table[1 << LZHashBits] = {};
+
+		const size_t	capacity	= std::min(dstCapacity, srcSize); // No point going past the raw size
+		size_t			in			= 0;
+		size_t			anchor		= 0;
+		size_t			out			= 0;
+
+		while (in + LZMinMatch <= srcSize)
+		{
+			const uint32_t	sequence	= ReadLZ32(src + in);
+			const size_t	hash		= HashLZ32(sequence);
+			const size_t	candidate	= table[hash];
+
+			table[hash] = uint32_t(in);
+
+			if (candidate >= in || in - candidate > LZMaxOffset || ReadLZ32(src + candidate) != sequence)
+			{
+				in++;
+				continue;
+			}
+
+			size_t matchLength = LZMinMatch;
+			while (in + matchLength < srcSize && src[candidate + matchLength] == src[in + matchLength])
+				matchLength++;
+
+			if (!WriteLZSequence(src + anchor, in - anchor, in - candidate, matchLength, dst, out, capacity))
+				return 0;
+
+			in		+= matchLength;
+			anchor	 = in;
+		}
+
+		if (!WriteLZSequence(src + anchor, srcSize - anchor, 0, 0, dst, out, capacity))
+			return 0;
+
+		return out < srcSize ? out : 0;
+	}
+
+
+	/************************************************************************************************/
+
+
+	bool DecompressBlock(const byte* src, const size_t srcSize, byte* dst, const size_t dstSize)
+	{
+		size_t in	= 0;
+		size_t out	= 0;
+
+		while (in < srcSize)
+		{
+			const uint8_t token = uint8_t(src[in++]);
+
+			size_t literalCount = token >> 4;
+			if (literalCount == 15 && !ReadLZLength(src, in, srcSize, literalCount))
+				return false;
+
+			if (literalCount > srcSize - in || literalCount > dstSize - out)
+				return false;
+
+			memcpy(dst + out, src + in, literalCount);
+			in	+= literalCount;
+			out	+= literalCount;
+
+			if (in == srcSize) // Last sequence
+				break;
+
+			if (in + 2 > srcSize)
+				return false;
+
+			const size_t offset = size_t(uint8_t(src[in])) | size_t(uint8_t(src[in + 1])) << 8;
+			in += 2;
+
+			size_t matchLength = token & 0x0f;
+			if (matchLength == 15 && !ReadLZLength(src, in, srcSize, matchLength))
+				return false;
+
+			matchLength += LZMinMatch;
+
+			if (!offset || offset > out || matchLength > dstSize - out)
+				return false;
+
+			const byte* match = dst + out - offset;
+
+			if (offset >= matchLength)
+				memcpy(dst + out, match, matchLength);
+			else
+			{	// Overlapping, repeats the last offset bytes
+				for (size_t I = 0; I < matchLength; ++I)
+					dst[out + I] = match[I];
+			}
+
+			out += matchLength;
+		}
+
+		return out == dstSize;
+	}
+
+
+	/************************************************************************************************/
+
+
+	size_t GetCompressedBlobBound(const size_t rawSize, const size_t blockSize)
+	{
+		const size_t blockCount = (rawSize + blockSize - 1) / blockSize;
+
+		return sizeof(CompressedBlobHeader) + sizeof(uint32_t) * blockCount + rawSize;
+	}
+
+
+	size_t CompressBlob(const byte* src, const size_t srcSize, byte* dst, const size_t dstCapacity, const size_t blockSize)
+	{
+		if (dstCapacity < GetCompressedBlobBound(srcSize, blockSize))
+			return 0;
+
+		CompressedBlobHeader header;
+		header.rawSize		= srcSize;
+		header.blockSize	= uint32_t(blockSize);
+		header.blockCount	= uint32_t((srcSize + blockSize - 1) / blockSize);
+
+		memcpy(dst, &header, sizeof(header));
+
+		byte*	storedSizes = dst + sizeof(header);
+		size_t	out			= sizeof(header) + sizeof(uint32_t) * header.blockCount;
+
+		for (size_t I = 0; I < header.blockCount; ++I)
+		{
+			const byte*		block		= src + I * blockSize;
+			const size_t	rawSize		= std::min(blockSize, srcSize - I * blockSize);
+			size_t			storedSize	= CompressBlock(block, rawSize, dst + out, rawSize);
+
+			if (!storedSize)
+			{
+				memcpy(dst + out, block, rawSize);
+				storedSize = rawSize;
+			}
+
+			const uint32_t size32 = uint32_t(storedSize);
+			memcpy(storedSizes + I * sizeof(uint32_t), &size32, sizeof(size32));
+
+			out += storedSize;
+		}
+
+		return out;
+	}
+
+
+	/************************************************************************************************/
+
+
+	static bool ReadCompressedBlobHeader(const byte* src, const size_t srcSize, CompressedBlobHeader& header)
+	{
+		if (srcSize < sizeof(header))
+			return false;
+
+		memcpy(&header, src, sizeof(header));
+
+		if (!header.blockSize)
+			return false;
+
+		return
+			header.blockCount == (header.rawSize + header.blockSize - 1) / header.blockSize &&
+			sizeof(header) + sizeof(uint32_t) * size_t(header.blockCount) <= srcSize;
+	}
+
+
+	size_t GetDecompressedSize(const byte* src, const size_t srcSize)
+	{
+		CompressedBlobHeader header;
+
+		return ReadCompressedBlobHeader(src, srcSize, header) ? size_t(header.rawSize) : 0;
+	}
+
+
+	/************************************************************************************************/
+
+
+	static bool DecodeBlobBlock(const byte* src, byte* dst, const CompressedBlobHeader& header, const Vector<size_t>& offsets, const uint32_t I)
+	{
+		const size_t blockStart	= size_t(I) * header.blockSize;
+		const size_t rawSize	= std::min(size_t(header.blockSize), size_t(header.rawSize) - blockStart);
+		const size_t storedSize	= offsets[I + 1] - offsets[I];
+
+		if (storedSize == rawSize)
+		{
+			memcpy(dst + blockStart, src + offsets[I], rawSize);
+			return true;
+		}
+
+		return DecompressBlock(src + offsets[I], storedSize, dst + blockStart, rawSize);
+	}
+
+
+	bool DecompressBlob(const byte* src, const size_t srcSize, byte* dst, const size_t dstSize, ThreadManager* threads, iAllocator* allocator)
+	{
+		CompressedBlobHeader header;
+
+		if (!ReadCompressedBlobHeader(src, srcSize, header) || header.rawSize != dstSize)
+			return false;
+
+		Vector<size_t> offsets{ allocator }; // block starts in src, blockCount + 1 of them
+		offsets.reserve(header.blockCount + 1);
+
+		size_t position = sizeof(header) + sizeof(uint32_t) * size_t(header.blockCount);
+		for (size_t I = 0; I < header.blockCount; ++I)
+		{
+			uint32_t storedSize;
+			memcpy(&storedSize, src + sizeof(header) + I * sizeof(uint32_t), sizeof(storedSize));
+
+			offsets.push_back(position);
+			position += storedSize;
+		}
+
+		offsets.push_back(position);
+
+		if (position > srcSize)
+			return false;
+
+		// Threads outside the pool have no queue to push to, those decode inline
+		if (!threads || header.blockCount < 2 || !localWorkQueue)
+		{
+			for (uint32_t I = 0; I < header.blockCount; ++I)
+			{
+				if (!DecodeBlobBlock(src, dst, header, offsets, I))
+					return false;
+			}
+
+			return true;
+		}
+
+		std::atomic_bool	failed	= false;
+		WorkBarrier			barrier{ *threads, allocator };
+		Vector<iWork*>		workItems{ allocator };
+
+		workItems.reserve(header.blockCount);
+
+		for (uint32_t I = 0; I < header.blockCount; ++I)
+		{
+			auto& workItem = CreateWorkItem(
+				[&, I]
+				{
+					if (!DecodeBlobBlock(src, dst, header, offsets, I))
+						failed = true;
+				}, allocator, allocator);
+
+			barrier.AddWork(workItem);
+			workItems.push_back(&workItem);
+		}
+
+		// Every block is counted before any is pushed, a block finishing early can't end the barrier
+		for (auto workItem : workItems)
+			PushToLocalQueue(*workItem);
+
+		// Runs blocks from this thread's queue, and steals, until the last one completes
+		barrier.Join();
+
+		return !failed;
+	}
+
+
+}	/************************************************************************************************/
@@ -0,0 +1,89 @@
+/**********************************************************************
+
+Copyright (c) 2015 - 2019 Robert May
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************/
+
+#ifndef BLOCKCOMPRESSION_H_INCLUDED
+#define BLOCKCOMPRESSION_H_INCLUDED
+
+#include "..\buildsettings.h"
+#include "..\coreutilities\memoryutilities.h"
+
+#include <stdint.h>
+
+// Chunked LZ compression for resource blobs. A blob is cut into fixed size blocks that compress and
+// decompress independently, so a load can spread its blocks over workers.
+//
+// Blob layout:
+//	CompressedBlobHeader
+//	uint32_t storedSize[blockCount]		a block stored at its raw size did not compress and is a plain copy
+//	blocks, back to back
+//
+// Blocks are LZ77 sequences: a token byte with the literal count in the high nibble and the match
+// length - 4 in the low, either extended by 255 bytes while saturated, the literals, then a 16 bit
+// little endian match offset. The last sequence of a block is literals only.
+
+namespace FlexKit
+{
+	class ThreadManager;
+
+
+	/************************************************************************************************/
+
+
+	constexpr size_t CompressionBlockSize = 64 * KILOBYTE;
+
+
+	struct CompressedBlobHeader
+	{
+		uint64_t rawSize;
+		uint32_t blockSize;
+		uint32_t blockCount;
+	};
+
+
+	// Returns the compressed size, or 0 when the block does not shrink
+	FLEXKITAPI size_t	CompressBlock	(const byte* src, const size_t srcSize, byte* dst, const size_t dstCapacity);
+
+	// Fails on anything malformed instead of reading or writing out of bounds
+	FLEXKITAPI bool		DecompressBlock	(const byte* src, const size_t srcSize, byte* dst, const size_t dstSize);
+
+
+	/************************************************************************************************/
+
+
+	FLEXKITAPI size_t	GetCompressedBlobBound	(const size_t rawSize, const size_t blockSize = CompressionBlockSize);
+
+	// Returns the blob's size, or 0 if dst is smaller than GetCompressedBlobBound
+	FLEXKITAPI size_t	CompressBlob			(const byte* src, const size_t srcSize, byte* dst, const size_t dstCapacity, const size_t blockSize = CompressionBlockSize);
+
+	// 0 when the header is malformed
+	FLEXKITAPI size_t	GetDecompressedSize		(const byte* src, const size_t srcSize);
+
+	// The calling thread decodes blocks alongside any workers that pick up the rest, so this is safe to
+	// call from threads without a local work queue. Work items come from allocator, which the workers free.
+	FLEXKITAPI bool		DecompressBlob			(const byte* src, const size_t srcSize, byte* dst, const size_t dstSize, ThreadManager* threads = nullptr, iAllocator* allocator = SystemAllocator);
+
+
+}	/************************************************************************************************/
+
+#endif
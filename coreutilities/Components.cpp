@@ -1,6 +1,8 @@
 #include "Components.h"
 #include "ComponentBlobs.h"
 
+#include <algorithm>
+
 namespace FlexKit
 {   /************************************************************************************************/
 
@@ -9,9 +11,12 @@ namespace FlexKit
     {
         auto handle = handles.GetNewHandle();
 
+        length = min(sizeof(StringID::ID) - 1, length);
+
         StringID newID;
+        newID.handle     = handle;
         newID.ID[length] = '\0';
-        strncpy(newID.ID, initial, min(sizeof(StringID), length));
+        strncpy(newID.ID, initial, length);
 
         handles[handle] = static_cast<index_t>(IDs.push_back(newID));
 
@@ -47,6 +52,281 @@ namespace FlexKit
     }
 
 
+    /************************************************************************************************/
+
+
+    void UpdateDispatcher::Execute()
+    {
+        const auto frameBegin   = Clock::now();
+        const auto nodeCount    = nodes.size();
+
+        // Counters still hold each task's input count
+        Vector<uint32_t>    order       { &frameArena, nodeCount };
+        Vector<int>         inputsLeft  { &frameArena, nodeCount };
+
+        for (auto node : nodes)
+        {
+            inputsLeft.push_back(node->counter);
+
+            if (node->isLeaf())
+                order.push_back(node->nodeIdx);
+        }
+
+        for (size_t I = 0; I < order.size(); ++I)
+            for (auto output : nodes[order[I]]->outputs)
+                if (--inputsLeft[output->nodeIdx] == 0)
+                    order.push_back(output->nodeIdx);
+
+        FK_ASSERT((order.size() == nodeCount), "Update graph has a cycle!");
+
+        // Rank each task by the longest chain it heads, using last frames' timings
+        for (size_t I = order.size(); I > 0; --I)
+        {
+            auto node       = nodes[order[I - 1]];
+            node->statsIdx  = _GetStatsIdx(*node);
+
+            const auto& stats   = taskStats[node->statsIdx];
+            double      longest = 0.0;
+
+            for (auto output : node->outputs)
+                longest = std::max(longest, output->rank);
+
+            node->rank = (stats.samples ? stats.averageDuration : UnknownTaskCost) + longest;
+
+            std::sort(
+                node->outputs.begin(), node->outputs.end(),
+                [](auto lhs, auto rhs) { return lhs->rank > rhs->rank; });
+
+            node->threadTask.Subscribe([node] { node->_ReleaseOutputs(); });
+        }
+
+        Vector<UpdateTaskBase*> leaves{ &frameArena, nodeCount };
+
+        for (auto node : nodes)
+            if (node->isLeaf())
+                leaves.push_back(node);
+
+        std::sort(
+            leaves.begin(), leaves.end(),
+            [](auto lhs, auto rhs) { return lhs->rank > rhs->rank; });
+
+        {
+            WorkBarrier barrier{ *threads, frameArena };
+
+            for (auto& node : nodes)
+                barrier.AddWork(node->threadTask);
+
+            // Workers steal from the front of this thread's queue while it pops from the back.
+            // The top ranked leaf goes in last so this thread starts on it, thieves get the rest by falling rank.
+            for (size_t I = 1; I < leaves.size(); ++I)
+                threads->AddWork(leaves[I]->threadTask, frameArena);
+
+            if (leaves.size())
+                threads->AddWork(leaves[0]->threadTask, frameArena);
+
+            barrier.Join();
+        }
+
+        _RecordFrame(order, frameBegin);
+
+        nodes.clear();
+        taskMap.clear();
+        frameArena.NextFrame();
+    }
+
+
+    /************************************************************************************************/
+
+
+    void UpdateDispatcher::_RecordFrame(const Vector<uint32_t>& order, const Clock::time_point frameBegin)
+    {
+        using MicroSeconds = std::chrono::duration<double, std::micro>;
+
+        frameRecords.clear();
+        frameEdges.clear();
+        criticalPath.clear();
+
+        criticalPathTime    = 0.0;
+        graphTime           = 0.0;
+
+        if (!nodes.size())
+            return;
+
+        // The input that finished last is the one that held a task back
+        Vector<UpdateTaskBase*> blockedBy   { &frameArena, nodes.size(), nullptr };
+        UpdateTaskBase*         last        = nullptr;
+
+        for (auto node : nodes)
+        {
+            const double duration = MicroSeconds{ node->end - node->begin }.count();
+
+            auto& stats = taskStats[node->statsIdx];
+            stats.averageDuration   = stats.samples ? stats.averageDuration + (duration / 1000.0 - stats.averageDuration) * DurationSmoothing : duration / 1000.0;
+            stats.lastDuration      = duration / 1000.0;
+            stats.samples++;
+
+            TaskRecord record;
+            record.name     = node->threadTask._debugID;
+            record.begin    = MicroSeconds{ node->begin - frameBegin }.count();
+            record.duration = duration;
+            record.threadID = node->threadID;
+            record.critical = false;
+
+            frameRecords.push_back(record);
+        }
+
+        for (auto idx : order)
+        {
+            auto node = nodes[idx];
+
+            for (auto output : node->outputs)
+            {
+                auto& blocker = blockedBy[output->nodeIdx];
+
+                if (!blocker || blocker->end < node->end)
+                    blocker = node;
+
+                frameEdges.push_back({ node->nodeIdx, output->nodeIdx });
+            }
+
+            if (!last || last->end < node->end)
+                last = node;
+        }
+
+        for (auto node = last; node; node = blockedBy[node->nodeIdx])
+        {
+            auto& record = frameRecords[node->nodeIdx];
+            record.critical = true;
+
+            taskStats[node->statsIdx].criticalCount++;
+            criticalPathTime += record.duration / 1000.0;
+            criticalPath.push_back(node->nodeIdx);
+        }
+
+        std::reverse(criticalPath.begin(), criticalPath.end());
+
+        graphTime = MicroSeconds{ last->end - frameBegin }.count() / 1000.0;
+    }
+
+
+    /************************************************************************************************/
+
+
+    uint32_t UpdateDispatcher::_GetStatsIdx(const UpdateTaskBase& task)
+    {
+        const char* name = task.threadTask._debugID;
+
+        uint64_t key = task.ID;
+
+        if (!key)
+        {
+            // FNV-1a, debug strings are compared by contents since the same literal can live in several modules
+            key = 14695981039346656037ull;
+
+            for (auto c = name; *c; ++c)
+                key = (key ^ uint8_t(*c)) * 1099511628211ull;
+        }
+
+        const auto res = statsLookup.find(key);
+        if (res != statsLookup.end())
+            return res->second;
+
+        TaskStats stats;
+        stats.key               = key;
+        stats.name              = name;
+        stats.averageDuration   = 0.0;
+        stats.lastDuration      = 0.0;
+        stats.samples           = 0;
+        stats.criticalCount     = 0;
+
+        const auto idx = (uint32_t)taskStats.push_back(stats);
+        statsLookup[key] = idx;
+
+        return idx;
+    }
+
+
+    /************************************************************************************************/
+
+
+    uint32_t UpdateDispatcher::_GetThreadID() noexcept
+    {
+        static std::atomic_uint32_t threadCount = 0;
+        thread_local const uint32_t threadID    = threadCount++;
+
+        return threadID;
+    }
+
+
+    /************************************************************************************************/
+
+
+    static void WriteJSONString(FILE* file, const char* str)
+    {
+        fputc('"', file);
+
+        for (auto c = str; *c; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+                fputc('\\', file);
+
+            if ((unsigned char)*c >= 0x20)
+                fputc(*c, file);
+        }
+
+        fputc('"', file);
+    }
+
+
+    bool UpdateDispatcher::ExportTrace(const char* fileName) const
+    {
+        FILE* file = nullptr;
+
+        if (fopen_s(&file, fileName, "w") || !file)
+            return false;
+
+        const char* separator = "";
+
+        fprintf(file, "{\"traceEvents\":[\n");
+
+        for (const auto& record : frameRecords)
+        {
+            fprintf(file, "%s{\"name\":", separator);
+            WriteJSONString(file, record.name);
+            fprintf(file,
+                ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%u,\"args\":{\"critical\":%s}}",
+                record.critical ? "task,critical" : "task",
+                record.begin,
+                record.duration,
+                record.threadID,
+                record.critical ? "true" : "false");
+
+            separator = ",\n";
+        }
+
+        // Dependencies show up as flow arrows from the end of an input to the start of its output
+        for (size_t I = 0; I < frameEdges.size(); ++I)
+        {
+            const auto& from    = frameRecords[frameEdges[I].first];
+            const auto& to      = frameRecords[frameEdges[I].second];
+
+            fprintf(file,
+                "%s{\"name\":\"dependency\",\"cat\":\"dependency\",\"ph\":\"s\",\"id\":%u,\"ts\":%.3f,\"pid\":0,\"tid\":%u},\n"
+                "{\"name\":\"dependency\",\"cat\":\"dependency\",\"ph\":\"f\",\"bp\":\"e\",\"id\":%u,\"ts\":%.3f,\"pid\":0,\"tid\":%u}",
+                separator,
+                (uint32_t)I, from.begin + from.duration, from.threadID,
+                (uint32_t)I, to.begin, to.threadID);
+
+            separator = ",\n";
+        }
+
+        fprintf(file, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"criticalPathMS\":%.4f,\"graphMS\":%.4f}}\n", criticalPathTime, graphTime);
+        fclose(file);
+
+        return true;
+    }
+
+
 }   /************************************************************************************************/
 
 
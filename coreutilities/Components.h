@@ -8,9 +8,12 @@
 #include "..\coreutilities\type.h"
 
 
+#include <chrono>
 #include <iostream>
+#include <mutex>
 #include <type_traits>
 #include <tuple>
+#include <unordered_map>
 
 #ifndef COMPONENT_H
 #define COMPONENT_H
@@ -151,7 +154,7 @@ namespace FlexKit
 
 		Component() 
 		{
-			FK_ASSERT(component != nullptr, "Component System error: double creation detected!");
+			FK_ASSERT((component == nullptr), "Component System error: double creation detected!");
 
 			component = static_cast<TY*>(this);
 			ComponentBase::AddComponent(*static_cast<ComponentBase*>(this));
@@ -200,6 +203,10 @@ namespace FlexKit
 
 		ComponentBase& GetComponentRef()	{ return ComponentBase::GetComponent(ID); }
 
+		// Called by GameObject as the view is added and removed, views over BasicComponent_t elements pass it on
+		// to their element so ComponentQuery can join components by GameObject
+		virtual void SetGameObject(GameObject* gameObject) {}
+
 		ComponentID ID;
 	};
 
@@ -218,9 +225,13 @@ namespace FlexKit
 	/************************************************************************************************/
 
 
+	// Views are placed in a buffer inside the GameObject so an object's views share its cache lines, only views past
+	// the buffer come from the allocator. Views never move, so neither can the GameObject.
 	class GameObject
 	{
 	public:
+		static const size_t InlineViewBufferSize = 256;
+
 		GameObject(iAllocator* IN_allocator = SystemAllocator) :
 			allocator{ IN_allocator }
 			//behaviors{ allocator } 
@@ -233,14 +244,20 @@ namespace FlexKit
 		}
 
 
+		GameObject				(const GameObject&) = delete;
+		GameObject& operator =	(const GameObject&) = delete;
+
+
 		template<typename TY_View, typename ... TY_args>
 		void AddView(TY_args&& ... args)
 		{
 			static_assert(std::is_base_of<ComponentViewBase, TY_View>(), "You can only add view types!");
+			static_assert(alignof(TY_View) <= 16, "Over aligned view type!");
 
-			views.push_back({
-					&allocator->allocate<TY_View>(std::forward<TY_args>(args)...),
-					TY_View::GetComponentID() });
+			auto& view = *new(_AllocateView(sizeof(TY_View), alignof(TY_View))) TY_View(std::forward<TY_args>(args)...);
+
+			views.push_back({ &view, TY_View::GetComponentID() });
+			view.SetGameObject(this);
 		}
 
 
@@ -251,7 +268,7 @@ namespace FlexKit
 			{
 				if (std::get<1>(*itr) == id) {
 					auto _ptr = std::get<0>(*itr);
-					allocator->release(_ptr);
+					_ReleaseView(_ptr);
 					views.remove_unstable(itr);
 				}
 			}
@@ -268,10 +285,11 @@ namespace FlexKit
 		{
 			for (auto& view : views) {
 				auto view_ptr = std::get<0>(view);
-				allocator->release(view_ptr);
+				_ReleaseView(view_ptr);
 			}
 
 			views.clear();
+			viewBufferUsed = 0;
 		}
 
 
@@ -296,11 +314,118 @@ namespace FlexKit
 
 
 	private:
+
+		void* _AllocateView(const size_t size, const size_t alignment)
+		{
+			const size_t offset = (viewBufferUsed + alignment - 1) & ~(alignment - 1);
+
+			if (offset + size > InlineViewBufferSize)
+				return allocator->malloc(size);
+
+			viewBufferUsed = offset + size;
+
+			return viewBuffer + offset;
+		}
+
+
+		// Space of a removed inline view is only reused once the object is released
+		void _ReleaseView(ComponentViewBase* view)
+		{
+			view->SetGameObject(nullptr);
+
+			const bool inlineView = (std::byte*)view >= viewBuffer && (std::byte*)view < viewBuffer + InlineViewBufferSize;
+
+			if (inlineView)
+				view->~ComponentViewBase();
+			else
+				allocator->release(view);
+		}
+
+
 		static_vector<pair<ComponentViewBase*, ComponentID>, 16>	views;	// component + Code
 		iAllocator*						        					allocator;
+		size_t														viewBufferUsed = 0;
+		alignas(16) std::byte										viewBuffer[InlineViewBufferSize];
     };
 
 
+	/************************************************************************************************/
+
+
+	// Constructs count GameObjects in a single allocation, with views stored inline a whole batch of objects and
+	// their views is one allocation. Release with ReleaseGameObjects.
+	inline GameObject* CreateGameObjects(const size_t count, iAllocator* allocator)
+	{
+		auto objects = static_cast<GameObject*>(allocator->_aligned_malloc(sizeof(GameObject) * count, alignof(GameObject)));
+
+		for (size_t I = 0; I < count; ++I)
+			new(objects + I) GameObject(allocator);
+
+		return objects;
+	}
+
+
+	inline void ReleaseGameObjects(GameObject* objects, const size_t count, iAllocator* allocator)
+	{
+		for (size_t I = 0; I < count; ++I)
+			objects[I].~GameObject();
+
+		allocator->_aligned_free(objects);
+	}
+
+
+	// Keeps every batch made through it, for owners that release whole batches at once
+	class GameObjectBatches
+	{
+	public:
+		GameObjectBatches(iAllocator* IN_allocator) :
+			batches{ IN_allocator } {}
+
+		~GameObjectBatches()
+		{
+			Release();
+		}
+
+		GameObjectBatches				(const GameObjectBatches&) = delete;
+		GameObjectBatches& operator =	(const GameObjectBatches&) = delete;
+
+
+		GameObject* Create(const size_t count, iAllocator* allocator)
+		{
+			auto objects = CreateGameObjects(count, allocator);
+			batches.push_back({ objects, count, allocator });
+
+			return objects;
+		}
+
+
+		void Release()
+		{
+			for (auto& batch : batches)
+				ReleaseGameObjects(batch.objects, batch.count, batch.allocator);
+
+			batches.clear();
+		}
+
+
+		size_t size() const noexcept
+		{
+			return batches.size();
+		}
+
+	private:
+
+		struct Batch
+		{
+			GameObject*	objects;
+			size_t		count;
+			iAllocator*	allocator;
+		};
+
+		Vector<Batch> batches;
+	};
+
+
     /************************************************************************************************/
 
 
@@ -414,6 +539,13 @@ namespace FlexKit
 	/************************************************************************************************/
 
 
+    template<typename TY_Component, typename = void>
+    struct HasGameObjectElements : std::false_type {};
+
+    template<typename TY_Component>
+    struct HasGameObjectElements<TY_Component, std::void_t<decltype(std::declval<TY_Component&>().elements[0].gameObject)>> : std::true_type {};
+
+
     template<typename TY_Component>
     class BasicComponentView_t : public ComponentView_t<TY_Component>
     {
@@ -429,6 +561,13 @@ namespace FlexKit
         virtual ~BasicComponentView_t() final {}
 
 
+        void SetGameObject(GameObject* gameObject) override
+        {
+            if constexpr (HasGameObjectElements<TY_Component>::value)
+                GetComponent().SetGameObject(handle, gameObject);
+        }
+
+
         decltype(auto) GetData()
         {
             return GetComponent()[handle];
@@ -470,6 +609,7 @@ namespace FlexKit
 		{
 			TY_Handle		handle;
 			TY				componentData;
+			GameObject*		gameObject = nullptr;
 		};
 
         using View = BasicComponentView_t<BasicComponent_t<TY, TY_Handle, ID>>;
@@ -479,6 +619,8 @@ namespace FlexKit
 			auto handle		= handles.GetNewHandle();
 			handles[handle] = (index_t)elements.push_back({ handle, initial });
 
+			layoutVersion++;
+
 			return handle;
 		}
 
@@ -497,6 +639,22 @@ namespace FlexKit
 
 			handles[lastElement.handle] = handles[handle];
 			handles.RemoveHandle(handle);
+
+			layoutVersion++;
+		}
+
+
+		void SetGameObject(TY_Handle handle, GameObject* gameObject)
+		{
+			elements[handles[handle]].gameObject = gameObject;
+			layoutVersion++;
+		}
+
+
+		// Changes whenever elements are added, removed or attached to a different GameObject
+		size_t GetLayoutVersion() const
+		{
+			return layoutVersion;
 		}
 
 
@@ -521,6 +679,20 @@ namespace FlexKit
 			return elements[handles[handle]].componentData;
 		}
 
+
+		bool Has(TY_Handle handle) const
+		{
+			return handles.Has(handle);
+		}
+
+
+		// nullptr for stale handles, checked in release builds too
+		TY* TryGet(TY_Handle handle)
+		{
+			index_t idx;
+			return handles.TryGet(handle, idx) ? &elements[idx].componentData : nullptr;
+		}
+
         auto begin()
         {
             return elements.begin();
@@ -534,6 +706,211 @@ namespace FlexKit
 		HandleUtilities::HandleTable<TY_Handle>	handles;
 		Vector<elementData>						elements;
         TY_EventHandler                         eventHandler;
+		size_t									layoutVersion = 0;
+	};
+
+
+	/************************************************************************************************/
+
+
+	// Iterates every GameObject holding all of the given views, handing over each component's element directly.
+	// The join by GameObject is cached as rows of element indices and only rebuilt once one of the components
+	// adds, removes or reattaches an element, so a pass is a walk over the element arrays with no view lookups.
+	// Rows are in the order of the first component's elements, list the largest or hottest component first.
+	// Creating or removing elements while iterating is not allowed. Several threads may iterate at once, the
+	// rebuild is done under a lock, but call Refresh before handing the query to a task so workers only read.
+	template<typename ... TY_Views>
+	class ComponentQuery
+	{
+	public:
+		static const size_t ComponentCount		= sizeof...(TY_Views);
+		static const size_t DefaultChunkSize	= 512;
+
+		template<typename TY_View>
+		using Component_t = std::decay_t<decltype(TY_View::GetComponent())>;
+
+		static_assert(ComponentCount > 0, "Query needs at least one view type!");
+		static_assert((HasGameObjectElements<Component_t<TY_Views>>::value && ...), "Only views over BasicComponent_t's can be queried!");
+
+		struct Row
+		{
+			GameObject*	gameObject;
+			index_t		elements[ComponentCount];
+		};
+
+
+		ComponentQuery(iAllocator* IN_allocator) :
+			allocator	{ IN_allocator },
+			rows		{ IN_allocator } {}
+
+
+		// fn(GameObject&, elementData& ...), one elementData per view type in order
+		template<typename FN>
+		void ForEach(FN fn)
+		{
+			_Refresh();
+
+			const auto elements = _GetElements();
+
+			for (auto& row : rows)
+				_Invoke(fn, row, elements, std::index_sequence_for<TY_Views...>{});
+		}
+
+
+		// Same as ForEach, chunkSize rows per work item, fn is called concurrently
+		template<typename FN>
+		void ParallelForEach(ThreadManager& threads, iAllocator* temp, FN fn, const size_t chunkSize = DefaultChunkSize)
+		{
+			_Refresh();
+
+			const auto elements		= _GetElements();
+			const auto chunkCount	= (rows.size() + chunkSize - 1) / chunkSize;
+
+			auto RunChunk = [&](const size_t chunk)
+			{
+				const size_t end = min(rows.size(), (chunk + 1) * chunkSize);
+
+				for (size_t I = chunk * chunkSize; I < end; ++I)
+					_Invoke(fn, rows[I], elements, std::index_sequence_for<TY_Views...>{});
+			};
+
+			if (chunkCount <= 1)
+			{
+				if (chunkCount)
+					RunChunk(0);
+
+				return;
+			}
+
+			WorkBarrier barrier{ threads, temp };
+
+			for (size_t I = 0; I < chunkCount; ++I)
+			{
+				auto chunkWork = [&, I] { RunChunk(I); };
+
+				auto& workItem = CreateWorkItem(chunkWork, temp);
+
+				barrier.AddWork(workItem);
+				PushToLocalQueue(workItem);
+			}
+
+			barrier.Join();
+		}
+
+
+		size_t size()
+		{
+			_Refresh();
+			return rows.size();
+		}
+
+
+		void Refresh()
+		{
+			_Refresh();
+		}
+
+
+		void Release()
+		{
+			rows.Release();
+		}
+
+	private:
+
+		auto _GetElements() const
+		{
+			return std::make_tuple(Component_t<TY_Views>::GetComponent().elements.begin()...);
+		}
+
+
+		template<typename FN, typename TY_Elements, size_t ... Idx>
+		static void _Invoke(FN& fn, const Row& row, const TY_Elements& elements, std::index_sequence<Idx...>)
+		{
+			fn(*row.gameObject, std::get<Idx>(elements)[row.elements[Idx]]...);
+		}
+
+
+		void _Refresh()
+		{
+			const size_t versions[] = { Component_t<TY_Views>::GetComponent().GetLayoutVersion()... };
+
+			std::scoped_lock lock{ refreshLock };
+
+			if (built && !memcmp(versions, layoutVersions, sizeof(versions)))
+				return;
+
+			memcpy(layoutVersions, versions, sizeof(versions));
+			built = true;
+
+			_Rebuild(std::index_sequence_for<TY_Views...>{});
+		}
+
+
+		struct JoinEntry
+		{
+			GameObject*	gameObject;
+			index_t		element;
+
+			bool operator < (const JoinEntry& rhs) const { return gameObject < rhs.gameObject; }
+		};
+
+
+		template<size_t ... Idx>
+		void _Rebuild(std::index_sequence<Idx...>)
+		{
+			rows.clear();
+
+			// Every component's attached elements sorted by GameObject, then one merge pass over all of them
+			Vector<JoinEntry> entries[ComponentCount] = { Vector<JoinEntry>{ allocator, Component_t<TY_Views>::GetComponent().elements.size() }... };
+
+			auto Gather = [&](auto& elements, Vector<JoinEntry>& out)
+			{
+				for (size_t I = 0; I < elements.size(); ++I)
+					if (elements[I].gameObject)
+						out.push_back({ elements[I].gameObject, (index_t)I });
+
+				std::sort(out.begin(), out.end());
+			};
+
+			(Gather(Component_t<TY_Views>::GetComponent().elements, entries[Idx]), ...);
+
+			size_t cursors[ComponentCount] = {};
+
+			for (auto& entry : entries[0])
+			{
+				Row row;
+				row.gameObject	= entry.gameObject;
+				row.elements[0]	= entry.element;
+
+				bool matched = true;
+
+				for (size_t I = 1; I < ComponentCount && matched; ++I)
+				{
+					auto& cursor = cursors[I];
+
+					while (cursor < entries[I].size() && entries[I][cursor].gameObject < entry.gameObject)
+						cursor++;
+
+					matched = cursor < entries[I].size() && entries[I][cursor].gameObject == entry.gameObject;
+
+					if (matched)
+						row.elements[I] = entries[I][cursor].element;
+				}
+
+				if (matched)
+					rows.push_back(row);
+			}
+
+			std::sort(rows.begin(), rows.end(), [](auto& lhs, auto& rhs) { return lhs.elements[0] < rhs.elements[0]; });
+		}
+
+
+		iAllocator*		allocator;
+		Vector<Row>		rows;
+		size_t			layoutVersions[ComponentCount]	= {};
+		bool			built							= false;
+		std::mutex		refreshLock;
 	};
 
 
@@ -564,6 +941,8 @@ namespace FlexKit
 
 		char* operator[] (StringIDHandle handle) { return IDs[handles[handle]].ID; }
 
+		bool Has(StringIDHandle handle) const { return handles.Has(handle); }
+
         void AddComponentView(GameObject& GO, const std::byte* buffer, const size_t bufferSize, iAllocator* allocator) override;
 
 		HandleUtilities::HandleTable<StringIDHandle>	handles;
@@ -809,10 +1188,11 @@ namespace FlexKit
 
 
 
-	class UpdateDispatcher
+	class FLEXKITAPI UpdateDispatcher
 	{
 	public:
 		typedef size_t	UpdateID_t;
+		typedef std::chrono::high_resolution_clock	Clock;
 
 		class UpdateTaskBase
 		{
@@ -825,7 +1205,8 @@ namespace FlexKit
 
 			UpdateTaskBase(ThreadManager* IN_manager, iUpdateFN& IN_updateFn, iAllocator* IN_allocator) :
 				Update		{ IN_updateFn						},
-				threadTask	{ this, IN_manager, IN_allocator	} {}
+				threadTask	{ this, IN_manager, IN_allocator	},
+				outputs		{ IN_allocator						} {}
 
 			// No Copy
 			UpdateTaskBase				(const UpdateTaskBase&)	= delete;
@@ -858,7 +1239,14 @@ namespace FlexKit
 
 			void Run()
 			{
+				threadID	= _GetThreadID();
+				begin		= Clock::now();
+
+				FK_ALLOCATION_TAG(threadTask._debugID);
+
 				Update(*this);
+
+				end			= Clock::now();
 			}
 
 
@@ -868,17 +1256,13 @@ namespace FlexKit
 			}
 
 
+            // Outputs are released by Execute once it knows their ranks
             void AddInput(UpdateTaskBase& input) 
             {
                 counter++;
                 leaf = false;
 
-                input.AddContinuationTask(
-                    [&]
-                    {
-                        if (_DecrementCounter())
-                            PushToLocalQueue(threadTask);
-                    });
+                input.outputs.push_back(this);
             }
 
 
@@ -895,6 +1279,28 @@ namespace FlexKit
             }
 
 
+            // Outputs are sorted by falling rank. Thieves take from the front of this thread's queue, so ready
+            // outputs go in by falling rank, except the top ranked one goes in last for this thread to run next.
+            void _ReleaseOutputs()
+            {
+                UpdateTaskBase* top = nullptr;
+
+                for (auto output : outputs)
+                {
+                    if (!output->_DecrementCounter())
+                        continue;
+
+                    if (top)
+                        PushToLocalQueue(output->threadTask);
+                    else
+                        top = output;
+                }
+
+                if (top)
+                    PushToLocalQueue(top->threadTask);
+            }
+
+
             void AddContinuation(UpdateTaskBase& task)
             {
                 threadTask.Subscribe(
@@ -918,9 +1324,18 @@ namespace FlexKit
             std::atomic_int     counter     = 0;
             bool                leaf        = true;
 
-			UpdateID_t			ID;
+			UpdateID_t			ID			= 0; // TaskID given to Add, keys the task's timings when set
 			iUpdateFN&			Update;
 			char*			    Data;
+
+			Vector<UpdateTaskBase*>	outputs;
+
+			Clock::time_point	begin;
+			Clock::time_point	end;
+			uint32_t			threadID	= 0;
+			uint32_t			nodeIdx		= 0;
+			uint32_t			statsIdx	= 0;
+			double				rank		= 0.0; // predicted ms from this task starting to the end of the longest chain below it
 		};
 
 		template<typename TY>
@@ -938,11 +1353,48 @@ namespace FlexKit
 		};
 
 
-		UpdateDispatcher(ThreadManager* IN_threads, iAllocator* IN_allocator) :
-			nodes		{ IN_allocator	},
-			allocator	{ IN_allocator	},
-			threads		{ IN_threads	},
-            taskMap     { IN_allocator  } {}
+		// Timings are kept across frames per TaskID, or per debug string for tasks added without one.
+		// Tasks with neither all share a single entry.
+		struct TaskStats
+		{
+			uint64_t	key;
+			const char*	name;
+			double		averageDuration;	// ms, moving average used to rank the next frame's tasks
+			double		lastDuration;		// ms
+			uint32_t	samples;
+			uint32_t	criticalCount;		// times this task sat on a frame's critical path
+		};
+
+
+		struct TaskRecord
+		{
+			const char*	name;
+			double		begin;		// us since Execute started
+			double		duration;	// us
+			uint32_t	threadID;
+			bool		critical;
+		};
+
+
+		static const size_t		DefaultFrameArenaSize	= 16 * MEGABYTE;
+		static constexpr double	UnknownTaskCost			= 0.05;	// ms, used until a task has been timed once
+		static constexpr double	DurationSmoothing		= 0.1;
+
+		// Task nodes, their data and scratch asked for through GetFrameArena live in a frame arena. It moves on
+		// to its next buffer after every Execute, so anything allocated from it survives two more Execute calls.
+		// Keep the dispatcher around between frames, its arena and lists are reused rather than reallocated.
+		// Every Execute times its tasks, and the next one runs tasks heading the longest predicted chain first.
+		UpdateDispatcher(ThreadManager* IN_threads, iAllocator* IN_allocator, const size_t frameArenaSize = DefaultFrameArenaSize) :
+			nodes			{ IN_allocator					},
+			allocator		{ IN_allocator					},
+			threads			{ IN_threads					},
+            taskMap			{ IN_allocator					},
+			frameArena		{ IN_allocator, frameArenaSize	},
+			taskStats		{ IN_allocator					},
+			statsLookup		{ 64							},
+			frameRecords	{ IN_allocator					},
+			frameEdges		{ IN_allocator					},
+			criticalPath	{ IN_allocator					} {}
 
 
 		// No Copy
@@ -950,22 +1402,24 @@ namespace FlexKit
 		const UpdateDispatcher& operator =	(const UpdateDispatcher&) = delete;
 
 
-		void Execute()
-		{
-			WorkBarrier barrier{ *threads, allocator };
+		void Execute();
 
-            for (auto& node : nodes)
-                barrier.AddWork(node->threadTask);
 
-            for (auto node : nodes)
-                if (node->isLeaf())
-                    threads->AddWork(node->threadTask, allocator);
+		// Per frame scratch, any task may allocate from it
+		FrameArena& GetFrameArena() noexcept { return frameArena; }
 
-			barrier.Join();
 
-            nodes.clear();
-            taskMap.clear();
-		}
+		// Writes the last executed frame as Chrome trace JSON, open it in chrome://tracing
+		bool ExportTrace(const char* fileName) const;
+
+		const Vector<TaskStats>&	GetTaskStats	() const noexcept { return taskStats; }
+		const Vector<TaskRecord>&	GetFrameRecords	() const noexcept { return frameRecords; }
+
+		// Indices into GetFrameRecords, from the first task of the chain to the last
+		const Vector<uint32_t>&		GetCriticalPath	() const noexcept { return criticalPath; }
+
+		double GetCriticalPathTime	() const noexcept { return criticalPathTime; }	// ms, sum of the chain's task durations
+		double GetGraphTime			() const noexcept { return graphTime; }			// ms, from Execute starting to the last task ending
 
 
 		class UpdateBuilder
@@ -976,12 +1430,19 @@ namespace FlexKit
                 dispatcher  { IN_dispatcher } {}
 
 
+			// Also keys the task's timings, so it has to outlive the dispatcher
 			void SetDebugString(const char* str) noexcept
 			{
 				newNode.threadTask._debugID = str;
 			}
 
 
+			FrameArena& GetFrameArena() noexcept
+			{
+				return dispatcher.frameArena;
+			}
+
+
 			void AddOutput(UpdateTaskBase& node)
 			{
 				node.AddInput(newNode);
@@ -1041,7 +1502,10 @@ namespace FlexKit
             auto& task = Add<TY_NODEDATA>(LinkageSetup, UpdateFN);
 
             if (find(taskMap, [&](auto& task) { return get<0>(task) == TaskID; } ) == taskMap.end())
+            {
+                task.ID = TaskID;
                 taskMap.push_back({ TaskID, &task });
+            }
             else
             {
                 std::cout << "ERROR!";
@@ -1071,9 +1535,10 @@ namespace FlexKit
 				FN_UPDATE	function;
 			};
 
-			auto& functor		= allocator->allocate_aligned<data_BoilderPlate>(std::move(UpdateFN));
-			auto& newNode		= allocator->allocate_aligned<UpdateTask<TY_NODEDATA>>(threads, functor, allocator);
+			auto& functor		= frameArena.allocate_aligned<data_BoilderPlate>(std::move(UpdateFN));
+			auto& newNode		= frameArena.allocate_aligned<UpdateTask<TY_NODEDATA>>(threads, functor, &frameArena);
 			newNode.Data		= reinterpret_cast<char*>(&functor.locals);
+			newNode.nodeIdx		= (uint32_t)nodes.size();
 
 			UpdateBuilder Builder{ newNode, *this };
 			LinkageSetup(Builder, functor.locals);
@@ -1087,6 +1552,20 @@ namespace FlexKit
         Vector<UpdateTaskBase*>		                    nodes;
         Vector<std::pair<uint32_t, UpdateTaskBase*>>	taskMap;
 		iAllocator*					                    allocator;
+		FrameArena										frameArena;
+
+	private:
+		static uint32_t	_GetThreadID	() noexcept;
+		uint32_t		_GetStatsIdx	(const UpdateTaskBase& task);
+		void			_RecordFrame	(const Vector<uint32_t>& order, const Clock::time_point frameBegin);
+
+		Vector<TaskStats>						taskStats;
+		std::unordered_map<uint64_t, uint32_t>	statsLookup;	// TaskStats::key -> index into taskStats
+		Vector<TaskRecord>						frameRecords;
+		Vector<std::pair<uint32_t, uint32_t>>	frameEdges;
+		Vector<uint32_t>						criticalPath;
+		double									criticalPathTime	= 0.0;
+		double									graphTime			= 0.0;
 	};
 
 
@@ -0,0 +1,150 @@
+/**********************************************************************
+
+Copyright (c) 2015 - 2019 Robert May
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************/
+
+#include "CullingKernels.h"
+#include "TransformKernels.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CULLINGKERNELS_X64
+
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#define CULLING_TARGET_AVX2
+#else
+#define CULLING_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#endif
+
+
+namespace FlexKit
+{
+	/************************************************************************************************/
+
+
+	void CullSpheres_Scalar(const CullingPlanes& planes, const float* x, const float* y, const float* z, const float* r, const size_t count, uint64_t* out) noexcept
+	{
+		const size_t wordCount = (count + 63) / 64;
+
+		for (size_t word = 0; word < wordCount; ++word)
+		{
+			const size_t begin	= word * 64;
+			const size_t end	= begin + 64 < count ? begin + 64 : count;
+
+			uint64_t bits = 0;
+
+			for (size_t I = begin; I < end; ++I)
+			{
+				bool visible = true;
+
+				for (size_t plane = 0; plane < 6 && visible; ++plane)
+				{
+					const float d =
+						planes.nx[plane] * (x[I] - planes.ox[plane]) +
+						planes.ny[plane] * (y[I] - planes.oy[plane]) +
+						planes.nz[plane] * (z[I] - planes.oz[plane]);
+
+					visible = !(d - r[I] > 0.0f);
+				}
+
+				bits |= uint64_t(visible) << (I - begin);
+			}
+
+			out[word] = bits;
+		}
+	}
+
+
+	/************************************************************************************************/
+
+#ifdef CULLINGKERNELS_X64
+
+	CULLING_TARGET_AVX2 void CullSpheres_AVX2(const CullingPlanes& planes, const float* x, const float* y, const float* z, const float* r, const size_t count, uint64_t* out) noexcept
+	{
+		const size_t	wordCount	= (count + 63) / 64;
+		const __m256	zero		= _mm256_setzero_ps();
+
+		for (size_t word = 0; word < wordCount; ++word)
+		{
+			const size_t begin	= word * 64;
+			const size_t end	= begin + 64 < count ? begin + 64 : count;
+
+			uint64_t bits = 0;
+
+			for (size_t I = begin; I < end; I += CullingBlockWidth)
+			{
+				const __m256 X = _mm256_loadu_ps(x + I);
+				const __m256 Y = _mm256_loadu_ps(y + I);
+				const __m256 Z = _mm256_loadu_ps(z + I);
+				const __m256 R = _mm256_loadu_ps(r + I);
+
+				__m256 outside = zero;
+
+				// No FMA here, keeps the results identical to the scalar test
+				for (size_t plane = 0; plane < 6; ++plane)
+				{
+					__m256 d = _mm256_mul_ps(_mm256_set1_ps(planes.nx[plane]), _mm256_sub_ps(X, _mm256_set1_ps(planes.ox[plane])));
+					d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(planes.ny[plane]), _mm256_sub_ps(Y, _mm256_set1_ps(planes.oy[plane]))));
+					d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(planes.nz[plane]), _mm256_sub_ps(Z, _mm256_set1_ps(planes.oz[plane]))));
+
+					outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_sub_ps(d, R), zero, _CMP_GT_OQ));
+				}
+
+				bits |= uint64_t(~_mm256_movemask_ps(outside) & 0xff) << (I - begin);
+			}
+
+			// Lanes past the end of the range are padding
+			if (end - begin < 64)
+				bits &= (uint64_t(1) << (end - begin)) - 1;
+
+			out[word] = bits;
+		}
+	}
+
+#else
+
+	void CullSpheres_AVX2(const CullingPlanes& planes, const float* x, const float* y, const float* z, const float* r, const size_t count, uint64_t* out) noexcept
+	{
+		CullSpheres_Scalar(planes, x, y, z, r, count, out);
+	}
+
+#endif
+
+
+	/************************************************************************************************/
+
+
+	void CullSpheres(const CullingPlanes& planes, const float* x, const float* y, const float* z, const float* r, const size_t count, uint64_t* out) noexcept
+	{
+		static const bool AVX2 = CPUSupportsAVX2();
+
+		if (AVX2)
+			CullSpheres_AVX2(planes, x, y, z, r, count, out);
+		else
+			CullSpheres_Scalar(planes, x, y, z, r, count, out);
+	}
+
+
+}	/************************************************************************************************/
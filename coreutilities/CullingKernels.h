@@ -0,0 +1,84 @@
+/**********************************************************************
+
+Copyright (c) 2015 - 2019 Robert May
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************/
+
+#ifndef CULLINGKERNELS_H
+#define CULLINGKERNELS_H
+
+#include "..\coreutilities\intersection.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Batched bounding sphere vs frustum tests over packed x/y/z/r arrays, eight spheres per step.
+
+namespace FlexKit
+{
+	/************************************************************************************************/
+
+
+	constexpr size_t CullingBlockWidth = 8;
+
+
+	// Frustum planes split into components, one splat per plane per block
+	struct CullingPlanes
+	{
+		float nx[6], ny[6], nz[6];	// outward normals
+		float ox[6], oy[6], oz[6];	// points on the planes
+	};
+
+
+	inline CullingPlanes GetCullingPlanes(const Frustum& frustum)
+	{
+		CullingPlanes planes;
+
+		for (size_t I = 0; I < 6; ++I)
+		{
+			planes.nx[I] = frustum.Planes[I].Normal.x;
+			planes.ny[I] = frustum.Planes[I].Normal.y;
+			planes.nz[I] = frustum.Planes[I].Normal.z;
+			planes.ox[I] = frustum.Planes[I].Orgin.x;
+			planes.oy[I] = frustum.Planes[I].Orgin.y;
+			planes.oz[I] = frustum.Planes[I].Orgin.z;
+		}
+
+		return planes;
+	}
+
+
+	/************************************************************************************************/
+
+	// Sets bit I of out[I / 64] for every sphere I in [0, count) touching the frustum, using the same test
+	// as Intersects(Frustum, BoundingSphere). Every word of out covering the range is overwritten, so
+	// ranges split across threads should start on a multiple of 64. Arrays must be readable up to count
+	// rounded up to CullingBlockWidth.
+	void CullSpheres_Scalar	(const CullingPlanes& planes, const float* x, const float* y, const float* z, const float* r, const size_t count, uint64_t* out) noexcept;
+	void CullSpheres_AVX2	(const CullingPlanes& planes, const float* x, const float* y, const float* z, const float* r, const size_t count, uint64_t* out) noexcept;
+
+	// Picks the AVX2 kernel when the CPU supports it
+	void CullSpheres		(const CullingPlanes& planes, const float* x, const float* y, const float* z, const float* r, const size_t count, uint64_t* out) noexcept;
+
+
+}	/************************************************************************************************/
+
+#endif
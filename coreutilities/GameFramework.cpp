@@ -95,6 +95,11 @@ namespace FlexKit
 
 
 	bool SetDebugRenderMode	(Console* C, ConsoleVariable* Arguments, size_t ArguementCount, void* USR);
+	bool ExportFrameTrace	(Console* C, ConsoleVariable* Arguments, size_t ArguementCount, void* USR);
+#if USING(ALLOCATIONTELEMETRY)
+	bool PrintMemStats		(Console* C, ConsoleVariable* Arguments, size_t ArguementCount, void* USR);
+	bool DumpMemStats		(Console* C, ConsoleVariable* Arguments, size_t ArguementCount, void* USR);
+#endif
 	void EventsWrapper		(const Event& evt, void* _ptr);
 
 
@@ -179,6 +184,8 @@ namespace FlexKit
 	GameFramework::GameFramework(EngineCore& IN_core) :
 		console				{ DefaultAssets.Font, IN_core.RenderSystem, IN_core.GetBlockMemory() },
 		core				{ IN_core	},
+		frameDispatcher		{ &IN_core.Threads, IN_core.GetBlockMemory() },
+		assetLoader			{ IN_core.Threads, assetReader, IN_core.GetBlockMemory() },
 		fixStepAccumulator	{ 0.0		}
 
 	{
@@ -192,7 +199,7 @@ namespace FlexKit
 	void GameFramework::Initiate()
 	{
 		SetDebugMemory			(core.GetDebugMemory());
-		InitiateAssetTable	    (core.GetBlockMemory());
+		InitiateAssetTable	    (core.GetBlockMemory(), &core.Threads);
 		InitiateGeometryTable	(core.GetBlockMemory());
 
 		clearColor					= { 0.0f, 0.2f, 0.4f, 1.0f };
@@ -236,6 +243,11 @@ namespace FlexKit
 		console.BindBoolVar("FrameLock",    &core.FrameLock);
 
 		console.AddFunction({ "SetRenderMode", &SetDebugRenderMode, this, 1, { ConsoleVariableType::CONSOLE_UINT }});
+		console.AddFunction({ "ExportFrameTrace", &ExportFrameTrace, this, 0, {} });
+#if USING(ALLOCATIONTELEMETRY)
+		console.AddFunction({ "MemStats", &PrintMemStats, this, 0, {} });
+		console.AddFunction({ "DumpMemStats", &DumpMemStats, this, 0, {} });
+#endif
 
 		AddLogCallback(&logMessagePipe, Verbosity_INFO);
 	}
@@ -345,23 +357,25 @@ namespace FlexKit
 	{
 		FK_LOG_9("Frame Begin");
 
-		UpdateDispatcher dispatcher{ &core.Threads, core.GetTempMemory() };
-
-		Update			(dispatcher, dT);
-		UpdatePreDraw	(dispatcher, core.GetTempMemory(), dT);
+		Update			(frameDispatcher, dT);
+		UpdatePreDraw	(frameDispatcher, core.GetTempMemory(), dT);
 
 		ProfileBegin(PROFILE_SUBMISSION);
 
-		Draw			(dispatcher, core.GetTempMemory(), dT);
+		Draw			(frameDispatcher, core.GetTempMemory(), dT);
 
-        dispatcher.Execute();
+        frameDispatcher.Execute();
 
         ProfileEnd(PROFILE_SUBMISSION);
 
-		PostDraw		(dispatcher, core.GetTempMemory(), dT);
+		PostDraw		(frameDispatcher, core.GetTempMemory(), dT);
 
 		core.GetTempMemory().clear();
 
+#if USING(ALLOCATIONTELEMETRY)
+		AllocationTelemetryNextFrame();
+#endif
+
 		fixStepAccumulator += dT;
 
 		FK_LOG_9("Frame End");
@@ -376,6 +390,8 @@ namespace FlexKit
 
 	void GameFramework::Release()
 	{
+		assetLoader.Shutdown(); // before the workers its callbacks run on
+
 		core.Threads.SendShutdown();
 		core.Threads.WaitForWorkersToComplete();
 
@@ -388,6 +404,7 @@ namespace FlexKit
 		FlexKit::Release(DefaultAssets.Font, core.RenderSystem);
 
 
+		LogAssetLoadStats	();
 		FreeAllAssetFiles	();
 		FreeAllAssets		();
 	
@@ -421,11 +438,19 @@ namespace FlexKit
 			"FPS: %u\n"
 			"Update/Draw Dispatch Time: %fms\n"
 			"Objects Drawn: %u\n"
+			"Frame Arena: %u KB, Peak: %u KB, Overflows: %u\n"
+			"Task Graph: %fms, Critical Path: %fms over %u tasks\n"
 			"Build Date: " __DATE__ "\n",
 			VRamUsage, 
 			(uint32_t)stats.fps,
 			DrawTiming, 
-			(uint32_t)stats.objectsDrawnLastFrame);
+			(uint32_t)stats.objectsDrawnLastFrame,
+			(uint32_t)(frameDispatcher.GetFrameArena().GetUsed() / KILOBYTE),
+			(uint32_t)(frameDispatcher.GetFrameArena().GetHighWaterMark() / KILOBYTE),
+			(uint32_t)frameDispatcher.GetFrameArena().GetOverflowCount(),
+			(float)frameDispatcher.GetGraphTime(),
+			(float)frameDispatcher.GetCriticalPathTime(),
+			(uint32_t)frameDispatcher.GetCriticalPath().size());
 
 
         const uint2 WH          = ActiveWindow->WH;
@@ -649,4 +674,102 @@ namespace FlexKit
 	}
 
 
+	/************************************************************************************************/
+
+
+	bool ExportFrameTrace(Console* C, ConsoleVariable* Arguments, size_t ArguementCount, void* USR)
+	{
+		GameFramework* framework = (GameFramework*)USR;
+
+		if (!framework->frameDispatcher.ExportTrace("FrameTrace.json"))
+		{
+			C->PrintLine("FAILED TO WRITE FrameTrace.json!");
+			return false;
+		}
+
+		C->PrintLine("Frame trace written to FrameTrace.json");
+		return true;
+	}
+
+
+	/************************************************************************************************/
+
+#if USING(ALLOCATIONTELEMETRY)
+
+	bool PrintMemStats(Console* C, ConsoleVariable* Arguments, size_t ArguementCount, void* USR)
+	{
+		GameFramework*	framework	= (GameFramework*)USR;
+		auto&			allocator	= framework->core.GetBlockMemory();
+
+		auto PrintStatLine = [&](const char* format, auto ... args)
+		{
+			const size_t length = snprintf(nullptr, 0, format, args...) + 1;
+
+			char* str = (char*)allocator.malloc(length);
+			snprintf(str, length, format, args...);
+
+			C->PrintLine(str, allocator);
+		};
+
+		const auto totals = GetAllocationTotals();
+
+		PrintStatLine("Live: %lluKB in %llu allocations, Peak: %lluKB, Last Frame: %llu allocations %lluKB",
+			(unsigned long long)(totals.liveBytes / KILOBYTE),
+			(unsigned long long)totals.liveCount,
+			(unsigned long long)(totals.peakBytes / KILOBYTE),
+			(unsigned long long)totals.lastFrameAllocations,
+			(unsigned long long)(totals.lastFrameBytes / KILOBYTE));
+
+		AllocationTagStats	tags[MaxAllocationTags];
+		const size_t		tagCount = GetAllocationTagStats(tags, MaxAllocationTags);
+
+		std::sort(tags, tags + tagCount, [](auto& lhs, auto& rhs) { return lhs.liveBytes > rhs.liveBytes; });
+
+		for (size_t I = 0; I < tagCount && I < 8; ++I)
+			PrintStatLine("    %s: %lluKB live, %lluKB peak, %llu last frame",
+				tags[I].tag,
+				(unsigned long long)(tags[I].liveBytes / KILOBYTE),
+				(unsigned long long)(tags[I].peakBytes / KILOBYTE),
+				(unsigned long long)tags[I].lastFrameAllocations);
+
+		const auto pools = allocator.GetPoolStats();
+
+		auto PrintPool = [&](const char* name, const BlockPoolStats& pool)
+		{
+			const size_t	free			= pool.capacity - pool.used;
+			const float		fragmentation	= free ? 1.0f - float(pool.largestFree) / float(free) : 0.0f;
+
+			PrintStatLine("%s Pool: %lluKB / %lluKB, Fragmentation: %.2f",
+				name,
+				(unsigned long long)(pool.used / KILOBYTE),
+				(unsigned long long)(pool.capacity / KILOBYTE),
+				fragmentation);
+		};
+
+		PrintPool("Small",	pools.smallPool);
+		PrintPool("Medium",	pools.mediumPool);
+		PrintPool("Large",	pools.largePool);
+
+		return true;
+	}
+
+
+	/************************************************************************************************/
+
+
+	bool DumpMemStats(Console* C, ConsoleVariable* Arguments, size_t ArguementCount, void* USR)
+	{
+		if (!DumpAllocationTelemetry("AllocationTelemetry.txt"))
+		{
+			C->PrintLine("FAILED TO WRITE AllocationTelemetry.txt!");
+			return false;
+		}
+
+		C->PrintLine("Allocation telemetry written to AllocationTelemetry.txt");
+		return true;
+	}
+
+#endif
+
+
 }	/************************************************************************************************/
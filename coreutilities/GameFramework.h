@@ -123,6 +123,11 @@ namespace FlexKit
 		EngineCore&				core;
 		NodeHandle				rootNode;
 
+		UpdateDispatcher		frameDispatcher; // lives across frames to keep its frame arena
+
+		GameResourceReader		assetReader;
+		AssetLoader				assetLoader;
+
 		static_vector<MouseHandler>		mouseHandlers;
 		static_vector<FrameworkState*>	subStates;
 
@@ -25,10 +25,16 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "GraphicScene.h"
 #include "GraphicsComponents.h"
 #include "intersection.h"
+#include "LooseOctree.h"
 
 #include "..\coreutilities\Components.h"
 #include "..\coreutilities\componentBlobs.h"
 #include "..\graphicsutilities\AnimationRuntimeUtilities.H"
+#include "..\graphicsutilities\DrawBatching.h"
+#include "..\coreutilities\ParallelMerge.h"
+#include "..\coreutilities\RadixSort.h"
+
+#include <algorithm>
 
 namespace FlexKit
 {
@@ -146,9 +152,8 @@ namespace FlexKit
 			[&](SceneVisibilityView& visibility)
 			{
 				sceneEntities.push_back(visibility);
+				sceneManagement.AddEntity(visibility);
 			});
-
-		//sceneManagement.AddEntity(vis);
 	}
 
 
@@ -162,6 +167,7 @@ namespace FlexKit
 		[&, allocator = this->allocator](SceneVisibilityView& vis) 
 		{
 			const auto handle = vis.visibility;
+			sceneManagement.RemoveEntity(handle);
 			go.RemoveView(vis);
 
 			sceneEntities.remove_unstable(
@@ -183,12 +189,12 @@ namespace FlexKit
 			auto entity		= visables[visHandle].entity;
 			auto visable	= entity->GetView(visableID);
 			entity->RemoveView(visable);
-
-			allocator->release(visable);
 		}
 
 		sceneEntities.clear();
 		sceneManagement.clear();
+
+		loadedGameObjects.Release();
 	}
 
 
@@ -354,278 +360,335 @@ namespace FlexKit
 	/************************************************************************************************/
 
 
-	void UpdateQuadTree(QuadTreeNode* Node, GraphicScene* Scene)
+	BoundingSphere GetWorldBoundingSphere(const VisibilityFields& visibility)
 	{
-		/*
-		for (const auto D : Scene->Drawables) {
-			if (GetFlag(D.Node, SceneNodes::StateFlags::UPDATED))
-			{
-				if()
-				{	// Moved Branch
-					if()
-					{	// Space in Node Available
-					}
-					else
-					{	// Node Split Needed
-					}
-				}
-			}
-		}
-		*/
+		const auto Ls	= GetLocalScale		(visibility.node).x;
+		const auto Pw	= GetPositionW		(visibility.node);
+		const auto Lq	= GetOrientation	(visibility.node);
+
+		return BoundingSphere{
+			Lq * visibility.boundingSphere.xyz() + Pw,
+			Ls * visibility.boundingSphere.w };
 	}
 
 
 	/************************************************************************************************/
 
 
-	void QuadTreeNode::ExpandNode(iAllocator* allocator)
+	void SceneSpatialIndex::AddEntity(VisibilityHandle handle)
 	{
-		ChildNodes.push_back(&allocator->allocate_aligned<QuadTreeNode>(allocator));
-		ChildNodes.push_back(&allocator->allocate_aligned<QuadTreeNode>(allocator));
-		ChildNodes.push_back(&allocator->allocate_aligned<QuadTreeNode>(allocator));
-		ChildNodes.push_back(&allocator->allocate_aligned<QuadTreeNode>(allocator));
+		std::unique_lock lock{ updateLock };
 
-		const auto SpanVector	= upperRight - lowerLeft;
-		const auto CenterPoint	= (lowerLeft + upperRight) / 2;
+		auto& visibility = SceneVisibilityComponent::GetComponent()[handle];
 
-		ChildNodes[(int)QuadTreeNodeLocation::UpperRight]->upperRight	= CenterPoint + SpanVector / 2;
-		ChildNodes[(int)QuadTreeNodeLocation::UpperRight]->lowerLeft	= CenterPoint;
-
-		ChildNodes[(int)QuadTreeNodeLocation::UpperLeft]->upperRight	= CenterPoint + (SpanVector / 2) * float2( 0.0f,  1.0f);
-		ChildNodes[(int)QuadTreeNodeLocation::UpperLeft]->lowerLeft		= CenterPoint + (SpanVector / 2) * float2(-1.0f,  0.0f);
+		if (slotCount == spheresX.size())
+		{
+			const size_t newSize = slotCount + 64;
+
+			spheresX.resize(newSize);
+			spheresY.resize(newSize);
+			spheresZ.resize(newSize);
+			spheresR.resize(newSize);
+			slotEntities.resize(newSize);
+			slotDrawables.resize(newSize);
+			drawableMask.push_back(0);
+			transparentMask.push_back(0);
+		}
 
-		ChildNodes[(int)QuadTreeNodeLocation::LowerLeft]->upperRight	= CenterPoint;
-		ChildNodes[(int)QuadTreeNodeLocation::LowerLeft]->lowerLeft		= CenterPoint - (SpanVector / 2);
+		const auto slot = (uint32_t)slotCount++;
 
-		ChildNodes[(int)QuadTreeNodeLocation::LowerRight]->upperRight	= CenterPoint + (SpanVector / 2) * float2( 1.0f,  0.0f);
-		ChildNodes[(int)QuadTreeNodeLocation::LowerRight]->lowerLeft	= CenterPoint + (SpanVector / 2) * float2( 0.0f, -1.0f);
+		// Node may not have a world transform yet, it's still dirty and Update refreshes it once it does
+		visibility.spatialEntry	= octree.Insert(GetWorldBoundingSphere(visibility), slot);
+		visibility.spatialIndex	= this;
+		visibility.spatialDirty	= false;
+		visibility.cullingSlot	= slot;
+		slotEntities[slot]		= handle;
 
-		for (auto& node : ChildNodes)
-			node->centerPoint = (node->upperRight + node->lowerLeft) / 2;
+		_LinkNode(handle, visibility);
+		_RefreshSlot(slot, visibility);
 	}
 
 
 	/************************************************************************************************/
 
 
-	float4 QuadTreeNode::GetArea() const
+	void SceneSpatialIndex::RemoveEntity(VisibilityHandle handle)
 	{
-		const auto areaLL = (lowerLeft.y <  upperRight.y) ? lowerLeft : upperRight;
-		const auto areaUR = (lowerLeft.y >= upperRight.y) ? lowerLeft : upperRight;
+		std::unique_lock lock{ updateLock };
 
-		return { areaLL, areaUR };
-	}
+		auto& visables		= SceneVisibilityComponent::GetComponent();
+		auto& visibility	= visables[handle];
 
+		if (visibility.spatialEntry == LooseOctree::InvalidIndex)
+			return;
 
-	/************************************************************************************************/
+		octree.Remove(visibility.spatialEntry);
+		visibility.spatialEntry = LooseOctree::InvalidIndex;
 
+		_UnlinkNode(handle, visibility);
 
-	void QuadTree::clear()
-	{
-		root.Clear();
-	}
+		{
+			std::scoped_lock dirtyGuard{ dirtyLock };
 
+			if (visibility.spatialDirty)
+			{
+				auto res = std::find(dirtyEntities.begin(), dirtyEntities.end(), handle);
+				if (res != dirtyEntities.end())
+					dirtyEntities.remove_unstable(res);
+			}
 
-	/************************************************************************************************/
+			visibility.spatialIndex = nullptr;
+			visibility.spatialDirty = true;
+		}
 
+		const auto slot = visibility.cullingSlot;
+		const auto last = (uint32_t)--slotCount;
 
-	void QuadTreeNode::AddEntity(VisibilityHandle visable)
-	{
-		if (ChildNodes.empty() && !Contents.full())
+		if (slot != last)
 		{
-			Contents.push_back(visable);
+			spheresX[slot]		= spheresX[last];
+			spheresY[slot]		= spheresY[last];
+			spheresZ[slot]		= spheresZ[last];
+			spheresR[slot]		= spheresR[last];
+			slotEntities[slot]	= slotEntities[last];
+			slotDrawables[slot]	= slotDrawables[last];
+
+			_SetBit(drawableMask,		slot, _GetBit(drawableMask, last));
+			_SetBit(transparentMask,	slot, _GetBit(transparentMask, last));
+
+			auto& moved = visables[slotEntities[slot]];
+			moved.cullingSlot = slot;
+			octree.SetValue(moved.spatialEntry, slot);
 		}
-		else
-		{
-			if (ChildNodes.empty()) 
-			{
-				ExpandNode(allocator);
 
-				for (auto C : Contents)
-					AddEntity(visable);
+		_SetBit(drawableMask,		last, false);
+		_SetBit(transparentMask,	last, false);
 
-				Contents.clear();
-			}
+		visibility.cullingSlot = LooseOctree::InvalidIndex;
+	}
 
-			// Get Nearest Node
-			auto visableEntity	= SceneVisibilityComponent::GetComponent()[visable];
-			auto node			= visableEntity.node;
-			auto position		= GetPositionW(node);
 
-			float2 pos_f2{position.x, position.z};
+	/************************************************************************************************/
+
+
+	void SceneSpatialIndex::Update(GraphicScene& parentScene)
+	{
+		FK_LOG_9("SceneSpatialIndex::Update");
+
+		std::unique_lock lock{ updateLock };
+
+		auto& visables = SceneVisibilityComponent::GetComponent();
 
-			float			l = 1000000000.0f;
-			QuadTreeNode*	nearestNode = ChildNodes.front();
+		const size_t updateCount = GetTransformUpdateCount();
 
-			for (auto child : ChildNodes)
+		if (updateCount != transformUpdate)
+		{
+			if (updateCount == transformUpdate + 1)
 			{
-				float d = (child->centerPoint - pos_f2).Magnitude();
-				if (d < l)
+				for (const auto node : GetUpdatedNodes())
 				{
-					l = d;
-					nearestNode = child;
+					if (node.to_uint() >= nodeEntities.size())
+						continue;
+
+					for (auto handle = nodeEntities[node.to_uint()]; handle != InvalidHandle_t; handle = visables[handle].nextOnNode)
+						_RefreshSlot(visables[handle].cullingSlot, visables[handle]);
 				}
 			}
+			else
+			{	// Missed a transform update, its node list is gone
+				for (uint32_t slot = 0; slot < slotCount; ++slot)
+					_RefreshSlot(slot, visables[slotEntities[slot]]);
+			}
 
-			nearestNode->AddEntity(visable);
+			transformUpdate = updateCount;
 		}
-	}
-
-
-	/************************************************************************************************/
 
+		std::scoped_lock dirtyGuard{ dirtyLock };
 
-	QuadTreeNode::SphereTestRes QuadTreeNode::IsSphereInside(float r, float3 pos)
-	{
-		float nodeSpan			= (lowerLeft - upperRight).Magnitude();
-		float l					= (float2(pos.x, pos.z) - centerPoint).Magnitude();
+		for (auto handle : dirtyEntities)
+		{
+			auto& visibility = visables[handle];
 
-		bool OutSideNode		= (l > (nodeSpan / 2));
+			_RefreshSlot(visibility.cullingSlot, visibility);
+			visibility.spatialDirty = false;
+		}
 
-		return OutSideNode ? Failed : Fully;
+		dirtyEntities.clear();
 	}
 
+
 	/************************************************************************************************/
 
-	void QuadTreeNode::UpdateBounds()
-	{
-		for (auto child : ChildNodes) 
-		{
-			child->UpdateBounds();
 
-			upperRight.x = (child->upperRight.x > upperRight.x) ? child->upperRight.x : upperRight.x;
-			upperRight.y = (child->upperRight.y > upperRight.y) ? child->upperRight.y : upperRight.y;
+	void SceneSpatialIndex::MarkDirty(VisibilityHandle handle)
+	{
+		std::scoped_lock dirtyGuard{ dirtyLock };
 
-			lowerLeft.x = (child->lowerLeft.x > lowerLeft.x) ? child->lowerLeft.x : lowerLeft.x;
-			lowerLeft.y = (child->lowerLeft.y > lowerLeft.y) ? child->lowerLeft.y : lowerLeft.y;
-		}
+		auto& visibility = SceneVisibilityComponent::GetComponent()[handle];
 
-		auto& visibility = SceneVisibilityComponent::GetComponent();
+		if (visibility.spatialDirty)
+			return;
 
-		for(auto visable : Contents)
-		{
-			auto& visableInfo	= visibility[visable];
-			auto node			= visableInfo.node;
-			auto boundingSphere	= visableInfo.boundingSphere;
-			auto r				= boundingSphere.w;
-			auto offset			= boundingSphere.xyz();
-			auto position		= GetPositionW(node);
-
-			float2 vectorToNode				= centerPoint - float2{position.x + offset.x, position.z + offset.x };
-			
-			float2 vectorToNodeNormalized	= vectorToNode / vectorToNode.Magnitude();
-			
-			if ((vectorToNode * vectorToNode).Sum() < 0.00001f)
-				vectorToNodeNormalized = float2{ 0, 0 };
-
-			float2 newUR					= centerPoint + vectorToNodeNormalized * -r;
-
-			upperRight.x = (newUR.y > upperRight.y) ? newUR.x : upperRight.x;
-			upperRight.y = (newUR.y > upperRight.y) ? newUR.y : upperRight.y;
-
-			lowerLeft.x = (newUR.y < lowerLeft.y) ? newUR.x : lowerLeft.x;
-			lowerLeft.y = (newUR.y < lowerLeft.y) ? newUR.y : lowerLeft.y;
-		}
+		visibility.spatialDirty = true;
+		dirtyEntities.push_back(handle);
 	}
 
+
 	/************************************************************************************************/
 
 
-	void QuadTree::AddEntity(VisibilityHandle entityHandle)
+	void SceneSpatialIndex::_LinkNode(VisibilityHandle handle, VisibilityFields& visibility)
 	{
-		root.AddEntity(entityHandle);
-		//UpdateBounds();
+		const auto nodeIdx = visibility.node.to_uint();
+
+		while (nodeEntities.size() <= nodeIdx)
+			nodeEntities.push_back(InvalidHandle_t);
+
+		visibility.nextOnNode	= nodeEntities[nodeIdx];
+		nodeEntities[nodeIdx]	= handle;
 	}
 
 
 	/************************************************************************************************/
 
 
-	void QuadTree::RemoveEntity(VisibilityHandle handle)
+	void SceneSpatialIndex::_UnlinkNode(VisibilityHandle handle, VisibilityFields& visibility)
 	{
+		auto& visables	= SceneVisibilityComponent::GetComponent();
+		auto* link		= &nodeEntities[visibility.node.to_uint()];
+
+		while (*link != handle)
+			link = &visables[*link].nextOnNode;
 
+		*link					= visibility.nextOnNode;
+		visibility.nextOnNode	= InvalidHandle_t;
 	}
 
 
 	/************************************************************************************************/
 
 
-	void QuadTree::Rebuild(GraphicScene& parentScene) 
+	void SceneSpatialIndex::_RefreshSlot(const uint32_t slot, const VisibilityFields& visibility)
 	{
-		RebuildCounter = 0;
-		root.Clear();
+		const auto sphere = GetWorldBoundingSphere(visibility);
 
-		float2 lowerLeft	{ 0, 0 };
-		float2 upperRight	{ 0, 0 };
-			
-		//for (auto item : allEntities)
-		{
-			//auto boundingSphere = parentScene.GetBoundingSphere(item);
-			//float r = boundingSphere.w;
+		octree.Move(visibility.spatialEntry, sphere);
 
-			//upperRight.x = boundingSphere.x + r > upperRight.x ? boundingSphere.x + r : upperRight.x;
-			//upperRight.y = boundingSphere.z + r > upperRight.y ? boundingSphere.z + r : upperRight.y;
+		spheresX[slot] = sphere.x;
+		spheresY[slot] = sphere.y;
+		spheresZ[slot] = sphere.z;
+		spheresR[slot] = sphere.w;
 
-			//lowerLeft.x = boundingSphere.x - r < lowerLeft.x ? boundingSphere.x - r : lowerLeft.x;
-			//lowerLeft.y = boundingSphere.z - r < lowerLeft.y ? boundingSphere.z - r : lowerLeft.y;
-		}
+		auto drawableView = static_cast<DrawableView*>(visibility.entity->GetView(DrawableComponent::GetComponentID()));
 
-		auto centerPoint	= (upperRight - lowerLeft) / 2;
-		root.centerPoint	= centerPoint;
-		root.lowerLeft		= lowerLeft;
-		root.upperRight		= upperRight;
+		slotDrawables[slot] = drawableView ? drawableView->drawable : DrawableHandle{ InvalidHandle_t };
 
-		//for (auto item : allEntities)
-		//	root.AddChild(item, allocator);
+		_SetBit(drawableMask,		slot, visibility.visable && drawableView != nullptr);
+		_SetBit(transparentMask,	slot, visibility.transparent);
 	}
 
 
 	/************************************************************************************************/
 
 
-	float4	QuadTree::GetArea()
+	void SceneSpatialIndex::GatherCullChunks(const Frustum& frustum, Vector<uint32_t>& slots, Vector<CullChunk>& chunks) const
 	{
-		return root.GetArea();
+		std::shared_lock lock{ updateLock };
+
+		octree.QueryCells(frustum,
+			[&](const uint32_t* cellSlots, const size_t count, const bool fullyInside)
+			{
+				chunks.push_back({ (uint32_t)slots.size(), (uint32_t)count, fullyInside });
+
+				for (size_t I = 0; I < count; ++I)
+					slots.push_back(cellSlots[I]);
+			});
 	}
 
 
 	/************************************************************************************************/
 
 
-	UpdateTask& QuadTree::Update(FlexKit::UpdateDispatcher& dispatcher, GraphicScene* parentScene, UpdateTask& transformDependency)
+	void SceneSpatialIndex::CullChunks(const CullingPlanes& planes, const uint32_t* slots, const CullChunk* begin, const CullChunk* end, PVS& solid, PVS& transparent) const
 	{
-		struct QuadTreeUpdate
+		std::shared_lock lock{ updateLock };
+
+		auto& drawables = DrawableComponent::GetComponent();
+
+		// Chunk's spheres gathered for the SoA test, CullSpheres reads in groups of 8
+		alignas(32) float x[64];
+		alignas(32) float y[64];
+		alignas(32) float z[64];
+		alignas(32) float r[64];
+
+		for (auto chunk = begin; chunk < end; ++chunk)
 		{
-			QuadTree*		QTree;
-			GraphicScene*	parentScene;
-		};
+			const uint32_t* chunkSlots = slots + chunk->begin;
+
+			uint64_t visible = chunk->count == 64 ? ~uint64_t(0) : (uint64_t(1) << chunk->count) - 1;
 
-		auto& task = dispatcher.Add<QuadTreeUpdate>(
-			[&](DependencyBuilder& builder, auto& QuadTreeUpdate)
+			if (!chunk->fullyInside)
 			{
-				builder.AddInput(transformDependency);
-				builder.SetDebugString("QuadTree Update!");
+				for (uint32_t I = 0; I < chunk->count; ++I)
+				{
+					const auto slot = chunkSlots[I];
 
-				QuadTreeUpdate.QTree		= this;
-				QuadTreeUpdate.parentScene	= parentScene;
+					x[I] = spheresX[slot];
+					y[I] = spheresY[slot];
+					z[I] = spheresZ[slot];
+					r[I] = spheresR[slot];
+				}
 
-			},
-			[](auto& QuadTreeUpdate)
+				CullSpheres(planes, x, y, z, r, chunk->count, &visible);
+			}
+
+			while (visible)
 			{
-				FK_LOG_9("QuadTree::Update");
+				const auto bit = LowestSetBit(visible);
+				visible &= visible - 1;
 
-				const auto period  = QuadTreeUpdate.QTree->RebuildPeriod;
-				const auto counter = QuadTreeUpdate.QTree->RebuildCounter;
+				const auto slot = chunkSlots[bit];
 
-				//if (period <= counter)
-				//	QuadTreeUpdate.QTree->Rebuild(*QuadTreeUpdate.parentScene);
-				//else
-				//	QuadTreeUpdate.QTree->root.UpdateBounds(*QuadTreeUpdate.parentScene);
+				// Entities may have been removed since the chunks were gathered
+				if (slot >= slotCount || !_GetBit(drawableMask, slot))
+					continue;
 
-				//QuadTreeUpdate.QTree->RebuildCounter++;
-			});
+				auto& drawable = drawables[slotDrawables[slot]];
 
-		return task;
+				if (drawable.Skinned)
+					continue;
+
+				if (_GetBit(transparentMask, slot))
+					PushPV(drawable, transparent);
+				else
+					PushPV(drawable, solid);
+			}
+		}
+	}
+
+
+	/************************************************************************************************/
+
+
+	void SceneSpatialIndex::clear()
+	{
+		std::unique_lock lock{ updateLock };
+
+		octree.Clear();
+		nodeEntities.clear();
+
+		{
+			std::scoped_lock dirtyGuard{ dirtyLock };
+			dirtyEntities.clear();
+		}
+
+		slotCount = 0;
+
+		for (auto& word : drawableMask)
+			word = 0;
+
+		for (auto& word : transparentMask)
+			word = 0;
 	}
 
 
@@ -671,56 +734,207 @@ namespace FlexKit
 		FK_ASSERT(&T_out	!= nullptr);
 
 
-		auto& cameraComponent = CameraComponent::GetComponent();
+		auto&		spatialIndex	= SM->sceneManagement;
+		const auto	frustum			= GetFrustum(Camera);
+		const auto	planes			= GetCullingPlanes(frustum);
 
-		const auto CameraNode	= cameraComponent.GetCameraNode(Camera);
-		const float3	POS		= GetPositionW(CameraNode);
-		const Quaternion Q		= GetOrientation(CameraNode);
-		const auto F			= GetFrustum(Camera);
-		const auto& Visibles	= SceneVisibilityComponent::GetComponent();
+		spatialIndex.Update(*SM);
+
+		Vector<uint32_t>						slots	{ SM->allocator };
+		Vector<SceneSpatialIndex::CullChunk>	chunks	{ SM->allocator };
+
+		spatialIndex.GatherCullChunks(frustum, slots, chunks);
+		spatialIndex.CullChunks(planes, slots.begin(), chunks.begin(), chunks.end(), out, T_out);
+	}
 
-		for(auto handle : SM->sceneEntities)
+
+	/************************************************************************************************/
+
+
+	size_t GetGatherSceneScratchSize(const size_t slotCount)
+	{
+		// Headroom for entities added between queuing the gather and running it
+		const size_t blockCount	= (slotCount + slotCount / 4) / GatherSceneBlockSize + 1;
+		const size_t slots		= blockCount * GatherSceneBlockSize;
+
+		// Candidate slots and their chunks, per block lists, the merged solid list, its merge buffer and the transparent
+		// list, per block radix sort scratch, the transparent sort's scratch, plus work items and run bookkeeping
+		return
+			slots * (sizeof(uint32_t) + sizeof(SceneSpatialIndex::CullChunk)) +
+			5 * slots * sizeof(PVEntry) +
+			2 * GetRadixSortScratchSize<PVEntry>(slots) +
+			blockCount * KILOBYTE + 64 * KILOBYTE;
+	}
+
+
+	/************************************************************************************************/
+
+
+	void GatherSceneParallel(ThreadManager& threads, GraphicScene* SM, CameraHandle Camera, PVS& solid, PVS& transparent, iAllocator* temp)
+	{
+		FK_ASSERT(&solid	!= &transparent);
+		FK_ASSERT(SM		!= nullptr);
+
+		auto&		spatialIndex	= SM->sceneManagement;
+		auto&		camera			= CameraComponent::GetComponent().GetCamera(Camera);
+		const auto	frustum			= GetFrustum(Camera);
+		const auto	planes			= GetCullingPlanes(frustum);
+
+		spatialIndex.Update(*SM);
+
+		// Coarse pass on the calling thread, only the candidates from cells touching the frustum are split up
+		Vector<uint32_t>						candidates	{ temp, spatialIndex.GetSlotCount() };
+		Vector<SceneSpatialIndex::CullChunk>	chunks		{ temp, spatialIndex.GetSlotCount() };
+
+		spatialIndex.GatherCullChunks(frustum, candidates, chunks);
+
+		// Blocks are runs of whole chunks holding at most GatherSceneBlockSize candidates
+		Vector<size_t> blockEnds{ temp, candidates.size() / (GatherSceneBlockSize - 63) + 1 };
+
+		size_t blockCandidates = 0;
+		for (size_t I = 0; I < chunks.size(); ++I)
 		{
-			const auto potentialVisible = Visibles[handle];
+			if (blockCandidates + chunks[I].count > GatherSceneBlockSize)
+			{
+				blockEnds.push_back(I);
+				blockCandidates = 0;
+			}
+
+			blockCandidates += chunks[I].count;
+		}
+
+		if (chunks.size())
+			blockEnds.push_back(chunks.size());
+
+		const size_t blockCount = blockEnds.size();
 
-			if(	potentialVisible.visable && 
-				potentialVisible.entity->hasView(DrawableComponent::GetComponentID()))
+		if (blockCount <= 1)
+		{
+			spatialIndex.CullChunks(planes, candidates.begin(), chunks.begin(), chunks.end(), solid, transparent);
+			SortPVS(&solid, &camera);
+			SortPVSTransparent(&transparent, &camera);
+			return;
+		}
+
+		const auto cameraPosition = GetPositionW(camera.Node);
+
+		struct GatherBlock
+		{
+			GatherBlock(iAllocator* allocator) :
+				solid		{ allocator, GatherSceneBlockSize },
+				transparent	{ allocator, GatherSceneBlockSize },
+				sortScratch	{ allocator->_aligned_malloc(GetRadixSortScratchSize<PVEntry>(GatherSceneBlockSize)) } {}
+
+			PVS		solid;
+			PVS		transparent;
+			void*	sortScratch;
+		};
+
+		// Reserved up front so workers never allocate
+		Vector<GatherBlock> blocks{ temp, blockCount };
+		for (size_t I = 0; I < blockCount; ++I)
+			blocks.emplace_back(temp);
+
+		auto SortBySortID	= [](const PVEntry& lhs, const PVEntry& rhs) { return lhs.SortID < rhs.SortID; };
+		auto GetSortID		= [](const PVEntry& entry) { return entry.SortID; };
+
+		// Fan out, cull, key and sort each block
+		{
+			WorkBarrier barrier{ threads, temp };
+
+			for (size_t I = 0; I < blockCount; ++I)
 			{
-				auto Ls	= GetLocalScale		(potentialVisible.node).x;
-				auto Pw	= GetPositionW		(potentialVisible.node);
-				auto Lq	= GetOrientation	(potentialVisible.node);
-				auto BS = BoundingSphere{ 
-					Lq * potentialVisible.boundingSphere.xyz() + Pw, 
-					Ls * potentialVisible.boundingSphere.w };
-
-				Apply(*potentialVisible.entity,
-					[&](DrawableView& drawable)
-					{
-						if (!drawable.GetDrawable().Skinned && CompareBSAgainstFrustum(&F, BS))
-						{
-							float distance = 0;
-							if (potentialVisible.transparent)
-								PushPV(drawable, T_out);
-							else
-								PushPV(drawable, out);
-						}
-					});
+				auto cullBlock = [&, I]
+				{
+					auto&		block		= blocks[I];
+					const auto	chunkBegin	= chunks.begin() + (I ? blockEnds[I - 1] : 0);
+					const auto	chunkEnd	= chunks.begin() + blockEnds[I];
+
+					spatialIndex.CullChunks(planes, candidates.begin(), chunkBegin, chunkEnd, block.solid, block.transparent);
+
+					for (auto& entry : block.solid)
+						entry.SortID = GetPVSortingID(*entry.D, cameraPosition);
+
+					RadixSort(block.solid.begin(), block.solid.size(), GetSortID, block.sortScratch);
+				};
+
+				auto& workItem = CreateWorkItem(cullBlock, temp);
+
+				barrier.AddWork(workItem);
+				PushToLocalQueue(workItem);
 			}
+
+			barrier.Join();
+		}
+
+		// Fan in, the blocks are sorted runs, merge neighbouring runs pairwise until one is left
+		size_t solidCount		= 0;
+		size_t transparentCount	= 0;
+
+		for (auto& block : blocks)
+		{
+			solidCount			+= block.solid.size();
+			transparentCount	+= block.transparent.size();
 		}
+
+		const size_t solidBase			= solid.size();
+		const size_t transparentBase	= transparent.size();
+
+		solid.resize(solidBase + solidCount);
+		transparent.resize(transparentBase + transparentCount);
+
+		auto* mergeScratch			= (PVEntry*)temp->_aligned_malloc(sizeof(PVEntry) * (solidCount + 1));
+		void* transparentScratch	= temp->_aligned_malloc(GetRadixSortScratchSize<PVEntry>(transparentCount + 1));
+
+		// Transparent lists are concatenated alongside the merge
+		WorkBarrier transparentBarrier{ threads, temp };
+
+		auto concatenateTransparent = [&]
+		{
+			size_t offset = transparentBase;
+
+			for (auto& block : blocks)
+			{
+				for (auto entry : block.transparent)
+				{
+					entry.OcclusionID		= offset;
+					entry.SortID			= CreateTransparentDrawKey(*entry.D, float3(cameraPosition - GetPositionW(entry.D->Node)).magnitude());
+					transparent[offset++]	= entry;
+				}
+			}
+
+			RadixSort(transparent.begin() + transparentBase, transparentCount, GetSortID, transparentScratch);
+		};
+
+		auto& workItem = CreateWorkItem(concatenateTransparent, temp);
+
+		transparentBarrier.AddWork(workItem);
+		PushToLocalQueue(workItem);
+
+		// OcclusionID's are block local, offset them to match a serial gather
+		MergeSortedBlocks(
+			threads, blockCount,
+			[&](const size_t I) -> PVS& { return blocks[I].solid; },
+			[&](PVEntry& entry, const size_t offset) { entry.OcclusionID += solidBase + offset; },
+			SortBySortID,
+			solid.begin() + solidBase, mergeScratch, temp);
+
+		transparentBarrier.Join();
 	}
 
 
 	/************************************************************************************************/
 
 
-    UpdateTaskTyped<GetPVSTaskData>& GatherScene(UpdateDispatcher& dispatcher, GraphicScene* scene, CameraHandle C, iAllocator* allocator)
+    UpdateTaskTyped<GetPVSTaskData>& GatherScene(UpdateDispatcher& dispatcher, GraphicScene* scene, CameraHandle C)
 	{
 		auto& task = dispatcher.Add<GetPVSTaskData>(
 			[&](auto& builder, auto& data)
 			{
-				size_t taskMemorySize = KILOBYTE * 2048;
-				data.taskMemory.Init((byte*)allocator->malloc(taskMemorySize), taskMemorySize);
+				const size_t taskMemorySize = GetGatherSceneScratchSize(scene->sceneManagement.GetSlotCount());
+				data.taskMemory.Init((byte*)builder.GetFrameArena().malloc(taskMemorySize), taskMemorySize);
 				data.scene			= scene;
+				data.threads		= dispatcher.threads;
 				data.solid			= PVS{ data.taskMemory };
 				data.transparent	= PVS{ data.taskMemory };
 				data.camera			= C;
@@ -731,8 +945,7 @@ namespace FlexKit
 			{
                 FK_LOG_9("Start PVS gather\n");
 
-                GatherScene(data.scene, data.camera, data.solid, data.transparent);
-				SortPVS(&data.solid, &CameraComponent::GetComponent().GetCamera(data.camera));
+                GatherSceneParallel(*data.threads, data.scene, data.camera, data.solid, data.transparent, data.taskMemory);
 
                 FK_LOG_9("End PVS gather\n");
 			});
@@ -771,6 +984,8 @@ namespace FlexKit
 
 	bool LoadScene(RenderSystem* RS, GUID_t Guid, GraphicScene& GS_out, iAllocator* allocator, iAllocator* temp)
 	{
+		FK_ALLOCATION_TAG("Scene Load");
+
 		bool Available = isAssetAvailable(Guid);
 		if (Available)
 		{
@@ -790,6 +1005,22 @@ namespace FlexKit
 				ComponentRequirementBlock*	componentRequirement    = nullptr;
 				Vector<NodeHandle>			nodes{ temp };
 
+				// Every entity's GameObject comes from one allocation, count them first
+				size_t entityCount = 0;
+
+				for (size_t blockOffset = 0, itr = 0; blockOffset < sceneBlob->ResourceSize && itr < blockCount; ++itr)
+				{
+					SceneBlock* block = reinterpret_cast<SceneBlock*>(sceneBlob->Buffer + blockOffset);
+
+					if (block->blockType == SceneBlockType::Entity || block->blockType == SceneBlockType::ComponentRequirementTable)
+						entityCount++;
+
+					blockOffset += block->blockSize;
+				}
+
+				GameObject* gameObjects		= entityCount ? GS_out.loadedGameObjects.Create(entityCount, allocator) : nullptr;
+				size_t		gameObjectCount	= 0;
+
 
 				while (offset < sceneBlob->ResourceSize && currentBlock < blockCount)
 				{
@@ -841,7 +1072,7 @@ namespace FlexKit
 
                             EntityBlock::Header entityBlock;
                             memcpy(&entityBlock, block, sizeof(entityBlock));
-							auto& gameObject = allocator->allocate<GameObject>(allocator);
+							auto& gameObject = gameObjects[gameObjectCount++];
 
                             size_t itr                  = 0;
                             size_t componentOffset      = 0;
@@ -928,33 +1159,39 @@ namespace FlexKit
 	/************************************************************************************************/
 
 
-	Vector<PointLightHandle> GraphicScene::FindPointLights(const Frustum &f, iAllocator* tempMemory) const
+	// Lights are found through their visibility bounds, see SetBoundingSphereFromLight
+	template<typename TY_SHAPE>
+	static Vector<PointLightHandle> FindPointLightsInScene(const SceneSpatialIndex& spatialIndex, const TY_SHAPE& shape, iAllocator* tempMemory)
 	{
-		Vector<PointLightHandle> lights{tempMemory};
+		Vector<PointLightHandle> lights{ tempMemory };
 
 		auto& visables = SceneVisibilityComponent::GetComponent();
 
-		for (auto entity : sceneEntities)
-			Apply(*visables[entity].entity,
-				[&](PointLightView&			pointLight,
-					SceneVisibilityView&	visibility,
-					SceneNodeView<>&		sceneNode)
-				{
-					auto position	= sceneNode.GetPosition();
-					auto scale		= sceneNode.GetScale();
-					auto radius		= pointLight.GetRadius();
-
-					if (CompareBSAgainstFrustum(&f, { position, radius * scale }))
-						lights.emplace_back(pointLight);
+		spatialIndex.Query(shape,
+			[&](const VisibilityHandle handle, const BoundingSphere&)
+			{
+				auto* pointLight = static_cast<PointLightView*>(visables[handle].entity->GetView(PointLightComponentID));
 
-					//visibility->GetBoundingVolume();
-					//BoundingSphere BoundingVolume = float4(Pw, light.R * Ps);
-				});
+				if (pointLight)
+					lights.emplace_back(*pointLight);
+			});
 
 		return lights;
 	}
 
 
+	Vector<PointLightHandle> GraphicScene::FindPointLights(const Frustum& f, iAllocator* tempMemory) const
+	{
+		return FindPointLightsInScene(sceneManagement, f, tempMemory);
+	}
+
+
+	Vector<PointLightHandle> GraphicScene::FindPointLights(const BoundingSphere& area, iAllocator* tempMemory) const
+	{
+		return FindPointLightsInScene(sceneManagement, area, tempMemory);
+	}
+
+
 	/************************************************************************************************/
 
 
@@ -967,23 +1204,21 @@ namespace FlexKit
 				data.pointLights	= Vector<PointLightHandle>{ data.temp, 1024 };
 				data.scene			= this;
 
+				// Rebuilt here so the task and GetPointLightCount never rebuild the rows under each other
+				pointLightQuery.Refresh();
+
                 builder.SetDebugString("Point Light Gather");
 			},
 			[this](PointLightGather& data)
 			{
                 FK_LOG_9("Point Light Gather");
 
-				for (auto entity : sceneEntities)
-				{
-					auto& visables = SceneVisibilityComponent::GetComponent();
-
-					Apply(*visables[entity].entity,
-						[&](PointLightView&         pointLight,
-							SceneVisibilityView&    visibility)
-						{
-							data.pointLights.emplace_back(pointLight);
-						});
-				}
+				pointLightQuery.ForEach(
+					[&](GameObject& gameObject, auto& pointLight, auto& visibility)
+					{
+						if (visibility.componentData.scene == sceneID)
+							data.pointLights.emplace_back(pointLight.handle);
+					});
 			}
 		);
 	}
@@ -994,12 +1229,13 @@ namespace FlexKit
 
 	size_t	GraphicScene::GetPointLightCount()
 	{
-		auto& visables		= SceneVisibilityComponent::GetComponent();
-		size_t lightCount	= 0;
+		size_t lightCount = 0;
 
-		for (auto entity : sceneEntities)
-			Apply(*visables[entity].entity,
-				[&](PointLightView& pointLight) { lightCount++; });
+		pointLightQuery.ForEach(
+			[&](GameObject& gameObject, auto& pointLight, auto& visibility)
+			{
+				lightCount += visibility.componentData.scene == sceneID;
+			});
 
 		return lightCount;
 	}
@@ -28,11 +28,16 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "..\buildsettings.h"
 #include "..\coreutilities\Assets.h"
 #include "..\coreutilities\GraphicsComponents.h"
+#include "..\coreutilities\CullingKernels.h"
+#include "..\coreutilities\LooseOctree.h"
 #include "..\graphicsutilities\AnimationUtilities.h" 
 #include "..\graphicsutilities\graphics.h"
 #include "..\graphicsutilities\CoreSceneObjects.h"
 #include "..\graphicsutilities\defaultpipelinestates.h"
 
+#include <mutex>
+#include <shared_mutex>
+
 namespace FlexKit
 {
 	//Forward Declarations 
@@ -43,19 +48,9 @@ namespace FlexKit
 	typedef Pair<bool, int64_t> GSPlayAnimation_RES;
 
 	class  GraphicScene;
+	class  SceneSpatialIndex;
 	struct SceneNodeComponentSystem;
 
-	enum class QuadTreeNodeLocation: int
-	{
-		UpperRight,
-		UpperLeft,
-		LowerLeft,
-		LowerRight
-	};
-
-	const float MinNodeSize = 1;
-
-
 	/************************************************************************************************/
 
 
@@ -106,6 +101,11 @@ namespace FlexKit
 			return mesh->BS;
 		}
 
+		void SetGameObject(GameObject* gameObject) override
+		{
+			GetComponent().SetGameObject(drawable, gameObject);
+		}
+
 		DrawableHandle	drawable = GetComponent().Create(Drawable{});
 	};
 
@@ -192,6 +192,11 @@ namespace FlexKit
 			GetComponent()[light].Position = node;
 		}
 
+		void SetGameObject(GameObject* gameObject) override
+		{
+			GetComponent().SetGameObject(light, gameObject);
+		}
+
 
 		operator PointLightHandle () { return light; }
 
@@ -215,8 +220,13 @@ namespace FlexKit
 		bool			visable		= true;
 		bool			rayVisible	= false;
 		bool			transparent = false;
+		bool			spatialDirty	= true; // world space bounds or flags in the scene's spatial index need a refresh
 
-		BoundingSphere	boundingSphere = { 0, 0, 0, 0 }; // model space
+		BoundingSphere			boundingSphere	= { 0, 0, 0, 0 }; // model space
+		SceneSpatialIndex*		spatialIndex	= nullptr;
+		LooseOctree::EntryID	spatialEntry	= LooseOctree::InvalidIndex;
+		uint32_t				cullingSlot		= LooseOctree::InvalidIndex;
+		VisibilityHandle		nextOnNode		= InvalidHandle_t; // next visible in the spatial index sharing this node
 	};
 
 	using SceneVisibilityComponent = BasicComponent_t<VisibilityFields, VisibilityHandle, SceneVisibilityComponentID>;
@@ -237,14 +247,24 @@ namespace FlexKit
 		void SetBoundingSphere(const BoundingSphere boundingSphere)
 		{
 			GetComponent()[visibility].boundingSphere = boundingSphere;
+			MarkSpatialDirty();
 		}
 
 
         void SetVisable(bool v)
         {
             GetComponent()[visibility].visable = v;
+            MarkSpatialDirty();
         }
 
+
+		inline void MarkSpatialDirty();
+
+		void SetGameObject(GameObject* gameObject) override
+		{
+			GetComponent().SetGameObject(visibility, gameObject);
+		}
+
 		operator VisibilityHandle() { return visibility; }
 
 		VisibilityHandle visibility;
@@ -299,96 +319,151 @@ namespace FlexKit
 	/************************************************************************************************/
 
 
-	struct QuadTreeNode
+	// World space bounding spheres of a scene's visibles, kept twice: in a loose octree for region queries, and
+	// packed into x/y/z/r arrays with drawable/transparent bitmasks for batched camera culling. Update only
+	// refreshes the entries on nodes the last transform update touched, and the entries marked dirty by a bounds
+	// or flag change; if it missed a transform update it refreshes everything. GatherScene runs it. Queries from
+	// several threads only block on a running Update.
+	class SceneSpatialIndex
 	{
-		QuadTreeNode(iAllocator* in_allocator) : 
-			allocator{ in_allocator } {}
+	public:
+		SceneSpatialIndex(iAllocator* allocator) :
+			octree			{ allocator },
+			spheresX		{ allocator },
+			spheresY		{ allocator },
+			spheresZ		{ allocator },
+			spheresR		{ allocator },
+			drawableMask	{ allocator },
+			transparentMask	{ allocator },
+			slotEntities	{ allocator },
+			slotDrawables	{ allocator },
+			nodeEntities	{ allocator },
+			dirtyEntities	{ allocator } {}
 
-		~QuadTreeNode()
-		{
+		void AddEntity		(VisibilityHandle handle);
+		void RemoveEntity	(VisibilityHandle handle);
 
-		}
+		// Queues an entity whose bounds or flags changed for the next Update
+		void MarkDirty		(VisibilityHandle handle);
 
-		void Clear()
-		{
-			for (auto child : ChildNodes) 
-			{
-				child->Clear();
-				child->Contents.clear();
-				allocator->free(child);
-			}
+		void Update			(GraphicScene& parentScene);
+		void clear			();
 
-			ChildNodes.clear();
-			Contents.clear();
-		}
+		size_t size() const { return octree.size(); }
+
+		// Culling slots, CullChunks index these
+		size_t GetSlotCount() const { return slotCount; }
 
-		void AddEntity		(VisibilityHandle visable);
-		void RemoveEntity	(VisibilityHandle visable);
-		
-		enum SphereTestRes
+
+		// A run of candidate slots from a single octree cell
+		struct CullChunk
 		{
-			Partially	= 2,
-			Fully		= 3, 
-			Failed		= 0
+			uint32_t	begin;			// into the candidate slot list
+			uint32_t	count;			// at most 64
+			bool		fullyInside;	// the cell is inside the frustum, nothing to test
 		};
 
-		SphereTestRes IsSphereInside(float r, float3 pos);
 
-		// requires SceneVisibilityComponent
-		void UpdateBounds();
-		void ExpandNode(iAllocator* allocator);
+		// Calls visitor(VisibilityHandle, BoundingSphere) for every entity touching shape,
+		// a Frustum, BoundingSphere or AABB
+		template<typename TY_SHAPE, typename TY_FN>
+		void Query(const TY_SHAPE& shape, TY_FN&& visitor) const
+		{
+			std::shared_lock lock{ updateLock };
 
-		float4								GetArea() const;
+			octree.Query(shape,
+				[&](const uint32_t value, const BoundingSphere& sphere)
+				{
+					visitor(slotEntities[value], sphere);
+				});
+		}
 
-		float2								lowerLeft;
-		float2								upperRight;
-		float2								centerPoint;
 
-		static_vector<VisibilityHandle, 4>	Contents;
-		static_vector<QuadTreeNode*,4>		ChildNodes;
+		// Calls visitor(VisibilityHandle, BoundingSphere, distance) for every entity the ray hits within maxDistance
+		template<typename TY_FN>
+		void Query(const Ray& ray, const float maxDistance, TY_FN&& visitor) const
+		{
+			std::shared_lock lock{ updateLock };
 
-		iAllocator*							allocator;
-	};
+			octree.Query(ray, maxDistance,
+				[&](const uint32_t value, const BoundingSphere& sphere, const float distance)
+				{
+					visitor(slotEntities[value], sphere, distance);
+				});
+		}
 
 
-	struct QuadTree
-	{
-		QuadTree(SceneHandle in_scene, float2 AreaDimensions, iAllocator* in_allocator) :
-			allocator	{ in_allocator	},
-			scene		{ in_scene		},
-			root		{ in_allocator	}
+		// Appends every entity touching shape to out, returns how many were added
+		template<typename TY_SHAPE>
+		size_t Gather(const TY_SHAPE& shape, Vector<VisibilityHandle>& out) const
 		{
-			area					= float2{0, 0};
+			const size_t begin = out.size();
+			Query(shape, [&](const VisibilityHandle handle, const BoundingSphere&) { out.push_back(handle); });
 
-			root.upperRight = AreaDimensions;
-			root.lowerLeft	= AreaDimensions * -1;
+			return out.size() - begin;
 		}
 
-		void clear();
-		
-		void AddEntity		(VisibilityHandle handle);
-		void RemoveEntity	(VisibilityHandle handle);
-
-		void Rebuild		(GraphicScene& parentScene);
 
-		float4		GetArea();
+		// Coarse pass, walks the octree cells against the frustum and appends the slots of every cell it doesn't
+		// reject to slots, one chunk per cell and at most 64 slots each.
+		void GatherCullChunks(const Frustum& frustum, Vector<uint32_t>& slots, Vector<CullChunk>& chunks) const;
 
-		UpdateTask& Update(FlexKit::UpdateDispatcher& dispatcher, GraphicScene* parentScene, UpdateTask& transformDependency);
+		// Fine pass, pushes the visible, non skinned drawables of the chunks into solid or transparent. A fully
+		// inside chunk takes all of its slots, the others test only their own slots eight at a time. Chunks can
+		// be split across threads that each fill their own PVS.
+		void CullChunks(const CullingPlanes& planes, const uint32_t* slots, const CullChunk* begin, const CullChunk* end, PVS& solid, PVS& transparent) const;
 
-		const SceneHandle			scene;
-		const size_t				NodeSize = 16;
+	private:
+		void _RefreshSlot(const uint32_t slot, const VisibilityFields& visibility);
+		void _LinkNode	(VisibilityHandle handle, VisibilityFields& visibility);
+		void _UnlinkNode(VisibilityHandle handle, VisibilityFields& visibility);
 
+		static void _SetBit(Vector<uint64_t>& mask, const size_t idx, const bool value)
+		{
+			const uint64_t bit = uint64_t(1) << (idx % 64);
+			mask[idx / 64] = value ? (mask[idx / 64] | bit) : (mask[idx / 64] & ~bit);
+		}
 
-		size_t						RebuildPeriod	= 10;
-		size_t						RebuildCounter	= 10;
+		static bool _GetBit(const Vector<uint64_t>& mask, const size_t idx)
+		{
+			return (mask[idx / 64] >> (idx % 64)) & 1;
+		}
 
-		float2						area;
-		QuadTreeNode				root;
-		iAllocator*					allocator;
+		LooseOctree					octree;				// entry values are culling slots
+
+		// Culling slots are dense, removal moves the last slot into the hole.
+		// Arrays are padded out to a multiple of 64 slots.
+		size_t						slotCount = 0;
+		Vector<float>				spheresX;
+		Vector<float>				spheresY;
+		Vector<float>				spheresZ;
+		Vector<float>				spheresR;
+		Vector<uint64_t>			drawableMask;		// visable, with a drawable view
+		Vector<uint64_t>			transparentMask;
+		Vector<VisibilityHandle>	slotEntities;
+		Vector<DrawableHandle>		slotDrawables;
+
+		Vector<VisibilityHandle>	nodeEntities;		// NodeHandle -> first entity on that node, chained through nextOnNode
+		Vector<VisibilityHandle>	dirtyEntities;
+		size_t						transformUpdate = 0;	// last transform update Update caught up with
+
+		mutable std::shared_mutex	updateLock;
+		std::mutex					dirtyLock;
 	};
 
 
-	void UpdateQuadTree		( QuadTreeNode* Node, GraphicScene* Scene );
+	inline void SceneVisibilityView::MarkSpatialDirty()
+	{
+		auto& fields = GetComponent()[visibility];
+
+		if (fields.spatialIndex)
+			fields.spatialIndex->MarkDirty(visibility);
+		else
+			fields.spatialDirty = true;
+	}
+
+
+	BoundingSphere GetWorldBoundingSphere(const VisibilityFields& visibility);
 
 	
 	/************************************************************************************************/
@@ -410,8 +485,10 @@ namespace FlexKit
 				allocator					{ in_allocator							},
 				HandleTable					{ in_allocator							},
 				sceneID						{ rand()								},
-				sceneManagement				{ sceneID, {1024, 1024}, in_allocator	},
-				sceneEntities				{ in_allocator							} {}
+				sceneManagement				{ in_allocator							},
+				sceneEntities				{ in_allocator							},
+				loadedGameObjects			{ in_allocator							},
+				pointLightQuery				{ in_allocator							} {}
 				
 		~GraphicScene()
 		{
@@ -426,6 +503,7 @@ namespace FlexKit
 		Drawable&	        SetNode(SceneEntityHandle EHandle, NodeHandle Node);
 
 		Vector<PointLightHandle>    FindPointLights(const Frustum& f, iAllocator* tempMemory) const;
+		Vector<PointLightHandle>    FindPointLights(const BoundingSphere& area, iAllocator* tempMemory) const;
 
 
         PointLightGatherTask&	    GetPointLights(UpdateDispatcher& disatcher, iAllocator* tempMemory);
@@ -439,8 +517,11 @@ namespace FlexKit
 		HandleUtilities::HandleTable<SceneEntityHandle, 16> HandleTable;
 			
 		Vector<VisibilityHandle>			sceneEntities;
-		QuadTree							sceneManagement;
+		SceneSpatialIndex					sceneManagement;
 		iAllocator*							allocator;
+		GameObjectBatches					loadedGameObjects; // Made by LoadScene, released by ClearScene
+
+		ComponentQuery<PointLightView, SceneVisibilityView>	pointLightQuery;
 
 		operator GraphicScene* () { return this; }
 	};
@@ -459,6 +540,7 @@ namespace FlexKit
 	{
 		CameraHandle	camera;
 		GraphicScene*	scene; // Source Scene
+		ThreadManager*	threads;
 		StackAllocator	taskMemory;
 		PVS				solid;
 		PVS				transparent;
@@ -483,7 +565,19 @@ namespace FlexKit
 	FLEXKITAPI void UpdateShadowCasters				(GraphicScene* SM);
 
     FLEXKITAPI void         GatherScene(GraphicScene* SM, CameraHandle Camera, PVS& solid, PVS& transparent);
-    FLEXKITAPI GatherTask&  GatherScene(UpdateDispatcher& dispatcher, GraphicScene* scene, CameraHandle C, iAllocator* allocator);
+    FLEXKITAPI GatherTask&  GatherScene(UpdateDispatcher& dispatcher, GraphicScene* scene, CameraHandle C);
+
+    // Most candidate slots per worker block in GatherSceneParallel, blocks are made of whole cell chunks
+    constexpr size_t GatherSceneBlockSize = 4096;
+
+    // Scratch GatherSceneParallel needs for a scene with slotCount culling slots
+    FLEXKITAPI size_t       GetGatherSceneScratchSize(const size_t slotCount);
+
+    // GatherScene and SortPVS split across the worker threads. The octree cells are walked on the calling thread,
+    // then each block of candidates is culled, keyed and sorted on a worker into its own PVS's, and the sorted
+    // blocks are merged pairwise in parallel while the transparent lists are concatenated. temp is only
+    // allocated from by the calling thread.
+    FLEXKITAPI void         GatherSceneParallel(ThreadManager& threads, GraphicScene* SM, CameraHandle Camera, PVS& solid, PVS& transparent, iAllocator* temp);
 
 
 	FLEXKITAPI void ReleaseGraphicScene				(GraphicScene* SM);
@@ -507,75 +601,6 @@ namespace FlexKit
 	inline void Release(PoseState* EPS, iAllocator* allocator);
 
 
-	/************************************************************************************************/
-
-
-	inline void DEBUG_DrawQuadTree(
-		GraphicScene&			scene, 
-		UpdateDispatcher&		dispatcher,
-		UpdateTask&				sceneUpdate,
-		FrameGraph&				graph, 
-		CameraHandle			camera,
-		VertexBufferHandle		vertexBuffer, 
-		ConstantBufferHandle	constantBuffer,
-		ResourceHandle			renderTarget,
-		iAllocator*				tempMemory)
-	{
-		Vector<FlexKit::Rectangle> rects{ tempMemory };
-
-		const float4 colors[] =
-		{
-			{0, 0, 1, 1},
-			{0, 1, 1, 1},
-			{1, 1, 0, 1},
-			{1, 0, 0, 1}
-		};
-
-		const auto	area		= scene.sceneManagement.GetArea();
-		const auto	areaLL		= (area.y <  area.z) ? float2{ area.x, area.y } : float2{ area.z, area.w };
-		const auto	areaUR		= (area.y >= area.z) ? float2{ area.x, area.y } : float2{ area.z, area.w };
-		const auto	areaSpan	= (areaUR - areaLL);
-		int			itr			= 0;
-
-		auto drawNode = [&](auto& self, const QuadTreeNode& Node, const int depth) -> void
-		{
-			auto nodeArea = Node.GetArea();
-
-			//const auto ll = (float2{ nodeArea.x, nodeArea.y } - areaLL) / areaSpan;
-			//const auto ur = (float2{ nodeArea.z, nodeArea.w } - areaLL) / areaSpan;
-
-			const auto ll = float2{nodeArea.x, nodeArea.y};// lower left
-			const auto ur = float2{nodeArea.z, nodeArea.w};// upper right
-
-			FlexKit::Rectangle rect;
-			rect.Color		= colors[depth % 4];
-			rect.Position	= ll;
-			rect.WH			= ur - ll;
-			rects.push_back(rect);
-
-			for (auto& child : Node.ChildNodes)
-				self(self, *child, depth + 1 + itr++);
-		};
-
-		drawNode(drawNode, scene.sceneManagement.root, 0);
-
-		DrawWireframeRectangle_Desc drawDesc =
-		{
-			renderTarget,
-			vertexBuffer,
-			constantBuffer,
-			camera,
-			DRAW_LINE3D_PSO
-		};
-
-		WireframeRectangleList(
-			graph,
-			drawDesc,
-			rects,
-			tempMemory);
-	}
-
-
     /************************************************************************************************/
 
 
@@ -28,6 +28,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "..\coreutilities\containers.h"
 #include "..\coreutilities\type.h"
 
+#include <algorithm>
 #include <stdint.h>
 
 
@@ -168,63 +169,120 @@ namespace FlexKit
 
 	namespace HandleUtilities
 	{
-		// TODO RESORT HANDLES AFTER FREE LIST FILLS
+		// Handles carry a generation in their top bits, bumped every time their slot is released, so a stale handle
+		// fails Has() instead of aliasing whatever reused the slot. Generations wrap after 2^GenerationBits reuses.
+		// Handles under 32 bits keep every bit for the slot and only get the live check.
 
-		template<typename HANDLE, size_t SIZE = 128>
+		template<typename HANDLE, size_t SIZE = 128, size_t GenerationBits = (HANDLE::GetHandleSize() >= 32 ? 8 : 0)>
 		struct HandleTable
 		{
-			HandleTable(iAllocator* Memory = nullptr, const Type_t type = 0x00 ) : mType( type ), FreeList(Memory), Indexes(Memory) {}
+			static_assert(GenerationBits < HANDLE::GetHandleSize(),	"No bits left for the slot!");
+			static_assert(GenerationBits <= 15,						"Generations are stored in 15 bits!");
+
+			static const size_t		SlotBits		= HANDLE::GetHandleSize() - GenerationBits;
+			static const index_t	SlotMask		= index_t((uint64_t(1) << SlotBits) - 1);
+			static const uint16_t	GenerationMask	= uint16_t((1u << GenerationBits) - 1);
+
+			HandleTable(iAllocator* Memory = nullptr, const Type_t type = 0x00 ) : mType( type ), FreeList(Memory), Indexes(Memory), Generations(Memory) {}
 
 			void Initiate( iAllocator* Memory )
 			{
-				FreeList.Allocator = Memory;
-				Indexes.Allocator = Memory;
+				FreeList.Allocator		= Memory;
+				Indexes.Allocator		= Memory;
+				Generations.Allocator	= Memory;
 			}
 
 			inline index_t&	operator[] ( const HANDLE in )
 			{
 				#ifdef _DEBUG
-				//HandleUtilities::CheckType(in, mType);
+				FK_ASSERT(Has(in), "Stale or invalid handle!");
 				#endif
-				return Indexes[ in.INDEX ];
+				return Indexes[ GetSlot(in) ];
 			}
 
-			inline index_t	operator[] ( const HANDLE in ) const	{return Indexes[ in.INDEX ];}
+			inline index_t	operator[] ( const HANDLE in ) const	{return Indexes[ GetSlot(in) ];}
+
+			inline index_t&	Get( const HANDLE in )					{return Indexes[ GetSlot(in) ];}
+			inline index_t	Get( const HANDLE in ) const			{return Indexes[ GetSlot(in) ];}
+
+			// Release builds skip the check in operator [], lookups that can see stale handles should use this
+			inline bool		TryGet( const HANDLE in, index_t& out ) const
+			{
+				if (!Has(in))
+					return false;
 
-			inline index_t&	Get( const HANDLE in )					{return Indexes[ in.INDEX ];}
-			inline index_t	Get( const HANDLE in ) const			{return Indexes[ in.INDEX ];}
+				out = Indexes[ GetSlot(in) ];
+				return true;
+			}
 
 			inline HANDLE	GetNewHandle()
 			{
-                while(FreeList.size() && FreeList.back() >= FreeList.size())
-                    FreeList.pop_back();
+				index_t slot;
 
-                if (FreeList.size())
-                    return { FreeList.pop_back(), mType, FlexKit::Handle::HF_USED };
+				if (FreeList.size())
+					slot = FreeList.pop_back();
+				else
+				{
+					slot = (index_t)Indexes.push_back(-1);
 
-                return { (index_t)Indexes.push_back(-1), mType, FlexKit::Handle::HF_USED };
+					// Slots trimmed by Compact keep their generation
+					if (slot == Generations.size())
+						Generations.push_back(0);
+				}
+
+				FK_ASSERT((slot <= SlotMask), "Handle table out of slots!");
+
+				Generations[slot] |= LiveBit;
+
+				return _MakeHandle(slot);
 			}
 
 			inline void	Clear()
 			{
+				// Retire every handle handed out so far, generations are kept so old handles stay invalid
+				for (auto& generation : Generations)
+					generation = uint16_t((generation & ~LiveBit) + GenerationStep);
+
 				FreeList.clear();
 				Indexes.clear();
 			}
 
-			inline bool	Has( Handle find_this_Handle ) const
+			inline bool	Has( const HANDLE in ) const
 			{
-				if( std::find( Indexes.begin(), Indexes.end(), find_this_Handle.INDEX ) !=
-					Indexes.end() )
-					return true;
-				return false;
+				const auto slot = GetSlot(in);
+
+				return
+					slot < Indexes.size() &&
+					(Generations[slot] & LiveBit) &&
+					((Generations[slot] >> 1) & GenerationMask) == GetGeneration(in);
 			}
 
 			inline void	RemoveHandle( HANDLE in )
 			{
-				if( in.INDEX < Indexes.size() )
-					FreeList.push_back( Indexes[in.INDEX] );
+				if( Has(in) )
+				{
+					const auto slot = GetSlot(in);
+
+					Generations[slot] = uint16_t((Generations[slot] & ~LiveBit) + GenerationStep);
+					FreeList.push_back( slot );
+				}
 				else
-					FK_ASSERT( 0 );
+					FK_ASSERT( 0, "Handle removed twice, or was never issued by this table!" );
+			}
+
+			// Drops free slots off the end of the table and orders the rest lowest first. One shot, slots removed
+			// after this are pushed on the back and handed out before the sorted ones, call again to reorder.
+			void Compact()
+			{
+				std::sort(FreeList.begin(), FreeList.end());
+
+				while (FreeList.size() && FreeList.back() == Indexes.size() - 1)
+				{
+					FreeList.pop_back();
+					Indexes.pop_back();
+				}
+
+				std::reverse(FreeList.begin(), FreeList.end());
 			}
 
 			inline size_t size()
@@ -250,26 +308,51 @@ namespace FlexKit
 
 			HANDLE find(size_t idx)
 			{
-				for (size_t I = 0; I < Indexes.size(); ++I)
-					if(Indexes[I] == idx)
-						return HANDLE(I);
+				for (index_t I = 0; I < Indexes.size(); ++I)
+					if(Indexes[I] == idx && (Generations[I] & LiveBit))
+						return _MakeHandle(I);
 
 				return HANDLE(-1);
 			}
 
-			HandleTable( const HandleTable<HANDLE>& in )				= delete;	// Do not allow Table copying
-			HandleTable& operator = ( const HandleTable<HANDLE>& rhs )	= delete;	// Do not allow Table copying
+			static index_t	GetSlot			(const HANDLE in) { return index_t(in.INDEX) & SlotMask; }
+			static uint16_t	GetGeneration	(const HANDLE in)
+			{
+				if constexpr (GenerationBits > 0)
+					return uint16_t(index_t(in.INDEX) >> SlotBits);
+				else
+					return 0;
+			}
+
+			HandleTable( const HandleTable& in )				= delete;	// Do not allow Table copying
+			HandleTable& operator = ( const HandleTable& rhs )	= delete;	// Do not allow Table copying
 
-			Vector<index_t> FreeList;
-			Vector<index_t> Indexes;
+			Vector<index_t>		FreeList;		// Free slots, popped from the back
+			Vector<index_t>		Indexes;
+			Vector<uint16_t>	Generations;	// Per slot, live flag in the low bit
 
 			void Release()
 			{
 				FreeList.Release();
 				Indexes.Release();
+				Generations.Release();
 			}
 
 			const Type_t mType;
+
+		private:
+			static const uint16_t LiveBit			= 0x01;
+			static const uint16_t GenerationStep	= 0x02;
+
+			HANDLE _MakeHandle(const index_t slot) const
+			{
+				index_t index = slot;
+
+				if constexpr (GenerationBits > 0)
+					index |= index_t((Generations[slot] >> 1) & GenerationMask) << SlotBits;
+
+				return { index, mType, FlexKit::Handle::HF_USED };
+			}
 		};
 
 		inline void CheckType(HANDLE hdnl_in, Type_t type_in )
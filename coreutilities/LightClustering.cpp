@@ -0,0 +1,281 @@
+/**********************************************************************
+
+Copyright (c) 2015 - 2019 Robert May
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************/
+
+#include "LightClustering.h"
+#include "..\coreutilities\ThreadUtilities.h"
+
+#include <algorithm>
+#include <math.h>
+
+namespace FlexKit
+{
+	/************************************************************************************************/
+
+
+	uint32_t LightClusterGrid::GetSlice(const float distance) const noexcept
+	{
+		if (!(distance > nearZ))
+			return 0;
+
+		const float slice = logf(distance / nearZ) / logf(farZ / nearZ) * float(sliceCount);
+
+		return slice < float(sliceCount - 1) ? uint32_t(slice) : sliceCount - 1;
+	}
+
+
+	/************************************************************************************************/
+
+
+	// Half open cluster ranges, x and y in tiles then slices
+	struct LightClusterBounds
+	{
+		uint32_t begin[3];
+		uint32_t end[3];
+	};
+
+
+	static uint32_t GetTileRangeBegin(const float ndc, const float pixels, const uint32_t tileSize, const uint32_t tileCount)
+	{
+		const float tile = (ndc + 1.0f) * 0.5f * pixels / float(tileSize);
+		return tile > 0.0f ? (tile < float(tileCount) ? uint32_t(tile) : tileCount - 1) : 0;
+	}
+
+
+	static uint32_t GetTileRangeEnd(const float ndc, const float pixels, const uint32_t tileSize, const uint32_t tileCount)
+	{
+		const float tile = (ndc + 1.0f) * 0.5f * pixels / float(tileSize);
+		return tile > 0.0f ? (tile < float(tileCount) ? uint32_t(tile) + 1 : tileCount) : 1;
+	}
+
+
+	// Projects the sphere's view space bounding box, so the tile range can be loose near the edges of the
+	// screen but never misses a tile. Returns false when the light is outside of the frustum.
+	static bool GetLightClusterBounds(const LightClusterGrid& grid, const Quaternion inverseOrientation, const BoundingSphere& light, LightClusterBounds& out)
+	{
+		const float3	offset		= light.xyz() - grid.position;
+		const float3	view		= inverseOrientation * offset;
+		const float		r			= light.w;
+		const float		depth		= -view.z;
+
+		if (depth + r < grid.nearZ || depth - r > grid.farZ)
+			return false;
+
+		const float tanY	= tanf(grid.fovY / 2.0f);
+		const float tanX	= tanY * grid.aspectRatio;
+		const float nearest	= depth - r;
+		const float furthest = depth + r;
+
+		float minX = -1.0f, maxX = 1.0f;
+		float minY = -1.0f, maxY = 1.0f;
+
+		// Spheres reaching behind the camera can cover any part of the screen
+		if (nearest > 0.0f)
+		{
+			minX = std::min((view.x - r) / nearest, (view.x - r) / furthest) / tanX;
+			maxX = std::max((view.x + r) / nearest, (view.x + r) / furthest) / tanX;
+			minY = std::min((view.y - r) / nearest, (view.y - r) / furthest) / tanY;
+			maxY = std::max((view.y + r) / nearest, (view.y + r) / furthest) / tanY;
+
+			if (minX > 1.0f || maxX < -1.0f || minY > 1.0f || maxY < -1.0f)
+				return false;
+		}
+
+		const uint2		tiles		= grid.GetTileCount();
+		const float		distance	= offset.magnitude();
+
+		out.begin[0]	= GetTileRangeBegin	(minX, float(grid.screenWH[0]), grid.tileSize, tiles[0]);
+		out.end[0]		= GetTileRangeEnd	(maxX, float(grid.screenWH[0]), grid.tileSize, tiles[0]);
+
+		// Tile rows count down from the top of the screen
+		out.begin[1]	= GetTileRangeBegin	(-maxY, float(grid.screenWH[1]), grid.tileSize, tiles[1]);
+		out.end[1]		= GetTileRangeEnd	(-minY, float(grid.screenWH[1]), grid.tileSize, tiles[1]);
+
+		out.begin[2]	= grid.GetSlice(distance - r);
+		out.end[2]		= grid.GetSlice(distance + r) + 1;
+
+		return true;
+	}
+
+
+	/************************************************************************************************/
+
+
+	// Runs FN over [0, count) in blocks, inline when there are no threads or only one block
+	template<typename FN>
+	static void ForEachLightClusterBlock(ThreadManager* threads, const size_t count, const size_t blockSize, iAllocator* allocator, FN fn)
+	{
+		if (!threads || count <= blockSize)
+		{
+			fn(size_t(0), count);
+			return;
+		}
+
+		WorkBarrier barrier{ *threads, allocator };
+
+		for (size_t begin = 0; begin < count; begin += blockSize)
+		{
+			const size_t end = std::min(begin + blockSize, count);
+
+			auto& workItem = CreateWorkItem([&fn, begin, end] { fn(begin, end); }, allocator);
+
+			barrier.AddWork(workItem);
+			PushToLocalQueue(workItem);
+		}
+
+		barrier.Join();
+	}
+
+
+	/************************************************************************************************/
+
+
+	void BuildLightClusters(
+		const LightClusterGrid&	grid,
+		const BoundingSphere*	lights,
+		const size_t			lightCount,
+		LightClusterList&		out,
+		ThreadManager*			threads,
+		iAllocator*				allocator)
+	{
+		constexpr size_t CullBlockSize = 256;
+
+		out.clear();
+
+		const uint2		tiles			= grid.GetTileCount();
+		const uint32_t	tilesPerSlice	= tiles.Product();
+		const uint32_t	sliceCount		= grid.sliceCount;
+
+		out.clusters.resize(grid.GetClusterCount());
+		memset(out.clusters.begin(), 0, sizeof(LightCluster) * out.clusters.size());
+
+		if (!lightCount || !tilesPerSlice)
+			return;
+
+		// Cull and find every light's cluster range
+		Vector<LightClusterBounds>	bounds	{ allocator, lightCount };
+		Vector<uint8_t>				visible	{ allocator, lightCount };
+		bounds.resize(lightCount);
+		visible.resize(lightCount);
+
+		const Quaternion inverseOrientation = grid.orientation.Inverse();
+
+		ForEachLightClusterBlock(threads, lightCount, CullBlockSize, allocator,
+			[&](const size_t begin, const size_t end)
+			{
+				for (size_t I = begin; I < end; ++I)
+					visible[I] = GetLightClusterBounds(grid, inverseOrientation, lights[I], bounds[I]);
+			});
+
+		// Compact the survivors, from here on lights are referred to by visible index
+		size_t visibleCount = 0;
+		for (size_t I = 0; I < lightCount; ++I)
+		{
+			if (visible[I])
+			{
+				out.visibleLights.push_back((uint32_t)I);
+				bounds[visibleCount++] = bounds[I];
+			}
+		}
+
+		if (!visibleCount)
+			return;
+
+		// Slices are independent, each one counts, offsets and fills its own clusters
+		Vector<uint32_t> sliceTotals{ allocator, sliceCount };
+		sliceTotals.resize(sliceCount);
+
+		ForEachLightClusterBlock(threads, sliceCount, 1, allocator,
+			[&](const size_t begin, const size_t end)
+			{
+				for (size_t slice = begin; slice < end; ++slice)
+				{
+					LightCluster*	sliceClusters	= out.clusters.begin() + slice * tilesPerSlice;
+					uint32_t		total			= 0;
+
+					for (size_t I = 0; I < visibleCount; ++I)
+					{
+						const auto& range = bounds[I];
+
+						if (slice < range.begin[2] || slice >= range.end[2])
+							continue;
+
+						for (uint32_t y = range.begin[1]; y < range.end[1]; ++y)
+							for (uint32_t x = range.begin[0]; x < range.end[0]; ++x)
+								sliceClusters[x + y * tiles[0]].count++;
+
+						total += (range.end[0] - range.begin[0]) * (range.end[1] - range.begin[1]);
+					}
+
+					sliceTotals[slice] = total;
+				}
+			});
+
+		uint32_t indexCount = 0;
+		for (auto& total : sliceTotals)
+		{
+			const uint32_t sliceSize = total;
+			total		= indexCount;
+			indexCount += sliceSize;
+		}
+
+		out.lightIndices.resize(indexCount);
+
+		ForEachLightClusterBlock(threads, sliceCount, 1, allocator,
+			[&](const size_t begin, const size_t end)
+			{
+				for (size_t slice = begin; slice < end; ++slice)
+				{
+					LightCluster*	sliceClusters	= out.clusters.begin() + slice * tilesPerSlice;
+					uint32_t		offset			= sliceTotals[slice];
+
+					for (uint32_t I = 0; I < tilesPerSlice; ++I)
+					{
+						sliceClusters[I].offset	 = offset;
+						offset					+= sliceClusters[I].count;
+						sliceClusters[I].count	 = 0;
+					}
+
+					// Lights are visited in order, so every cluster's list comes out sorted
+					for (size_t I = 0; I < visibleCount; ++I)
+					{
+						const auto& range = bounds[I];
+
+						if (slice < range.begin[2] || slice >= range.end[2])
+							continue;
+
+						for (uint32_t y = range.begin[1]; y < range.end[1]; ++y)
+						{
+							for (uint32_t x = range.begin[0]; x < range.end[0]; ++x)
+							{
+								auto& cluster = sliceClusters[x + y * tiles[0]];
+								out.lightIndices[cluster.offset + cluster.count++] = (uint32_t)I;
+							}
+						}
+					}
+				}
+			});
+	}
+
+
+}	/************************************************************************************************/
@@ -0,0 +1,123 @@
+/**********************************************************************
+
+Copyright (c) 2015 - 2019 Robert May
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************/
+
+#ifndef LIGHTCLUSTERING_H_INCLUDED
+#define LIGHTCLUSTERING_H_INCLUDED
+
+#include "..\buildsettings.h"
+#include "..\coreutilities\containers.h"
+#include "..\coreutilities\intersection.h"
+#include "..\coreutilities\MathUtils.h"
+
+#include <stdint.h>
+
+// Froxel light assignment on the CPU. Screen tiles are split into exponential slices of distance from
+// the camera, every light is binned into the clusters its bounding sphere might touch, and the result
+// is a flat light index list with an offset/count pair per cluster, ready to upload as is.
+
+namespace FlexKit
+{
+	class ThreadManager;
+
+
+	/************************************************************************************************/
+
+
+	constexpr uint32_t LightClusterTileSize		= 10; // pixels, matches the tiled shading pass's group size
+	constexpr uint32_t LightClusterSliceCount	= 16;
+
+
+	// Camera looks down -Z of its orientation, fovY is the full vertical angle in radians
+	struct LightClusterGrid
+	{
+		float3		position;
+		Quaternion	orientation;
+		float		fovY;
+		float		aspectRatio;
+		float		nearZ;
+		float		farZ;
+		uint2		screenWH;
+		uint32_t	tileSize	= LightClusterTileSize;
+		uint32_t	sliceCount	= LightClusterSliceCount;
+
+		uint2		GetTileCount	() const noexcept { return { (screenWH[0] + tileSize - 1) / tileSize, (screenWH[1] + tileSize - 1) / tileSize }; }
+		uint32_t	GetClusterCount	() const noexcept { return GetTileCount().Product() * sliceCount; }
+
+		// Slices split distance from the camera, not view depth, the shading pass gets the same
+		// distance back from the depth buffer without reconstructing view space
+		uint32_t	GetSlice		(const float distance) const noexcept;
+
+		uint32_t	GetClusterIndex	(const uint32_t x, const uint32_t y, const uint32_t slice) const noexcept
+		{
+			const uint2 tiles = GetTileCount();
+			return x + y * tiles[0] + slice * tiles[0] * tiles[1];
+		}
+	};
+
+
+	/************************************************************************************************/
+
+
+	struct LightCluster
+	{
+		uint32_t offset; // into LightClusterList::lightIndices
+		uint32_t count;
+	};
+
+
+	struct LightClusterList
+	{
+		LightClusterList(iAllocator* allocator = nullptr) :
+			visibleLights	{ allocator },
+			clusters		{ allocator },
+			lightIndices	{ allocator } {}
+
+		void clear()
+		{
+			visibleLights.clear();
+			clusters.clear();
+			lightIndices.clear();
+		}
+
+		Vector<uint32_t>		visibleLights;	// indices of the lights that survived culling, in input order
+		Vector<LightCluster>	clusters;		// x fastest, then y, then slice, see LightClusterGrid::GetClusterIndex
+		Vector<uint32_t>		lightIndices;	// indices into visibleLights, ascending within each cluster
+	};
+
+
+	// Culls the lights against the grid's frustum and bins the survivors. Assignment is conservative, a light
+	// can be listed in a cluster it only nearly touches but never misses one it touches.
+	// Work is split over threads when given one, all memory comes from allocator on the calling thread.
+	FLEXKITAPI void BuildLightClusters(
+		const LightClusterGrid&	grid,
+		const BoundingSphere*	lights,
+		const size_t			lightCount,
+		LightClusterList&		out,
+		ThreadManager*			threads,
+		iAllocator*				allocator);
+
+
+}	/************************************************************************************************/
+
+#endif
@@ -0,0 +1,466 @@
+/**********************************************************************
+
+Copyright (c) 2015 - 2019 Robert May
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************/
+
+#include "LooseOctree.h"
+
+namespace FlexKit
+{
+	/************************************************************************************************/
+
+
+	LooseOctree::LooseOctree(iAllocator* IN_allocator, const float3 IN_center, const float IN_halfSpan) :
+		allocator		{ IN_allocator },
+		cells			{ IN_allocator },
+		entries			{ IN_allocator },
+		freeEntries		{ IN_allocator },
+		freeCellBlocks	{ IN_allocator }
+	{
+		Cell root;
+		root.center[0]		= IN_center.x;
+		root.center[1]		= IN_center.y;
+		root.center[2]		= IN_center.z;
+		root.halfSpan		= IN_halfSpan;
+		root.parent			= InvalidIndex;
+		root.firstChild		= InvalidIndex;
+		root.firstEntry		= InvalidIndex;
+		root.entryCount		= 0;
+		root.subtreeCount	= 0;
+		root.depth			= 0;
+
+		cells.push_back(root);
+	}
+
+
+	/************************************************************************************************/
+
+
+	LooseOctree::EntryID LooseOctree::Insert(const BoundingSphere sphere, const uint32_t userValue)
+	{
+		Entry entry;
+		entry.sphere	= sphere;
+		entry.userValue	= userValue;
+		entry.cell		= InvalidIndex;
+		entry.prev		= InvalidIndex;
+		entry.next		= InvalidIndex;
+
+		EntryID entryIdx;
+
+		if (freeEntries.size())
+		{
+			entryIdx			= freeEntries.pop_back();
+			entries[entryIdx]	= entry;
+		}
+		else
+			entryIdx = (EntryID)entries.push_back(entry);
+
+		_Link(entryIdx, _FindCell(sphere));
+
+		return entryIdx;
+	}
+
+
+	/************************************************************************************************/
+
+
+	void LooseOctree::Remove(const EntryID entryIdx)
+	{
+		FK_ASSERT((entries[entryIdx].cell != InvalidIndex), "Entry removed twice!");
+
+		const auto cell = entries[entryIdx].cell;
+
+		_Unlink(entryIdx);
+		_CollapseEmpty(cell);
+
+		freeEntries.push_back(entryIdx);
+	}
+
+
+	/************************************************************************************************/
+
+
+	bool LooseOctree::Move(const EntryID entryIdx, const BoundingSphere sphere)
+	{
+		auto& entry		= entries[entryIdx];
+		entry.sphere	= sphere;
+
+		const auto& cell = cells[entry.cell];
+
+		// Still fits, and would not go any deeper
+		if (_Fits(cell, sphere) && (cell.firstChild == InvalidIndex || _ChildFor(cell, sphere) == InvalidIndex))
+			return false;
+
+		const auto previousCell = entry.cell;
+		const auto newCell		= _FindCell(sphere);
+
+		if (newCell == previousCell)
+			return false;
+
+		_Unlink(entryIdx);
+		_Link(entryIdx, newCell);
+		_CollapseEmpty(previousCell);
+
+		return true;
+	}
+
+
+	/************************************************************************************************/
+
+
+	void LooseOctree::Clear()
+	{
+		auto root = cells[0];
+		root.firstChild		= InvalidIndex;
+		root.firstEntry		= InvalidIndex;
+		root.entryCount		= 0;
+		root.subtreeCount	= 0;
+
+		cells.clear();
+		cells.push_back(root);
+
+		entries.clear();
+		freeEntries.clear();
+		freeCellBlocks.clear();
+	}
+
+
+	/************************************************************************************************/
+
+
+	AABB LooseOctree::_GetLooseBounds(const Cell& cell) const
+	{
+		const float looseSpan = cell.halfSpan * 2.0f;
+
+		AABB bounds;
+		bounds.min = { cell.center[0] - looseSpan, cell.center[1] - looseSpan, cell.center[2] - looseSpan };
+		bounds.max = { cell.center[0] + looseSpan, cell.center[1] + looseSpan, cell.center[2] + looseSpan };
+
+		return bounds;
+	}
+
+
+	/************************************************************************************************/
+
+
+	LooseOctree::CellTestResult LooseOctree::_TestCell(const Frustum& frustum, const Cell& cell) const
+	{
+		const float looseSpan = cell.halfSpan * 2.0f;
+
+		bool intersects = false;
+
+		for (const auto& plane : frustum.Planes)
+		{
+			// Distance from the plane to the box center, and how far the box reaches along the plane normal
+			const float d =
+				plane.Normal.x * (cell.center[0] - plane.Orgin.x) +
+				plane.Normal.y * (cell.center[1] - plane.Orgin.y) +
+				plane.Normal.z * (cell.center[2] - plane.Orgin.z);
+
+			const float reach = looseSpan * (fabs(plane.Normal.x) + fabs(plane.Normal.y) + fabs(plane.Normal.z));
+
+			if (d - reach > 0.0f)
+				return CellTestResult::Outside;
+
+			if (d + reach > 0.0f)
+				intersects = true;
+		}
+
+		return intersects ? CellTestResult::Intersects : CellTestResult::Inside;
+	}
+
+
+	/************************************************************************************************/
+
+
+	LooseOctree::CellTestResult LooseOctree::_TestCell(const BoundingSphere& sphere, const Cell& cell) const
+	{
+		const float looseSpan = cell.halfSpan * 2.0f;
+
+		float nearestSquared	= 0.0f;
+		float furthestSquared	= 0.0f;
+
+		for (size_t I = 0; I < 3; ++I)
+		{
+			const float d		= fabs(sphere[I] - cell.center[I]);
+			const float outside	= d - looseSpan;
+
+			if (outside > 0.0f)
+				nearestSquared += outside * outside;
+
+			furthestSquared += (d + looseSpan) * (d + looseSpan);
+		}
+
+		const float rSquared = sphere.w * sphere.w;
+
+		if (nearestSquared > rSquared)
+			return CellTestResult::Outside;
+
+		return furthestSquared <= rSquared ? CellTestResult::Inside : CellTestResult::Intersects;
+	}
+
+
+	/************************************************************************************************/
+
+
+	LooseOctree::CellTestResult LooseOctree::_TestCell(const AABB& aabb, const Cell& cell) const
+	{
+		const AABB bounds = _GetLooseBounds(cell);
+
+		if (!Intersects(aabb, bounds))
+			return CellTestResult::Outside;
+
+		for (size_t I = 0; I < 3; ++I)
+		{
+			if (bounds.min[I] < aabb.min[I] || bounds.max[I] > aabb.max[I])
+				return CellTestResult::Intersects;
+		}
+
+		return CellTestResult::Inside;
+	}
+
+
+	/************************************************************************************************/
+
+
+	bool LooseOctree::_Fits(const Cell& cell, const BoundingSphere sphere) const
+	{
+		if (cell.parent == InvalidIndex) // Root takes anything
+			return true;
+
+		return
+			sphere.w <= cell.halfSpan &&
+			fabs(sphere.x - cell.center[0]) <= cell.halfSpan &&
+			fabs(sphere.y - cell.center[1]) <= cell.halfSpan &&
+			fabs(sphere.z - cell.center[2]) <= cell.halfSpan;
+	}
+
+
+	/************************************************************************************************/
+
+
+	uint32_t LooseOctree::_ChildFor(const Cell& cell, const BoundingSphere sphere) const
+	{
+		if (cell.depth >= MaxDepth || sphere.w > cell.halfSpan / 2)
+			return InvalidIndex;
+
+		// Only the root can hold entries centered outside of its tight bounds
+		if (fabs(sphere.x - cell.center[0]) > cell.halfSpan ||
+			fabs(sphere.y - cell.center[1]) > cell.halfSpan ||
+			fabs(sphere.z - cell.center[2]) > cell.halfSpan)
+			return InvalidIndex;
+
+		return
+			(sphere.x >= cell.center[0] ? 1 : 0) |
+			(sphere.y >= cell.center[1] ? 2 : 0) |
+			(sphere.z >= cell.center[2] ? 4 : 0);
+	}
+
+
+	/************************************************************************************************/
+
+
+	uint32_t LooseOctree::_FindCell(const BoundingSphere sphere) const
+	{
+		uint32_t cellIdx = 0;
+
+		while (cells[cellIdx].firstChild != InvalidIndex)
+		{
+			const auto child = _ChildFor(cells[cellIdx], sphere);
+
+			if (child == InvalidIndex)
+				break;
+
+			cellIdx = cells[cellIdx].firstChild + child;
+		}
+
+		return cellIdx;
+	}
+
+
+	/************************************************************************************************/
+
+
+	void LooseOctree::_Link(const EntryID entryIdx, const uint32_t cellIdx)
+	{
+		auto& entry = entries[entryIdx];
+		auto& cell	= cells[cellIdx];
+
+		entry.cell	= cellIdx;
+		entry.prev	= InvalidIndex;
+		entry.next	= cell.firstEntry;
+
+		if (cell.firstEntry != InvalidIndex)
+			entries[cell.firstEntry].prev = entryIdx;
+
+		cell.firstEntry = entryIdx;
+		cell.entryCount++;
+
+		for (auto itr = cellIdx; itr != InvalidIndex; itr = cells[itr].parent)
+			cells[itr].subtreeCount++;
+
+		if (cell.firstChild == InvalidIndex && cell.entryCount > CellCapacity && cell.depth < MaxDepth)
+			_Split(cellIdx);
+	}
+
+
+	/************************************************************************************************/
+
+
+	void LooseOctree::_Unlink(const EntryID entryIdx)
+	{
+		auto& entry = entries[entryIdx];
+		auto& cell	= cells[entry.cell];
+
+		if (entry.prev != InvalidIndex)
+			entries[entry.prev].next = entry.next;
+		else
+			cell.firstEntry = entry.next;
+
+		if (entry.next != InvalidIndex)
+			entries[entry.next].prev = entry.prev;
+
+		cell.entryCount--;
+
+		for (auto itr = entry.cell; itr != InvalidIndex; itr = cells[itr].parent)
+			cells[itr].subtreeCount--;
+
+		entry.cell = InvalidIndex;
+		entry.prev = InvalidIndex;
+		entry.next = InvalidIndex;
+	}
+
+
+	/************************************************************************************************/
+
+
+	void LooseOctree::_Split(const uint32_t cellIdx)
+	{
+		uint32_t firstChild;
+
+		if (freeCellBlocks.size())
+			firstChild = freeCellBlocks.pop_back();
+		else
+		{
+			firstChild = (uint32_t)cells.size();
+
+			for (size_t I = 0; I < 8; ++I)
+				cells.push_back(Cell{});
+		}
+
+		auto&		parent		= cells[cellIdx];
+		const float	childSpan	= parent.halfSpan / 2;
+
+		for (uint32_t I = 0; I < 8; ++I)
+		{
+			auto& child = cells[firstChild + I];
+
+			child.center[0]		= parent.center[0] + ((I & 1) ? childSpan : -childSpan);
+			child.center[1]		= parent.center[1] + ((I & 2) ? childSpan : -childSpan);
+			child.center[2]		= parent.center[2] + ((I & 4) ? childSpan : -childSpan);
+			child.halfSpan		= childSpan;
+			child.parent		= cellIdx;
+			child.firstChild	= InvalidIndex;
+			child.firstEntry	= InvalidIndex;
+			child.entryCount	= 0;
+			child.subtreeCount	= 0;
+			child.depth			= parent.depth + 1;
+		}
+
+		parent.firstChild = firstChild;
+
+		// Push down everything small enough, counts above this cell do not change
+		auto entryIdx = parent.firstEntry;
+		while (entryIdx != InvalidIndex)
+		{
+			const auto next		= entries[entryIdx].next;
+			const auto child	= _ChildFor(parent, entries[entryIdx].sphere);
+
+			if (child != InvalidIndex)
+			{
+				auto& entry = entries[entryIdx];
+
+				if (entry.prev != InvalidIndex)
+					entries[entry.prev].next = entry.next;
+				else
+					parent.firstEntry = entry.next;
+
+				if (entry.next != InvalidIndex)
+					entries[entry.next].prev = entry.prev;
+
+				parent.entryCount--;
+
+				auto& childCell = cells[firstChild + child];
+				entry.cell	= firstChild + child;
+				entry.prev	= InvalidIndex;
+				entry.next	= childCell.firstEntry;
+
+				if (childCell.firstEntry != InvalidIndex)
+					entries[childCell.firstEntry].prev = entryIdx;
+
+				childCell.firstEntry = entryIdx;
+				childCell.entryCount++;
+				childCell.subtreeCount++;
+			}
+
+			entryIdx = next;
+		}
+	}
+
+
+	/************************************************************************************************/
+
+
+	void LooseOctree::_CollapseEmpty(uint32_t cellIdx)
+	{
+		// Free child blocks whose whole subtree emptied out, then see if that emptied the parent's children too
+		for (; cellIdx != InvalidIndex; cellIdx = cells[cellIdx].parent)
+		{
+			auto& cell = cells[cellIdx];
+
+			if (cell.subtreeCount != cell.entryCount)
+				return;
+
+			if (cell.firstChild == InvalidIndex)
+				continue;
+
+			Vector<uint32_t> pending{ allocator, 8 };
+			pending.push_back(cell.firstChild);
+			cell.firstChild = InvalidIndex;
+
+			while (pending.size())
+			{
+				const auto block = pending.pop_back();
+
+				for (uint32_t I = 0; I < 8; ++I)
+				{
+					if (cells[block + I].firstChild != InvalidIndex)
+						pending.push_back(cells[block + I].firstChild);
+				}
+
+				freeCellBlocks.push_back(block);
+			}
+		}
+	}
+
+
+}	/************************************************************************************************/
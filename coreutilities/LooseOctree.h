@@ -0,0 +1,305 @@
+/**********************************************************************
+
+Copyright (c) 2015 - 2019 Robert May
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************/
+
+#ifndef LOOSEOCTREE_H
+#define LOOSEOCTREE_H
+
+#include "..\buildsettings.h"
+#include "..\coreutilities\containers.h"
+#include "..\coreutilities\intersection.h"
+#include "..\coreutilities\memoryutilities.h"
+
+namespace FlexKit
+{
+	/************************************************************************************************/
+
+
+	// Loose octree over bounding spheres. A cell's loose bounds are twice its tight bounds, so an entry sits in the
+	// deepest cell that holds its center and is at least as wide as its radius, and small moves rarely change cells.
+	// Cells only split once they hold more than CellCapacity entries. Entries centered outside the root stay in the root.
+	// Not thread safe for writes, any number of threads may query while nobody writes.
+	class FLEXKITAPI LooseOctree
+	{
+	public:
+		static const uint32_t InvalidIndex	= 0xffffffff;
+		static const uint32_t CellCapacity	= 16;
+		static const uint32_t MaxDepth		= 12;
+
+		using EntryID = uint32_t;
+
+
+		LooseOctree(iAllocator* IN_allocator, const float3 IN_center = { 0, 0, 0 }, const float IN_halfSpan = 4096.0f);
+
+		LooseOctree				(const LooseOctree&) = delete;
+		LooseOctree& operator =	(const LooseOctree&) = delete;
+
+
+		// userValue is handed back by queries
+		EntryID	Insert	(const BoundingSphere sphere, const uint32_t userValue);
+		void	Remove	(const EntryID entry);
+
+		// Returns true if the entry changed cells
+		bool	Move	(const EntryID entry, const BoundingSphere sphere);
+
+		void	Clear	();
+
+		BoundingSphere	GetSphere	(const EntryID entry) const { return entries[entry].sphere; }
+		uint32_t		GetValue	(const EntryID entry) const { return entries[entry].userValue; }
+		void			SetValue	(const EntryID entry, const uint32_t userValue) { entries[entry].userValue = userValue; }
+
+		size_t	size		() const { return cells[0].subtreeCount; }
+		size_t	GetCellCount() const { return cells.size() - freeCellBlocks.size() * 8; }
+
+
+		// Calls visitor(userValue, sphere) for every entry whose sphere touches the frustum
+		template<typename TY_FN>
+		void Query(const Frustum& frustum, TY_FN&& visitor) const
+		{
+			_Traverse(
+				[&](const Cell& cell)				{ return _TestCell(frustum, cell); },
+				[&](const BoundingSphere& sphere)	{ return Intersects(frustum, sphere); },
+				visitor);
+		}
+
+
+		// Calls visitor(userValue, sphere) for every entry whose sphere touches the query sphere
+		template<typename TY_FN>
+		void Query(const BoundingSphere& querySphere, TY_FN&& visitor) const
+		{
+			_Traverse(
+				[&](const Cell& cell)				{ return _TestCell(querySphere, cell); },
+				[&](const BoundingSphere& sphere)	{ return Intersects(querySphere, sphere); },
+				visitor);
+		}
+
+
+		// Calls visitor(userValue, sphere) for every entry whose sphere touches the box
+		template<typename TY_FN>
+		void Query(const AABB& aabb, TY_FN&& visitor) const
+		{
+			_Traverse(
+				[&](const Cell& cell)				{ return _TestCell(aabb, cell); },
+				[&](const BoundingSphere& sphere)	{ return Intersects(aabb, sphere); },
+				visitor);
+		}
+
+
+		// Calls visitor(userValue, sphere, distance) for every entry the ray hits within maxDistance, in no particular order
+		template<typename TY_FN>
+		void Query(const Ray& ray, const float maxDistance, TY_FN&& visitor) const
+		{
+			float distance = 0.0f;
+
+			_Traverse(
+				[&](const Cell& cell)
+				{
+					float cellDistance;
+					return Intersects(ray, _GetLooseBounds(cell), cellDistance) && cellDistance <= maxDistance ?
+						CellTestResult::Intersects : CellTestResult::Outside;
+				},
+				[&](const BoundingSphere& sphere)	{ return Intersects(ray, sphere, distance) && distance <= maxDistance; },
+				[&](const uint32_t value, const BoundingSphere& sphere) { visitor(value, sphere, distance); });
+		}
+
+
+		// Calls visitor(values, count, fullyInside) with the userValues of the entries held by each cell the frustum
+		// doesn't reject, at most 64 at a time. fullyInside is set when the cell's loose bounds are inside the
+		// frustum so every entry in it is too, otherwise the entries still need testing. Cells come in Query order.
+		template<typename TY_FN>
+		void QueryCells(const Frustum& frustum, TY_FN&& visitor) const
+		{
+			_TraverseCells(
+				[&](const Cell& cell) { return _TestCell(frustum, cell); },
+				[&](const Cell& cell, const bool fullyInside)
+				{
+					uint32_t	values[64];
+					size_t		count = 0;
+
+					for (auto entryIdx = cell.firstEntry; entryIdx != InvalidIndex; entryIdx = entries[entryIdx].next)
+					{
+						values[count++] = entries[entryIdx].userValue;
+
+						if (count == 64)
+						{
+							visitor(values, count, fullyInside);
+							count = 0;
+						}
+					}
+
+					if (count)
+						visitor(values, count, fullyInside);
+				});
+		}
+
+
+		// Appends the userValue of every entry touching shape to out, returns how many were added
+		template<typename TY_SHAPE>
+		size_t Gather(const TY_SHAPE& shape, Vector<uint32_t>& out) const
+		{
+			const size_t begin = out.size();
+			Query(shape, [&](const uint32_t value, const BoundingSphere&) { out.push_back(value); });
+
+			return out.size() - begin;
+		}
+
+
+		size_t Gather(const Ray& ray, const float maxDistance, Vector<uint32_t>& out) const
+		{
+			const size_t begin = out.size();
+			Query(ray, maxDistance, [&](const uint32_t value, const BoundingSphere&, const float) { out.push_back(value); });
+
+			return out.size() - begin;
+		}
+
+
+	private:
+
+		struct Cell
+		{
+			float		center[3];
+			float		halfSpan;
+
+			uint32_t	parent;
+			uint32_t	firstChild;		// children are allocated as a block of 8
+			uint32_t	firstEntry;
+			uint32_t	entryCount;
+			uint32_t	subtreeCount;
+			uint32_t	depth;
+		};
+
+		struct Entry
+		{
+			BoundingSphere	sphere;
+			uint32_t		userValue;
+			uint32_t		cell;
+			uint32_t		prev;
+			uint32_t		next;
+		};
+
+		enum class CellTestResult
+		{
+			Outside,
+			Intersects,
+			Inside,
+		};
+
+
+		// Cells are tested with their loose bounds, entries can reach out to twice the cell's half span
+		AABB			_GetLooseBounds		(const Cell& cell) const;
+
+		CellTestResult	_TestCell			(const Frustum& frustum,		const Cell& cell) const;
+		CellTestResult	_TestCell			(const BoundingSphere& sphere,	const Cell& cell) const;
+		CellTestResult	_TestCell			(const AABB& aabb,				const Cell& cell) const;
+
+
+		// Stops testing entries once a cell is fully inside
+		template<typename TY_CELLTEST, typename TY_ENTRYTEST, typename TY_FN>
+		void _Traverse(TY_CELLTEST&& cellTest, TY_ENTRYTEST&& entryTest, TY_FN&& visitor) const
+		{
+			_TraverseCells(cellTest,
+				[&](const Cell& cell, const bool fullyInside)
+				{
+					for (auto entryIdx = cell.firstEntry; entryIdx != InvalidIndex; entryIdx = entries[entryIdx].next)
+					{
+						const auto& entry = entries[entryIdx];
+
+						if (fullyInside || entryTest(entry.sphere))
+							visitor(entry.userValue, entry.sphere);
+					}
+				});
+		}
+
+
+		// Depth first walk that calls cellVisitor(cell, fullyInside) on every non empty cell, skipping the subtrees
+		// cellTest rejects and no longer testing below a cell that is fully inside.
+		// The root is always visited since it also holds the entries centered outside of it.
+		template<typename TY_CELLTEST, typename TY_FN>
+		void _TraverseCells(TY_CELLTEST&& cellTest, TY_FN&& cellVisitor) const
+		{
+			uint32_t	stack[MaxDepth * 8 + 1];
+			bool		inside[MaxDepth * 8 + 1];
+			size_t		stackSize = 0;
+
+			stack[stackSize]	= 0;
+			inside[stackSize]	= false;
+			stackSize++;
+
+			while (stackSize)
+			{
+				stackSize--;
+				const auto	cellIdx		= stack[stackSize];
+				const bool	fullyInside	= inside[stackSize];
+				const auto& cell		= cells[cellIdx];
+
+				if (!cell.subtreeCount)
+					continue;
+
+				if (cell.entryCount)
+					cellVisitor(cell, fullyInside);
+
+				if (cell.firstChild == InvalidIndex)
+					continue;
+
+				for (uint32_t I = 0; I < 8; ++I)
+				{
+					const auto	childIdx	= cell.firstChild + I;
+					const auto& child		= cells[childIdx];
+
+					if (!child.subtreeCount)
+						continue;
+
+					auto res = fullyInside ? CellTestResult::Inside : cellTest(child);
+
+					if (res == CellTestResult::Outside)
+						continue;
+
+					stack[stackSize]	= childIdx;
+					inside[stackSize]	= res == CellTestResult::Inside;
+					stackSize++;
+				}
+			}
+		}
+
+
+		bool		_Fits				(const Cell& cell, const BoundingSphere sphere) const;
+		uint32_t	_ChildFor			(const Cell& cell, const BoundingSphere sphere) const;
+		uint32_t	_FindCell			(const BoundingSphere sphere) const;
+
+		void		_Link				(const EntryID entry, const uint32_t cell);
+		void		_Unlink				(const EntryID entry);
+		void		_Split				(const uint32_t cell);
+		void		_CollapseEmpty		(uint32_t cell);
+
+		Vector<Cell>		cells;
+		Vector<Entry>		entries;
+		Vector<uint32_t>	freeEntries;
+		Vector<uint32_t>	freeCellBlocks;
+
+		iAllocator*			allocator;
+	};
+
+
+}	/************************************************************************************************/
+
+#endif
@@ -0,0 +1,145 @@
+/**********************************************************************
+
+Copyright (c) 2015 - 2019 Robert May
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************/
+
+#ifndef PARALLELMERGE_H_INCLUDED
+#define PARALLELMERGE_H_INCLUDED
+
+#include "..\buildsettings.h"
+#include "..\coreutilities\containers.h"
+#include "..\coreutilities\ThreadUtilities.h"
+
+#include <algorithm>
+
+namespace FlexKit
+{
+	/************************************************************************************************/
+
+
+	// Merges blockCount sorted blocks into out on the worker threads, stable across blocks in block order.
+	// getBlock(I) returns block I's Vector. Before the first round every entry gets rebase(entry, offset), offset
+	// being where its block starts in out, then neighbouring blocks are merged straight into out. Each later
+	// round merges neighbouring runs pairwise, ping ponging between out and scratch, until one run is left.
+	// out and scratch hold every entry, temp is only allocated from by the calling thread.
+	template<typename TY, typename FN_GetBlock, typename FN_Rebase, typename FN_Less>
+	void MergeSortedBlocks(ThreadManager& threads, const size_t blockCount, FN_GetBlock getBlock, FN_Rebase rebase, FN_Less less, TY* out, TY* scratch, iAllocator* temp)
+	{
+		Vector<size_t> runs{ temp, blockCount + 1 };
+		runs.push_back(0);
+
+		for (size_t I = 0; I < blockCount; ++I)
+			runs.push_back(runs.back() + getBlock(I).size());
+
+		const size_t count = runs.back();
+
+		TY*		buffers[]	= { out, scratch };
+		size_t	dst			= 0;
+
+		{
+			WorkBarrier barrier{ threads, temp };
+
+			for (size_t I = 0; I < blockCount; I += 2)
+			{
+				auto mergeBlocks = [&, I]
+				{
+					for (size_t J = I; J < I + 2 && J < blockCount; ++J)
+					{
+						for (auto& entry : getBlock(J))
+							rebase(entry, runs[J]);
+					}
+
+					auto& lhs = getBlock(I);
+
+					if (I + 1 < blockCount)
+					{
+						auto& rhs = getBlock(I + 1);
+						std::merge(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), buffers[dst] + runs[I], less);
+					}
+					else
+						std::copy(lhs.begin(), lhs.end(), buffers[dst] + runs[I]);
+				};
+
+				auto& workItem = CreateWorkItem(mergeBlocks, temp);
+
+				barrier.AddWork(workItem);
+				PushToLocalQueue(workItem);
+			}
+
+			barrier.Join();
+		}
+
+		// Every other run boundary survives each round
+		auto DropMergedRuns = [&]
+		{
+			size_t itr = 0;
+			for (size_t I = 0; I < runs.size(); I += 2)
+				runs[itr++] = runs[I];
+
+			if (runs.back() != runs[itr - 1])
+				runs[itr++] = runs.back();
+
+			runs.resize(itr);
+		};
+
+		DropMergedRuns();
+
+		while (runs.size() > 2)
+		{
+			const auto src = dst;
+			dst ^= 1;
+
+			WorkBarrier barrier{ threads, temp };
+
+			for (size_t I = 0; I + 1 < runs.size(); I += 2)
+			{
+				auto mergeRuns = [&, I, src, dst]
+				{
+					const auto begin	= runs[I];
+					const auto middle	= runs[I + 1];
+					const auto end		= I + 2 < runs.size() ? runs[I + 2] : middle;
+
+					std::merge(
+						buffers[src] + begin,	buffers[src] + middle,
+						buffers[src] + middle,	buffers[src] + end,
+						buffers[dst] + begin, less);
+				};
+
+				auto& workItem = CreateWorkItem(mergeRuns, temp);
+
+				barrier.AddWork(workItem);
+				PushToLocalQueue(workItem);
+			}
+
+			barrier.Join();
+
+			DropMergedRuns();
+		}
+
+		if (dst != 0)
+			std::copy(buffers[1], buffers[1] + count, buffers[0]);
+	}
+
+
+}	/************************************************************************************************/
+
+#endif
@@ -0,0 +1,136 @@
+/**********************************************************************
+
+Copyright (c) 2015 - 2019 Robert May
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************/
+
+#ifndef RADIXSORT_H_INCLUDED
+#define RADIXSORT_H_INCLUDED
+
+#include "..\buildsettings.h"
+#include "..\coreutilities\memoryutilities.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include <utility>
+
+namespace FlexKit
+{
+	/************************************************************************************************/
+
+
+	struct RadixSortKey
+	{
+		uint64_t key;
+		uint64_t index;
+	};
+
+
+	// Two key buffers to ping pong between, plus room to gather the items in their new order
+	template<typename TY>
+	constexpr size_t GetRadixSortScratchSize(const size_t count)
+	{
+		return count * (2 * sizeof(RadixSortKey) + sizeof(TY));
+	}
+
+
+	/************************************************************************************************/
+
+
+	// Stable, ascending LSD radix sort on a 64 bit key per item, in 11 bit digits.
+	// Only key/index pairs move between passes, items are moved once at the end. Digits every key
+	// agrees on are skipped, so keys with constant high bits cost fewer passes.
+	// scratch has to hold GetRadixSortScratchSize<TY>(count) bytes, 16 byte aligned.
+	template<typename TY, typename FN_GetKey>
+	void RadixSort(TY* items, const size_t count, FN_GetKey getKey, void* scratch)
+	{
+		static_assert(std::is_trivially_copyable<TY>::value, "Radix sorted items are moved with memcpy!");
+
+		if (count < 2)
+			return;
+
+		constexpr size_t	DigitBits	= 11;
+		constexpr size_t	DigitCount	= (64 + DigitBits - 1) / DigitBits;
+		constexpr size_t	BucketCount	= size_t(1) << DigitBits;
+		constexpr uint64_t	DigitMask	= BucketCount - 1;
+
+		auto* keys		= reinterpret_cast<RadixSortKey*>(scratch);
+		auto* keysOut	= keys + count;
+		auto* itemsOut	= reinterpret_cast<TY*>(keysOut + count);
+
+		// Every digit's histogram comes out of the same read
+		static thread_local uint32_t histograms[DigitCount][BucketCount];
+		memset(histograms, 0, sizeof(histograms));
+
+		for (size_t I = 0; I < count; ++I)
+		{
+			const uint64_t key = getKey(items[I]);
+			keys[I] = { key, I };
+
+			for (size_t digit = 0; digit < DigitCount; ++digit)
+				histograms[digit][(key >> (digit * DigitBits)) & DigitMask]++;
+		}
+
+		for (size_t digit = 0; digit < DigitCount; ++digit)
+		{
+			const size_t	shift		= digit * DigitBits;
+			auto&			histogram	= histograms[digit];
+
+			if (histogram[(keys[0].key >> shift) & DigitMask] == count)
+				continue; // Every key has the same digit, nothing would move
+
+			uint32_t offset = 0;
+			for (auto& bucket : histogram)
+			{
+				const auto bucketSize = bucket;
+				bucket	= offset;
+				offset += bucketSize;
+			}
+
+			for (size_t I = 0; I < count; ++I)
+				keysOut[histogram[(keys[I].key >> shift) & DigitMask]++] = keys[I];
+
+			std::swap(keys, keysOut);
+		}
+
+		for (size_t I = 0; I < count; ++I)
+			memcpy(itemsOut + I, items + keys[I].index, sizeof(TY));
+
+		memcpy(items, itemsOut, sizeof(TY) * count);
+	}
+
+
+	template<typename TY, typename FN_GetKey>
+	void RadixSort(TY* items, const size_t count, FN_GetKey getKey, iAllocator* temp)
+	{
+		if (count < 2)
+			return;
+
+		auto* scratch = temp->_aligned_malloc(GetRadixSortScratchSize<TY>(count));
+		RadixSort(items, count, getKey, scratch);
+		temp->_aligned_free(scratch);
+	}
+
+
+}	/************************************************************************************************/
+
+#endif
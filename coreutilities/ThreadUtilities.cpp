@@ -6,6 +6,7 @@
 #include "ThreadUtilities.h"
 #include <atomic>
 #include <chrono>
+#include <immintrin.h>
 
 using std::mutex;
 
@@ -53,63 +54,57 @@ namespace FlexKit
 			Running.store(false);
 		});
 
-		while (true)
+		auto doWork = [&](iWork* work)
 		{
-			auto doWork = [&](iWork* work)
+			if (work) 
 			{
-				if (work) 
-				{
-					hasJob.store(true, std::memory_order_release);
+				hasJob.store(true, std::memory_order_release);
 
-					work->Run();
-					work->NotifyWatchers();
-					work->Release();
+				work->Run();
+				work->NotifyWatchers();
+				work->Release();
+
+				tasksCompleted++;
 
-					tasksCompleted++;
+				hasJob.store(false, std::memory_order_release);
 
-					hasJob.store(false, std::memory_order_release);
+				return true;
+			}
+			return false;
+		};
 
-					return true;
-				}
-				return false;
-			};
+		// Spin on the queues for a short while before parking, most gaps between tasks are far shorter than a wake up
+		size_t idleSpins = 0;
 
+		while (!Quit)
+		{
+			Manager->IncrementActiveWorkerCount();
+			const bool ranWork = doWork(Manager->FindWork(true));
+			Manager->DecrementActiveWorkerCount();
 
-            for(size_t I = 0; I < 10; I++)
+			if (ranWork)
 			{
-				EXITSCOPE({
-					Manager->DecrementActiveWorkerCount();
-					});
-
-				    Manager->IncrementActiveWorkerCount();
-
-                    if (auto workItem = Manager->FindWork(true); workItem)
-                    {
-                        I = 0;
-                        doWork(workItem);
-                    }
-                    else if(I > 1)
-                    {
-                        const auto beginTimePoint = std::chrono::high_resolution_clock::now();
-
-                        while (true)
-                        {
-                            const auto currentTime    = std::chrono::high_resolution_clock::now();
-                            const auto duration       = currentTime - beginTimePoint;
-
-                            if (duration > 1000ns)
-                                break;
-                        }
-
-                    }
+				idleSpins = 0;
+				continue;
 			}
 
-			Manager->WaitForWork();
+			if (++idleSpins < SpinCount)
+			{
+				for (size_t I = 0; I < 16; ++I)
+					_mm_pause();
 
-			if (Quit)
-				return;
-		}
+				continue;
+			}
+
+			idleSpins = 0;
 
+			if (auto workItem = Manager->WaitForWork(Quit); workItem)
+			{
+				Manager->IncrementActiveWorkerCount();
+				doWork(workItem);
+				Manager->DecrementActiveWorkerCount();
+			}
+		}
 	}
 
 
@@ -154,27 +154,37 @@ namespace FlexKit
     /************************************************************************************************/
 
 
+	// Chase-Lev work stealing deque. Only the owning thread may push_back and pop_back, any thread may Steal.
+	// Memory ordering follows Le, Pop, Cohen & Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory Models".
+	// The ring grows when full, old rings are kept until the queue is destroyed since a thief may still be reading one.
 	template<typename TY_E>
 	class alignas(64) CircularStealingQueue
 	{
 	public:
-        using ElementType = alignedAtomicWrapper<TY_E>;
+		static_assert(std::is_trivially_copyable_v<TY_E>, "Queue elements must be trivially copyable!");
+
+		using ElementType = std::atomic<TY_E>;
 
 		CircularStealingQueue(iAllocator* IN_allocator, const size_t initialReservation = 64) noexcept :
-			queueArraySize	{ initialReservation	},
-			queue			{ nullptr				},
-			frontCounter	{ 0						},
-			backCounter	    { 0						},
             allocator       { IN_allocator          }
 		{
-			if(initialReservation)
-                queue = (ElementType*)allocator->_aligned_malloc(sizeof(ElementType) * initialReservation);
+			size_t capacity = 2;
+			while (capacity < initialReservation)
+				capacity *= 2;
+
+			queue.store(_CreateBuffer(capacity, nullptr), std::memory_order_relaxed);
 		}
 
 		~CircularStealingQueue()
 		{
-            if(queue)
-                allocator->_aligned_free(queue);
+			auto buffer = queue.load(std::memory_order_relaxed);
+
+			while (buffer)
+			{
+				auto retired = buffer->retired;
+				allocator->_aligned_free(buffer);
+				buffer = retired;
+			}
 		}
 
 
@@ -182,32 +192,35 @@ namespace FlexKit
 		CircularStealingQueue& 	operator =	(const CircularStealingQueue&) = delete;
 
 
-        [[nodiscard]] std::optional<TY_E> pop_back() noexcept // FILO
+        [[nodiscard]] std::optional<TY_E> pop_back() noexcept // FILO, owner only
 		{
-            const auto back  = backCounter.fetch_sub(1) - 1;
-            const auto front = frontCounter.load();
+            const int64_t back   = backCounter.load(std::memory_order_relaxed) - 1;
+            auto          buffer = queue.load(std::memory_order_relaxed);
+
+            backCounter.store(back, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            int64_t front = frontCounter.load(std::memory_order_relaxed);
 
             if (front <= back)
             {
-                auto job = *queue[back % 64];
+                auto job = buffer->Get(back);
 
                 if (front != back)
                     return job;
+
+                // last job in queue, potential race with a steal
+                const bool res = frontCounter.compare_exchange_strong(front, front + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                backCounter.store(back + 1, std::memory_order_relaxed);
+
+                if (res)
+                    return job;
                 else
-                {   // last job in queue, potential race with a steal
-                    auto expected   = front;
-                    const auto res  = frontCounter.compare_exchange_strong(expected, expected + 1);
-                    backCounter.store(front + 1);
-
-                    if (res)
-                        return { job };
-                    else
-                        return {};
-                }
+                    return {};
             }
             else
             {
-                backCounter.store(front);
+                backCounter.store(back + 1, std::memory_order_relaxed);
                 return {};
             }
 		}
@@ -215,14 +228,16 @@ namespace FlexKit
 
         [[nodiscard]] std::optional<TY_E> Steal() noexcept // FIFO
 		{
-            auto front = frontCounter.load(std::memory_order_seq_cst);
-            auto back  = backCounter.load(std::memory_order_seq_cst);
+            int64_t front = frontCounter.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const int64_t back = backCounter.load(std::memory_order_acquire);
 
             if (front < back)
             {
-                auto job = *queue[front % queueArraySize];
+                auto buffer = queue.load(std::memory_order_acquire);
+                auto job    = buffer->Get(front);
 
-                if (frontCounter.compare_exchange_strong(front, front + 1))
+                if (frontCounter.compare_exchange_strong(front, front + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
                     return job;
                 else
                     return {};
@@ -232,16 +247,20 @@ namespace FlexKit
 		}
 
 	
-		void push_back(TY_E element) noexcept
+		void push_back(TY_E element) noexcept // owner only
 		{
-            if (queueArraySize < size() + 1)
-                _Expand();
+            const int64_t back   = backCounter.load(std::memory_order_relaxed);
+            const int64_t front  = frontCounter.load(std::memory_order_acquire);
+            auto          buffer = queue.load(std::memory_order_relaxed);
+
+            if (back - front > buffer->mask)
+                buffer = _Expand(buffer, front, back);
 
-            queue[backCounter % queueArraySize] = element;
+            buffer->Put(back, element);
 
             std::atomic_thread_fence(std::memory_order_release);
 
-			backCounter.fetch_add(1); // publish push
+			backCounter.store(back + 1, std::memory_order_relaxed); // publish push
 		}
 
 
@@ -251,62 +270,167 @@ namespace FlexKit
 		}
 
 
-		size_t size() const noexcept
+		size_t size() const noexcept // approximate while other threads are stealing
+		{
+			const int64_t back  = backCounter.load(std::memory_order_relaxed);
+			const int64_t front = frontCounter.load(std::memory_order_relaxed);
+
+			return back > front ? size_t(back - front) : 0;
+		}
+
+
+		size_t capacity() const noexcept
 		{
-			return (size_t)(backCounter - frontCounter);
+			return size_t(queue.load(std::memory_order_relaxed)->mask + 1);
 		}
 
 
 	private:
-		void _Expand() noexcept
+
+		struct Buffer
 		{
-			const auto	arraySize	= queueArraySize * 2;
-            auto		newArray	= (ElementType*)allocator->_aligned_malloc(sizeof(ElementType) * arraySize);
+			int64_t		mask;
+			Buffer*		retired; // previous ring, freed with the queue
 
-			const int64_t   begin	= frontCounter;
-			const int64_t   end	    = backCounter;
-			const auto      count	= size_t(end - begin);
+			ElementType* Elements() noexcept { return reinterpret_cast<ElementType*>(this + 1); }
 
-			FK_ASSERT(queueArraySize >= count);
+			TY_E Get(const int64_t idx) noexcept
+			{
+				return Elements()[idx & mask].load(std::memory_order_relaxed);
+			}
 
-			for (uint64_t idx = 0; idx < count; ++idx)
+			void Put(const int64_t idx, TY_E element) noexcept
 			{
-				const auto oldIdx = (begin + idx) % queueArraySize;
-				const auto newIdx = (begin + idx) % arraySize;
-				newArray[newIdx]  = *queue[oldIdx];
+				Elements()[idx & mask].store(element, std::memory_order_relaxed);
 			}
+		};
+
+
+		Buffer* _CreateBuffer(const size_t capacity, Buffer* retired) noexcept
+		{
+			static_assert(sizeof(Buffer) % alignof(ElementType) == 0);
 
-			auto tmp_ptr    = queue;
-			queue			= newArray;
-			queueArraySize	= arraySize;
+			auto buffer = new(allocator->_aligned_malloc(sizeof(Buffer) + sizeof(ElementType) * capacity)) Buffer;
+			buffer->mask	= int64_t(capacity - 1);
+			buffer->retired	= retired;
 
-            allocator->_aligned_free(tmp_ptr);
+			for (size_t idx = 0; idx < capacity; ++idx)
+				new(buffer->Elements() + idx) ElementType{};
+
+			return buffer;
 		}
 
 
-		void _Contract() noexcept
+		Buffer* _Expand(Buffer* buffer, const int64_t front, const int64_t back) noexcept
 		{
-			const auto newSize	= (size_t)std::pow(2, log2(size()) + 1);
-			const auto newArray	= new TY_E[newSize];
+			auto newBuffer = _CreateBuffer(size_t(buffer->mask + 1) * 2, buffer);
+
+			for (int64_t idx = front; idx < back; ++idx)
+				newBuffer->Put(idx, buffer->Get(idx));
+
+			queue.store(newBuffer, std::memory_order_release);
+
+			return newBuffer;
 		}
 
-		size_t			                    queueArraySize  = 0;
-        ElementType*                        queue           = nullptr;
+
         iAllocator*                         allocator       = nullptr;
+		std::atomic<Buffer*>                queue           = nullptr;
 
 		alignas(64) std::atomic_int64_t     backCounter    = 0;
 		alignas(64) std::atomic_int64_t     frontCounter   = 0;
 	};
 
 
+	// Lets idle threads park without missing a wake up. A waiter calls PrepareWait, checks for work one last time
+	// and then either calls CancelWait or Wait with the returned key. Notify is nearly free when nobody is parked.
+	class EventCount
+	{
+	public:
+		using Key = uint64_t;
+
+		EventCount() = default;
+
+		EventCount				(const EventCount&) = delete;
+		EventCount& operator =	(const EventCount&) = delete;
+
+
+		[[nodiscard]] Key PrepareWait() noexcept
+		{
+			waiters.fetch_add(1, std::memory_order_seq_cst);
+			return epoch.load(std::memory_order_acquire);
+		}
+
+
+		void CancelWait() noexcept
+		{
+			waiters.fetch_sub(1, std::memory_order_seq_cst);
+		}
+
+
+		void Wait(const Key key) noexcept
+		{
+			{
+				std::unique_lock lock{ m };
+				cv.wait(lock, [&] { return epoch.load(std::memory_order_acquire) != key; });
+			}
+
+			waiters.fetch_sub(1, std::memory_order_seq_cst);
+		}
+
+
+		void Notify(const bool all = false) noexcept
+		{
+			// Pairs with the fetch_add in PrepareWait, either we see the waiter or it sees our work
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+
+			if (waiters.load(std::memory_order_relaxed) == 0)
+				return;
+
+			{
+				std::scoped_lock lock{ m };
+				epoch.fetch_add(1, std::memory_order_release);
+			}
+
+			if (all)
+				cv.notify_all();
+			else
+				cv.notify_one();
+		}
+
+
+		void NotifyAll() noexcept
+		{
+			Notify(true);
+		}
+
+
+		uint32_t WaiterCount() const noexcept
+		{
+			return waiters.load(std::memory_order_relaxed);
+		}
+
+	private:
+		alignas(64) std::atomic_uint64_t	epoch	= 0;
+		alignas(64) std::atomic_uint32_t	waiters	= 0;
+
+		std::mutex				m;
+		std::condition_variable	cv;
+	};
+
+
+	/************************************************************************************************/
+
+
     thread_local CircularStealingQueue<iWork*>* localWorkQueue = nullptr;
 
     class _BackgrounWorkQueue
     {
     public:
-        _BackgrounWorkQueue(iAllocator* allocator) :
-            queue               { allocator },
-            workList            { allocator }
+        _BackgrounWorkQueue(iAllocator* allocator, EventCount& IN_workAvailable) :
+            queue               { allocator         },
+            workList            { allocator         },
+            workAvailable       { IN_workAvailable  }
         {
             backgroundThread = std::thread{
                 [&]
@@ -321,7 +445,11 @@ namespace FlexKit
 
         void Shutdown()
         {
-            running = false;
+            {
+                std::scoped_lock localLock{ lock };
+                running = false;
+            }
+
             cv.notify_all();
             backgroundThread.join();
         }
@@ -345,13 +473,14 @@ namespace FlexKit
                     std::scoped_lock localLock{ lock };
                     while (workList.size())
                         queue.push_back(workList.pop_back());
+
+                    workAvailable.NotifyAll();
                 }
                 else
-                {
-                    std::mutex m;
-                    std::unique_lock ul{ m };
+                {   // Waiting on lock, work pushed between the size check and the wait would otherwise sit here until the next push
+                    std::unique_lock ul{ lock };
 
-                    cv.wait(ul);
+                    cv.wait(ul, [&] { return workList.size() || !running; });
                 }
             }
         }
@@ -376,16 +505,14 @@ namespace FlexKit
         std::atomic_bool                running = false;
         std::condition_variable         cv;
         std::thread                     backgroundThread;
+        EventCount&                     workAvailable;
 
         CircularStealingQueue<iWork*>   queue;
     };
 
 
 
-    FLEXKITAPI inline void PushToLocalQueue(iWork& work)
-    {
-        localWorkQueue->push_back(&work);
-    }
+    FLEXKITAPI inline void PushToLocalQueue(iWork& work);
 
 
     class _WorkerThread
@@ -422,6 +549,8 @@ namespace FlexKit
 
 		static ThreadManager*	Manager;
 
+		static constexpr size_t SpinCount = 256; // Failed work searches before a worker parks
+
 	private:
 		void _Run();
 
@@ -504,7 +633,7 @@ namespace FlexKit
 			workerCount			{ ThreadCount       },
 			workQueues          { IN_allocator      },
             mainThreadQueue     { IN_allocator      },
-            backgroundQueue     { IN_allocator      }
+            backgroundQueue     { IN_allocator, workAvailable }
 		{
 			WorkerThread::Manager = this;
             localWorkQueue = &mainThreadQueue;
@@ -546,13 +675,21 @@ namespace FlexKit
 		{
 			for (auto& I : threads)
 				I.Shutdown();
+
+			workAvailable.NotifyAll();
 		}
 
 
 		void AddWork(iWork* newWork, iAllocator* Allocator = SystemAllocator) noexcept
 		{
 			localWorkQueue->push_back(newWork);
-			workerWait.notify_all();
+			NotifyWorkAvailable();
+		}
+
+
+		void NotifyWorkAvailable() noexcept
+		{
+			workAvailable.Notify();
 		}
 
 
@@ -589,7 +726,7 @@ namespace FlexKit
 					I.Shutdown();
 				}
 
-				workerWait.notify_all();
+				workAvailable.NotifyAll();
 			} while (threadRunnings);
 		}
 
@@ -597,23 +734,41 @@ namespace FlexKit
 		void IncrementActiveWorkerCount() noexcept
 		{
 			workingThreadCount++;
-			CV.notify_all();
 		}
 
 
 		void DecrementActiveWorkerCount() noexcept
 		{
 			workingThreadCount--;
-			CV.notify_all();
 		}
 
 
-		void WaitForWork() noexcept
+		// Parks the calling thread until new work is pushed, or returns right away if work showed up
+		// after the caller last looked. Returns the work found on the final check, if any.
+		iWork* WaitForWork(const std::atomic_bool& quit) noexcept
 		{
-            std::mutex m;
-            std::unique_lock l{ m };
+			const auto key = workAvailable.PrepareWait();
 
-            workerWait.wait_for(l, 1ms);
+			if (quit)
+			{
+				workAvailable.CancelWait();
+				return nullptr;
+			}
+
+			if (auto work = FindWork(true); work)
+			{
+				workAvailable.CancelWait();
+				return work;
+			}
+
+			workAvailable.Wait(key);
+			return nullptr;
+		}
+
+
+		uint32_t GetParkedThreadCount() const noexcept
+		{
+			return workAvailable.WaiterCount();
 		}
 
 
@@ -647,10 +802,9 @@ namespace FlexKit
 
 	private:
 		WorkerList	            threads;
+        EventCount              workAvailable;
         _BackgrounWorkQueue     backgroundQueue;
 
-		std::condition_variable		CV;
-		std::condition_variable		workerWait;
 		std::atomic_int				workingThreadCount;
 		std::default_random_engine	randomDevice;
 
@@ -667,6 +821,18 @@ namespace FlexKit
 	/************************************************************************************************/
 
 
+    FLEXKITAPI inline void PushToLocalQueue(iWork& work)
+    {
+        localWorkQueue->push_back(&work);
+
+        if (WorkerThread::Manager)
+            WorkerThread::Manager->NotifyWorkAvailable();
+    }
+
+
+	/************************************************************************************************/
+
+
 	class WorkBarrier
 	{
 	public:
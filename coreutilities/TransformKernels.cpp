@@ -0,0 +1,210 @@
+/**********************************************************************
+
+Copyright (c) 2015 - 2019 Robert May
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************/
+
+#include "TransformKernels.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define TRANSFORMKERNELS_X64
+
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#include <cpuid.h>
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+#endif
+
+
+namespace FlexKit
+{
+	/************************************************************************************************/
+
+
+	void TRSBlockToWorld_Scalar(const TRSBlock& local, const MatrixBlock& parent, MatrixBlock& out) noexcept
+	{
+		for (size_t lane = 0; lane < TransformBlockWidth; ++lane)
+		{
+			const float x = local.R[0][lane];
+			const float y = local.R[1][lane];
+			const float z = local.R[2][lane];
+			const float w = local.R[3][lane];
+
+			const float sx = local.S[0][lane];
+			const float sy = local.S[1][lane];
+			const float sz = local.S[2][lane];
+
+			const float xx = x * x, yy = y * y, zz = z * z;
+			const float xy = x * y, xz = x * z, yz = y * z;
+			const float xw = x * w, yw = y * w, zw = z * w;
+
+			// Local matrix, rotation rows scaled, translation in column 3
+			const float L[3][4] = {
+				{ (1.0f - 2.0f * (yy + zz)) * sx,	2.0f * (xy - zw) * sx,			2.0f * (xz + yw) * sx,			local.T[0][lane] },
+				{ 2.0f * (xy + zw) * sy,			(1.0f - 2.0f * (xx + zz)) * sy,	2.0f * (yz - xw) * sy,			local.T[1][lane] },
+				{ 2.0f * (xz - yw) * sz,			2.0f * (yz + xw) * sz,			(1.0f - 2.0f * (xx + yy)) * sz,	local.T[2][lane] } };
+
+			for (size_t row = 0; row < 4; ++row)
+			{
+				const float P0 = parent.m[row * 4 + 0][lane];
+				const float P1 = parent.m[row * 4 + 1][lane];
+				const float P2 = parent.m[row * 4 + 2][lane];
+				const float P3 = parent.m[row * 4 + 3][lane];
+
+				out.m[row * 4 + 0][lane] = P0 * L[0][0] + P1 * L[1][0] + P2 * L[2][0];
+				out.m[row * 4 + 1][lane] = P0 * L[0][1] + P1 * L[1][1] + P2 * L[2][1];
+				out.m[row * 4 + 2][lane] = P0 * L[0][2] + P1 * L[1][2] + P2 * L[2][2];
+				out.m[row * 4 + 3][lane] = P0 * L[0][3] + P1 * L[1][3] + P2 * L[2][3] + P3;
+			}
+		}
+	}
+
+
+	/************************************************************************************************/
+
+#ifdef TRANSFORMKERNELS_X64
+
+	TARGET_AVX2 void TRSBlockToWorld_AVX2(const TRSBlock& local, const MatrixBlock& parent, MatrixBlock& out) noexcept
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 two = _mm256_set1_ps(2.0f);
+
+		const __m256 x = _mm256_load_ps(local.R[0]);
+		const __m256 y = _mm256_load_ps(local.R[1]);
+		const __m256 z = _mm256_load_ps(local.R[2]);
+		const __m256 w = _mm256_load_ps(local.R[3]);
+
+		const __m256 sx = _mm256_load_ps(local.S[0]);
+		const __m256 sy = _mm256_load_ps(local.S[1]);
+		const __m256 sz = _mm256_load_ps(local.S[2]);
+
+		const __m256 x2 = _mm256_mul_ps(x, two);
+		const __m256 y2 = _mm256_mul_ps(y, two);
+		const __m256 z2 = _mm256_mul_ps(z, two);
+
+		const __m256 xx = _mm256_mul_ps(x, x2), yy = _mm256_mul_ps(y, y2), zz = _mm256_mul_ps(z, z2);
+		const __m256 xy = _mm256_mul_ps(x, y2), xz = _mm256_mul_ps(x, z2), yz = _mm256_mul_ps(y, z2);
+		const __m256 xw = _mm256_mul_ps(w, x2), yw = _mm256_mul_ps(w, y2), zw = _mm256_mul_ps(w, z2);
+
+		const __m256 L[3][4] = {
+			{	_mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), sx),
+				_mm256_mul_ps(_mm256_sub_ps(xy, zw), sx),
+				_mm256_mul_ps(_mm256_add_ps(xz, yw), sx),
+				_mm256_load_ps(local.T[0]) },
+			{	_mm256_mul_ps(_mm256_add_ps(xy, zw), sy),
+				_mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, zz)), sy),
+				_mm256_mul_ps(_mm256_sub_ps(yz, xw), sy),
+				_mm256_load_ps(local.T[1]) },
+			{	_mm256_mul_ps(_mm256_sub_ps(xz, yw), sz),
+				_mm256_mul_ps(_mm256_add_ps(yz, xw), sz),
+				_mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, yy)), sz),
+				_mm256_load_ps(local.T[2]) } };
+
+		for (size_t row = 0; row < 4; ++row)
+		{
+			const __m256 P0 = _mm256_load_ps(parent.m[row * 4 + 0]);
+			const __m256 P1 = _mm256_load_ps(parent.m[row * 4 + 1]);
+			const __m256 P2 = _mm256_load_ps(parent.m[row * 4 + 2]);
+			const __m256 P3 = _mm256_load_ps(parent.m[row * 4 + 3]);
+
+			for (size_t column = 0; column < 3; ++column)
+			{
+				__m256 r = _mm256_mul_ps(P0, L[0][column]);
+				r = _mm256_fmadd_ps(P1, L[1][column], r);
+				r = _mm256_fmadd_ps(P2, L[2][column], r);
+
+				_mm256_store_ps(out.m[row * 4 + column], r);
+			}
+
+			__m256 t = _mm256_fmadd_ps(P0, L[0][3], P3);
+			t = _mm256_fmadd_ps(P1, L[1][3], t);
+			t = _mm256_fmadd_ps(P2, L[2][3], t);
+
+			_mm256_store_ps(out.m[row * 4 + 3], t);
+		}
+	}
+
+
+	/************************************************************************************************/
+
+
+	bool CPUSupportsAVX2() noexcept
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+
+		if (info[0] < 7)
+			return false;
+
+		__cpuid(info, 1);
+		const bool fma		= (info[2] & (1 << 12)) != 0;
+		const bool osxsave	= (info[2] & (1 << 27)) != 0;
+
+		__cpuidex(info, 7, 0);
+		const bool avx2		= (info[1] & (1 << 5)) != 0;
+
+		// Make sure the OS saves the YMM registers
+		const bool ymmState = osxsave && ((_xgetbv(0) & 0x6) == 0x6);
+
+		return fma && avx2 && ymmState;
+#else
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+	}
+
+#else
+
+	void TRSBlockToWorld_AVX2(const TRSBlock& local, const MatrixBlock& parent, MatrixBlock& out) noexcept
+	{
+		TRSBlockToWorld_Scalar(local, parent, out);
+	}
+
+
+	bool CPUSupportsAVX2() noexcept
+	{
+		return false;
+	}
+
+#endif
+
+
+	/************************************************************************************************/
+
+
+	void TRSBlockToWorld(const TRSBlock& local, const MatrixBlock& parent, MatrixBlock& out) noexcept
+	{
+		static const bool AVX2 = CPUSupportsAVX2();
+
+		if (AVX2)
+			TRSBlockToWorld_AVX2(local, parent, out);
+		else
+			TRSBlockToWorld_Scalar(local, parent, out);
+	}
+
+
+}	/************************************************************************************************/
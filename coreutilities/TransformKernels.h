@@ -0,0 +1,72 @@
+/**********************************************************************
+
+Copyright (c) 2015 - 2019 Robert May
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************/
+
+#ifndef TRANSFORMKERNELS_H
+#define TRANSFORMKERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Batched local TRS -> world matrix kernels. Plain float SoA blocks, no DirectXMath dependency.
+
+namespace FlexKit
+{
+	/************************************************************************************************/
+
+
+	constexpr size_t TransformBlockWidth = 8;
+
+
+	// Eight local transforms, one lane per node
+	struct alignas(32) TRSBlock
+	{
+		float T[3][TransformBlockWidth];	// x, y, z
+		float R[4][TransformBlockWidth];	// quaternion x, y, z, w
+		float S[3][TransformBlockWidth];	// x, y, z
+	};
+
+
+	// Eight row major 4x4 matrices, element [row * 4 + column] of every lane is contiguous.
+	// Matrices use the same layout as WT_Entry, translation lives in column 3.
+	struct alignas(32) MatrixBlock
+	{
+		float m[16][TransformBlockWidth];
+	};
+
+
+	/************************************************************************************************/
+
+	// out = parent * (T * S * R) for every lane, matching the per node path in UpdateTransforms
+	void TRSBlockToWorld_Scalar	(const TRSBlock& local, const MatrixBlock& parent, MatrixBlock& out) noexcept;
+	void TRSBlockToWorld_AVX2	(const TRSBlock& local, const MatrixBlock& parent, MatrixBlock& out) noexcept;
+
+	// Picks the AVX2 kernel when the CPU supports it
+	void TRSBlockToWorld		(const TRSBlock& local, const MatrixBlock& parent, MatrixBlock& out) noexcept;
+
+	bool CPUSupportsAVX2() noexcept;
+
+
+}	/************************************************************************************************/
+
+#endif
@@ -24,6 +24,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
 #include "Transforms.h"
+#include "TransformKernels.h"
 #include <iostream>
 
 namespace FlexKit
@@ -31,17 +32,7 @@ namespace FlexKit
 	/************************************************************************************************/
 
 
-	size_t CalculateNodeBufferSize(size_t BufferSize)
-	{
-		size_t PerNodeFootPrint = sizeof(LT_Entry) + sizeof(WT_Entry) + sizeof(Node) + sizeof(uint16_t);
-		return (BufferSize - sizeof(SceneNodes)) / PerNodeFootPrint;
-	}
-
-	
-	/************************************************************************************************/
-
-
-	inline uint16_t	_SNHandleToIndex(NodeHandle Node) 
+	inline uint32_t	_SNHandleToIndex(NodeHandle Node) 
 	{ 
 		return SceneNodeTable.Indexes[Node.INDEX]; 
 	}
@@ -50,7 +41,7 @@ namespace FlexKit
 	/************************************************************************************************/
 
 
-	inline void		_SNSetHandleIndex(NodeHandle Node, uint16_t index)
+	inline void		_SNSetHandleIndex(NodeHandle Node, uint32_t index)
 	{ 
 		SceneNodeTable.Indexes[Node.INDEX] = index; 
 	}
@@ -59,57 +50,63 @@ namespace FlexKit
 	/************************************************************************************************/
 
 
-	void InitiateSceneNodeBuffer(byte* pmem, size_t MemSize)
+	void _AddNodePage()
 	{
-		size_t NodeFootPrint = sizeof(SceneNodes::BOILERPLATE);
-		size_t NodeMax = (MemSize - sizeof(SceneNodes)) / NodeFootPrint  - 0x20;
+		auto page = (SceneNodes::Page*)SceneNodeTable.allocator->_aligned_malloc(sizeof(SceneNodes::Page), 0x40);
 
-		SceneNodeTable.Nodes = (Node*)pmem;
+		for (size_t I = 0; I < SceneNodes::PageSize; ++I)
 		{
-			const size_t aligment = 0x10;
-			auto Memory = pmem + NodeMax;
-			size_t alignoffset = (size_t)Memory % aligment;
-			if(alignoffset)
-				Memory += aligment - alignoffset;	// 16 Byte byte Align
-			SceneNodeTable.LT = (LT_Entry*)(Memory);
-			int c = 0; // Debug Point
+			page->LT[I].R		= DirectX::XMQuaternionIdentity();
+			page->LT[I].S		= DirectX::XMVectorSet(1, 1, 1, 1);
+			page->LT[I].T		= DirectX::XMVectorSet(0, 0, 0, 0);
+			page->WT[I].m4x4	= DirectX::XMMatrixIdentity();
+			page->Nodes[I]		= { InvalidHandle_t, InvalidHandle_t, InvalidHandle_t, false };
+			page->Flags[I]		= SceneNodes::FREE;
 		}
-		{
-			const size_t aligment = 0x40;
-			char* Memory = (char*)SceneNodeTable.LT + NodeMax;
-			size_t alignoffset = (size_t)Memory % aligment; // Cache Align
-			if(alignoffset)
-				Memory += aligment - alignoffset;
-			SceneNodeTable.WT = (WT_Entry*)(Memory);
-			int c = 0; // Debug Point
-		}
-		{
-			SceneNodeTable.Flags = (char*)(SceneNodeTable.WT + NodeMax);
-			for (size_t I = 0; I < NodeMax; ++I)
-				SceneNodeTable.Flags[I] = SceneNodes::FREE;
 
-			int c = 0; // Debug Point
-		}
-		{
-			SceneNodeTable.Indexes = (uint16_t*)(SceneNodeTable.Flags + NodeMax);
-			for (size_t I = 0; I < NodeMax; ++I)
-				SceneNodeTable.Indexes[I] = 0xffff;
+		SceneNodeTable.pages.push_back(page);
+		SceneNodeTable.max += SceneNodes::PageSize;
+	}
 
-			int c = 0; // Debug Point
-		}
 
-		for (size_t I = 0; I < NodeMax; ++I)
-		{
-			SceneNodeTable.LT[I].R = DirectX::XMQuaternionIdentity();
-			SceneNodeTable.LT[I].S = DirectX::XMVectorSet(1, 1, 1, 1);
-			SceneNodeTable.LT[I].T = DirectX::XMVectorSet(0, 0, 0, 0);
-		}
+	/************************************************************************************************/
+
+
+	void InitiateSceneNodeBuffer(iAllocator* allocator, size_t initialNodeCount)
+	{
+		SceneNodeTable.allocator				= allocator;
+		SceneNodeTable.pages.Allocator			= allocator;
+		SceneNodeTable.Indexes.Allocator		= allocator;
+		SceneNodeTable.FreeHandles.Allocator	= allocator;
+		SceneNodeTable.UpdatedNodes.Allocator	= allocator;
 
-		for (size_t I = 0; I < NodeMax; ++I)
-			SceneNodeTable.WT[I].m4x4 = DirectX::XMMatrixIdentity();
+		SceneNodeTable.used			= 0;
+		SceneNodeTable.max			= 0;
+		SceneNodeTable.firstFree	= 0;
 
-		SceneNodeTable.used		= 0;
-		SceneNodeTable.max		= NodeMax;
+		SceneNodeTable.Indexes.reserve(initialNodeCount);
+
+		while (SceneNodeTable.max < initialNodeCount)
+			_AddNodePage();
+	}
+
+
+	/************************************************************************************************/
+
+
+	void ReleaseSceneNodeBuffer()
+	{
+		for (auto page : SceneNodeTable.pages)
+			SceneNodeTable.allocator->_aligned_free(page);
+
+		SceneNodeTable.pages.Release();
+		SceneNodeTable.Indexes.Release();
+		SceneNodeTable.FreeHandles.Release();
+		SceneNodeTable.UpdatedNodes.Release();
+
+		SceneNodeTable.used			= 0;
+		SceneNodeTable.max			= 0;
+		SceneNodeTable.firstFree	= 0;
 	}
 
 
@@ -120,6 +117,9 @@ namespace FlexKit
 	{
 		for (size_t I = 1; I < SceneNodeTable.used; ++I)
 		{
+			if (SceneNodeTable.Flags[I] & SceneNodes::FREE)
+				continue;
+
 			auto ParentIndex = _SNHandleToIndex(SceneNodeTable.Nodes[I].Parent);
 			if(ParentIndex == CurrentNode)
 			{
@@ -147,110 +147,88 @@ namespace FlexKit
 		SceneNodeTable.Flags[RHS]	= Flags_Temp;
 	}
 
-	size_t FindFreeIndex()
+
+	/************************************************************************************************/
+
+
+	void _MoveNodeEntry(size_t from, size_t to)
 	{
-		size_t FreeIndex = -1;
-		for (size_t I = SceneNodeTable.used - 1; I >= 0; ++I)
-		{
-			if (SceneNodeTable.Flags[I] & SceneNodes::FREE) {
-				FreeIndex = I;
-				break;
-			}
-		}
-		return FreeIndex;
+		SceneNodeTable.LT[to]		= SceneNodeTable.LT		[from];
+		SceneNodeTable.WT[to]		= SceneNodeTable.WT		[from];
+		SceneNodeTable.Nodes[to]	= SceneNodeTable.Nodes	[from];
+		SceneNodeTable.Flags[to]	= SceneNodeTable.Flags	[from];
+
+		_SNSetHandleIndex(SceneNodeTable.Nodes[to].TH, (uint32_t)to);
+
+		SceneNodeTable.Flags[from]			= SceneNodes::FREE;
+		SceneNodeTable.Nodes[from].Parent	= InvalidHandle_t;
 	}
 
-	void SortNodes(StackAllocator* Temp)
+
+	/************************************************************************************************/
+
+	// Slides live nodes down into free slots, moving at most maxMoves nodes per call. Nodes keep their
+	// relative order, so parents stay in front of their children. Returns the number of nodes moved.
+	size_t CompactNodes(size_t maxMoves)
 	{
-		#ifdef _DEBUG
-			std::cout << "Node Usage Before\n";
-			for (size_t I = 0; I < SceneNodeTable.used; ++I)
-				if (SceneNodeTable.Flags[I] & SceneNodes::FREE)
-					std::cout << "Node: " << I << " Unused\n";
-				else
-					std::cout << "Node: " << I << " Used\n";
-		#endif
-
-		// Find Order
-		if (SceneNodeTable.used > 1)
+		size_t write = std::max<size_t>(SceneNodeTable.firstFree, 1);// First Node Is Always Root
+
+		while (write < SceneNodeTable.used && !(SceneNodeTable.Flags[write] & SceneNodes::FREE))
+			++write;
+
+		size_t read		= write + 1;
+		size_t moves	= 0;
+
+		for (; moves < maxMoves; ++moves, ++write, ++read)
 		{
-			size_t NewLength = SceneNodeTable.used;
-			Vector<size_t> Out{ *Temp, SceneNodeTable.used - 1 };
+			while (read < SceneNodeTable.used && (SceneNodeTable.Flags[read] & SceneNodes::FREE))
+				++read;
 
-			for (size_t I = 1; I < SceneNodeTable.used; ++I)// First Node Is Always Root
-			{
-				if (SceneNodeTable.Flags[I] & SceneNodes::FREE) {
-					size_t II = I + 1;
-					for (; II < SceneNodeTable.used; ++II)
-						if (!(SceneNodeTable.Flags[II] & SceneNodes::FREE))
-							break;
-					
-					SwapNodeEntryies(I, II);
-					SceneNodeTable.Indexes[I] = (uint16_t)I;
-					SceneNodeTable.Indexes[II]= (uint16_t)II;
-					NewLength--;
-					int x = 0;
-				}
-				if(SceneNodeTable.Nodes[I].Parent == NodeHandle(-1))
-					continue;
-
-				size_t ParentIndex = _SNHandleToIndex(SceneNodeTable.Nodes[I].Parent);
-				if (ParentIndex > I)
-				{					
-					SwapNodeEntryies(ParentIndex, I);
-					SceneNodeTable.Indexes[ParentIndex]	= (uint16_t)I;
-					SceneNodeTable.Indexes[I]			= (uint16_t)ParentIndex;
-				}
-			}
-			SceneNodeTable.used = NewLength + 1;
-#ifdef _DEBUG
-			std::cout << "Node Usage After\n";
-			for (size_t I = 0; I < SceneNodeTable.used; ++I)
-				if (SceneNodeTable.Flags[I] & SceneNodes::FREE)
-					std::cout << "Node: " << I << " Unused\n";
-				else
-					std::cout << "Node: " << I << " Used\n";
-#endif
+			if (read >= SceneNodeTable.used)
+				break;
+
+			_MoveNodeEntry(read, write);
 		}
+
+		SceneNodeTable.firstFree = write;
+
+		while (read < SceneNodeTable.used && (SceneNodeTable.Flags[read] & SceneNodes::FREE))
+			++read;
+
+		if (read >= SceneNodeTable.used) // Everything past write is free
+			SceneNodeTable.used = std::min(write, SceneNodeTable.used);
+
+		return moves;
 	}
 
 
 	/************************************************************************************************/
 
-	// TODO: Search an optional Free List
-	NodeHandle GetNewNode()
+
+	void SortNodes(StackAllocator* Temp)
 	{
-		if (SceneNodeTable.max < SceneNodeTable.used)
-			FK_ASSERT(0);
+		CompactNodes(SceneNodeTable.used);
+	}
 
-		uint16_t HandleIndex	= 0;
-        uint16_t NodeIndex		= 0;
 
-		{
-            uint16_t itr = 0;
-            uint16_t end = (uint16_t)SceneNodeTable.max;
-			for (; itr < end; ++itr)
-			{
-				if (SceneNodeTable.Indexes[itr] == 0xffff)
-					break;
-			}
-			NodeIndex = itr;
+	/************************************************************************************************/
 
-			itr = 0;
-			for (; itr < end; ++itr)
-			{
-				if (SceneNodeTable.Flags[itr] & SceneNodes::FREE) break;
-			}
 
-			HandleIndex = itr;
-		}
+	NodeHandle GetNewNode()
+	{
+		if (SceneNodeTable.used == SceneNodeTable.max)
+			_AddNodePage();
+
+		const uint32_t NodeIndex	= (uint32_t)SceneNodeTable.used++;
+		const uint32_t HandleIndex	= SceneNodeTable.FreeHandles.size() ?
+			SceneNodeTable.FreeHandles.pop_back() :
+			(uint32_t)SceneNodeTable.Indexes.push_back(NodeIndex);
 
-		SceneNodeTable.Flags[NodeIndex] = SceneNodes::DIRTY;
 		auto node = NodeHandle(HandleIndex);
 
-		SceneNodeTable.Indexes[HandleIndex] = NodeIndex;
-		SceneNodeTable.Nodes[node.INDEX].TH	= node;
-		SceneNodeTable.used++;
+		SceneNodeTable.Indexes[HandleIndex]		= NodeIndex;
+		SceneNodeTable.Flags[NodeIndex]			= SceneNodes::DIRTY;
+		SceneNodeTable.Nodes[NodeIndex].TH		= node;
 
 		return node;
 	}
@@ -273,11 +251,34 @@ namespace FlexKit
 	/************************************************************************************************/
 
 
+	// Live children move up to the released node's parent, keeping their local transforms. Children are
+	// always stored after their parent, and the grandparent before both, so table order still holds.
 	void ReleaseNode(NodeHandle handle)
 	{
-		SceneNodeTable.Flags[_SNHandleToIndex(handle)] = SceneNodes::FREE;
-		SceneNodeTable.Nodes[_SNHandleToIndex(handle)].Parent = NodeHandle(-1);
-		_SNSetHandleIndex(handle, -1);
+		const auto index		= _SNHandleToIndex(handle);
+		const auto grandParent	= SceneNodeTable.Nodes[index].Parent;
+
+		for (size_t itr = index + 1; itr < SceneNodeTable.used; ++itr)
+		{
+			if (SceneNodeTable.Flags[itr] & SceneNodes::FREE)
+				continue;
+
+			if (SceneNodeTable.Nodes[itr].Parent == handle)
+			{
+				SceneNodeTable.Nodes[itr].Parent	= grandParent;
+				SceneNodeTable.Flags[itr]		   |= SceneNodes::DIRTY;
+			}
+		}
+
+		SceneNodeTable.Flags[index]			= SceneNodes::FREE;
+		SceneNodeTable.Nodes[index].Parent	= InvalidHandle_t;
+		SceneNodeTable.firstFree			= std::min<size_t>(SceneNodeTable.firstFree, index);
+
+		while (SceneNodeTable.used > 1 && (SceneNodeTable.Flags[SceneNodeTable.used - 1] & SceneNodes::FREE))
+			SceneNodeTable.used--;
+
+		_SNSetHandleIndex(handle, SceneNodes::InvalidIndex);
+		SceneNodeTable.FreeHandles.push_back(handle.INDEX);
 	}
 
 	
@@ -549,85 +550,267 @@ namespace FlexKit
 	/************************************************************************************************/
 
 
-	bool UpdateTransforms()
+	inline void _UpdateNodeWT(const size_t itr) noexcept
 	{
-		using DirectX::XMMatrixIdentity;
 		using DirectX::XMMatrixMultiply;
 		using DirectX::XMMatrixTranspose;
 		using DirectX::XMMatrixTranslationFromVector;
 		using DirectX::XMMatrixScalingFromVector;
 		using DirectX::XMMatrixRotationQuaternion;
 
-		SceneNodeTable.WT[0].SetToIdentity();// Making sure root is Identity 
-#if 0
-		for (size_t itr = 1; itr < Nodes->used; ++itr)// Skip Root
+		const LT_Entry&	TRS	= SceneNodeTable.LT[itr];
+		const bool		sf	= (SceneNodeTable.Flags[itr] & SceneNodes::StateFlags::SCALE) != 0;
+
+		const auto LT =(XMMatrixRotationQuaternion(TRS.R) *
+						XMMatrixScalingFromVector(sf ? TRS.S : float3(1.0f, 1.0f, 1.0f).pfloats)) *
+						XMMatrixTranslationFromVector(TRS.T);
+
+		const auto ParentIndex	= _SNHandleToIndex(SceneNodeTable.Nodes[itr].Parent);
+		const auto PT			= SceneNodeTable.WT[ParentIndex].m4x4;
+
+		SceneNodeTable.WT[itr].m4x4 = XMMatrixTranspose(XMMatrixMultiply(LT, XMMatrixTranspose(PT)));
+	}
+
+
+	/************************************************************************************************/
+
+
+	// Nodes passed in must not depend on each other, which holds for nodes within a single depth layer.
+	// Runs blocks of TransformBlockWidth nodes through the batched kernel, the tail goes through the per node path.
+	inline void _UpdateNodeWTs(const uint32_t* nodes, const size_t count) noexcept
+	{
+		TRSBlock	local;
+		MatrixBlock	parent;
+		MatrixBlock	world;
+
+		const size_t blockedCount = count - (count % TransformBlockWidth);
+
+		for (size_t blockBegin = 0; blockBegin < blockedCount; blockBegin += TransformBlockWidth)
 		{
-			if ( Nodes->Flags[itr]												| SceneNodes::DIRTY || 
-				 Nodes->Flags[_SNHandleToIndex(Nodes, Nodes->Nodes[itr].Parent)]| SceneNodes::DIRTY )
+			for (size_t lane = 0; lane < TransformBlockWidth; ++lane)
 			{
-				Nodes->Flags[itr] = Nodes->Flags[itr] | SceneNodes::DIRTY; // To cause Further children to update
-				bool			  EnableScale = Nodes->Nodes[itr].Scaleflag;
-				FlexKit::WT_Entry Parent;
-				FlexKit::WT_Entry WOut;
-				FlexKit::LT_Entry LIn;
-
-				// Gather
-				GetTransform(Nodes, Nodes->Nodes[itr].Parent, &Parent);
-
-				WOut = Nodes->WT[itr];
-				LIn  = Nodes->LT[itr];
-
-				// Calculate
-				WOut.World.R = DirectX::XMQuaternionMultiply(LIn.R, Parent.World.R);
-				WOut.World.S = DirectX::XMVectorMultiply	(LIn.S, Parent.World.S);
-
-				LIn.T.m128_f32[3] = 0;// Should Always Be Zero
-				//if(EnableScale)	WOut.World.T = DirectX::XMVectorMultiply(Parent.World.S, LIn.T);
-				WOut.World.T = DirectX::XMQuaternionMultiply(DirectX::XMQuaternionConjugate(Parent.World.R), LIn.T);
-				WOut.World.T = DirectX::XMQuaternionMultiply(WOut.World.T, Parent.World.R);
-				WOut.World.T = DirectX::XMVectorAdd			(WOut.World.T, Parent.World.T);
-
-				// Write Results
-				Nodes->WT[itr] = WOut;
+				const uint32_t	idx	= nodes[blockBegin + lane];
+				const LT_Entry&	TRS	= SceneNodeTable.LT[idx];
+				const bool		sf	= (SceneNodeTable.Flags[idx] & SceneNodes::StateFlags::SCALE) != 0;
+
+				const float* T = reinterpret_cast<const float*>(&TRS.T);
+				const float* R = reinterpret_cast<const float*>(&TRS.R);
+				const float* S = reinterpret_cast<const float*>(&TRS.S);
+
+				for (size_t itr = 0; itr < 3; ++itr)
+				{
+					local.T[itr][lane] = T[itr];
+					local.S[itr][lane] = sf ? S[itr] : 1.0f;
+				}
+
+				for (size_t itr = 0; itr < 4; ++itr)
+					local.R[itr][lane] = R[itr];
+
+				const auto		ParentIndex = _SNHandleToIndex(SceneNodeTable.Nodes[idx].Parent);
+				const float*	PT			= reinterpret_cast<const float*>(&SceneNodeTable.WT[ParentIndex].m4x4);
+
+				for (size_t itr = 0; itr < 16; ++itr)
+					parent.m[itr][lane] = PT[itr];
+			}
+
+			TRSBlockToWorld(local, parent, world);
+
+			for (size_t lane = 0; lane < TransformBlockWidth; ++lane)
+			{
+				float* WT = reinterpret_cast<float*>(&SceneNodeTable.WT[nodes[blockBegin + lane]].m4x4);
+
+				for (size_t itr = 0; itr < 16; ++itr)
+					WT[itr] = world.m[itr][lane];
 			}
 		}
-#else
-		for (size_t itr = 1; itr < SceneNodeTable.used; ++itr)
-			if (SceneNodeTable.Flags[itr] | SceneNodes::UPDATED && !(SceneNodeTable.Flags[itr] | SceneNodes::DIRTY))
-				SceneNodeTable.Flags[itr] ^= SceneNodes::CLEAR;
 
-		size_t Unused_Nodes = 0;;
+		for (size_t itr = blockedCount; itr < count; ++itr)
+			_UpdateNodeWT(nodes[itr]);
+	}
+
+
+	/************************************************************************************************/
+
+	// Returns true if the node needs a new world transform this frame, and marks it UPDATED so its
+	// children pick up the change. Parents are always stored at a lower index than their children,
+	// so a forward sweep sees the parent's state for this frame before it reaches the child.
+	inline bool _MarkDirtyNode(const size_t itr) noexcept
+	{
+		auto& flags = SceneNodeTable.Flags[itr];
+
+		const auto ParentIndex = _SNHandleToIndex(SceneNodeTable.Nodes[itr].Parent);
+
+		if ((flags & SceneNodes::DIRTY) || (SceneNodeTable.Flags[ParentIndex] & SceneNodes::UPDATED))
+		{
+			flags = (flags & ~SceneNodes::DIRTY) | SceneNodes::UPDATED;
+			return true;
+		}
+
+		flags &= ~SceneNodes::UPDATED;
+		return false;
+	}
+
+
+	/************************************************************************************************/
+
+
+	bool UpdateTransforms()
+	{
+		SceneNodeTable.WT[0].SetToIdentity();// Making sure root is Identity 
+		SceneNodeTable.Flags[0] &= ~SceneNodes::UPDATED;
+
+		SceneNodeTable.UpdatedNodes.clear();
+		SceneNodeTable.updateCount++;
+
+		size_t Unused_Nodes = 0;
 		for (size_t itr = 1; itr < SceneNodeTable.used; ++itr)
 		{
-			if (!(SceneNodeTable.Flags[itr] & SceneNodes::FREE)  &&
-				 (SceneNodeTable.Flags[itr] | SceneNodes::DIRTY) ||
-				SceneNodeTable.Flags[_SNHandleToIndex(SceneNodeTable.Nodes[itr].Parent)] | SceneNodes::UPDATED)
+			if (SceneNodeTable.Flags[itr] & SceneNodes::FREE)
 			{
-				SceneNodeTable.Flags[itr] ^= SceneNodes::DIRTY;
-				SceneNodeTable.Flags[itr] |= SceneNodes::UPDATED; // Propagates Dirty Status of Panret to Children to update
+				Unused_Nodes++;
+				continue;
+			}
 
-				DirectX::XMMATRIX LT = XMMatrixIdentity();
-				LT_Entry TRS = GetLocal(SceneNodeTable.Nodes[itr].TH);
+			if (_MarkDirtyNode(itr))
+			{
+				_UpdateNodeWT(itr);
+				SceneNodeTable.UpdatedNodes.push_back(SceneNodeTable.Nodes[itr].TH);
+			}
+		}
 
-				bool sf = (SceneNodeTable.Flags[itr] & SceneNodes::StateFlags::SCALE) != 0;
-				LT =(	XMMatrixRotationQuaternion(TRS.R) *
-						XMMatrixScalingFromVector(sf ? TRS.S : float3(1.0f, 1.0f, 1.0f).pfloats)) *
-						XMMatrixTranslationFromVector(TRS.T);
+		return ((float(Unused_Nodes) / float(SceneNodeTable.used)) > 0.25f);
+	}
+
+
+	/************************************************************************************************/
+
+
+	TransformUpdateLayers BuildTransformUpdateLayers(iAllocator* temp)
+	{
+		TransformUpdateLayers out{ temp };
+
+		const size_t used = SceneNodeTable.used;
+
+		SceneNodeTable.Flags[0] &= ~SceneNodes::UPDATED;
 
-				auto ParentIndex = _SNHandleToIndex(SceneNodeTable.Nodes[itr].Parent);
-				auto PT = SceneNodeTable.WT[ParentIndex].m4x4;
-				auto WT = XMMatrixTranspose(XMMatrixMultiply(LT, XMMatrixTranspose(PT)));
+		SceneNodeTable.UpdatedNodes.clear();
+		SceneNodeTable.updateCount++;
 
-				auto temp						= SceneNodeTable.WT[itr].m4x4;
-				SceneNodeTable.WT[itr].m4x4	= WT;
+		if (used < 2)
+			return out;
+
+		Vector<uint16_t>	depths		{ temp, used, uint16_t(0) };
+		Vector<uint32_t>	dirtyNodes	{ temp, used };
+		Vector<uint32_t>	layerCounts	{ temp, 32 };
+
+		for (size_t itr = 1; itr < used; ++itr)
+		{
+			if (SceneNodeTable.Flags[itr] & SceneNodes::FREE)
+			{
+				out.unusedNodes++;
+				continue;
 			}
 
-			Unused_Nodes += (SceneNodeTable.Flags[itr] & SceneNodes::FREE);
+			const auto ParentIndex	= _SNHandleToIndex(SceneNodeTable.Nodes[itr].Parent);
+			const auto depth		= uint16_t(depths[ParentIndex] + 1);
+			depths[itr]				= depth;
+
+			if (!_MarkDirtyNode(itr))
+				continue;
+
+			dirtyNodes.push_back(uint32_t(itr));
+			SceneNodeTable.UpdatedNodes.push_back(SceneNodeTable.Nodes[itr].TH);
+
+			while (layerCounts.size() <= depth)
+				layerCounts.push_back(0);
+
+			layerCounts[depth]++;
 		}
-#endif
 
+		if (!dirtyNodes.size())
+			return out;
+
+		// Counting sort the dirty nodes into depth layers, preserving table order within a layer
+		uint32_t offset = 0;
+		for (auto& count : layerCounts)
+		{
+			const auto layerSize = count;
+			count	 = offset;
+			offset	+= layerSize;
+
+			if (layerSize)
+				out.layerEnds.push_back(offset);
+		}
+
+		out.nodes = Vector<uint32_t>{ temp, dirtyNodes.size(), uint32_t(0) };
+
+		for (const auto node : dirtyNodes)
+			out.nodes[layerCounts[depths[node]]++] = node;
+
+		return out;
+	}
+
+
+	/************************************************************************************************/
+
+
+	const Vector<NodeHandle>& GetUpdatedNodes()
+	{
+		return SceneNodeTable.UpdatedNodes;
+	}
+
+
+	size_t GetTransformUpdateCount()
+	{
+		return SceneNodeTable.updateCount;
+	}
+
+
+	/************************************************************************************************/
+
+
+	bool UpdateTransforms(ThreadManager& threads, iAllocator* temp)
+	{
 		SceneNodeTable.WT[0].SetToIdentity();// Making sure root is Identity 
-		return ((float(Unused_Nodes) / float(SceneNodeTable.used)) > 0.25f);
+
+		const auto layers = BuildTransformUpdateLayers(temp);
+
+		// Each layer only depends on the layers above it, so nodes within a layer are updated in parallel
+		// and the layers are joined in order.
+		size_t begin = 0;
+		for (const size_t end : layers.layerEnds)
+		{
+			const size_t layerSize = end - begin;
+
+			if (layerSize <= TransformUpdateBlockSize)
+				_UpdateNodeWTs(layers.nodes.begin() + begin, layerSize);
+			else
+			{
+				WorkBarrier barrier{ threads, temp };
+
+				for (size_t itr = begin; itr < end; itr += TransformUpdateBlockSize)
+				{
+					const uint32_t*	blockBegin	= layers.nodes.begin() + itr;
+					const size_t	blockSize	= std::min<size_t>(TransformUpdateBlockSize, end - itr);
+
+					auto updateBlock = [blockBegin, blockSize]
+					{
+						_UpdateNodeWTs(blockBegin, blockSize);
+					};
+
+					auto& workItem = CreateWorkItem(updateBlock, temp);
+
+					barrier.AddWork(workItem);
+					PushToLocalQueue(workItem);
+				}
+
+				barrier.Join();
+			}
+
+			begin = end;
+		}
+
+		return ((float(layers.unusedNodes) / float(SceneNodeTable.used)) > 0.25f);
 	}
 
 
@@ -659,18 +842,26 @@ namespace FlexKit
 	auto& QueueTransformUpdateTask(UpdateDispatcher& Dispatcher)
 	{
 		struct TransformUpdateData
-		{};
+		{
+			ThreadManager*	threads;
+			iAllocator*		temp;
+		};
 
 		auto& TransformUpdate = Dispatcher.Add<TransformUpdateData>(
             TransformComponentID,
 			[&](auto& Builder, TransformUpdateData& Data)
 			{
 				Builder.SetDebugString("UpdateTransform");
+
+				Data.threads	= Dispatcher.threads;
+				Data.temp		= Dispatcher.GetFrameArena();
 			},
 			[](auto& Data)
 			{
 				FK_LOG_9("Transform Update");
-				UpdateTransforms();
+
+				if (UpdateTransforms(*Data.threads, Data.temp))
+					CompactNodes(TransformCompactionBudget);
 			});
 
 		return TransformUpdate;
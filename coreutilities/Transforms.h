@@ -34,7 +34,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 namespace FlexKit
 {
-	const	size_t											NodeHandleSize = 16;
+	const	size_t											NodeHandleSize = 32;
 	typedef Handle_t<NodeHandleSize, GetCRCGUID(SCENENODE)>	NodeHandle;
 	typedef Handle_t<16, GetCRCGUID(TextureSet)>			TextureSetHandle;
 	typedef static_vector<NodeHandle, 32>					ChildrenVector;
@@ -92,39 +92,92 @@ namespace FlexKit
 			UPDATED = 0x08
 		};
 
-		size_t used;
-		size_t max;
+		static const size_t		PageShift		= 10;
+		static const size_t		PageSize		= 1 << PageShift; // Nodes per page
+		static const size_t		PageMask		= PageSize - 1;
+		static const uint32_t	InvalidIndex	= 0xffffffff;
 
-		Node*			Nodes;
-		LT_Entry*		LT;
-		WT_Entry*		WT;
-		char*			Flags;
 
-		uint16_t*		Indexes;
-		ChildrenVector* Children;
+		// Each column is contiguous within a page, pages are never moved once allocated so
+		// growing the table never invalidates a NodeHandle or a reference into a page.
+		struct alignas(64) Page
+		{
+			LT_Entry	LT		[PageSize];
+			WT_Entry	WT		[PageSize];
+			Node		Nodes	[PageSize];
+			char		Flags	[PageSize];
+		};
 
 
-		#pragma pack(push, 1)
-		struct BOILERPLATE
+		template<typename TY, TY (Page::*Column)[PageSize]>
+		struct PagedColumn
 		{
-			Node		N;
-			LT_Entry	LT;
-			WT_Entry	WT;
-			uint16_t	I;
-			char		State;
+			PagedColumn(Vector<Page*>& IN_pages) : pages{ IN_pages } {}
+
+			PagedColumn				(const PagedColumn&) = delete;
+			PagedColumn& operator =	(const PagedColumn&) = delete;
+
+			TY&			operator [] (const size_t idx) noexcept			{ return (pages[idx >> PageShift]->*Column)[idx & PageMask]; }
+			const TY&	operator [] (const size_t idx) const noexcept	{ return (pages[idx >> PageShift]->*Column)[idx & PageMask]; }
+
+			Vector<Page*>& pages;
 		};
-		#pragma pack(pop)
+
+
+		SceneNodes() :
+			LT		{ pages },
+			WT		{ pages },
+			Nodes	{ pages },
+			Flags	{ pages } {}
+
+
+		size_t used			= 0; // One past the highest node index in use
+		size_t max			= 0; // Allocated capacity, always a multiple of PageSize
+		size_t firstFree	= 0; // Lowest node index that may be free, compaction starts here
+
+		Vector<Page*>		pages;
+		Vector<uint32_t>	Indexes;		// NodeHandle -> node index
+		Vector<uint32_t>	FreeHandles;
+		Vector<NodeHandle>	UpdatedNodes;	// Nodes given a new world transform by the last transform update
+		size_t				updateCount	= 0;	// Transform updates run so far, UpdatedNodes belongs to the latest
+		iAllocator*			allocator	= nullptr;
+
+		PagedColumn<LT_Entry,	&Page::LT>		LT;
+		PagedColumn<WT_Entry,	&Page::WT>		WT;
+		PagedColumn<Node,		&Page::Nodes>	Nodes;
+		PagedColumn<char,		&Page::Flags>	Flags;
 
 	}SceneNodeTable;
 
 
+	/************************************************************************************************/
+
+
+	constexpr size_t TransformUpdateBlockSize	= 1024; // Nodes per work item when a layer is split across workers
+	constexpr size_t TransformCompactionBudget	= 512;	// Nodes moved per frame once the node table is fragmented
+
+	// Dirty nodes grouped by their depth in the hierarchy, a layer only reads world transforms from the layers before it
+	struct TransformUpdateLayers
+	{
+		TransformUpdateLayers(iAllocator* allocator) :
+			nodes		{ allocator },
+			layerEnds	{ allocator } {}
+
+		Vector<uint32_t>	nodes;		// Node indices, sorted by depth
+		Vector<uint32_t>	layerEnds;	// End offset into nodes of each layer
+		size_t				unusedNodes = 0;
+	};
+
+
 	/************************************************************************************************/
 	// TODO: add no except where applicable
 
-	FLEXKITAPI uint16_t	_SNHandleToIndex	(NodeHandle Node);
-	FLEXKITAPI void		_SNSetHandleIndex	(NodeHandle Node, uint16_t index);
+	FLEXKITAPI uint32_t	_SNHandleToIndex	(NodeHandle Node);
+	FLEXKITAPI void		_SNSetHandleIndex	(NodeHandle Node, uint32_t index);
 
-	FLEXKITAPI void			InitiateSceneNodeBuffer		( byte* pmem, size_t );
+	FLEXKITAPI void			InitiateSceneNodeBuffer		( iAllocator* allocator, size_t initialNodeCount = SceneNodes::PageSize );
+	FLEXKITAPI void			ReleaseSceneNodeBuffer		();
+	FLEXKITAPI size_t		CompactNodes				( size_t maxMoves );
 	FLEXKITAPI void			SortNodes					( StackAllocator* Temp );
 	FLEXKITAPI void			ReleaseNode					( NodeHandle Node );
 
@@ -160,7 +213,13 @@ namespace FlexKit
 
 
 
-	FLEXKITAPI bool		UpdateTransforms();
+	FLEXKITAPI bool						UpdateTransforms			();
+	FLEXKITAPI bool						UpdateTransforms			( ThreadManager& threads, iAllocator* temp );
+	FLEXKITAPI TransformUpdateLayers	BuildTransformUpdateLayers	( iAllocator* temp );
+
+	// Nodes the last transform update gave a new world transform, valid until the next update
+	FLEXKITAPI const Vector<NodeHandle>&	GetUpdatedNodes				();
+	FLEXKITAPI size_t						GetTransformUpdateCount		();
 	FLEXKITAPI auto&	QueueTransformUpdateTask	    ( UpdateDispatcher& Dispatcher );
 
 	FLEXKITAPI inline void Yaw							( NodeHandle Node,	float r );
@@ -231,6 +231,74 @@ namespace FlexKit
     /************************************************************************************************/
 
 
+    ID3D12PipelineState* CreateGBufferInstancedPassPSO(RenderSystem* RS)
+    {
+        auto DrawRectVShader = LoadShader("ForwardInstanced_VS", "ForwardInstanced_VS", "vs_5_0",	"assets\\shaders\\forwardRender.hlsl");
+        auto DrawRectPShader = LoadShader("GBufferFill_PS", "GBufferFill_PS",           "ps_5_0",	"assets\\shaders\\forwardRender.hlsl");
+
+        FINALLY
+         Release(&DrawRectVShader);
+         Release(&DrawRectPShader);
+        FINALLYOVER
+
+        /*
+        typedef struct D3D12_INPUT_ELEMENT_DESC
+        {
+        LPCSTR SemanticName;
+        UINT SemanticIndex;
+        DXGI_FORMAT Format;
+        UINT InputSlot;
+        UINT AlignedByteOffset;
+        D3D12_INPUT_CLASSIFICATION InputSlotClass;
+        UINT InstanceDataStepRate;
+        } 	D3D12_INPUT_ELEMENT_DESC;
+        */
+
+        D3D12_INPUT_ELEMENT_DESC InputElements[] = {
+            { "POSITION",	0, DXGI_FORMAT::DXGI_FORMAT_R32G32B32_FLOAT, 0, 0,	D3D12_INPUT_CLASSIFICATION::D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+            { "NORMAL",		0, DXGI_FORMAT::DXGI_FORMAT_R32G32B32_FLOAT, 1, 0, D3D12_INPUT_CLASSIFICATION::D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+            { "TANGENT",	0, DXGI_FORMAT::DXGI_FORMAT_R32G32B32_FLOAT, 2, 0, D3D12_INPUT_CLASSIFICATION::D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+            { "TEXCOORD",	0, DXGI_FORMAT::DXGI_FORMAT_R32G32_FLOAT,	 3, 0,  D3D12_INPUT_CLASSIFICATION::D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        };
+
+
+        D3D12_RASTERIZER_DESC		Rast_Desc	= CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+        D3D12_DEPTH_STENCIL_DESC	Depth_Desc	= CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+        Depth_Desc.DepthFunc	= D3D12_COMPARISON_FUNC::D3D12_COMPARISON_FUNC_LESS;
+        Depth_Desc.DepthEnable	= true;
+
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC	PSO_Desc = {}; {
+            PSO_Desc.pRootSignature        = RS->Library.RS6CBVs4SRVs;
+            PSO_Desc.VS                    = DrawRectVShader;
+            PSO_Desc.PS                    = DrawRectPShader;
+            PSO_Desc.RasterizerState       = Rast_Desc;
+            PSO_Desc.BlendState            = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+            PSO_Desc.SampleMask            = UINT_MAX;
+            PSO_Desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE::D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+            PSO_Desc.NumRenderTargets      = 4;
+            PSO_Desc.RTVFormats[0]         = DXGI_FORMAT_R8G8B8A8_UNORM; // Albedo
+            PSO_Desc.RTVFormats[1]         = DXGI_FORMAT_R16G16B16A16_FLOAT; // Specular
+            PSO_Desc.RTVFormats[2]         = DXGI_FORMAT_R16G16B16A16_FLOAT; // Normal
+            PSO_Desc.RTVFormats[3]         = DXGI_FORMAT_R16G16B16A16_FLOAT; // Tangent
+            PSO_Desc.SampleDesc.Count      = 1;
+            PSO_Desc.SampleDesc.Quality    = 0;
+            PSO_Desc.DSVFormat             = DXGI_FORMAT_D32_FLOAT;
+            PSO_Desc.InputLayout           = { InputElements, sizeof(InputElements)/sizeof(*InputElements) };
+            PSO_Desc.DepthStencilState     = Depth_Desc;
+            PSO_Desc.BlendState.RenderTarget[0].BlendEnable = false;
+        }
+
+        ID3D12PipelineState* PSO = nullptr;
+        auto HR = RS->pDevice->CreateGraphicsPipelineState(&PSO_Desc, IID_PPV_ARGS(&PSO));
+        FK_ASSERT(SUCCEEDED(HR));
+
+        return PSO;
+    }
+
+
+    /************************************************************************************************/
+
+
     ID3D12PipelineState* CreateGBufferSkinnedPassPSO(RenderSystem* RS)
     {
         auto DrawRectVShader = LoadShader("ForwardSkinned_VS",  "ForwardSkinned_VS",    "vs_5_0",	"assets\\shaders\\forwardRender.hlsl");
@@ -1150,7 +1218,7 @@ namespace FlexKit
 
                 data.passConstantsBuffer    = std::move(reserveCB(localBufferSize * 2));
 
-                data.lightLists			    = builder.ReadWriteUAV(lightLists,			DRS_ShaderResource);
+                data.lightClusters		    = builder.ReadWriteUAV(lightClusters,		DRS_ShaderResource);
                 data.pointLightBuffer	    = builder.ReadWriteUAV(pointLightBuffer,	DRS_ShaderResource);
 
                 data.WH                     = lightMapWH;
@@ -1158,7 +1226,7 @@ namespace FlexKit
             [=](ForwardPlusPass& data, const FrameResources& resources, Context& ctx, iAllocator& allocator)
             {
                 const auto cameraConstants  = ConstantBufferDataSet{ GetCameraConstants(camera), data.passConstantsBuffer };
-                const auto passConstants    = ConstantBufferDataSet{ ForwardDrawConstants{ (float)data.pointLights.size(), t, data.WH }, data.passConstantsBuffer };
+                const auto passConstants    = ConstantBufferDataSet{ ForwardDrawConstants{ (float)data.pointLights.size(), t, data.WH, LightClusterSliceCount }, data.passConstantsBuffer };
 
                 DescriptorHeap descHeap;
                 descHeap.Init(
@@ -1166,7 +1234,7 @@ namespace FlexKit
                     resources.renderSystem.Library.RS6CBVs4SRVs.GetDescHeap(0),
                     &allocator);
 
-                descHeap.SetSRV(ctx, 1, lightLists);
+                descHeap.SetSRV(ctx, 1, lightClusters);
                 descHeap.SetSRV(ctx, 2, pointLightBuffer);
                 descHeap.NullFill(ctx);
 
@@ -1220,84 +1288,186 @@ namespace FlexKit
     /************************************************************************************************/
 
 
+    void WorldRender::ReserveLightBuffers()
+    {
+        // Released buffers are kept alive until the GPU is done with them
+        if (pointLightDemand > pointLightCapacity)
+        {
+            pointLightCapacity = pointLightDemand + pointLightDemand / 2;
+
+            renderSystem.ReleaseUAV(pointLightBuffer);
+            pointLightBuffer = renderSystem.CreateUAVBufferResource(sizeof(GPUPointLight) * pointLightCapacity);
+            renderSystem.SetDebugName(pointLightBuffer, "pointLightBuffer");
+        }
+
+        if (lightIndexDemand > lightIndexCapacity)
+        {
+            lightIndexCapacity = lightIndexDemand + lightIndexDemand / 2;
+
+            renderSystem.ReleaseUAV(lightClusters);
+            lightClusters = renderSystem.CreateUAVBufferResource(GetLightClusterBufferSize(lightMapWH, lightIndexCapacity));
+            renderSystem.SetDebugName(lightClusters, "lightClusters");
+        }
+    }
+
+
+    /************************************************************************************************/
+
+
+    void WorldRender::ResizeLightClusters(const uint2 WH)
+    {
+        if (WH == targetWH)
+            return;
+
+        targetWH            = WH;
+        lightMapWH          = GetLightClusterTiles(WH);
+        lightIndexCapacity  = std::max(lightIndexCapacity, InitialLightIndexCapacity(lightMapWH));
+
+        renderSystem.ReleaseUAV(lightClusters);
+        lightClusters = renderSystem.CreateUAVBufferResource(GetLightClusterBufferSize(lightMapWH, lightIndexCapacity));
+        renderSystem.SetDebugName(lightClusters, "lightClusters");
+
+        renderSystem.ReleaseUAV(tempBuffer);
+        tempBuffer = renderSystem.CreateUAVTextureResource(WH, DeviceFormat::R16G16B16A16_FLOAT);
+        renderSystem.SetDebugName(tempBuffer, "tempBuffer");
+    }
+
+
+    /************************************************************************************************/
+
+
     LightBufferUpdate& WorldRender::UpdateLightBuffers(
         UpdateDispatcher&		        dispatcher,
         FrameGraph&				        graph,
         const CameraHandle	            camera,
         const GraphicScene&	            scene,
         const SceneDescription&         sceneDescription,
+        const ResourceHandle            renderTarget,
         ReserveConstantBufferFunction   reserveCB,
         iAllocator*				        tempMemory, 
         LighBufferDebugDraw*	        drawDebug)
     {
-        graph.Resources.AddUAVResource(lightLists,			0, graph.GetRenderSystem().GetObjectState(lightLists));
+        // Every pass reading the clusters this frame uses the grid set here
+        ResizeLightClusters(renderSystem.GetTextureWH(renderTarget));
+        ReserveLightBuffers();
+
+        graph.Resources.AddUAVResource(lightClusters,		0, graph.GetRenderSystem().GetObjectState(lightClusters));
         graph.Resources.AddUAVResource(pointLightBuffer,	0, graph.GetRenderSystem().GetObjectState(pointLightBuffer));
 
+        // Cull and bin the lights on the workers, the frame graph only uploads the result
+        auto& clusterTask = dispatcher.Add<LightClusterData>(
+            [&](UpdateDispatcher::UpdateBuilder& builder, LightClusterData& data)
+            {
+                builder.AddInput(sceneDescription.lights);
+                builder.AddInput(sceneDescription.cameras);
+
+                data.allocator      = &builder.GetFrameArena();
+                data.clusters       = LightClusterList{ data.allocator };
+                data.pointLights    = Vector<GPUPointLight>{ data.allocator };
+                data.camera         = camera;
+                data.threads        = dispatcher.threads;
+
+                builder.SetDebugString("Light Clustering");
+            },
+            [&lights = sceneDescription.lights, screenWH = targetWH](LightClusterData& data)
+            {
+                FK_LOG_9("Start light clustering\n");
+
+                const auto& pointLightHandles   = lights.GetData().pointLights;
+                auto&       pointLights         = PointLightComponent::GetComponent();
+                auto&       camera              = CameraComponent::GetComponent().GetCamera(data.camera);
+
+                data.grid.position      = GetPositionW(camera.Node);
+                data.grid.orientation   = GetOrientation(camera.Node);
+                data.grid.fovY          = camera.FOV;
+                data.grid.aspectRatio   = camera.AspectRatio;
+                data.grid.nearZ         = camera.Near;
+                data.grid.farZ          = camera.Far;
+                data.grid.screenWH      = screenWH;
+
+                Vector<BoundingSphere> bounds{ data.allocator, pointLightHandles.size() };
+
+                for (const auto light : pointLightHandles)
+                {
+                    const PointLight& pointLight = pointLights[light];
+                    bounds.push_back({ GetPositionW(pointLight.Position), pointLight.R });
+                }
+
+                BuildLightClusters(data.grid, bounds.begin(), bounds.size(), data.clusters, data.threads, data.allocator);
+
+                data.pointLights.reserve(data.clusters.visibleLights.size());
+
+                for (const auto visibleLight : data.clusters.visibleLights)
+                {
+                    const PointLight& pointLight = pointLights[pointLightHandles[visibleLight]];
+
+                    data.pointLights.push_back(
+                        {	{ pointLight.K, pointLight.I },
+                            bounds[visibleLight] });
+                }
+
+                FK_LOG_9("End light clustering\n");
+            });
+
         auto& lightBufferData = graph.AddNode<LightBufferUpdate>(
             LightBufferUpdate{
-                    Vector<GPUPointLight>(tempMemory, 1024),
-                    &sceneDescription.lights.GetData().pointLights,
-                    ReserveUploadBuffer(graph.GetRenderSystem(), 1024 * sizeof(GPUPointLight)),// max point light count of 1024
-                    camera,
-                    reserveCB(2 * KILOBYTE),
+                    &clusterTask.GetData(),
+                    camera
             },
             [&, this](FrameGraphNodeBuilder& builder, LightBufferUpdate& data)
             {
-                auto& renderSystem      = graph.GetRenderSystem();
-                data.lightListObject	= builder.ReadWriteUAV(lightLists,		 DRS_UAV);
+                data.lightClusterObject	= builder.ReadWriteUAV(lightClusters,	 DRS_Write);
                 data.lightBufferObject	= builder.ReadWriteUAV(pointLightBuffer, DRS_Write);
-                data.camera				= camera;
-
 
-                builder.AddDataDependency(sceneDescription.lights);
-                builder.AddDataDependency(sceneDescription.cameras);
+                builder.AddDataDependency(clusterTask);
             },
-            [XY = lightMapWH](LightBufferUpdate& data, FrameResources& resources, Context& ctx, iAllocator& allocator)
+            [this](LightBufferUpdate& data, FrameResources& resources, Context& ctx, iAllocator& allocator)
             {
-                const auto cameraConstants = GetCameraConstants(data.camera);
+                const auto& lightClusterData    = *data.lightClusters;
+                const auto& clusterList         = lightClusterData.clusters;
 
-                struct ConstantsLayout
-                {
-                    float4x4 iproj;
-                    float4x4 view;
-                    uint2    LightMapWidthHeight;
-                    uint32_t lightCount;
-                }constantsValues = {
-                    XMMatrixToFloat4x4(DirectX::XMMatrixInverse(nullptr, Float4x4ToXMMATIRX(cameraConstants.Proj))),
-                    cameraConstants.View,
-                    XY,
-                    (uint32_t)data.pointLightHandles->size()
-                };
+                pointLightDemand = std::max(pointLightDemand, lightClusterData.pointLights.size());
+                lightIndexDemand = std::max(lightIndexDemand, clusterList.lightIndices.size());
 
-                ConstantBufferDataSet constants{ constantsValues, data.constants };
-                PointLightComponent& pointLights = PointLightComponent::GetComponent();
+                const size_t lightCount = std::min(lightClusterData.pointLights.size(),  pointLightCapacity);
+                const size_t indexCount = std::min(clusterList.lightIndices.size(),      lightIndexCapacity);
+                const size_t tableSize  = clusterList.clusters.size() * sizeof(LightCluster);
 
-                for (const auto light : *data.pointLightHandles)
+                if (lightCount)
                 {
-                    PointLight pointLight	= pointLights[light];
-                    float3 position			= GetPositionW(pointLight.Position);
+                    const size_t    uploadSize  = lightCount * sizeof(GPUPointLight);
+                    auto            upload      = ReserveUploadBuffer(resources.renderSystem, uploadSize);
 
-                    data.pointLights.push_back(
-                        {	{ pointLight.K, pointLight.I	},
-                            { position, pointLight.R        } });
+                    MoveBuffer2UploadBuffer(upload, (byte*)lightClusterData.pointLights.begin(), uploadSize);
+                    ctx.CopyBuffer(upload, uploadSize, resources.WriteUAV(data.lightBufferObject, &ctx));
                 }
 
-                const size_t uploadSize = data.pointLights.size() * sizeof(GPUPointLight);
-                MoveBuffer2UploadBuffer(data.lightBuffer, (byte*)data.pointLights.begin(), uploadSize);
-                ctx.CopyBuffer(data.lightBuffer, uploadSize, resources.WriteUAV(data.lightBufferObject, &ctx));
+                const size_t    uploadSize  = tableSize + indexCount * sizeof(uint32_t);
+                auto            upload      = ReserveUploadBuffer(resources.renderSystem, uploadSize);
 
-                DescriptorHeap descHeap;
-                descHeap.Init(ctx, resources.renderSystem.Library.ComputeSignature.GetDescHeap(0), &allocator);
-                descHeap.SetUAV(ctx, 1, resources.GetUAVBufferResource	(data.lightListObject));
-                descHeap.SetSRV(ctx, 2, resources.ReadUAVBuffer			(data.lightBufferObject, DRS_ShaderResource, &ctx));
-                descHeap.SetCBV(ctx, 6, constants.Handle(), constants.Offset(), sizeof(ConstantsLayout));
-                descHeap.NullFill(ctx);
+                memcpy(upload.buffer, clusterList.clusters.begin(), tableSize);
+
+                if (indexCount)
+                    memcpy(upload.buffer + tableSize, clusterList.lightIndices.begin(), indexCount * sizeof(uint32_t));
 
-                ctx.SetPipelineState(resources.GetPipelineState(LIGHTPREPASS));
-                ctx.SetComputeRootSignature(resources.renderSystem.Library.ComputeSignature);
-                ctx.SetComputeDescriptorTable(0, descHeap);
+                if (indexCount < clusterList.lightIndices.size() || lightCount < lightClusterData.pointLights.size())
+                {   // Overflowed, drop whatever didn't fit until the buffers grow
+                    auto* clusters  = reinterpret_cast<LightCluster*>(upload.buffer);
+                    auto* indices   = reinterpret_cast<const uint32_t*>(upload.buffer + tableSize);
+
+                    for (size_t I = 0; I < clusterList.clusters.size(); ++I)
+                    {
+                        const size_t end = clusters[I].offset + clusters[I].count;
+                        if (end > indexCount)
+                            clusters[I].count = clusters[I].offset < indexCount ? uint32_t(indexCount - clusters[I].offset) : 0;
 
-                ctx.Dispatch({ XY[0], XY[1], 1 });
+                        // Indices are ascending within a cluster, lights past lightCount were not uploaded and are all at the end
+                        while (clusters[I].count && indices[clusters[I].offset + clusters[I].count - 1] >= lightCount)
+                            clusters[I].count--;
+                    }
+                }
+
+                ctx.CopyBuffer(upload, uploadSize, resources.WriteUAV(data.lightClusterObject, &ctx));
             });
 
         return lightBufferData;
@@ -1353,8 +1523,19 @@ namespace FlexKit
                     }
                 };
 
+                DrawBatchList batches{ &allocator };
+                BuildDrawBatches(data.pvs, batches);
+
                 const size_t entityBufferSize =
-                    GetConstantsAlignedSize<Drawable::VConstantsLayout>() * data.pvs.size();
+                    GetConstantsAlignedSize<Drawable::VConstantsLayout>() * batches.size();
+
+                // The instanced pass binds a CBV over the whole Poses array, reserve all of it per batch even if only part is pushed
+                const size_t instancedBatchCount = std::count_if(
+                    batches.batches.begin(), batches.batches.end(),
+                    [](auto& batch) { return batch.instanceCount > 1; });
+
+                const size_t instanceBufferSize =
+                    GetConstantsAlignedSize<EntityPoses>() * instancedBatchCount;
 
                 constexpr size_t passBufferSize =
                     GetConstantsAlignedSize<Camera::ConstantBuffer>() +
@@ -1365,6 +1546,7 @@ namespace FlexKit
 
                 auto passConstantBuffer   = data.reserveCB(passBufferSize);
                 auto entityConstantBuffer = data.reserveCB(entityBufferSize);
+                auto instanceBuffer       = data.reserveCB(instanceBufferSize);
                 auto poseBuffer           = data.reserveCB(poseBufferSize);
 
                 const auto cameraConstants  = ConstantBufferDataSet{ GetCameraConstants(camera), passConstantBuffer };
@@ -1415,11 +1597,13 @@ namespace FlexKit
                 TriMesh* prevMesh = nullptr;
 
 
-                // unskinned models
-                for (auto& drawable : data.pvs)
+                // unskinned models, runs of the same mesh and material are drawn instanced
+                bool instancedPSO = false;
+
+                for (auto& batch : batches.batches)
                 {
-                    const auto constants    = drawable.D->GetConstants();
-                    auto* triMesh           = GetMeshResource(drawable.D->MeshHandle);
+                    const auto constants    = batch.drawable->GetConstants();
+                    auto* triMesh           = GetMeshResource(batch.drawable->MeshHandle);
 
                     if (triMesh != prevMesh)
                     {
@@ -1438,7 +1622,30 @@ namespace FlexKit
                     }
 
                     ctx.SetGraphicsConstantBufferView(2, ConstantBufferDataSet(constants, entityConstantBuffer));
-                    ctx.DrawIndexed(triMesh->IndexCount);
+
+                    if (batch.instanceCount == 1)
+                    {
+                        if (instancedPSO)
+                            ctx.SetPipelineState(resources.GetPipelineState(GBUFFERPASS));
+
+                        instancedPSO = false;
+                        ctx.DrawIndexed(triMesh->IndexCount);
+                    }
+                    else
+                    {
+                        if (!instancedPSO)
+                            ctx.SetPipelineState(resources.GetPipelineState(GBUFFERPASS_INSTANCED));
+
+                        instancedPSO = true;
+
+                        const auto instanceOffset = instanceBuffer.Push(
+                            (const char*)(batches.transforms.begin() + batch.firstInstance),
+                            sizeof(float4x4) * batch.instanceCount,
+                            GetConstantsAlignedSize<EntityPoses>());
+
+                        ctx.SetGraphicsConstantBufferView(4, ConstantBufferDataSet(instanceOffset, ConstantBufferHandle(instanceBuffer)));
+                        ctx.DrawIndexedInstanced(triMesh->IndexCount, 0, 0, batch.instanceCount);
+                    }
                 }
 
                 // skinned models
@@ -1511,13 +1718,15 @@ namespace FlexKit
             float4 PR;	// XYZ + radius in W
         };
 
+        ReserveLightBuffers();
+
         frameGraph.Resources.AddUAVResource(pointLightBuffer,	0, frameGraph.GetRenderSystem().GetObjectState(pointLightBuffer));
 
         auto& pass = frameGraph.AddNode<TiledDeferredShade>(
             TiledDeferredShade{
                 gbuffer,
                 gather,
-                ReserveUploadBuffer(frameGraph.GetRenderSystem(), 1024 * sizeof(GPUPointLight)),// max point light count of 1024
+                UploadSegment{},
             },
             [&](FrameGraphNodeBuilder& builder, TiledDeferredShade& data)
             {
@@ -1542,7 +1751,7 @@ namespace FlexKit
                 data.passConstants = reserveCB(6 * KILOBYTE);
                 data.passVertices  = reserveVB(sizeof(float4) * 6);
             },
-            [camera = sceneDescription.camera, renderTarget, diffuseMap, GGXSpecularMap, t]
+            [this, camera = sceneDescription.camera, renderTarget, diffuseMap, GGXSpecularMap, t]
             (TiledDeferredShade& data, FrameResources& resources, Context& ctx, iAllocator& allocator)
             {
                 PointLightComponent& pointLights = PointLightComponent::GetComponent();
@@ -1557,9 +1766,17 @@ namespace FlexKit
                             { position, 2000    } });
                 }
 
-                const size_t uploadSize = data.pointLights.size() * sizeof(GPUPointLight);
-                MoveBuffer2UploadBuffer(data.lightBuffer, (byte*)data.pointLights.begin(), uploadSize);
-                ctx.CopyBuffer(data.lightBuffer, uploadSize, resources.WriteUAV(data.pointLightBufferObject, &ctx));
+                pointLightDemand = std::max(pointLightDemand, data.pointLights.size());
+
+                const size_t lightCount = std::min(data.pointLights.size(), pointLightCapacity);
+                const size_t uploadSize = lightCount * sizeof(GPUPointLight);
+
+                if (uploadSize)
+                {
+                    data.lightBuffer = ReserveUploadBuffer(resources.renderSystem, uploadSize);
+                    MoveBuffer2UploadBuffer(data.lightBuffer, (byte*)data.pointLights.begin(), uploadSize);
+                    ctx.CopyBuffer(data.lightBuffer, uploadSize, resources.WriteUAV(data.pointLightBufferObject, &ctx));
+                }
 
                 auto& renderSystem          = resources.renderSystem;
                 const auto WH               = resources.renderSystem.GetTextureWH(renderTarget);
@@ -1571,7 +1788,7 @@ namespace FlexKit
                     float2  WH;
                     float   time;
                     float   lightCount;
-                }passConstants = { {(float)WH[0], (float)WH[1]}, t, (float)data.pointLights.size() };
+                }passConstants = { {(float)WH[0], (float)WH[1]}, t, (float)lightCount };
 
 
                 struct
@@ -1638,7 +1855,7 @@ namespace FlexKit
             {
                 data.dispatchDims   = { lightMapWH[0], lightMapWH[1], 1 };
                 data.activeCamera   = scene.activeCamera;
-                data.WH             = lightMapWH * 10;
+                data.WH             = targetWH;
                 // Inputs
                 data.albedoObject         = builder.ReadShaderResource(scene.gbuffer.Albedo);
                 data.MRIAObject           = builder.ReadShaderResource(scene.gbuffer.MRIA);
@@ -1646,7 +1863,7 @@ namespace FlexKit
                 data.tangentObject        = builder.ReadShaderResource(scene.gbuffer.Tangent);
                 data.depthBufferObject    = builder.ReadShaderResource(scene.depthTarget);
 
-                data.lightBitBucketObject   = builder.ReadWriteUAV(lightLists,          DRS_ShaderResource);
+                data.lightClusterObject     = builder.ReadWriteUAV(lightClusters,       DRS_ShaderResource);
                 data.lightBuffer            = builder.ReadWriteUAV(pointLightBuffer,    DRS_ShaderResource);
 
                 // Ouputs
@@ -1665,14 +1882,16 @@ namespace FlexKit
 
                 struct LocalPassConstants
                 {
-                    uint32_t    lightCount;
                     uint2       WH;
+                    uint2       clusterXY;
+                    uint32_t    sliceCount;
                 };
 
                 ConstantBufferDataSet localConstants{
                     LocalPassConstants{
-                        (uint32_t)data.pointLights.GetData().pointLights.size(),
-                        data.WH
+                        data.WH,
+                        uint2{ data.dispatchDims[0], data.dispatchDims[1] },
+                        LightClusterSliceCount
                     },
                     pushBuffer
                 };
@@ -1685,7 +1904,7 @@ namespace FlexKit
                 srvHeap.SetSRV(ctx, 2, resources.GetTexture(data.normalObject));
                 srvHeap.SetSRV(ctx, 3, resources.GetTexture(data.tangentObject));
                 srvHeap.SetSRV(ctx, 4, resources.GetTexture(data.depthBufferObject), DeviceFormat::R32_FLOAT);
-                srvHeap.SetSRV(ctx, 5, lightLists);
+                srvHeap.SetSRV(ctx, 5, lightClusters);
                 srvHeap.SetSRV(ctx, 6, pointLightBuffer);
 
                 DescriptorHeap uavHeap;
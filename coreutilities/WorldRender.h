@@ -37,8 +37,10 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../graphicsutilities/FrameGraph.h"
 #include "../graphicsutilities/graphics.h"
 #include "../graphicsutilities/CoreSceneObjects.h"
+#include "../graphicsutilities/DrawBatching.h"
 #include "../graphicsutilities/AnimationComponents.h"
 #include "../coreutilities/GraphicScene.h"
+#include "../coreutilities/LightClustering.h"
 
 #include <d3dx12.h>
 
@@ -78,6 +80,7 @@ namespace FlexKit
 	static const PSOHandle FORWARDDRAW				   = PSOHandle(GetTypeGUID(FORWARDDRAW));
 	static const PSOHandle GBUFFERPASS                 = PSOHandle(GetTypeGUID(GBUFFERPASS));
 	static const PSOHandle GBUFFERPASS_SKINNED         = PSOHandle(GetTypeGUID(GBUFFERPASS_SKINNED));
+	static const PSOHandle GBUFFERPASS_INSTANCED       = PSOHandle(GetTypeGUID(GBUFFERPASS_INSTANCED));
 	static const PSOHandle SHADINGPASS                 = PSOHandle(GetTypeGUID(SHADINGPASS));
 	static const PSOHandle COMPUTETILEDSHADINGPASS     = PSOHandle(GetTypeGUID(COMPUTETILEDSHADINGPASS));
 	static const PSOHandle ENVIRONMENTPASS             = PSOHandle(GetTypeGUID(ENVIRONMENTPASS));
@@ -108,6 +111,7 @@ namespace FlexKit
 	ID3D12PipelineState* CreateLightPassPSO				    (RenderSystem* RS);
     ID3D12PipelineState* CreateGBufferPassPSO               (RenderSystem* RS);
     ID3D12PipelineState* CreateGBufferSkinnedPassPSO        (RenderSystem* RS);
+    ID3D12PipelineState* CreateGBufferInstancedPassPSO      (RenderSystem* RS);
     ID3D12PipelineState* CreateDeferredShadingPassPSO       (RenderSystem* RS);
     ID3D12PipelineState* CreateComputeTiledDeferredPSO      (RenderSystem* RS);
 
@@ -186,18 +190,26 @@ namespace FlexKit
 	};
 
 
-	struct LightBufferUpdate 
+	struct LightClusterData
 	{
-		Vector<GPUPointLight>		    pointLights;
-		const Vector<PointLightHandle>*	pointLightHandles;
-        UploadSegment			        lightBuffer;	// immediate update
+		LightClusterGrid		grid;
+		LightClusterList		clusters;
+		Vector<GPUPointLight>	pointLights;	// only the visible lights, in the order the cluster lists refer to them
 
 		CameraHandle			camera;
+		ThreadManager*			threads;
+		iAllocator*				allocator;
+	};
+
+	using LightClusterTask = UpdateTaskTyped<LightClusterData>;
 
-		CBPushBuffer			constants;
-		ResourceHandle			lightListBuffer;
 
-		FrameResourceHandle		lightListObject;
+	struct LightBufferUpdate 
+	{
+		const LightClusterData*	lightClusters;
+		CameraHandle			camera;
+
+		FrameResourceHandle		lightClusterObject;
 		FrameResourceHandle		lightBufferObject;
 	};
 
@@ -228,9 +240,10 @@ namespace FlexKit
 
     struct ForwardDrawConstants
     {
-        float LightCount;
-        float t;
-        uint2 WH;
+        float       LightCount;
+        float       t;
+        uint2       WH;         // light cluster tiles
+        uint32_t    sliceCount;
     };
 
     struct ForwardPlusPass
@@ -248,7 +261,7 @@ namespace FlexKit
         FrameResourceHandle			DepthBuffer;
         FrameResourceHandle			OcclusionBuffer;
         FrameResourceHandle			lightMap;
-        FrameResourceHandle			lightLists;
+        FrameResourceHandle			lightClusters;
         FrameResourceHandle			pointLightBuffer;
         VertexBufferHandle			VertexBuffer;
 
@@ -467,7 +480,7 @@ namespace FlexKit
         FrameResourceHandle tangentObject;
         FrameResourceHandle depthBufferObject;
 
-        FrameResourceHandle lightBitBucketObject;
+        FrameResourceHandle lightClusterObject;
         FrameResourceHandle lightBuffer;
 
         FrameResourceHandle renderTargetObject;
@@ -485,11 +498,14 @@ namespace FlexKit
 		WorldRender(iAllocator* Memory, RenderSystem& RS_IN, TextureStreamingEngine& IN_streamingEngine, const uint2 WH) :
 			renderSystem                { RS_IN                                                                                     },
 			OcclusionCulling	        { false																                        },
-			lightLists			        { renderSystem.CreateUAVBufferResource(sizeof(uint32_t) * (WH / 10).Product() * 32)         },
-			pointLightBuffer	        { renderSystem.CreateUAVBufferResource(sizeof(GPUPointLight) * 1024)                        },
+			lightClusters		        { renderSystem.CreateUAVBufferResource(GetLightClusterBufferSize(GetLightClusterTiles(WH), InitialLightIndexCapacity(GetLightClusterTiles(WH)))) },
+			pointLightBuffer	        { renderSystem.CreateUAVBufferResource(sizeof(GPUPointLight) * InitialPointLightCapacity)  },
+			pointLightCapacity	        { InitialPointLightCapacity                                                                 },
+			lightIndexCapacity	        { InitialLightIndexCapacity(GetLightClusterTiles(WH))                                       },
             tempBuffer                  { renderSystem.CreateUAVTextureResource(WH, DeviceFormat::R16G16B16A16_FLOAT)               },
 			streamingEngine		        { IN_streamingEngine											                            },
-			lightMapWH			        { WH / 10                                                                                   }
+			lightMapWH			        { GetLightClusterTiles(WH)                                                                  },
+			targetWH			        { WH                                                                                        }
 		{
 			RS_IN.RegisterPSOLoader(FORWARDDRAW,			    { &RS_IN.Library.RS6CBVs4SRVs,		CreateForwardDrawPSO,		   });
 			RS_IN.RegisterPSOLoader(FORWARDDRAWINSTANCED,	    { &RS_IN.Library.RS6CBVs4SRVs,		CreateForwardDrawInstancedPSO });
@@ -499,6 +515,7 @@ namespace FlexKit
 
 			RS_IN.RegisterPSOLoader(GBUFFERPASS,			    { &RS_IN.Library.RS6CBVs4SRVs,      CreateGBufferPassPSO          });
 			RS_IN.RegisterPSOLoader(GBUFFERPASS_SKINNED,	    { &RS_IN.Library.RS6CBVs4SRVs,      CreateGBufferSkinnedPassPSO   });
+			RS_IN.RegisterPSOLoader(GBUFFERPASS_INSTANCED,	    { &RS_IN.Library.RS6CBVs4SRVs,      CreateGBufferInstancedPassPSO });
 
 			RS_IN.RegisterPSOLoader(SHADINGPASS,			    { &RS_IN.Library.RS6CBVs4SRVs,      CreateDeferredShadingPassPSO  });
             RS_IN.RegisterPSOLoader(ENVIRONMENTPASS,            { &RS_IN.Library.RS6CBVs4SRVs,      CreateEnvironmentPassPSO      });
@@ -511,6 +528,7 @@ namespace FlexKit
 
             RS_IN.QueuePSOLoad(GBUFFERPASS);
             RS_IN.QueuePSOLoad(GBUFFERPASS_SKINNED);
+            RS_IN.QueuePSOLoad(GBUFFERPASS_INSTANCED);
             RS_IN.QueuePSOLoad(DEPTHPREPASS);
             RS_IN.QueuePSOLoad(LIGHTPREPASS);
             RS_IN.QueuePSOLoad(FORWARDDRAW);
@@ -522,7 +540,7 @@ namespace FlexKit
             RS_IN.QueuePSOLoad(TEXTUREFEEDBACK);
 
             RS_IN.SetDebugName(tempBuffer,        "tempBuffer");
-            RS_IN.SetDebugName(lightLists,        "lightLists");
+            RS_IN.SetDebugName(lightClusters,     "lightClusters");
             RS_IN.SetDebugName(pointLightBuffer,  "pointLightBuffer");
 		}
 
@@ -541,7 +559,7 @@ namespace FlexKit
 
         void Release()
         {
-            renderSystem.ReleaseUAV(lightLists);
+            renderSystem.ReleaseUAV(lightClusters);
             renderSystem.ReleaseUAV(pointLightBuffer);
         }
 
@@ -586,6 +604,7 @@ namespace FlexKit
                 const CameraHandle              camera,
                 const GraphicScene&             scene,
                 const SceneDescription&         desc,
+                const ResourceHandle            renderTarget,
                 ReserveConstantBufferFunction   reserveCB,
                 iAllocator*                     tempMemory,
                 LighBufferDebugDraw*            drawDebug = nullptr);
@@ -657,13 +676,43 @@ namespace FlexKit
             const ComputeTiledDeferredShadeDesc&    scene);
 
 	private:
+        static constexpr size_t InitialPointLightCapacity = 1024;
+
+        static uint2 GetLightClusterTiles(const uint2 WH)
+        {
+            return { (WH[0] + LightClusterTileSize - 1) / LightClusterTileSize, (WH[1] + LightClusterTileSize - 1) / LightClusterTileSize };
+        }
+
+        static size_t InitialLightIndexCapacity(const uint2 tiles)
+        {
+            return tiles.Product() * LightClusterSliceCount * 4;
+        }
+
+        // Cluster table first, one offset/count pair per cluster, then the light index lists
+        static size_t GetLightClusterBufferSize(const uint2 tiles, const size_t indexCapacity)
+        {
+            return tiles.Product() * LightClusterSliceCount * sizeof(LightCluster) + indexCapacity * sizeof(uint32_t);
+        }
+
+        // Grows the light buffers to fit the most lights seen so far, a frame that overflows them is clamped
+        void ReserveLightBuffers();
+
+        // Rebuilds the cluster grid, the cluster buffer and tempBuffer when the render target changes size
+        void ResizeLightClusters(const uint2 WH);
+
 		RenderSystem&			renderSystem;
 
-        UAVResourceHandle		lightLists;			// GPU
+        UAVResourceHandle		lightClusters;		// GPU
         UAVResourceHandle		pointLightBuffer;	// GPU
         UAVTextureHandle		tempBuffer;	        // GPU
 
-		uint2					lightMapWH;			// Output Size
+        size_t                  pointLightCapacity;
+        size_t                  lightIndexCapacity;
+        size_t                  pointLightDemand    = 0; // largest counts seen, written while a frame graph runs and
+        size_t                  lightIndexDemand    = 0; // read when the next one is built
+
+		uint2					lightMapWH;			// light cluster tiles covering targetWH
+		uint2					targetWH;			// Output Size
 
 		TextureStreamingEngine&	streamingEngine;
 		bool                    OcclusionCulling;
@@ -235,6 +235,134 @@ namespace FlexKit
 	/************************************************************************************************/
 
 
+	// Same test as CompareBSAgainstFrustum, conservative for spheres near the frustum corners
+	inline bool Intersects(const Frustum& frustum, const BoundingSphere sphere)
+	{
+		for (const auto& plane : frustum.Planes)
+		{
+			const float d =
+				plane.Normal.x * (sphere.x - plane.Orgin.x) +
+				plane.Normal.y * (sphere.y - plane.Orgin.y) +
+				plane.Normal.z * (sphere.z - plane.Orgin.z);
+
+			if (d - sphere.w > 0.0f)
+				return false;
+		}
+
+		return true;
+	}
+
+
+	/************************************************************************************************/
+
+
+	inline bool Intersects(const BoundingSphere a, const BoundingSphere b)
+	{
+		const float dx = a.x - b.x;
+		const float dy = a.y - b.y;
+		const float dz = a.z - b.z;
+		const float r  = a.w + b.w;
+
+		return dx * dx + dy * dy + dz * dz <= r * r;
+	}
+
+
+	inline bool Intersects(const AABB& aabb, const BoundingSphere sphere)
+	{
+		float distanceSquared = 0.0f;
+
+		for (size_t I = 0; I < 3; ++I)
+		{
+			const float v = sphere[I];
+
+			if (v < aabb.min[I])
+				distanceSquared += (aabb.min[I] - v) * (aabb.min[I] - v);
+			else if (v > aabb.max[I])
+				distanceSquared += (v - aabb.max[I]) * (v - aabb.max[I]);
+		}
+
+		return distanceSquared <= sphere.w * sphere.w;
+	}
+
+
+	inline bool Intersects(const AABB& lhs, const AABB& rhs)
+	{
+		return
+			lhs.min.x <= rhs.max.x && lhs.max.x >= rhs.min.x &&
+			lhs.min.y <= rhs.max.y && lhs.max.y >= rhs.min.y &&
+			lhs.min.z <= rhs.max.z && lhs.max.z >= rhs.min.z;
+	}
+
+
+	// Distance along the ray to the first hit, 0 when the origin starts inside. Ray direction is expected to be normalized.
+	inline bool Intersects(const Ray& ray, const BoundingSphere sphere, float& distance)
+	{
+		const float3	offset	= ray.O - sphere.xyz();
+		const float		b		= offset.dot(ray.D);
+		const float		c		= offset.dot(offset) - sphere.w * sphere.w;
+
+		if (c <= 0.0f)
+		{
+			distance = 0.0f;
+			return true;
+		}
+
+		if (b > 0.0f)
+			return false;
+
+		const float discriminant = b * b - c;
+
+		if (discriminant < 0.0f)
+			return false;
+
+		distance = -b - sqrt(discriminant);
+
+		return true;
+	}
+
+
+	// Slab test, distance is where the ray enters the box, 0 when the origin starts inside
+	inline bool Intersects(const Ray& ray, const AABB& aabb, float& distance)
+	{
+		float tMin = 0.0f;
+		float tMax = std::numeric_limits<float>::max();
+
+		for (size_t I = 0; I < 3; ++I)
+		{
+			const float d = ray.D[I];
+			const float o = ray.O[I];
+
+			if (fabs(d) < 1.0e-8f)
+			{
+				if (o < aabb.min[I] || o > aabb.max[I])
+					return false;
+
+				continue;
+			}
+
+			const float	inverse = 1.0f / d;
+			float		t0		= (aabb.min[I] - o) * inverse;
+			float		t1		= (aabb.max[I] - o) * inverse;
+
+			if (t0 > t1)
+				std::swap(t0, t1);
+
+			tMin = t0 > tMin ? t0 : tMin;
+			tMax = t1 < tMax ? t1 : tMax;
+
+			if (tMin > tMax)
+				return false;
+		}
+
+		distance = tMin;
+
+		return true;
+	}
+
+
+	/************************************************************************************************/
+
+
 	FLEXKITAPI inline float3 DirectionVector(float3 A, float3 B) {return float3{ B - A }.normal();}
 
 
@@ -25,6 +25,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "memoryutilities.h"
 #include <fstream>
 #include <iostream>
+#include <thread>
 
 namespace FlexKit
 {
@@ -47,6 +48,10 @@ namespace FlexKit
 
 	void* StackAllocator::malloc(size_t s)
 	{
+#if USING(ALLOCATIONTELEMETRY)
+		TrackTransient(s, "StackAllocator");
+#endif
+
 		void* memory = nullptr;
 		if (used + s < size)
 		{
@@ -87,6 +92,251 @@ namespace FlexKit
 	}
 
 
+	/************************************************************************************************/
+
+
+	FrameArena::FrameArena(iAllocator* IN_allocator, const size_t IN_frameSize) :
+		allocator	{ IN_allocator	},
+		frameSize	{ IN_frameSize	}
+	{
+		for (auto& frame : frames)
+			frame.buffer = (byte*)allocator->_aligned_malloc(frameSize, 64);
+	}
+
+
+	/************************************************************************************************/
+
+
+	FrameArena::~FrameArena()
+	{
+		for (size_t I = 0; I < FrameCount; ++I)
+		{
+			NextFrame();
+			allocator->_aligned_free(frames[currentFrame].buffer);
+		}
+	}
+
+
+	/************************************************************************************************/
+
+
+	void* FrameArena::malloc(size_t size)
+	{
+		return _aligned_malloc(size, 0x10);
+	}
+
+
+	/************************************************************************************************/
+
+
+	void* FrameArena::_aligned_malloc(size_t size, size_t alignment)
+	{
+#if USING(ALLOCATIONTELEMETRY)
+		TrackTransient(size, "FrameArena");
+#endif
+
+		auto& frame			= frames[currentFrame];
+		const size_t base	= (size_t)frame.buffer;
+
+		size_t offset = frame.used.load(std::memory_order_relaxed);
+		size_t begin;
+
+		do
+		{
+			begin = ((base + offset + alignment - 1) & ~(alignment - 1)) - base;
+
+			if (begin + size > frameSize)
+				return _Overflow(frame, size, alignment);
+
+		} while (!frame.used.compare_exchange_weak(offset, begin + size, std::memory_order_relaxed));
+
+		return frame.buffer + begin;
+	}
+
+
+	/************************************************************************************************/
+
+
+	void* FrameArena::_Overflow(Frame& frame, const size_t size, const size_t alignment)
+	{
+		const size_t headerSize	= (sizeof(OverflowBlock) + alignment - 1) & ~(alignment - 1);
+		auto block				= (OverflowBlock*)allocator->_aligned_malloc(headerSize + size, alignment < 0x10 ? 0x10 : alignment);
+
+		if (!block)
+			return nullptr;
+
+		block->next = frame.overflow.load(std::memory_order_relaxed);
+		while (!frame.overflow.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed));
+
+		frame.overflowUsed.fetch_add(headerSize + size, std::memory_order_relaxed);
+		overflowCount.fetch_add(1, std::memory_order_relaxed);
+
+		return (byte*)block + headerSize;
+	}
+
+
+	/************************************************************************************************/
+
+
+	void FrameArena::NextFrame()
+	{
+		highWaterMark	= GetHighWaterMark();
+		currentFrame	= (currentFrame + 1) % FrameCount;
+
+		auto& frame = frames[currentFrame];
+
+		for (auto block = frame.overflow.exchange(nullptr, std::memory_order_acquire); block;)
+		{
+			auto next = block->next;
+			allocator->_aligned_free(block);
+			block = next;
+		}
+
+		frame.used			= 0;
+		frame.overflowUsed	= 0;
+	}
+
+
+	/************************************************************************************************/
+
+
+	size_t FrameArena::GetUsed() const noexcept
+	{
+		const auto& frame = frames[currentFrame];
+		return frame.used.load(std::memory_order_relaxed) + frame.overflowUsed.load(std::memory_order_relaxed);
+	}
+
+
+	/************************************************************************************************/
+
+
+	size_t FrameArena::GetHighWaterMark() const noexcept
+	{
+		const auto used = GetUsed();
+		return used > highWaterMark ? used : highWaterMark;
+	}
+
+
+	/************************************************************************************************/
+
+
+	static_assert(MaxThreadCaches <= 64, "Thread cache indices are claimed from a single 64 bit mask");
+
+	static std::atomic<uint64_t> claimedThreadCaches = 0;
+
+	// Plain statics so they outlive every thread and static BlockAllocator
+	static const size_t		MaxThreadCacheOwners = 16;
+	static BlockAllocator*	threadCacheOwners[MaxThreadCacheOwners];
+	static std::atomic_flag	threadCacheOwnersLock = ATOMIC_FLAG_INIT;
+
+	static const uint8_t			UnclaimedThreadCache	= 0xfe;
+	thread_local static uint8_t		threadCacheIndex		= UnclaimedThreadCache;
+
+
+	template<typename TY_FN>
+	static void WithThreadCacheOwners(TY_FN&& fn) noexcept
+	{
+		while (threadCacheOwnersLock.test_and_set(std::memory_order_acquire))
+			std::this_thread::yield();
+
+		fn();
+
+		threadCacheOwnersLock.clear(std::memory_order_release);
+	}
+
+
+	void RegisterThreadCaches(BlockAllocator* allocator) noexcept
+	{
+		WithThreadCacheOwners(
+			[&]
+			{
+				for (auto& owner : threadCacheOwners)
+				{
+					if (!owner)
+					{
+						owner = allocator;
+						return;
+					}
+				}
+
+				FK_ASSERT(false, "Too many BlockAllocators, raise MaxThreadCacheOwners");
+			});
+	}
+
+
+	void UnregisterThreadCaches(BlockAllocator* allocator) noexcept
+	{
+		WithThreadCacheOwners(
+			[&]
+			{
+				for (auto& owner : threadCacheOwners)
+				{
+					if (owner == allocator)
+						owner = nullptr;
+				}
+			});
+	}
+
+
+	struct ThreadCacheClaim
+	{
+		ThreadCacheClaim() noexcept
+		{
+			auto claimed = claimedThreadCaches.load(std::memory_order_relaxed);
+
+			for (uint8_t I = 0; I < MaxThreadCaches;)
+			{
+				const uint64_t bit = uint64_t(1) << I;
+
+				if (claimed & bit)
+					++I;
+				else if (claimedThreadCaches.compare_exchange_weak(claimed, claimed | bit))
+				{
+					index = I;
+					break;
+				}
+				else
+					I = 0;
+			}
+
+			threadCacheIndex = index;
+		}
+
+		// Thread locals destroyed after this one may still free, those frees see no index and go remote.
+		// The index is only handed on once the caches behind it are flushed.
+		~ThreadCacheClaim()
+		{
+			threadCacheIndex = InvalidThreadCache;
+
+			if (index == InvalidThreadCache)
+				return;
+
+			WithThreadCacheOwners(
+				[&]
+				{
+					for (auto owner : threadCacheOwners)
+					{
+						if (owner)
+							owner->FlushThreadCache(index);
+					}
+				});
+
+			claimedThreadCaches.fetch_and(~(uint64_t(1) << index));
+		}
+
+		uint8_t index = InvalidThreadCache;
+	};
+
+
+	uint8_t GetThreadCacheIndex() noexcept
+	{
+		if (threadCacheIndex == UnclaimedThreadCache)
+			thread_local const ThreadCacheClaim claim;
+
+		return threadCacheIndex;
+	}
+
+
 /************************************************************************************************/
 	
 // Generic Utiliteies
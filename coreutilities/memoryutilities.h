@@ -26,10 +26,15 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define MEMORYUTILITIES_INLUDED
 
 #include "..\buildsettings.h"
+#include "..\coreutilities\AllocationTelemetry.h"
 #include "..\coreutilities\Logging.h"
 #include <atomic>
 #include <mutex>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace FlexKit
 {
 	/************************************************************************************************/
@@ -105,27 +110,47 @@ namespace FlexKit
 
 		void* malloc(size_t n) override
 		{
-			return ::malloc(n);
+			auto memory = ::malloc(n);
+
+#if USING(ALLOCATIONTELEMETRY)
+			TrackAllocation(memory, n, "SystemAllocator");
+#endif
+
+			return memory;
 		}
 
 		void  free(void* _ptr) override
 		{
+#if USING(ALLOCATIONTELEMETRY)
+			TrackFree(_ptr);
+#endif
+
 			::free(_ptr);
 		}
 
 		void* _aligned_malloc(size_t n, size_t A = 0x10) override
 		{
-			return ::_aligned_malloc(n, A);
+			auto memory = ::_aligned_malloc(n, A);
+
+#if USING(ALLOCATIONTELEMETRY)
+			TrackAllocation(memory, n, "SystemAllocator");
+#endif
+
+			return memory;
 		}
 
 		void  _aligned_free(void* _ptr) override
 		{
+#if USING(ALLOCATIONTELEMETRY)
+			TrackFree(_ptr);
+#endif
+
 			::_aligned_free(_ptr);
 		}
 
 		void* malloc_Debug(size_t n, const char*, size_t) override
 		{
-			return ::malloc(n);
+			return malloc(n);
 		}
 
 		operator iAllocator* (){return this;}
@@ -284,16 +309,207 @@ namespace FlexKit
 	};
 
 
+	/************************************************************************************************/
+
+
+	// Thread safe linear allocator for per frame data. Holds FrameCount buffers and bump allocates from the
+	// current one, so memory handed out stays valid for FrameCount - 1 calls to NextFrame. Allocations that do
+	// not fit fall back to the backing allocator and are freed when their frame's buffer is reused, the high
+	// water mark includes them so the buffers can be sized to avoid that.
+	class FLEXKITAPI FrameArena : public iAllocator
+	{
+	public:
+		static const size_t FrameCount = 3;
+
+		FrameArena(iAllocator* IN_allocator, const size_t IN_frameSize);
+		~FrameArena();
+
+		FrameArena				(const FrameArena&) = delete;
+		FrameArena& operator =	(const FrameArena&) = delete;
+
+		void* malloc			(size_t size) override;
+		void  free				(void*) override {}
+		void* _aligned_malloc	(size_t size, size_t alignment = 0x10) override;
+		void  _aligned_free		(void*) override {}
+		void  clear				() override {}
+
+		void* malloc_Debug(size_t size, const char*, size_t) override
+		{
+			return malloc(size);
+		}
+
+		// Moves on to the next buffer, O(1) unless it overflowed. No allocations may be in flight.
+		void	NextFrame			();
+
+		size_t	GetFrameSize		() const noexcept { return frameSize; }
+		size_t	GetUsed				() const noexcept; // current frame, overflow included
+		size_t	GetHighWaterMark	() const noexcept; // largest frame so far, overflow included
+		size_t	GetOverflowCount	() const noexcept { return overflowCount; }
+
+		operator iAllocator* () { return this; }
+
+	private:
+		struct OverflowBlock
+		{
+			OverflowBlock* next;
+		};
+
+		struct alignas(64) Frame
+		{
+			byte*						buffer			= nullptr;
+			std::atomic_size_t			used			= 0;
+			std::atomic_size_t			overflowUsed	= 0;
+			std::atomic<OverflowBlock*>	overflow		= nullptr;
+		};
+
+		void* _Overflow(Frame& frame, const size_t size, const size_t alignment);
+
+		Frame				frames[FrameCount];
+		size_t				currentFrame	= 0;
+		size_t				frameSize;
+		size_t				highWaterMark	= 0;
+		std::atomic_size_t	overflowCount	= 0;
+		iAllocator*			allocator;
+	};
+
+
+	/************************************************************************************************/
+
+
+	inline uint32_t LowestSetBit(const uint64_t bits)
+	{
+#if defined(_MSC_VER)
+		unsigned long idx;
+		_BitScanForward64(&idx, bits);
+		return idx;
+#else
+		return (uint32_t)__builtin_ctzll(bits);
+#endif
+	}
+
+
+	/************************************************************************************************/
+
+
+	// A set bit marks a free entry. Each level above the first marks which words of the level below still have a
+	// free bit, up to a single top word, so finding the first free entry reads one word per level.
+	struct FreeBitmap
+	{
+		static const size_t InvalidIndex	= size_t(-1);
+		static const size_t MaxLevels		= 4; // 64^4 entries
+
+
+		static size_t BufferSize(size_t count) // in bytes
+		{
+			size_t words = 0;
+
+			do
+			{
+				count	= (count + 63) / 64;
+				words	+= count;
+			} while (count > 1);
+
+			return words * sizeof(uint64_t);
+		}
+
+
+		// Starts with every entry free
+		void Initialise(const size_t IN_count, uint64_t* buffer)
+		{
+			size_t count = IN_count;
+			levelCount = 0;
+
+			do
+			{
+				FK_ASSERT((levelCount < MaxLevels), "FreeBitmap too large!");
+
+				count					= (count + 63) / 64;
+				levels[levelCount++]	= buffer;
+
+				memset(buffer, 0, count * sizeof(uint64_t));
+				buffer += count;
+			} while (count > 1);
+
+			for (size_t I = 0; I < IN_count; ++I)
+				SetFree(I);
+		}
+
+
+		size_t FindFirstFree() const
+		{
+			if (!levels[levelCount - 1][0])
+				return InvalidIndex;
+
+			size_t idx = 0;
+
+			for (size_t level = levelCount; level > 0; --level)
+				idx = idx * 64 + LowestSetBit(levels[level - 1][idx]);
+
+			return idx;
+		}
+
+
+		void SetFree(size_t idx)
+		{
+			for (size_t level = 0; level < levelCount; ++level, idx /= 64)
+			{
+				auto&		word		= levels[level][idx / 64];
+				const bool	wasEmpty	= !word;
+
+				word |= uint64_t(1) << (idx % 64);
+
+				if (!wasEmpty)
+					return;
+			}
+		}
+
+
+		void SetUsed(size_t idx)
+		{
+			for (size_t level = 0; level < levelCount; ++level, idx /= 64)
+			{
+				auto& word = levels[level][idx / 64];
+				word &= ~(uint64_t(1) << (idx % 64));
+
+				if (word)
+					return;
+			}
+		}
+
+
+		bool IsFree(const size_t idx) const
+		{
+			return (levels[0][idx / 64] >> (idx % 64)) & 1;
+		}
+
+
+		uint64_t*	levels[MaxLevels];
+		size_t		levelCount = 0;
+	};
+
+
 	/************************************************************************************************/
 	// 64 Byte Allocator
 
+	// In bytes, slots held in a thread cache count as used. Fragmentation is 1 - largestFree / free.
+	struct BlockPoolStats
+	{
+		size_t capacity		= 0;
+		size_t used			= 0;
+		size_t largestFree	= 0;
+	};
+
+
+	/************************************************************************************************/
+
+
 	struct SmallBlockAllocator
 	{
 		SmallBlockAllocator() : 
 			Blocks	{nullptr},
 			Size	{0}{}
 
-		static int MaxAllocationSize() { return sizeof(Block::BlockSize); }
+		static int MaxAllocationSize() { return Block::BlockSize; }
 
 		void Initialise( size_t BufferSize, byte* Buffer )// Size in Bytes
 		{
@@ -301,38 +517,46 @@ namespace FlexKit
 			Size = BufferSize / AllocationFootPrint;
 			Blocks = reinterpret_cast<Block*>(Buffer);
 
-#ifdef _DEBUG
 			for (size_t itr = 0; itr < Size; ++itr)
 			{
 				Blocks[itr].BlockFull = false;
-				for (size_t itr2 = 0; itr2 < 4; ++itr2)
+				for (size_t itr2 = 0; itr2 < Block::BlockCount; ++itr2)
 					Blocks[itr].state[itr2] = Block::Free;
 			}
-#endif
+
+			// Tracks blocks with at least one free slot
+			openBlocks.Initialise(Size, (uint64_t*)::_aligned_malloc(FreeBitmap::BufferSize(Size), 0x40));
 		}
 
-		// TODO: maybe Multi-Thread?
 		byte* malloc(size_t, bool Aligned = false)
 		{
-			for (size_t itr = 0; itr < Size; ++itr)
+			const auto itr = openBlocks.FindFirstFree();
+
+			if (itr == FreeBitmap::InvalidIndex)
+			{
+				FK_ASSERT(0);
+				return nullptr;
+			}
+
+			auto& block = Blocks[itr];
+
+			for (size_t itr2 = 0; itr2 < Block::BlockCount; ++itr2)
 			{
-				if (!Blocks[itr].BlockFull)
+				if (block.state[itr2] == Block::Free)
 				{
-					for (size_t itr2 = 0; itr2 < 7; ++itr2)
+					block.state[itr2] = Block::Allocated | (Aligned ? Block::Aligned : 0);
+
+					if (_IsFull(block))
 					{
-						auto state = Blocks[itr].state[itr2];
-						if (state == Block::Free)
-						{
-							Blocks[itr].state[itr2] = (Block::Allocated | Aligned) ? Block::Aligned : 0;
-							//if(itr2 == Block::BlockCount) Blocks[itr].BlockFull = true;
-							return (byte*)&Blocks[itr].data[itr2];
-						}
+						block.BlockFull = true;
+						openBlocks.SetUsed(itr);
 					}
-					Blocks[itr].BlockFull = true;
+
+					return (byte*)&block.data[itr2];
 				}
 			}
 
-			FK_ASSERT(0);
+			FK_ASSERT(0, "Small block marked open with no free slots!");
 
 			return nullptr;
 		}
@@ -341,6 +565,8 @@ namespace FlexKit
 		{
 			Blocks[BlockID].state[SBlockID] = Block::Free;
 			Blocks[BlockID].BlockFull = false;
+
+			openBlocks.SetFree(BlockID);
 		}
 
 		void free(void* _ptr)
@@ -350,15 +576,13 @@ namespace FlexKit
 			size_t BlockID		= (temp1 - temp2) / sizeof(Block);
 			size_t SBlockID		= (temp1 - temp2) % sizeof(Block) / sizeof(Block::c);
 
-			if ( SBlockID == 0x08 )
-#ifdef _DEBUG
+			if (SBlockID >= Block::BlockCount)
 			{
 				FK_ASSERT( 0, "INVALID ADDRESS!!" );
 				return;
 			}
-#endif
-				_FreeBlock(BlockID, SBlockID);
 
+			_FreeBlock(BlockID, SBlockID);
 		}
 
 		void _aligned_free(void* _ptr)
@@ -392,7 +616,31 @@ namespace FlexKit
 			size_t	Padding[7];
 		}*Blocks;
 
-		size_t Size;
+		BlockPoolStats GetStats() const
+		{
+			BlockPoolStats stats;
+			stats.capacity = Size * Block::BlockCount * Block::BlockSize;
+
+			for (size_t itr = 0; itr < Size; ++itr)
+				for (auto state : Blocks[itr].state)
+					stats.used += state == Block::Free ? 0 : Block::BlockSize;
+
+			stats.largestFree = stats.used < stats.capacity ? Block::BlockSize : 0;
+
+			return stats;
+		}
+
+		static bool _IsFull(const Block& block)
+		{
+			for (auto state : block.state)
+				if (state == Block::Free)
+					return false;
+
+			return true;
+		}
+
+		size_t		Size;
+		FreeBitmap	openBlocks;
 	};
 
 
@@ -410,9 +658,10 @@ namespace FlexKit
 
 			for (size_t I = 0; I < Size; ++I)
 				BlockTable[I].state = BlockData::Free;
+
+			freeBlocks.Initialise(Size, (uint64_t*)::_aligned_malloc(FreeBitmap::BufferSize(Size), 0x40));
 		}
 
-		// TODO: maybe Multi-Thread?
 		byte* malloc(size_t size, bool ALIGNED = false, bool DebugMetaData = false)
 		{
 #ifdef _DEBUG
@@ -423,19 +672,19 @@ namespace FlexKit
 			}
 #endif
 
-			for (size_t i = 0; i < Size; ++i)
-				if (BlockTable[i].state == BlockData::Free)
-				{
-					BlockTable[i].state = 
-						BlockData::Allocated | 
-						(ALIGNED		? BlockData::Aligned : 0) | 
-						(DebugMetaData	? BlockData::DebugMD : 0);
-					return (byte*)&Blocks[i];
-				}
+			const auto i = freeBlocks.FindFirstFree();
 
-			throw(std::bad_alloc());
+			if (i == FreeBitmap::InvalidIndex)
+				throw(std::bad_alloc());
 
-			return nullptr;
+			freeBlocks.SetUsed(i);
+
+			BlockTable[i].state = 
+				BlockData::Allocated | 
+				(ALIGNED		? BlockData::Aligned : 0) | 
+				(DebugMetaData	? BlockData::DebugMD : 0);
+
+			return (byte*)&Blocks[i];
 		}
 
 
@@ -450,10 +699,11 @@ namespace FlexKit
 			size_t temp2 = (size_t)Blocks;
 			size_t index = (temp - temp2) / sizeof(Block);
 
-			if (index > Size)
+			if (index >= Size)
 				throw(std::runtime_error("Invalid Free"));
 
 			BlockTable[index].state = BlockData::Free;
+			freeBlocks.SetFree(index);
 		}
 
 		void _aligned_free(void* _ptr)
@@ -462,7 +712,7 @@ namespace FlexKit
 			size_t temp2 = (size_t)Blocks;
 			size_t index = (temp - temp2) / sizeof(Block);
 
-			if (index > Size)
+			if (index >= Size)
 				throw(std::runtime_error("Invalid Free"));
 
 #ifdef _DEBUG
@@ -470,6 +720,20 @@ namespace FlexKit
 #endif
 
 			BlockTable[index].state = BlockData::Free;
+			freeBlocks.SetFree(index);
+		}
+
+		BlockPoolStats GetStats() const
+		{
+			BlockPoolStats stats;
+			stats.capacity = Size * sizeof(Block);
+
+			for (size_t I = 0; I < Size; ++I)
+				stats.used += BlockTable[I].state == BlockData::Free ? 0 : sizeof(Block);
+
+			stats.largestFree = stats.used < stats.capacity ? sizeof(Block) : 0;
+
+			return stats;
 		}
 
 		struct Block
@@ -489,15 +753,21 @@ namespace FlexKit
 			byte state;
 		}*BlockTable;
 
-		size_t Size;
+		size_t		Size;
+		FreeBitmap	freeBlocks;
 	};
 
 
 	/************************************************************************************************/
 	// 1 MB MultiBlock Allocator
 
+	// Free runs of blocks are kept in lists binned by the log2 of their length, with a mask of the non empty
+	// bins. The last table entry of a free run points back to its first, so a freed run merges with both neighbours.
 	struct LargeBlockAllocator
 	{
+		static const uint16_t	InvalidBlock	= 0xffff;
+		static const size_t		BinCount		= 16;
+
 		void Initialise(size_t BufferSize, byte* Buffer)// Size in Bytes
 		{
 			FK_ASSERT(BufferSize < (size_t)uint32_t(-1));
@@ -509,46 +779,58 @@ namespace FlexKit
 
 			BlockTable	= reinterpret_cast<BlockData*>(temp + (temp & 0x3f));
 
+			FK_ASSERT((Size < InvalidBlock), "Large block pool too large for 16 bit block indices!");
+
 			for (size_t itr = 0; itr < Size; ++itr)
 				BlockTable[itr] = { BlockData::UNUSED, 0 };
 
-			BlockTable[0] = { BlockData::Free, 0, uint16_t(BufferSize / AllocationFootPrint) };
+			for (auto& bin : bins)
+				bin = InvalidBlock;
+
+			binMask = 0;
+
+			_PushFree(0, Size);
 		}
 
-		// TODO: maybe Multi-Thread?
 		byte* malloc(size_t requestsize, bool aligned = false)
 		{
 			size_t BlocksNeeded = requestsize / sizeof( Block ) + ( ( requestsize%sizeof( Block ) ) > 0 );
 			FK_ASSERT(BlocksNeeded);
 
-			for (size_t i = 0; i < Size;i += BlockTable[i].AllocationSize)
+			// Any run in a higher bin fits, only the needed size's own bin has to be searched
+			const size_t	bin			= _GetBin(BlocksNeeded);
+			const uint64_t	largerBins	= binMask & ~((uint64_t(2) << bin) - 1);
+
+			size_t i = InvalidBlock;
+
+			if (largerBins)
+				i = bins[LowestSetBit(largerBins)];
+			else
 			{
-				if (!BlockTable[i].AllocationSize)
-					break;
-				if (BlockTable[i].state == BlockData::Free && BlockTable[i].AllocationSize > BlocksNeeded)
+				for (auto itr = bins[bin]; itr != InvalidBlock; itr = BlockTable[itr].NextFree)
 				{
-					BlockTable[i].state = (BlockData::Flags)(BlockData::Allocated | (aligned ? BlockData::Aligned : 0));
-					if (BlockTable[i].AllocationSize > BlocksNeeded)
+					if (BlockTable[itr].AllocationSize >= BlocksNeeded)
 					{
-						size_t currentBlock  = i;
-						size_t NextBlockData = i + BlocksNeeded;
-						//for ( size_t II = i; II < NextBlockData; ++II )
-						//{
-						//	BlockTable[II].state  = BlockTable[i].state;
-						//	BlockTable[II].Parent = currentBlock;
-						//}
-						if(NextBlockData < Size && BlockTable[NextBlockData].state == BlockData::UNUSED)
-						{// Split Block
-							BlockTable[NextBlockData].state          = BlockData::Free;
-                            BlockTable[NextBlockData].AllocationSize = static_cast<uint16_t>(BlockTable[currentBlock].AllocationSize - BlocksNeeded);
-							BlockTable[currentBlock].AllocationSize  = static_cast<uint16_t>(BlocksNeeded);
-
-							FK_ASSERT(BlockTable[NextBlockData].AllocationSize);
-						}
+						i = itr;
+						break;
 					}
+				}
+			}
 
-					return (byte*)Blocks[i].data;
+			if (i != InvalidBlock)
+			{
+				const size_t runSize = BlockTable[i].AllocationSize;
+				_RemoveFree(i);
+
+				if (runSize > BlocksNeeded)
+				{// Split Block
+					_PushFree(i + BlocksNeeded, runSize - BlocksNeeded);
+					BlockTable[i].AllocationSize = static_cast<uint16_t>(BlocksNeeded);
 				}
+
+				BlockTable[i].state = (BlockData::Flags)(BlockData::Allocated | (aligned ? BlockData::Aligned : 0));
+
+				return (byte*)Blocks[i].data;
 			}
 
 #ifdef _DEBUG
@@ -582,7 +864,6 @@ namespace FlexKit
 			FK_ASSERT((index < Size),  "FREE ERROR!\n");
 #endif
 
-			BlockTable[index].state = BlockData::Free;
 			Collapse(index);
 		}
 
@@ -593,23 +874,109 @@ namespace FlexKit
 			size_t temp2 = (size_t)Blocks;
 			size_t index = (temp - temp2) / sizeof(Block);
 
-			BlockTable[index].state = BlockData::Free;
 			Collapse(index);
 		}
 
 
-		void Collapse(size_t block = 0)
+		BlockPoolStats GetStats() const
 		{
-			while (true)
+			BlockPoolStats stats;
+			stats.capacity = Size * sizeof(Block);
+
+			for (size_t I = 0; I < Size; I += BlockTable[I].AllocationSize)
+			{
+				const size_t runSize = BlockTable[I].AllocationSize * sizeof(Block);
+
+				if (BlockTable[I].state == BlockData::Free)
+					stats.largestFree = runSize > stats.largestFree ? runSize : stats.largestFree;
+				else
+					stats.used += runSize;
+			}
+
+			return stats;
+		}
+
+
+		// Frees the run starting at block, merged with whichever neighbours are free
+		void Collapse(size_t block)
+		{
+			size_t runSize	= BlockTable[block].AllocationSize;
+			size_t next		= block + runSize;
+
+			if (next < Size && BlockTable[next].state == BlockData::Free)
 			{
-				size_t next = block + BlockTable[block].AllocationSize;
-				if (next < Size && BlockTable[next].state == BlockData::Free)
+				runSize += BlockTable[next].AllocationSize;
+
+				_RemoveFree(next);
+				BlockTable[next].state = BlockData::UNUSED;
+			}
+
+			if (block > 0)
+			{
+				const size_t previous = BlockTable[block - 1].Parent;
+
+				if (BlockTable[previous].state == BlockData::Free && previous + BlockTable[previous].AllocationSize == block)
 				{
-					BlockTable[block].AllocationSize += BlockTable[next].AllocationSize;
-					BlockTable[next].state			= BlockData::UNUSED;
+					runSize += BlockTable[previous].AllocationSize;
+
+					_RemoveFree(previous);
+					BlockTable[block].state = BlockData::UNUSED;
+					block = previous;
 				}
-				else break;
 			}
+
+			_PushFree(block, runSize);
+		}
+
+
+		static size_t _GetBin(size_t blockCount)
+		{
+			size_t bin = 0;
+
+			while (blockCount >>= 1)
+				bin++;
+
+			return bin < BinCount ? bin : BinCount - 1;
+		}
+
+
+		void _PushFree(const size_t block, const size_t runSize)
+		{
+			const auto bin = _GetBin(runSize);
+
+			auto& entry = BlockTable[block];
+			entry.state				= BlockData::Free;
+			entry.AllocationSize	= static_cast<uint16_t>(runSize);
+			entry.PrevFree			= InvalidBlock;
+			entry.NextFree			= bins[bin];
+
+			if (bins[bin] != InvalidBlock)
+				BlockTable[bins[bin]].PrevFree = static_cast<uint16_t>(block);
+
+			bins[bin]	= static_cast<uint16_t>(block);
+			binMask		|= uint64_t(1) << bin;
+
+			BlockTable[block + runSize - 1].Parent = static_cast<uint16_t>(block);
+		}
+
+
+		void _RemoveFree(const size_t block)
+		{
+			auto& entry = BlockTable[block];
+
+			if (entry.PrevFree != InvalidBlock)
+				BlockTable[entry.PrevFree].NextFree = entry.NextFree;
+			else
+			{
+				const auto bin = _GetBin(entry.AllocationSize);
+				bins[bin] = entry.NextFree;
+
+				if (bins[bin] == InvalidBlock)
+					binMask &= ~(uint64_t(1) << bin);
+			}
+
+			if (entry.NextFree != InvalidBlock)
+				BlockTable[entry.NextFree].PrevFree = entry.PrevFree;
 		}
 
 
@@ -628,15 +995,34 @@ namespace FlexKit
 				Aligned		= 0x04,
 				DEBUG		= 0x08
 			}state;
-			uint16_t Parent;
+			uint16_t Parent;			// on the last block of a free run, the run's first block
 			uint16_t AllocationSize;
-			char	 Padding_2[0x40 - 0x06]; // To Put Data Blocks on 64byte Lines for Multi-Threading
+			uint16_t NextFree;
+			uint16_t PrevFree;
+			char	 Padding_2[0x40 - 0x0A]; // To Put Data Blocks on 64byte Lines for Multi-Threading
 		}*BlockTable;
 
-		size_t Size;
+		size_t		Size;
+		uint16_t	bins[BinCount];
+		uint64_t	binMask;
 	};
 
 
+	static const uint8_t	InvalidThreadCache	= 0xff;
+	static const size_t		MaxThreadCaches		= 64; // threads past this go straight to the shared pools
+
+	// Index of the calling thread's caches, the same index is used with every BlockAllocator.
+	// When a thread exits its caches are flushed back to every registered BlockAllocator's shared pools
+	// before the index is handed on. Frees made later in the thread's exit go through the remote free lists.
+	FLEXKITAPI uint8_t GetThreadCacheIndex() noexcept;
+
+	struct BlockAllocator;
+
+	// Init registers, the destructor unregisters
+	FLEXKITAPI void RegisterThreadCaches	(BlockAllocator* allocator) noexcept;
+	FLEXKITAPI void UnregisterThreadCaches	(BlockAllocator* allocator) noexcept;
+
+
 	struct BlockAllocator_desc
 	{
 		byte* _ptr;
@@ -660,6 +1046,12 @@ namespace FlexKit
 			Large{0}
 		{}
 
+		~BlockAllocator()
+		{
+			if (registered)
+				UnregisterThreadCaches(this);
+		}
+
 		BlockAllocator(BlockAllocator&) = delete;
 		BlockAllocator& operator = (const BlockAllocator&) = delete;
 
@@ -674,19 +1066,76 @@ namespace FlexKit
 			MediumBlockAlloc.Initialise	(in.MediumBlock,	(byte*)::_aligned_malloc(Medium,	0x40));
 			LargeBlockAlloc.Initialise	(in.LargeBlock,		(byte*)::_aligned_malloc(Large,		0x40));
 
+			const size_t slotCounts[] = { SmallBlockAlloc.Size * SmallBlockAllocator::Block::BlockCount, MediumBlockAlloc.Size + 1 };
+
+			for (size_t I = 0; I < SizeClassCount; ++I)
+			{
+				owners[I] = (uint8_t*)::_aligned_malloc(slotCounts[I], 0x40);
+				memset(owners[I], InvalidThreadCache, slotCounts[I]);
+			}
+
 			new(&AllocatorInterface) iBlockAllocator(this);
+
+			if (!registered)
+				RegisterThreadCaches(this);
+
+			registered = true;
+		}
+
+
+		// Hands everything cached for an exiting thread back to the shared pools, remote frees included
+		void FlushThreadCache(const uint8_t cacheIdx)
+		{
+			for (auto sizeClass : { SmallClass, MediumClass })
+			{
+				auto& cache		= caches[cacheIdx][sizeClass];
+				auto  remote	= cache.remoteFrees.exchange(nullptr, std::memory_order_acquire);
+
+				while (remote)
+				{
+					auto next		= remote->next;
+					remote->next	= cache.freeList;
+					cache.freeList	= remote;
+					cache.count++;
+
+					remote = next;
+				}
+
+				_Flush(cacheIdx, sizeClass, 0);
+			}
 		}
 
 		byte* malloc(const size_t size, bool MarkAligned = false, bool MarkDebugMetaData = false)
 		{
-			std::unique_lock ul{ mu };
+			auto ret = _Malloc(size, MarkAligned, MarkDebugMetaData);
 
+#if USING(ALLOCATIONTELEMETRY)
+			TrackAllocation(ret, size, "BlockAllocator");
+#endif
+
+			return ret;
+		}
+
+		// Small and medium blocks come from the calling thread's cache, only refills and large blocks take the lock
+		byte* _Malloc(const size_t size, bool MarkAligned = false, bool MarkDebugMetaData = false)
+		{
 			byte* ret = nullptr;
 
 			if (size <= SmallBlockAllocator::MaxAllocationSize())
-				ret = SmallBlockAlloc.malloc(size, MarkAligned);
+				ret = _CachedMalloc(SmallClass);
+			if (size <= MediumBlockAllocator::MaxBlockSize() && !ret)
+				ret = _CachedMalloc(MediumClass);
+
+			if (ret)
+				return ret;
+
+			std::unique_lock ul{ mu };
+
+			// No cache for this thread, or the pool was too full to refill one
+			if (size <= SmallBlockAllocator::MaxAllocationSize())
+				ret = _SharedMalloc(SmallClass);
 			if (size <=  MediumBlockAllocator::MaxBlockSize() && !ret)
-				ret = MediumBlockAlloc.malloc(size, MarkAligned, MarkDebugMetaData);
+				ret = _SharedMalloc(MediumClass);
 			if (!ret)
 				ret = LargeBlockAlloc.malloc(size, MarkAligned);
 
@@ -711,11 +1160,11 @@ namespace FlexKit
 			const size_t MetaDataSectionSize = Aligned ? 0x40 : 0x00;
 
 			if (size <= SmallBlockAllocator::MaxAllocationSize())
-				ret = (byte*)_aligned_malloc(size + MetaDataSectionSize, 0x40);
+				ret = (byte*)_AlignedMalloc(size + MetaDataSectionSize, 0x40);
 			if (size <=  MediumBlockAllocator::MaxBlockSize() && !ret)
-				ret = (byte*)_aligned_malloc(size + MetaDataSectionSize, 0x40, true);
+				ret = (byte*)_AlignedMalloc(size + MetaDataSectionSize, 0x40, true);
 			if (!ret)
-				ret = (byte*)_aligned_malloc(size + MetaDataSectionSize, 0x40);
+				ret = (byte*)_AlignedMalloc(size + MetaDataSectionSize, 0x40);
 
 			if (	
 				size > SmallBlockAllocator::MaxAllocationSize() && 
@@ -726,12 +1175,27 @@ namespace FlexKit
 				strncpy_s(reinterpret_cast<char*>(ret), DebugStringLen, "DEBUG ALLOCATION", DebugSectionSize);
 			}
 
+#if USING(ALLOCATIONTELEMETRY)
+			TrackAllocation(ret + MetaDataSectionSize, size, "BlockAllocator");
+#endif
+
 			return ret + MetaDataSectionSize;
 		}
 
 		char*	_aligned_malloc(size_t s, size_t alignement = 0x10, bool MarkDebugMetaData = false)
 		{
-			const char* NewBuffer		= (char*)malloc(s + alignement, true, MarkDebugMetaData);
+			auto ret = _AlignedMalloc(s, alignement, MarkDebugMetaData);
+
+#if USING(ALLOCATIONTELEMETRY)
+			TrackAllocation(ret, s, "BlockAllocator");
+#endif
+
+			return ret;
+		}
+
+		char*	_AlignedMalloc(size_t s, size_t alignement = 0x10, bool MarkDebugMetaData = false)
+		{
+			const char* NewBuffer		= (char*)_Malloc(s + alignement, true, MarkDebugMetaData);
 			const size_t alignoffset	= (size_t)(NewBuffer) % alignement;
 			const size_t Offset			= alignoffset  ? (alignement - alignoffset) : 0;
 
@@ -740,13 +1204,16 @@ namespace FlexKit
 		
 		void free(void* _ptr)
 		{
+#if USING(ALLOCATIONTELEMETRY)
+			TrackFree(_ptr);
+#endif
+
+			if (_CachedFree(_ptr))
+				return;
+
 			std::unique_lock ul(mu);
 
-			if (InSmallRange(reinterpret_cast<byte*>(_ptr)) && false)
-				SmallBlockAlloc.free(reinterpret_cast<void*>(_ptr));
-			else if (InMediumRange(reinterpret_cast<byte*>(_ptr)))
-				MediumBlockAlloc.free(reinterpret_cast<void*>(_ptr));
-			else if (InLargeRange(reinterpret_cast<byte*>(_ptr)))
+			if (InLargeRange(reinterpret_cast<byte*>(_ptr)))
 				LargeBlockAlloc.free(reinterpret_cast<void*>(_ptr));
 		}
 
@@ -759,16 +1226,34 @@ namespace FlexKit
 
 		void _aligned_free(void* _ptr)
 		{
+#if USING(ALLOCATIONTELEMETRY)
+			TrackFree(_ptr);
+#endif
+
+			if (_CachedFree(_ptr))
+				return;
+
 			std::unique_lock ul(mu);
 
-			if (InSmallRange((byte*)_ptr) && false)
-				SmallBlockAlloc._aligned_free(_ptr);
-			else if (InMediumRange(static_cast<byte*>(_ptr)))
-				MediumBlockAlloc._aligned_free(_ptr);
-			else if (InLargeRange(static_cast<byte*>(_ptr)))
+			if (InLargeRange(static_cast<byte*>(_ptr)))
 				LargeBlockAlloc._aligned_free(_ptr);
 		}
 
+		struct Stats
+		{
+			BlockPoolStats smallPool;
+			BlockPoolStats mediumPool;
+			BlockPoolStats largePool;
+		};
+
+		// Walks every pool's block table, meant for debug queries rather than every frame
+		Stats GetPoolStats()
+		{
+			std::unique_lock ul(mu);
+
+			return { SmallBlockAlloc.GetStats(), MediumBlockAlloc.GetStats(), LargeBlockAlloc.GetStats() };
+		}
+
 		template<typename T, size_t a = 16>
 		T& allocate_aligned()
 		{
@@ -812,20 +1297,238 @@ namespace FlexKit
 			free(&I);
 		}
 
+		enum SizeClass
+		{
+			SmallClass,
+			MediumClass,
+			SizeClassCount
+		};
+
+		static const size_t SmallCacheLimit		= 256;
+		static const size_t SmallBatchSize		= 64;
+		static const size_t MediumCacheLimit	= 32;
+		static const size_t MediumBatchSize		= 8;
+
+		struct FreeSlot
+		{
+			FreeSlot* next;
+		};
+
+		// Only the owning thread touches the free list. Other threads freeing one of its blocks push onto
+		// remoteFrees, which the owner takes whole once its own list runs dry.
+		struct alignas(64) ThreadCache
+		{
+			FreeSlot*							freeList	= nullptr;
+			size_t								count		= 0;
+			alignas(64) std::atomic<FreeSlot*>	remoteFrees	= nullptr;
+		};
+
+
+		byte* _CachedMalloc(const SizeClass sizeClass)
+		{
+			const auto cacheIdx = GetThreadCacheIndex();
+
+			if (cacheIdx == InvalidThreadCache)
+				return nullptr;
+
+			auto& cache = caches[cacheIdx][sizeClass];
+
+			if (!cache.freeList)
+			{
+				cache.freeList = cache.remoteFrees.exchange(nullptr, std::memory_order_acquire);
+
+				for (auto itr = cache.freeList; itr; itr = itr->next)
+					cache.count++;
+
+				if (!cache.freeList)
+					_Refill(cacheIdx, sizeClass);
+
+				if (!cache.freeList)
+					return nullptr;
+			}
+
+			auto slot		= cache.freeList;
+			cache.freeList	= slot->next;
+			cache.count--;
+
+			return reinterpret_cast<byte*>(slot);
+		}
+
+
+		bool _CachedFree(void* _ptr)
+		{
+			SizeClass	sizeClass;
+			size_t		slotIdx;
+			FreeSlot*	slot;
+
+			if (!_FindSlot(_ptr, sizeClass, slotIdx, slot))
+				return false;
+
+			const auto owner	= owners[sizeClass][slotIdx];
+			const auto cacheIdx	= GetThreadCacheIndex();
+
+			if (owner == InvalidThreadCache)
+			{
+				std::unique_lock ul{ mu };
+				_SharedFree(sizeClass, slotIdx, slot);
+			}
+			else if (owner == cacheIdx)
+			{
+				auto& cache = caches[cacheIdx][sizeClass];
+
+				slot->next		= cache.freeList;
+				cache.freeList	= slot;
+				cache.count++;
+
+				const size_t limit = sizeClass == SmallClass ? SmallCacheLimit : MediumCacheLimit;
+
+				if (cache.count > limit)
+					_Flush(cacheIdx, sizeClass, limit / 2);
+			}
+			else
+			{
+				auto& remoteFrees = caches[owner][sizeClass].remoteFrees;
+
+				slot->next = remoteFrees.load(std::memory_order_relaxed);
+				while (!remoteFrees.compare_exchange_weak(slot->next, slot, std::memory_order_release, std::memory_order_relaxed));
+			}
+
+			return true;
+		}
+
+
+		// Takes a batch from the shared pool under a single lock
+		void _Refill(const uint8_t cacheIdx, const SizeClass sizeClass)
+		{
+			auto&			cache		= caches[cacheIdx][sizeClass];
+			const size_t	batchSize	= sizeClass == SmallClass ? SmallBatchSize : MediumBatchSize;
+
+			std::unique_lock ul{ mu };
+
+			for (size_t I = 0; I < batchSize; ++I)
+			{
+				SizeClass	blockClass;
+				size_t		slotIdx;
+				FreeSlot*	slot;
+
+				auto block = _SharedMalloc(sizeClass);
+
+				if (!block || !_FindSlot(block, blockClass, slotIdx, slot))
+					break;
+
+				owners[sizeClass][slotIdx] = cacheIdx;
+
+				slot->next		= cache.freeList;
+				cache.freeList	= slot;
+				cache.count++;
+			}
+		}
+
+
+		// Hands all but keep cached blocks back to the shared pool
+		void _Flush(const uint8_t cacheIdx, const SizeClass sizeClass, const size_t keep)
+		{
+			auto& cache = caches[cacheIdx][sizeClass];
+
+			std::unique_lock ul{ mu };
+
+			while (cache.count > keep)
+			{
+				SizeClass	blockClass;
+				size_t		slotIdx;
+				FreeSlot*	slot = cache.freeList;
+
+				cache.freeList = slot->next;
+				cache.count--;
+
+				_FindSlot(slot, blockClass, slotIdx, slot);
+				_SharedFree(sizeClass, slotIdx, slot);
+			}
+		}
+
+
+		// Caller holds mu
+		byte* _SharedMalloc(const SizeClass sizeClass)
+		{
+			if (sizeClass == SmallClass)
+				return SmallBlockAlloc.malloc(SmallBlockAllocator::MaxAllocationSize(), true);
+
+			try
+			{
+				return MediumBlockAlloc.malloc(MediumBlockAllocator::MaxBlockSize(), true);
+			}
+			catch (std::bad_alloc&)
+			{
+				return nullptr;
+			}
+		}
+
+
+		// Caller holds mu
+		void _SharedFree(const SizeClass sizeClass, const size_t slotIdx, FreeSlot* slot)
+		{
+			owners[sizeClass][slotIdx] = InvalidThreadCache;
+
+			if (sizeClass == SmallClass)
+				SmallBlockAlloc._aligned_free(slot);
+			else
+				MediumBlockAlloc.free(slot);
+		}
+
+
+		// Maps any address inside a small or medium block back to the start of its block
+		bool _FindSlot(void* _ptr, SizeClass& sizeClass, size_t& slotIdx, FreeSlot*& slot)
+		{
+			auto address = static_cast<byte*>(_ptr);
+
+			if (InSmallRange(address))
+			{
+				const size_t offset		= address - (byte*)SmallBlockAlloc.Blocks;
+				const size_t blockIdx	= offset / sizeof(SmallBlockAllocator::Block);
+				const size_t subBlock	= offset % sizeof(SmallBlockAllocator::Block) / SmallBlockAllocator::Block::BlockSize;
+
+				FK_ASSERT((subBlock < SmallBlockAllocator::Block::BlockCount), "INVALID ADDRESS!!");
+
+				sizeClass	= SmallClass;
+				slotIdx		= blockIdx * SmallBlockAllocator::Block::BlockCount + subBlock;
+				slot		= reinterpret_cast<FreeSlot*>(&SmallBlockAlloc.Blocks[blockIdx].data[subBlock]);
+
+				return true;
+			}
+
+			if (InMediumRange(address))
+			{
+				const size_t blockIdx = (address - (byte*)MediumBlockAlloc.Blocks) / sizeof(MediumBlockAllocator::Block);
+
+				sizeClass	= MediumClass;
+				slotIdx		= blockIdx;
+				slot		= reinterpret_cast<FreeSlot*>(&MediumBlockAlloc.Blocks[blockIdx]);
+
+				return true;
+			}
+
+			return false;
+		}
+
+
 		SmallBlockAllocator		SmallBlockAlloc;
 		MediumBlockAllocator	MediumBlockAlloc;
 		LargeBlockAllocator		LargeBlockAlloc;
 		std::mutex				mu;
 
+		ThreadCache				caches[MaxThreadCaches][SizeClassCount];
+		uint8_t*				owners[SizeClassCount];	// cache each block was handed to, per slot
+
 		char*	Buffer_ptr;
 		size_t	Small, Medium, Large;
+		bool	registered = false;
 
 		bool InSmallRange(byte* a_ptr)
 		{
 			byte* bottom = (byte*)(SmallBlockAlloc.Blocks);
 			byte* top    = ((byte*)SmallBlockAlloc.Blocks) + Small;
 
-			return (bottom <= a_ptr) && (a_ptr < top) && false;
+			return (bottom <= a_ptr) && (a_ptr < top);
 		}
 
 		bool InMediumRange(byte* a_ptr)
@@ -48,13 +48,13 @@ namespace FlexKit
     /************************************************************************************************/
 
 
-    GatherSkinnedTask& GatherSkinned(UpdateDispatcher& dispatcher, GraphicScene* scene, CameraHandle C, iAllocator* allocator)
+    GatherSkinnedTask& GatherSkinned(UpdateDispatcher& dispatcher, GraphicScene* scene, CameraHandle C)
     {
         auto& task = dispatcher.Add<GatherSkinnedTaskData>(
 			[&](auto& builder, GatherSkinnedTaskData& data)
 			{
 				size_t taskMemorySize = KILOBYTE * 2048;
-				data.taskMemory.Init((byte*)allocator->malloc(taskMemorySize), taskMemorySize);
+				data.taskMemory.Init((byte*)builder.GetFrameArena().malloc(taskMemorySize), taskMemorySize);
 				data.scene			= scene;
 				data.skinned        = PosedDrawableList{ data.taskMemory };
 				data.camera			= C;
@@ -99,13 +99,13 @@ namespace FlexKit
     /************************************************************************************************/
 
 
-    UpdatePoseTask& UpdatePoses(UpdateDispatcher& dispatcher, GatherSkinnedTask& skinnedObjects, iAllocator* allocator)
+    UpdatePoseTask& UpdatePoses(UpdateDispatcher& dispatcher, GatherSkinnedTask& skinnedObjects)
     {
         auto& task = dispatcher.Add<UpdatePosesTaskData>(
 			[&](auto& builder, UpdatePosesTaskData& data)
 			{
 				size_t taskMemorySize = KILOBYTE * 2048;
-				data.taskMemory.Init((byte*)allocator->malloc(taskMemorySize), taskMemorySize);
+				data.taskMemory.Init((byte*)builder.GetFrameArena().malloc(taskMemorySize), taskMemorySize);
 				data.skinned        = &skinnedObjects.GetData().skinned;
 
                 builder.SetDebugString("Update Poses");
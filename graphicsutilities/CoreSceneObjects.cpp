@@ -24,21 +24,25 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
 #include "CoreSceneObjects.h"
+#include "DrawBatching.h"
+#include "..\\coreutilities\\RadixSort.h"
 
 namespace FlexKit
 {
 	/************************************************************************************************/
 
 
-	size_t CreateSortingID(bool Posed, bool Textured, size_t Depth)
+	size_t GetPVSortingID(const Drawable& drawable, const float3 cameraPosition)
 	{
-		size_t DepthPart	= (Depth & 0x00ffffffffffff);
-		size_t PosedBit		= (size_t(Posed)	<< (Posed		? 63 : 0));
-		size_t TextureBit	= (size_t(Textured) << (Textured	? 62 : 0));
-		return DepthPart | PosedBit | TextureBit;
-			
+		auto P = FlexKit::GetPositionW( drawable.Node );
+
+		return CreateDrawKey(drawable, float3(cameraPosition - P).magnitude());
 	}
 
+
+	/************************************************************************************************/
+
+
 	void SortPVS(PVS* PVS_, Camera* C)
 	{
 		if(!PVS_->size())
@@ -46,19 +50,9 @@ namespace FlexKit
 
 		auto CP = FlexKit::GetPositionW( C->Node );
 		for( auto& v : *PVS_ )
-		{
-			auto E = v.D;
-			auto P = FlexKit::GetPositionW( E->Node );
+			v.SortID = GetPVSortingID(*v.D, CP);
 
-			auto Depth = (size_t)abs(float3(CP - P).magnitudesquared() * 10000);
-			auto SortID = CreateSortingID(false, E->Textured, Depth);
-			v.SortID = SortID;
-		}
-		
-		std::sort( PVS_->begin(), PVS_->end(), []( PVEntry& R, PVEntry& L ) -> bool
-		{
-			return ( (size_t)R.SortID < (size_t)L.SortID);
-		} );
+		RadixSort(PVS_->begin(), PVS_->size(), [](const PVEntry& e) { return e.SortID; }, PVS_->Allocator);
 	}
 
 
@@ -73,16 +67,11 @@ namespace FlexKit
 		auto CP = FlexKit::GetPositionW( C->Node );
 		for( auto& v : *PVS_ )
 		{
-			auto E = v.D;
-			auto P = FlexKit::GetPositionW( E->Node );
-			float D = float3( CP - P ).magnitudesquared() * ( E->DrawLast ? -1.0 : 1.0 );
-			v.SortID = D;
+			auto P = FlexKit::GetPositionW( v.D->Node );
+			v.SortID = CreateTransparentDrawKey(*v.D, float3( CP - P ).magnitude());
 		}
 
-		std::sort( PVS_->begin(), PVS_->end(), []( auto& R, auto& L ) -> bool
-		{
-			return ( (size_t)R > (size_t)L );
-		} );
+		RadixSort(PVS_->begin(), PVS_->size(), [](const PVEntry& e) { return e.SortID; }, PVS_->Allocator);
 	}
 	
 
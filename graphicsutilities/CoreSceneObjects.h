@@ -183,6 +183,9 @@ namespace FlexKit
 			pvs.push_back(PVEntry( e, pvs.size(), 0u));
 	}
 
+	// Key SortPVS orders solid entries by, a DrawKey (DrawBatching.h) grouping by PSO, material and mesh before depth
+	FLEXKITAPI size_t GetPVSortingID	(const Drawable& drawable, const float3 cameraPosition);
+
 	FLEXKITAPI void SortPVS				(PVS* PVS_, Camera* C);
 	FLEXKITAPI void SortPVSTransparent	(PVS* PVS_, Camera* C);
 
@@ -0,0 +1,165 @@
+/**********************************************************************
+
+Copyright (c) 2015 - 2019 Robert May
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************/
+
+#include "DrawBatching.h"
+#include "..\coreutilities\Transforms.h"
+
+#include <string.h>
+
+namespace FlexKit
+{
+	/************************************************************************************************/
+
+
+	uint64_t QuantizeDrawDepth(const float distance)
+	{
+		const float normalized = distance > 0.0f ? (distance < DrawKey::MaxDepth ? distance / DrawKey::MaxDepth : 1.0f) : 0.0f;
+
+		return uint64_t(normalized * float(DrawKey::DepthMask));
+	}
+
+
+	/************************************************************************************************/
+
+
+	// float3 is padded out to 16 bytes and the struct has tail padding, so only the fields themselves are compared or hashed
+	static void GetMaterialFields(const Drawable& drawable, float (&out)[8])
+	{
+		const auto& material = drawable.MatProperties;
+
+		out[0] = material.albedo.x;
+		out[1] = material.albedo.y;
+		out[2] = material.albedo.z;
+		out[3] = material.kS;
+		out[4] = material.IOR;
+		out[5] = material.roughness;
+		out[6] = material.anisotropic;
+		out[7] = material.metallic;
+	}
+
+
+	uint64_t GetMaterialKey(const Drawable& drawable)
+	{
+		float fields[8];
+		GetMaterialFields(drawable, fields);
+
+		// FNV-1a over the material, folded down to the key's width
+		const auto*	bytes	= reinterpret_cast<const uint8_t*>(fields);
+		uint32_t	hash	= 2166136261u;
+
+		for (size_t I = 0; I < sizeof(fields); ++I)
+			hash = (hash ^ bytes[I]) * 16777619u;
+
+		return (hash ^ (hash >> DrawKey::MaterialBits)) & DrawKey::MaterialMask;
+	}
+
+
+	/************************************************************************************************/
+
+
+	uint64_t GetPSOKey(const Drawable& drawable)
+	{
+		return (drawable.Skinned ? 2 : 0) | (drawable.Textured ? 1 : 0);
+	}
+
+
+	/************************************************************************************************/
+
+
+	uint64_t CreateDrawKey(const Drawable& drawable, const float distance)
+	{
+		return DrawKey::Create(
+			drawable.Transparent ? DrawKey::Transparent : DrawKey::Opaque,
+			GetPSOKey(drawable),
+			GetMaterialKey(drawable),
+			drawable.MeshHandle.INDEX,
+			QuantizeDrawDepth(distance));
+	}
+
+
+	/************************************************************************************************/
+
+
+	uint64_t CreateTransparentDrawKey(const Drawable& drawable, const float distance)
+	{
+		// Non negative floats order the same as their bit patterns, inverted for furthest first
+		const float	clamped = distance > 0.0f ? distance : 0.0f;
+		uint32_t	distanceBits;
+		memcpy(&distanceBits, &clamped, sizeof(distanceBits));
+
+		return
+			DrawKey::Create(DrawKey::Transparent, 0, 0, 0, 0)	|
+			(drawable.DrawLast ? uint64_t(1) << 32 : 0)			|
+			uint64_t(~distanceBits);
+	}
+
+
+	/************************************************************************************************/
+
+
+	static bool CanInstanceTogether(const Drawable& lhs, const Drawable& rhs)
+	{
+		if (lhs.Skinned || rhs.Skinned || lhs.MeshHandle != rhs.MeshHandle || lhs.Textured != rhs.Textured)
+			return false;
+
+		// Keys only carry a material hash, confirm the material is really the same
+		float lhsFields[8];
+		float rhsFields[8];
+		GetMaterialFields(lhs, lhsFields);
+		GetMaterialFields(rhs, rhsFields);
+
+		return !memcmp(lhsFields, rhsFields, sizeof(lhsFields));
+	}
+
+
+	void BuildDrawBatches(const PVS& pvs, DrawBatchList& out, const size_t maxInstancesPerBatch)
+	{
+		out.clear();
+
+		if (!pvs.size())
+			return;
+
+		out.transforms.reserve(pvs.size());
+
+		DrawBatch* current = nullptr;
+
+		for (const auto& entry : pvs)
+		{
+			const Drawable& drawable = *entry.D;
+
+			if (!current ||
+				current->instanceCount >= maxInstancesPerBatch ||
+				!CanInstanceTogether(*current->drawable, drawable))
+			{
+				out.batches.push_back(DrawBatch{ &drawable, (uint32_t)out.transforms.size(), 0 });
+				current = &out.batches.back();
+			}
+
+			out.transforms.push_back(GetWT(drawable.Node).Transpose());
+			current->instanceCount++;
+		}
+	}
+
+
+}	/************************************************************************************************/
@@ -0,0 +1,144 @@
+/**********************************************************************
+
+Copyright (c) 2015 - 2019 Robert May
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************/
+
+#ifndef DRAWBATCHING_H_INCLUDED
+#define DRAWBATCHING_H_INCLUDED
+
+#include "..\buildsettings.h"
+#include "..\coreutilities\containers.h"
+#include "..\coreutilities\MathUtils.h"
+#include "..\graphicsutilities\CoreSceneObjects.h"
+
+namespace FlexKit
+{	/************************************************************************************************/
+
+
+	// 64 bit draw key, most significant field first, so sorting by key groups draws by pass, then
+	// pipeline state, then material and mesh, and only orders by depth within a run of identical draws.
+	//
+	//	| pass 4 | PSO 6 | material 20 | mesh 16 | depth 18 |
+
+	namespace DrawKey
+	{
+		constexpr uint64_t DepthBits	= 18;
+		constexpr uint64_t MeshBits		= 16;
+		constexpr uint64_t MaterialBits	= 20;
+		constexpr uint64_t PSOBits		= 6;
+		constexpr uint64_t PassBits		= 4;
+
+		constexpr uint64_t DepthShift		= 0;
+		constexpr uint64_t MeshShift		= DepthShift	+ DepthBits;
+		constexpr uint64_t MaterialShift	= MeshShift		+ MeshBits;
+		constexpr uint64_t PSOShift			= MaterialShift + MaterialBits;
+		constexpr uint64_t PassShift		= PSOShift		+ PSOBits;
+
+		static_assert(PassShift + PassBits == 64, "Draw key fields have to fill 64 bits");
+
+		constexpr uint64_t DepthMask	= (uint64_t(1) << DepthBits)	- 1;
+		constexpr uint64_t MeshMask		= (uint64_t(1) << MeshBits)		- 1;
+		constexpr uint64_t MaterialMask	= (uint64_t(1) << MaterialBits) - 1;
+		constexpr uint64_t PSOMask		= (uint64_t(1) << PSOBits)		- 1;
+		constexpr uint64_t PassMask		= (uint64_t(1) << PassBits)		- 1;
+
+		// Everything above depth, two draws with the same batch key can share an instanced draw
+		constexpr uint64_t BatchMask	= ~(DepthMask << DepthShift);
+
+		constexpr float MaxDepth = 4096.0f; // Distances past this all quantize to the last depth bucket
+
+		enum Pass : uint64_t
+		{
+			Opaque		= 0,
+			Transparent = 1,
+		};
+
+
+		inline uint64_t Create(const uint64_t pass, const uint64_t PSO, const uint64_t material, const uint64_t mesh, const uint64_t depth)
+		{
+			return
+				((pass		& PassMask)		<< PassShift)		|
+				((PSO		& PSOMask)		<< PSOShift)		|
+				((material	& MaterialMask)	<< MaterialShift)	|
+				((mesh		& MeshMask)		<< MeshShift)		|
+				((depth		& DepthMask)	<< DepthShift);
+		}
+
+		inline uint64_t GetPass		(const uint64_t key) { return (key >> PassShift)		& PassMask;		}
+		inline uint64_t GetPSO		(const uint64_t key) { return (key >> PSOShift)		& PSOMask;		}
+		inline uint64_t GetMaterial	(const uint64_t key) { return (key >> MaterialShift)	& MaterialMask; }
+		inline uint64_t GetMesh		(const uint64_t key) { return (key >> MeshShift)		& MeshMask;		}
+		inline uint64_t GetDepth	(const uint64_t key) { return (key >> DepthShift)		& DepthMask;	}
+	}
+
+
+	FLEXKITAPI uint64_t QuantizeDrawDepth	(const float distance);
+	FLEXKITAPI uint64_t GetMaterialKey		(const Drawable& drawable);
+	FLEXKITAPI uint64_t GetPSOKey			(const Drawable& drawable);
+	FLEXKITAPI uint64_t CreateDrawKey		(const Drawable& drawable, const float distance);
+
+	// Back to front with no state grouping, DrawLast entries after everything else. Ascending order, same as CreateDrawKey
+	FLEXKITAPI uint64_t CreateTransparentDrawKey(const Drawable& drawable, const float distance);
+
+
+	/************************************************************************************************/
+
+
+	// Limited by the size of the per instance constant buffer, shared with the skinned pose buffer
+	constexpr size_t MaxInstancesPerBatch = 128;
+
+
+	struct DrawBatch
+	{
+		const Drawable*	drawable;		// first drawable of the run, carries the batch's mesh and material
+		uint32_t		firstInstance;	// offset into DrawBatchList::transforms
+		uint32_t		instanceCount;
+	};
+
+
+	struct DrawBatchList
+	{
+		DrawBatchList(iAllocator* allocator) :
+			batches		{ allocator },
+			transforms	{ allocator } {}
+
+		void clear()
+		{
+			batches.clear();
+			transforms.clear();
+		}
+
+		size_t size() const { return batches.size(); }
+
+		Vector<DrawBatch>	batches;
+		Vector<float4x4>	transforms; // transposed world transforms, contiguous per batch, same layout as Drawable::GetConstants
+	};
+
+
+	// Collapses runs of draws with the same mesh and material in a sorted PVS into instanced batches.
+	// Skinned drawables are never merged, they need their own pose buffer.
+	FLEXKITAPI void BuildDrawBatches(const PVS& pvs, DrawBatchList& out, const size_t maxInstancesPerBatch = MaxInstancesPerBatch);
+
+
+}	/************************************************************************************************/
+
+#endif
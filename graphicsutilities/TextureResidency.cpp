@@ -0,0 +1,473 @@
+/**********************************************************************
+
+Copyright (c) 2015 - 2019 Robert May
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************/
+
+#include "TextureResidency.h"
+
+#include <algorithm>
+
+namespace FlexKit
+{	/************************************************************************************************/
+
+
+	TileResidencyManager::TileResidencyManager(const TileResidencyDesc& IN_desc, iAllocator* IN_allocator) :
+		tiles		{ IN_allocator	},
+		slots		{ IN_allocator	},
+		freeSlots	{ IN_allocator	},
+		desc		{ IN_desc		},
+		allocator	{ IN_allocator	}
+	{
+		tiles.reserve(desc.slotCount);
+		slots.resize(desc.slotCount);
+		freeSlots.reserve(desc.slotCount);
+
+		// Handed out from the back, lowest slots first
+		for (uint32_t I = desc.slotCount; I > 0; --I)
+			freeSlots.push_back(I - 1);
+	}
+
+
+	TileResidencyManager::~TileResidencyManager()
+	{
+		tiles.Release();
+		slots.Release();
+		freeSlots.Release();
+	}
+
+
+	/************************************************************************************************/
+
+
+	TileResidencyUpdate TileResidencyManager::Update(const uint64_t* begin, const uint64_t* end, iAllocator* temp)
+	{
+		updateIdx++;
+
+		TileResidencyUpdate out{ Vector<TileResidencyChange>{ temp }, Vector<TileResidencyChange>{ temp } };
+
+		Vector<uint64_t> requests{ temp };
+		requests.reserve(end - begin);
+
+		for (auto itr = begin; itr < end; ++itr)
+			requests.push_back(*itr);
+
+		std::sort(requests.begin(), requests.end());
+
+		struct Miss
+		{
+			uint64_t key;
+			uint32_t count;
+		};
+
+		Vector<Miss> misses{ temp };
+
+		for (size_t I = 0; I < requests.size();)
+		{
+			const uint64_t	key		= requests[I];
+			uint32_t		count	= 0;
+
+			for (; I < requests.size() && requests[I] == key; ++I)
+				count++;
+
+			if (const auto slot = _Find(key); slot != InvalidSlot)
+			{
+				slots[slot].lastRequested	 = updateIdx;
+				slots[slot].requestCount	+= count;
+
+				_Unlink(slot);
+				_PushNewest(slot);
+
+				stats.hits++;
+			}
+			else
+			{
+				misses.push_back({ key, count });
+				stats.misses++;
+			}
+		}
+
+		if (!misses.size())
+			return out;
+
+		// Coarse mips first, they cover the most and are what finer tiles fall back to while missing
+		std::sort(
+			misses.begin(),
+			misses.end(),
+			[](const Miss& lhs, const Miss& rhs)
+			{
+				const auto lhsMip = GetTileKeyMipInverted(lhs.key);
+				const auto rhsMip = GetTileKeyMipInverted(rhs.key);
+
+				if (lhsMip != rhsMip)
+					return lhsMip < rhsMip;
+
+				return lhs.count != rhs.count ? lhs.count > rhs.count : lhs.key < rhs.key;
+			});
+
+		const size_t uploadLimit	= std::max(desc.uploadBudget / std::max(desc.tileSize, size_t(1)), size_t(1));
+		const size_t uploadCount	= std::min(misses.size(), uploadLimit);
+		const size_t victimCount	= uploadCount > freeSlots.size() ? uploadCount - freeSlots.size() : 0;
+
+		// Only the oldest tiles are candidates. The list is in request order, so taking whole runs of one
+		// lastRequested until there are enough leaves the same victims as ordering every cold tile would.
+		Vector<uint32_t> victims{ temp };
+
+		for (auto slot = oldestSlot; slot != InvalidSlot; slot = slots[slot].newer)
+		{
+			const auto& tile = slots[slot];
+
+			if (updateIdx - tile.lastRequested <= desc.hysteresisUpdates)
+				break;
+
+			if (victims.size() >= victimCount && (!victims.size() || slots[victims.back()].lastRequested != tile.lastRequested))
+				break;
+
+			victims.push_back(slot);
+		}
+
+		// Least recently requested first, then finer mips, then the least requested, then by key so ties don't depend on list order
+		std::sort(
+			victims.begin(),
+			victims.end(),
+			[&](const uint32_t lhsSlot, const uint32_t rhsSlot)
+			{
+				const auto& lhs = slots[lhsSlot];
+				const auto& rhs = slots[rhsSlot];
+
+				if (lhs.lastRequested != rhs.lastRequested)
+					return lhs.lastRequested < rhs.lastRequested;
+
+				const auto lhsMip = GetTileKeyMipInverted(lhs.key);
+				const auto rhsMip = GetTileKeyMipInverted(rhs.key);
+
+				if (lhsMip != rhsMip)
+					return lhsMip > rhsMip;
+
+				return lhs.requestCount != rhs.requestCount ? lhs.requestCount < rhs.requestCount : lhs.key < rhs.key;
+			});
+
+		size_t nextVictim = 0;
+
+		Vector<TileEntry> added{ temp };
+		added.reserve(uploadCount);
+
+		for (const auto& miss : misses)
+		{
+			if (out.uploads.size() >= uploadLimit)
+				break;
+
+			uint32_t slot;
+
+			if (freeSlots.size())
+				slot = freeSlots.pop_back();
+			else if (nextVictim < victims.size())
+			{
+				slot = victims[nextVictim++];
+				out.evictions.push_back({ slots[slot].key, slot });
+
+				_Unlink(slot);
+			}
+			else
+				break; // Everything resident is still in use
+
+			slots[slot].key				= miss.key;
+			slots[slot].lastRequested	= updateIdx;
+			slots[slot].requestCount	= miss.count;
+			_PushNewest(slot);
+
+			out.uploads.push_back({ miss.key, slot });
+			added.push_back({ miss.key, slot });
+		}
+
+		stats.uploads		+= out.uploads.size();
+		stats.uploadedBytes	+= out.uploads.size() * desc.tileSize;
+		stats.evictions		+= out.evictions.size();
+		stats.deferred		+= misses.size() - out.uploads.size();
+
+		if (out.evictions.size())
+		{
+			Vector<uint64_t> evicted{ temp };
+			evicted.reserve(out.evictions.size());
+
+			for (auto& eviction : out.evictions)
+				evicted.push_back(eviction.key);
+
+			std::sort(evicted.begin(), evicted.end());
+
+			// Both sorted, one pass drops every evicted tile
+			size_t remaining	= 0;
+			size_t evictedItr	= 0;
+
+			for (size_t I = 0; I < tiles.size(); ++I)
+			{
+				while (evictedItr < evicted.size() && evicted[evictedItr] < tiles[I].key)
+					evictedItr++;
+
+				if (evictedItr < evicted.size() && evicted[evictedItr] == tiles[I].key)
+					continue;
+
+				tiles[remaining++] = tiles[I];
+			}
+
+			tiles.resize(remaining);
+		}
+
+		// Misses were never resident, merge them in from the back so nothing is moved twice
+		std::sort(
+			added.begin(),
+			added.end(),
+			[](const TileEntry& lhs, const TileEntry& rhs)
+			{
+				return lhs.key < rhs.key;
+			});
+
+		size_t lhs = tiles.size();
+		size_t rhs = added.size();
+
+		tiles.resize(tiles.size() + added.size());
+
+		for (size_t dst = tiles.size(); rhs;)
+		{
+			if (lhs && tiles[lhs - 1].key > added[rhs - 1].key)
+				tiles[--dst] = tiles[--lhs];
+			else
+				tiles[--dst] = added[--rhs];
+		}
+
+		return out;
+	}
+
+
+	/************************************************************************************************/
+
+
+	bool TileResidencyManager::IsResident(const uint64_t key) const
+	{
+		return _Find(key) != InvalidSlot;
+	}
+
+
+	uint32_t TileResidencyManager::_Find(const uint64_t key) const
+	{
+		auto res = std::lower_bound(
+			tiles.begin(),
+			tiles.end(),
+			key,
+			[](const TileEntry& lhs, const uint64_t rhs)
+			{
+				return lhs.key < rhs;
+			});
+
+		return (res != tiles.end() && res->key == key) ? res->slot : InvalidSlot;
+	}
+
+
+	void TileResidencyManager::_Unlink(const uint32_t slot)
+	{
+		auto& tile = slots[slot];
+
+		if (tile.newer != InvalidSlot)
+			slots[tile.newer].older = tile.older;
+		else
+			newestSlot = tile.older;
+
+		if (tile.older != InvalidSlot)
+			slots[tile.older].newer = tile.newer;
+		else
+			oldestSlot = tile.newer;
+
+		tile.newer = InvalidSlot;
+		tile.older = InvalidSlot;
+	}
+
+
+	void TileResidencyManager::_PushNewest(const uint32_t slot)
+	{
+		auto& tile = slots[slot];
+
+		tile.newer = InvalidSlot;
+		tile.older = newestSlot;
+
+		if (newestSlot != InvalidSlot)
+			slots[newestSlot].newer = slot;
+		else
+			oldestSlot = slot;
+
+		newestSlot = slot;
+	}
+
+
+	/************************************************************************************************/
+
+
+	DecodedTileCache::DecodedTileCache(const size_t IN_tileCount, const size_t IN_tileSize, iAllocator* IN_allocator) :
+		entries		{ IN_allocator	},
+		buckets		{ IN_allocator	},
+		tileCount	{ IN_tileCount	},
+		tileSize	{ IN_tileSize	},
+		allocator	{ IN_allocator	}
+	{
+		size_t bucketCount = 16;
+		while (bucketCount < 2 * tileCount)
+			bucketCount *= 2;
+
+		entries.reserve(tileCount);
+		buckets.resize(bucketCount);
+
+		for (auto& bucket : buckets)
+			bucket = InvalidEntry;
+	}
+
+
+	DecodedTileCache::~DecodedTileCache()
+	{
+		for (auto& entry : entries)
+			allocator->free(entry.buffer);
+
+		entries.Release();
+		buckets.Release();
+	}
+
+
+	/************************************************************************************************/
+
+
+	const char* DecodedTileCache::Find(const TileCacheKey& key)
+	{
+		const auto idx = _FindEntry(key);
+
+		if (idx == InvalidEntry)
+			return nullptr;
+
+		_Unlink(idx);
+		_PushFront(idx);
+
+		return entries[idx].buffer;
+	}
+
+
+	char* DecodedTileCache::Insert(const TileCacheKey& key)
+	{
+		uint32_t idx = _FindEntry(key);
+
+		if (idx != InvalidEntry)
+			_Unlink(idx);
+		else if (entries.size() < tileCount)
+		{
+			idx = (uint32_t)entries.push_back(Entry{ key, (char*)allocator->malloc(tileSize), InvalidEntry, InvalidEntry, InvalidEntry });
+
+			auto bucket = _GetBucket(key);
+			entries[idx].nextInBucket	= *bucket;
+			*bucket						= idx;
+		}
+		else
+		{
+			idx = leastRecent;
+
+			_RemoveFromBucket(idx);
+			_Unlink(idx);
+
+			auto bucket = _GetBucket(key);
+			entries[idx].key			= key;
+			entries[idx].nextInBucket	= *bucket;
+			*bucket						= idx;
+		}
+
+		_PushFront(idx);
+
+		return entries[idx].buffer;
+	}
+
+
+	/************************************************************************************************/
+
+
+	uint32_t* DecodedTileCache::_GetBucket(const TileCacheKey& key)
+	{
+		uint64_t h = key.asset ^ (uint64_t(key.mipLevel) << 32 | key.tile) * 0x9e3779b97f4a7c15ull;
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdull;
+		h ^= h >> 33;
+
+		return &buckets[size_t(h) & (buckets.size() - 1)];
+	}
+
+
+	uint32_t DecodedTileCache::_FindEntry(const TileCacheKey& key)
+	{
+		for (auto idx = *_GetBucket(key); idx != InvalidEntry; idx = entries[idx].nextInBucket)
+		{
+			if (entries[idx].key == key)
+				return idx;
+		}
+
+		return InvalidEntry;
+	}
+
+
+	void DecodedTileCache::_RemoveFromBucket(const uint32_t idx)
+	{
+		auto itr = _GetBucket(entries[idx].key);
+
+		while (*itr != idx)
+			itr = &entries[*itr].nextInBucket;
+
+		*itr = entries[idx].nextInBucket;
+	}
+
+
+	void DecodedTileCache::_Unlink(const uint32_t idx)
+	{
+		auto& entry = entries[idx];
+
+		if (entry.newer != InvalidEntry)
+			entries[entry.newer].older = entry.older;
+		else
+			mostRecent = entry.older;
+
+		if (entry.older != InvalidEntry)
+			entries[entry.older].newer = entry.newer;
+		else
+			leastRecent = entry.newer;
+
+		entry.newer = InvalidEntry;
+		entry.older = InvalidEntry;
+	}
+
+
+	void DecodedTileCache::_PushFront(const uint32_t idx)
+	{
+		auto& entry = entries[idx];
+
+		entry.newer = InvalidEntry;
+		entry.older = mostRecent;
+
+		if (mostRecent != InvalidEntry)
+			entries[mostRecent].newer = idx;
+		else
+			leastRecent = idx;
+
+		mostRecent = idx;
+	}
+
+
+}	/************************************************************************************************/
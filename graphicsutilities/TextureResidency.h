@@ -0,0 +1,210 @@
+/**********************************************************************
+
+Copyright (c) 2015 - 2019 Robert May
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************/
+
+#ifndef TEXTURERESIDENCY_H_INCLUDED
+#define TEXTURERESIDENCY_H_INCLUDED
+
+#include "..\buildsettings.h"
+#include "..\coreutilities\containers.h"
+
+// Decides which streamed texture tiles live in the tile heap. Feedback comes in as 64 bit tile keys, the
+// texture in the high 32 bits and the packed TileID_t in the low, duplicates counting as extra screen
+// coverage. Requests are served coarsest mip first then most requested, limited by an upload budget per
+// update. Room is made by evicting the least recently requested tiles, but never ones requested within
+// the last few updates, so two working sets slightly bigger than the heap don't evict each other every
+// update. CPU only, the streaming engine turns the results into tile mappings and copies.
+
+namespace FlexKit
+{	/************************************************************************************************/
+
+
+	inline uint64_t CreateTileKey(const uint32_t texture, const uint32_t tileID)
+	{
+		return (uint64_t(texture) << 32) | tileID;
+	}
+
+	inline uint32_t GetTileKeyTexture	(const uint64_t key) { return uint32_t(key >> 32); }
+	inline uint32_t GetTileKeyTileID	(const uint64_t key) { return uint32_t(key); }
+
+	// Mips are stored inverted in the tile ID, the coarsest levels have the lowest values
+	inline uint32_t GetTileKeyMipInverted(const uint64_t key) { return uint32_t(key >> 24) & 0xff; }
+
+
+	/************************************************************************************************/
+
+
+	struct TileResidencyDesc
+	{
+		uint32_t	slotCount;							// tiles the heap holds
+		size_t		tileSize			= 64 * KILOBYTE;
+		size_t		uploadBudget		= 4 * MEGABYTE;	// per update, requests past it wait for the next
+		uint32_t	hysteresisUpdates	= 8;			// tiles requested within this many updates are not evicted
+	};
+
+
+	struct TileResidencyChange
+	{
+		uint64_t	key;
+		uint32_t	slot;
+	};
+
+
+	struct TileResidencyUpdate
+	{
+		Vector<TileResidencyChange>	evictions;	// tiles whose slots were taken for this update's uploads
+		Vector<TileResidencyChange>	uploads;	// tiles to copy into their slot
+	};
+
+
+	struct TileResidencyStats
+	{
+		size_t hits				= 0;	// requests already resident
+		size_t misses			= 0;	// requests that were not
+		size_t uploads			= 0;
+		size_t uploadedBytes	= 0;
+		size_t evictions		= 0;
+		size_t deferred			= 0;	// misses left for a later update, over budget or nothing evictable
+	};
+
+
+	class FLEXKITAPI TileResidencyManager
+	{
+	public:
+		TileResidencyManager(const TileResidencyDesc& IN_desc, iAllocator* IN_allocator);
+		~TileResidencyManager();
+
+		TileResidencyManager				(const TileResidencyManager&) = delete;
+		TileResidencyManager& operator =	(const TileResidencyManager&) = delete;
+
+		// One update's feedback, in any order. Results are allocated from temp.
+		TileResidencyUpdate Update(const uint64_t* begin, const uint64_t* end, iAllocator* temp);
+
+		bool	IsResident			(const uint64_t key) const;
+		size_t	GetResidentCount	() const { return tiles.size(); }
+		size_t	GetFreeSlotCount	() const { return freeSlots.size(); }
+
+		uint64_t					GetUpdateIndex	() const { return updateIdx; }
+		const TileResidencyStats&	GetStats		() const { return stats; }
+		void						ResetStats		() { stats = {}; }
+
+	private:
+		static constexpr uint32_t InvalidSlot = 0xffffffff;
+
+		// Per heap slot, resident slots are linked in request order so eviction candidates come off the old end
+		struct ResidentTile
+		{
+			uint64_t	key;
+			uint64_t	lastRequested;	// update index
+			uint32_t	requestCount;	// summed over every update it was requested in
+			uint32_t	newer;			// towards newestSlot
+			uint32_t	older;			// towards oldestSlot
+		};
+
+		struct TileEntry
+		{
+			uint64_t	key;
+			uint32_t	slot;
+		};
+
+		uint32_t	_Find		(const uint64_t key) const; // InvalidSlot when not resident
+		void		_Unlink		(const uint32_t slot);
+		void		_PushNewest	(const uint32_t slot);
+
+		Vector<TileEntry>		tiles;		// sorted by key
+		Vector<ResidentTile>	slots;
+		uint32_t				oldestSlot = InvalidSlot;
+		uint32_t				newestSlot = InvalidSlot;
+		Vector<uint32_t>		freeSlots;
+		uint64_t				updateIdx = 0;
+		TileResidencyStats		stats;
+
+		const TileResidencyDesc	desc;
+		iAllocator*				allocator;
+	};
+
+
+	/************************************************************************************************/
+
+
+	struct TileCacheKey
+	{
+		GUID_t		asset;
+		uint32_t	mipLevel;
+		uint32_t	tile; // x and y, as packed in TileID_t
+
+		bool operator == (const TileCacheKey& rhs) const
+		{
+			return asset == rhs.asset && mipLevel == rhs.mipLevel && tile == rhs.tile;
+		}
+	};
+
+
+	// Fixed number of decoded tiles, the least recently used is recycled once full.
+	// Tiles are found through a chained hash and kept on a list in use order, so Find and Insert are constant time.
+	class FLEXKITAPI DecodedTileCache
+	{
+	public:
+		DecodedTileCache(const size_t IN_tileCount, const size_t IN_tileSize, iAllocator* IN_allocator);
+		~DecodedTileCache();
+
+		DecodedTileCache				(const DecodedTileCache&) = delete;
+		DecodedTileCache& operator =	(const DecodedTileCache&) = delete;
+
+		const char*	Find	(const TileCacheKey& key);
+		char*		Insert	(const TileCacheKey& key); // Returns the tile's buffer to fill
+
+		size_t GetTileSize	() const { return tileSize; }
+		size_t size			() const { return entries.size(); }
+
+	private:
+		static constexpr uint32_t InvalidEntry = 0xffffffff;
+
+		struct Entry
+		{
+			TileCacheKey	key;
+			char*			buffer;
+			uint32_t		nextInBucket;
+			uint32_t		newer;	// towards mostRecent
+			uint32_t		older;	// towards leastRecent
+		};
+
+		uint32_t*	_GetBucket		(const TileCacheKey& key);
+		uint32_t	_FindEntry		(const TileCacheKey& key);
+		void		_RemoveFromBucket	(const uint32_t idx);
+		void		_Unlink			(const uint32_t idx);
+		void		_PushFront		(const uint32_t idx);
+
+		Vector<Entry>		entries;
+		Vector<uint32_t>	buckets;
+		uint32_t			mostRecent	= InvalidEntry;
+		uint32_t			leastRecent	= InvalidEntry;
+		const size_t		tileCount;
+		const size_t		tileSize;
+		iAllocator*			allocator;
+	};
+
+
+}	/************************************************************************************************/
+
+#endif
@@ -6,27 +6,28 @@ namespace FlexKit
 {   /************************************************************************************************/
 
 
-    CRNDecompressor::CRNDecompressor(const uint32_t mipLevel, AssetHandle asset, iAllocator* IN_allocator) : allocator{ IN_allocator }
+    CRNDecompressor::CRNDecompressor(const GUID_t IN_guid, AssetHandle IN_asset, const crnd::crn_texture_info& IN_info, DecodedTileCache& IN_tileCache, DecodedCRNLevel& IN_level, iAllocator* IN_allocator) :
+        guid        { IN_guid       },
+        asset       { IN_asset      },
+        info        { IN_info       },
+        tileCache   { IN_tileCache  },
+        level       { IN_level      },
+        allocator   { IN_allocator  }
     {
         TextureResourceBlob* resource = reinterpret_cast<TextureResourceBlob*>(FlexKit::GetAsset(asset));
 
-        crnd::crn_level_info levelInfo;
-        crnd::crnd_get_level_info(resource->GetBuffer(), resource->GetBufferSize(), 0, &levelInfo);
-
-        rowPitch = levelInfo.m_blocks_x * levelInfo.m_bytes_per_block;
-        bufferSize = levelInfo.m_blocks_y * rowPitch;
+        crnData = resource->GetBuffer();
+        crnSize = resource->GetBufferSize();
+        context = crnd::crnd_unpack_begin(crnData, (crnd::uint32)crnSize);
+    }
 
-        blockSize   = levelInfo.m_bytes_per_block;
-        blocks_X    = levelInfo.m_blocks_x;
-        blocks_Y    = levelInfo.m_blocks_y;
 
-        buffer = (char*)allocator->malloc(bufferSize);
+    /************************************************************************************************/
 
-        void* data[1] = { (void*)buffer};
 
-        crnd::crnd_unpack_context crn_context = crnd::crnd_unpack_begin(resource->GetBuffer(), resource->GetBufferSize());
-        auto res = crnd::crnd_unpack_level(crn_context, data, bufferSize, rowPitch, 0);
-        crnd::crnd_unpack_end(crn_context);
+    CRNDecompressor::~CRNDecompressor()
+    {
+        crnd::crnd_unpack_end(context);
 
         FreeAsset(asset);
     }
@@ -35,9 +36,41 @@ namespace FlexKit
     /************************************************************************************************/
 
 
-    CRNDecompressor::~CRNDecompressor()
+    bool CRNDecompressor::DecodeLevel(const uint32_t mipLevel)
     {
-        allocator->free(buffer);
+        if (level.asset == guid && level.mipLevel == mipLevel)
+            return true;
+
+        crnd::crn_level_info levelInfo;
+        if (!context || !crnd::crnd_get_level_info(crnData, (crnd::uint32)crnSize, mipLevel, &levelInfo))
+            return false;
+
+        const size_t rowPitch   = levelInfo.m_blocks_x * levelInfo.m_bytes_per_block;
+        const size_t levelSize  = levelInfo.m_blocks_y * rowPitch;
+
+        if (levelSize > level.bufferSize)
+        {
+            if (level.buffer)
+                allocator->free(level.buffer);
+
+            level.buffer        = (char*)allocator->malloc(levelSize);
+            level.bufferSize    = levelSize;
+        }
+
+        level.asset = INVALIDHANDLE; // Whatever was in the buffer is gone if unpacking fails
+
+        void* data[1] = { (void*)level.buffer };
+
+        if (!crnd::crnd_unpack_level(context, data, (crnd::uint32)levelSize, (crnd::uint32)rowPitch, mipLevel))
+            return false;
+
+        level.asset     = guid;
+        level.mipLevel  = mipLevel;
+        level.blocksX   = levelInfo.m_blocks_x;
+        level.blocksY   = levelInfo.m_blocks_y;
+        level.rowPitch  = rowPitch;
+
+        return true;
     }
 
 
@@ -46,19 +79,49 @@ namespace FlexKit
 
     UploadReservation CRNDecompressor::ReadTile(const TileID_t id, const uint2 TileSize, CopyContext& ctx)
     {
-        const auto reservation    = ctx.Reserve(64 * KILOBYTE);
-        const auto blocksX        = TileSize[0] / 4;
-        const auto blocksY        = TileSize[1] / 4;
-        const auto localRowPitch  = blockSize * blocksX;
+        const auto reservation  = ctx.Reserve(64 * KILOBYTE);
+        const auto tileSize     = tileCache.GetTileSize();
+        const auto mipLevel     = std::min(id.GetMipLevel(info.m_levels), info.m_levels - 1);
+        const auto key          = TileCacheKey{ guid, mipLevel, id.bytes & 0x00ffffff };
+
+        if (auto cached = tileCache.Find(key); cached)
+        {
+            memcpy(reservation.buffer, cached, tileSize);
+            return reservation;
+        }
+
+        if (!DecodeLevel(mipLevel))
+        {
+            memset(reservation.buffer, 0, tileSize);
+            return reservation;
+        }
 
-        const auto tileX = id.GetTileX();
-        const auto tileY = id.GetTileY();
+        const size_t blockSize      = info.m_bytes_per_block;
+        const size_t blocksX        = TileSize[0] / 4;
+        const size_t blocksY        = TileSize[1] / 4;
+        const size_t localRowPitch  = blockSize * blocksX;
+        const size_t firstX         = id.GetTileX() * blocksX;
+        const size_t firstY         = id.GetTileY() * blocksY;
 
-        for (size_t row = 0; row < blocksY; ++row)
-            memcpy(
-                reservation.buffer + row * localRowPitch,
-                buffer + row * rowPitch + tileX * localRowPitch + rowPitch * blocksY * tileY,
-                localRowPitch);
+        FK_ASSERT(localRowPitch * blocksY <= tileSize);
+
+        char* tile = tileCache.Insert(key);
+        memset(tile, 0, tileSize);
+
+        // Tiles hanging off the edge of small levels are left zeroed past it
+        if (firstX < level.blocksX && firstY < level.blocksY)
+        {
+            const size_t rowSize    = std::min(blocksX, level.blocksX - firstX) * blockSize;
+            const size_t rowCount   = std::min(blocksY, level.blocksY - firstY);
+
+            for (size_t row = 0; row < rowCount; ++row)
+                memcpy(
+                    tile + row * localRowPitch,
+                    level.buffer + (firstY + row) * level.rowPitch + firstX * blockSize,
+                    rowSize);
+        }
+
+        memcpy(reservation.buffer, tile, tileSize);
 
         return reservation;
     }
@@ -67,40 +130,81 @@ namespace FlexKit
     /************************************************************************************************/
 
 
-    std::optional<CRNDecompressor*> CreateCRNDecompressor(const uint32_t MIPlevel, AssetHandle asset, iAllocator* allocator)
+    std::optional<CRNDecompressor*> CreateCRNDecompressor(const GUID_t guid, DecodedTileCache& tileCache, DecodedCRNLevel& level, iAllocator* allocator)
     {
-        TextureResourceBlob* resource   = reinterpret_cast<TextureResourceBlob*>(FlexKit::GetAsset(asset));
-        auto buffer                     = resource->GetBuffer();
-        const auto bufferSize           = resource->GetBufferSize();
-       
-        EXITSCOPE(FreeAsset(asset));
+        FK_ALLOCATION_TAG("Texture Streaming");
 
-        crnd::crn_texture_info info;
-        if (crnd::crnd_get_texture_info(buffer, resource->GetBufferSize(), &info))
-        {
-            crnd::crn_level_info levelInfo;
+        const auto asset = LoadGameAsset(guid);
 
-            if (!crnd::crnd_get_level_info(buffer, bufferSize, 0, &levelInfo))
-                return {};
+        if (asset == INVALIDHANDLE)
+            return {};
 
-            return &allocator->allocate<CRNDecompressor>(MIPlevel, asset, allocator);
-        }
-        else
+        TextureResourceBlob* resource = reinterpret_cast<TextureResourceBlob*>(FlexKit::GetAsset(asset));
+        EXITSCOPE(FreeAsset(asset)); // The decompressor takes its own reference
+
+        crnd::crn_texture_info info;
+
+        if (!resource ||
+            !IsDDS((DeviceFormat)resource->format) ||
+            !crnd::crnd_get_texture_info(resource->GetBuffer(), (crnd::uint32)resource->GetBufferSize(), &info))
             return {};
+
+        return &allocator->allocate<CRNDecompressor>(guid, asset, info, tileCache, level, allocator);
     }
 
 
     /************************************************************************************************/
 
 
-    TextureBlockAllocator::TextureBlockAllocator(const size_t blockCount, iAllocator* IN_allocator) :
-        blockTable      { IN_allocator },
-        allocator       { IN_allocator }
+    TextureBlockAllocator::TextureBlockAllocator(const TextureCacheDesc& desc, iAllocator* IN_allocator) :
+        residency   {
+            TileResidencyDesc{
+                .slotCount          = (uint32_t)(desc.textureCacheSize / desc.blockSize),
+                .tileSize           = desc.blockSize,
+                .uploadBudget       = desc.uploadBudget,
+                .hysteresisUpdates  = desc.hysteresisUpdates },
+            IN_allocator },
+        blockSize   { desc.blockSize } {}
+
+
+    /************************************************************************************************/
+
+
+    BlockAllocation TextureBlockAllocator::UpdateResidency(const gpuTileID* begin, const gpuTileID* end, iAllocator* temp)
     {
-        blockTable.reserve(blockCount);
+        Vector<uint64_t> requests{ temp };
+        requests.reserve(end - begin);
+
+        for (auto itr = begin; itr < end; ++itr)
+            requests.push_back(itr->GetSortingID());
+
+        const auto update = residency.Update(requests.begin(), requests.end(), temp);
+
+        const auto CreateBlock =
+            [&](const TileResidencyChange& change)
+            {
+                return AllocatedBlock{
+                    .tileID     = TileID_t{ GetTileKeyTileID(change.key) },
+                    .resource   = ResourceHandle{ GetTileKeyTexture(change.key) },
+                    .offset     = (uint32_t)(change.slot * blockSize),
+                    .tileIdx    = change.slot };
+            };
+
+        AllocatedBlockList reallocatedBlocks{ temp };
+        AllocatedBlockList allocatedBlocks  { temp };
+
+        reallocatedBlocks.reserve(update.evictions.size());
+        allocatedBlocks.reserve(update.uploads.size());
+
+        for (auto& eviction : update.evictions)
+            reallocatedBlocks.push_back(CreateBlock(eviction));
 
-        for (size_t I = 0; I < blockCount; ++I)
-            blockTable.emplace_back(Block{ (uint32_t)-1, InvalidHandle_t, 0, (uint32_t)I });
+        for (auto& upload : update.uploads)
+            allocatedBlocks.push_back(CreateBlock(upload));
+
+        return {
+            std::move(reallocatedBlocks),
+            std::move(allocatedBlocks) };
     }
 
 
@@ -354,26 +458,8 @@ namespace FlexKit
         if (!requests || !requestCount)
             return;
 
-        const auto lg_comparitor = [](const gpuTileID lhs, const gpuTileID rhs) -> bool
-        {
-            return lhs.GetSortingID() < rhs.GetSortingID();
-        };
-
-        const auto eq_comparitor = [](const gpuTileID lhs, const gpuTileID rhs) -> bool
-        {
-            return lhs.GetSortingID() == rhs.GetSortingID();
-        };
-
-        std::sort(
-            requests,
-            requests + requestCount,
-            lg_comparitor);
-
-        const auto end            = std::unique(requests, requests + requestCount, eq_comparitor);
-        const auto uniqueCount    = (size_t)(end - requests);
-
-        const auto stateUpdateRes     = textureStreamEngine.UpdateTileStates(requests, requests + uniqueCount, allocator);
-        const auto blockAllocations   = textureStreamEngine.AllocateTiles(stateUpdateRes.begin(), stateUpdateRes.end());
+        // Not deduplicated, how often a tile shows up in the feedback is its screen coverage
+        const auto blockAllocations = textureStreamEngine.UpdateTileResidency(requests, requests + requestCount);
 
         textureStreamEngine.PostUpdatedTiles(blockAllocations);
     }
@@ -441,7 +527,6 @@ namespace FlexKit
 
         Vector<ResourceHandle>  updatedTextures = { allocator };
         ResourceHandle          prevResource    = InvalidHandle_t;
-        TextureStreamContext    streamContext   = { allocator };
         uint2                   blockSize       = { 256, 256 };
         TileMapList             mappings        = { allocator };
 
@@ -521,7 +606,7 @@ namespace FlexKit
             if (!asset) // Skipped unmapped blocks
                 continue;
 
-            if (!streamContext.Open(block.tileID.GetMipLevel(0), asset.value()))
+            if (!streamContext.Open(asset.value()))
                 continue;
 
             const auto deviceResource   = renderSystem.GetDeviceResource(block.resource);
@@ -533,13 +618,22 @@ namespace FlexKit
                     resourceState,
                     DeviceResourceState::DRS_Write);
 
-            const auto blocks = filter(
+            auto blocks = filter(
                 blockChanges.allocations,
                 [&](auto& block)
                 {
                     return block.resource == resource;
                 });
 
+            // Grouped by level so each level is unpacked at most once
+            std::sort(
+                std::begin(blocks),
+                std::end(blocks),
+                [](auto& lhs, auto& rhs)
+                {
+                    return lhs.tileID.GetMipLevelInverted() < rhs.tileID.GetMipLevelInverted();
+                });
+
             TileMapList mappings{ allocator };
             for (const AllocatedBlock& block : blocks)
             {
@@ -588,130 +682,9 @@ namespace FlexKit
     /************************************************************************************************/
 
 
-    Vector<gpuTileID> TextureBlockAllocator::UpdateTileStates(const gpuTileID* begin, const gpuTileID* end, iAllocator* allocator)
-    {
-        auto pred = [](const auto& lhs, const auto& rhs)
-        {
-            return lhs.tileID < rhs.tileID;
-        };
-
-        std::sort(blockTable.begin(), blockTable.end(), pred);
-
-        for (auto& blockState : blockTable)
-            if(blockState.state != EBlockState::Free) blockState.state = EBlockState::Stale;
-
-        auto I                  = begin;
-        size_t stateIterator    = 0;
-
-        Vector<gpuTileID> allocationsNeeded{ allocator };
-
-        std::for_each(begin, end,
-            [&](const gpuTileID tile)
-            {
-                auto res = std::lower_bound(
-                    blockTable.begin(), blockTable.end(), tile,
-                    [&](auto lhs, auto rhs)
-                    {
-                        return lhs < rhs;
-                    });
-
-                if (res != std::end(blockTable) && res->tileID == tile.tileID && res->resource == tile.TextureID)
-                    res->state = EBlockState::InUse;
-                else
-                    allocationsNeeded.push_back(tile);
-            });
-
-        return allocationsNeeded;
-    }
-
-
-    /************************************************************************************************/
-
-
-    BlockAllocation TextureBlockAllocator::AllocateBlocks(const gpuTileID* begin, const gpuTileID* end, iAllocator* allocator)
-    {
-        AllocatedBlockList allocatedBlocks  { allocator };
-        AllocatedBlockList reallocatedBlocks{ allocator };
-
-        allocatedBlocks.reserve(blockTable.size());
-        reallocatedBlocks.reserve(blockTable.size());
-
-        uint32_t            itr        = 0;
-        const auto          blockCount = blockTable.size();
-        const gpuTileID*    block_itr  = begin;
-
-        while (block_itr < end)
-        {
-            while (itr < blockCount)
-            {
-                const auto idx = (last + itr) % blockCount;
-
-                if (blockTable[idx].state != EBlockState::InUse ||
-                    blockTable[idx].tileID.GetMipLevelInverted() > block_itr->tileID.GetMipLevelInverted())
-                {
-                    if (blockTable[idx].resource != InvalidHandle_t &&
-                        (blockTable[idx].state == EBlockState::Stale ||
-                         blockTable[idx].tileID.GetMipLevelInverted() > block_itr->tileID.GetMipLevelInverted()))
-                    {
-                        reallocatedBlocks.push_back({
-                            .tileID     = blockTable[idx].tileID,
-                            .resource   = blockTable[idx].resource,
-                            .offset     = blockTable[idx].blockID * 64 * KILOBYTE,
-                            .tileIdx    = blockTable[idx].blockID
-                            });
-                    }
-
-                    const auto resourceHandle = ResourceHandle{ block_itr->TextureID };
-                    const auto tileID         = block_itr->tileID;
-
-                    blockTable[idx].resource = resourceHandle;
-                    blockTable[idx].tileID   = tileID;
-                    blockTable[idx].state    = EBlockState::InUse;
-
-                    allocatedBlocks.push_back({
-                        .tileID     = tileID,
-                        .resource   = resourceHandle ,
-                        .offset     = blockTable[idx].blockID * 64 * KILOBYTE,
-                        .tileIdx    = blockTable[idx].blockID });
-
-                    break;
-                }
-
-                ++itr;
-            }
-
-            if (itr > blockCount)
-            {
-                last = 0;
-                return {}; /// Hrmm, we ran out of free blocks
-            }
-
-            block_itr++;
-        }
-
-        last = (last + itr) % blockTable.size();
-
-        return {
-            std::move(reallocatedBlocks),
-            std::move(allocatedBlocks) };
-    }
-
-
-    /************************************************************************************************/
-
-
-    BlockAllocation TextureStreamingEngine::AllocateTiles(const gpuTileID* begin, const gpuTileID* end)
-    {
-        return textureBlockAllocator.AllocateBlocks(begin, end, allocator);
-    }
-
-
-    /************************************************************************************************/
-
-
-    gpuTileList TextureStreamingEngine::UpdateTileStates(const gpuTileID* begin, const gpuTileID* end, iAllocator* allocator)
+    BlockAllocation TextureStreamingEngine::UpdateTileResidency(const gpuTileID* begin, const gpuTileID* end)
     {
-        return textureBlockAllocator.UpdateTileStates(begin, end, allocator);
+        return textureBlockAllocator.UpdateResidency(begin, end, allocator);
     }
 
 
@@ -4,6 +4,7 @@
 #include "Memoryutilities.h"
 #include "TextureUtilities.h"
 #include "ThreadUtilities.h"
+#include "TextureResidency.h"
 
 
 #define CRND_HEADER_FILE_ONLY
@@ -28,22 +29,44 @@ namespace FlexKit
     };
 
 
+    // The last level decoded, shared by every open CRN asset
+    struct DecodedCRNLevel
+    {
+        GUID_t      asset       = INVALIDHANDLE;
+        uint32_t    mipLevel    = 0;
+        uint32_t    blocksX     = 0;
+        uint32_t    blocksY     = 0;
+        size_t      rowPitch    = 0;
+        char*       buffer      = nullptr;
+        size_t      bufferSize  = 0;
+    };
+
+
+    // Crunch entropy codes a level as one stream, so a level is the smallest unit it can decode. Tiles are
+    // cut out of the decoded level, which stays around for the next tile, and kept in the tile cache.
     class CRNDecompressor final : public iDecompressor
     {
     public:
-        CRNDecompressor(const uint32_t mipLevel, AssetHandle asset, iAllocator* IN_allocator);
+        CRNDecompressor(const GUID_t IN_guid, AssetHandle IN_asset, const crnd::crn_texture_info& IN_info, DecodedTileCache& IN_tileCache, DecodedCRNLevel& IN_level, iAllocator* IN_allocator);
+
+        CRNDecompressor(const CRNDecompressor&)                 = delete;
+        CRNDecompressor& operator = (const CRNDecompressor&)    = delete;
         ~CRNDecompressor();
  
 
         UploadReservation ReadTile(const TileID_t id, const uint2 TileSize, CopyContext& ctx) override;
 
-
-        uint32_t                    blocks_X;
-        uint32_t                    blocks_Y;
-        uint32_t                    blockSize;
-        char*                       buffer;
-        size_t                      rowPitch;
-        size_t                      bufferSize;
+    private:
+        bool DecodeLevel(const uint32_t mipLevel);
+
+        const GUID_t                guid;
+        AssetHandle                 asset;      // Held until the decompressor is closed, the unpack context points into it
+        const char*                 crnData;
+        size_t                      crnSize;
+        crnd::crnd_unpack_context   context;
+        crnd::crn_texture_info      info;
+        DecodedTileCache&           tileCache;
+        DecodedCRNLevel&            level;
         iAllocator*                 allocator;
     };
 
@@ -51,7 +74,7 @@ namespace FlexKit
     /************************************************************************************************/
 
 
-    std::optional<CRNDecompressor*> CreateCRNDecompressor(const uint32_t MIPlevel, AssetHandle asset, iAllocator* allocator);
+    std::optional<CRNDecompressor*> CreateCRNDecompressor(const GUID_t guid, DecodedTileCache& tileCache, DecodedCRNLevel& level, iAllocator* allocator);
 
 
     /************************************************************************************************/
@@ -86,47 +109,76 @@ namespace FlexKit
     /************************************************************************************************/
 
 
+    // Persists across streaming updates, assets stay open and decoded tiles stay cached between them
     struct TextureStreamContext
     {
-        TextureStreamContext(iAllocator* IN_allocator) :
-            allocator{ IN_allocator } {}
+        TextureStreamContext(iAllocator* IN_allocator, const size_t IN_maxOpenAssets = 8, const size_t tileCacheSize = 64) :
+            openAssets      { IN_allocator                                      },
+            tileCache       { tileCacheSize, 64 * KILOBYTE, IN_allocator        },
+            maxOpenAssets   { IN_maxOpenAssets                                  },
+            allocator       { IN_allocator                                      } {}
 
 
         ~TextureStreamContext()
         {
             Close();
+
+            if (level.buffer)
+                allocator->free(level.buffer);
         }
 
 
-        bool Open(const uint32_t MIPlevel, AssetHandle asset)
+        bool Open(const GUID_t asset)
         {
-            auto textureAvailable   = isAssetAvailable(asset);
-            auto assetHandle        = LoadGameAsset(asset);
-            EXITSCOPE(FreeAsset(assetHandle));
+            for (auto& openAsset : openAssets)
+            {
+                if (openAsset.asset == asset)
+                {
+                    openAsset.lastUsed  = ++useCounter;
+                    decompressor        = openAsset.decompressor;
 
-            TextureResourceBlob* resource   = reinterpret_cast<TextureResourceBlob*>(FlexKit::GetAsset(assetHandle));
+                    return true;
+                }
+            }
 
-            if (IsDDS((DeviceFormat)resource->format))
-            {
-                Close();
+            decompressor = nullptr;
 
-                auto res        = CreateCRNDecompressor(MIPlevel, assetHandle, allocator);
-                decompressor    = res.value_or(nullptr);
+            if (!isAssetAvailable(asset))
+                return false;
 
-                return res.has_value();
-            }
-            else
+            auto res = CreateCRNDecompressor(asset, tileCache, level, allocator);
+
+            if (!res)
+                return false;
+
+            if (openAssets.size() >= maxOpenAssets)
             {
-                FK_ASSERT(0);
+                auto lru = std::min_element(
+                    std::begin(openAssets),
+                    std::end(openAssets),
+                    [](auto& lhs, auto& rhs)
+                    {
+                        return lhs.lastUsed < rhs.lastUsed;
+                    });
+
+                allocator->release(*lru->decompressor);
+                openAssets.remove_unstable(lru);
             }
 
-            return false;
+            decompressor = res.value();
+            openAssets.push_back(OpenAsset{ asset, decompressor, ++useCounter });
+
+            return true;
         }
 
+
         void Close()
         {
-            if (decompressor)
-                allocator->release(*decompressor);
+            for (auto& openAsset : openAssets)
+                allocator->release(*openAsset.decompressor);
+
+            openAssets.clear();
+            decompressor = nullptr;
         }
 
 
@@ -142,10 +194,21 @@ namespace FlexKit
         }
 
 
-        DeviceFormat    format;
-        iDecompressor*  decompressor = nullptr;
-        AssetHandle     currentAsset = -1;
-        iAllocator*     allocator;
+        struct OpenAsset
+        {
+            GUID_t          asset;
+            iDecompressor*  decompressor;
+            uint64_t        lastUsed;
+        };
+
+        Vector<OpenAsset>   openAssets;
+        DecodedTileCache    tileCache;
+        DecodedCRNLevel     level;
+
+        iDecompressor*      decompressor    = nullptr;
+        uint64_t            useCounter      = 0;
+        const size_t        maxOpenAssets;
+        iAllocator*         allocator;
     };
 
 
@@ -178,8 +241,10 @@ namespace FlexKit
 
 	struct TextureCacheDesc
 	{
-		const size_t textureCacheSize	= MEGABYTE * 2; // Very small for debugging purposes, forces resource eviction and priority, should be changed to a reasonable value
-		const size_t blockSize			= GetMinBlockSize();
+		const size_t	textureCacheSize	= MEGABYTE * 128;
+		const size_t	blockSize			= GetMinBlockSize();
+		const size_t	uploadBudget		= MEGABYTE * 4;	// per streaming update
+		const uint32_t	hysteresisUpdates	= 8;			// tiles requested within this many updates are kept
 	};
 
 
@@ -217,42 +282,16 @@ namespace FlexKit
         AllocatedBlockList  allocations;
     };
 
+	// Maps the residency manager's slots onto blocks of the tile heap
 	class TextureBlockAllocator
 	{
 	public:
+        TextureBlockAllocator(const TextureCacheDesc& desc, iAllocator* IN_allocator);
 
-        struct Block
-        {
-            TileID_t        tileID;
-            ResourceHandle  resource;
-            uint32_t        state;
-            uint32_t        blockID;
-
-            operator uint64_t() const
-            {
-                return ((uint64_t)resource.to_uint()) << 32 | tileID;
-            }
-        };
+        BlockAllocation UpdateResidency(const gpuTileID* begin, const gpuTileID* end, iAllocator* temp);
 
-        enum EBlockState
-        {
-            Free,
-            InUse,
-            Stale// Free for reallocation
-        };
-
-
-        TextureBlockAllocator(const size_t blockCount, iAllocator* IN_allocator);
-
-        Vector<gpuTileID>   UpdateTileStates    (const gpuTileID* begin, const gpuTileID* end, iAllocator* allocator);
-        BlockAllocation     AllocateBlocks      (const gpuTileID* begin, const gpuTileID* end, iAllocator* allocator);
-
-        const static uint32_t   blockSize   = 1 * GIGABYTE;
-        uint32_t                last        = 0;
-
-        Vector<Block>           blockTable;
-
-		iAllocator*             allocator;
+        TileResidencyManager    residency;
+        const size_t            blockSize;
 	};
 
 
@@ -264,7 +303,7 @@ namespace FlexKit
 	public:
 		TextureStreamingEngine(RenderSystem& IN_renderSystem, iAllocator* IN_allocator, const TextureCacheDesc& desc = {}) : 
 			allocator		        { IN_allocator		},
-            textureBlockAllocator   { desc.textureCacheSize / desc.blockSize,   IN_allocator },
+            textureBlockAllocator   { desc,             IN_allocator },
 			renderSystem	        { IN_renderSystem	},
 			settings		        { desc				},
             feedbackBuffer          { IN_renderSystem.CreateUAVBufferResource(MEGABYTE * 4)                                    },
@@ -272,7 +311,8 @@ namespace FlexKit
             feedbackCounters        { IN_renderSystem.CreateUAVBufferResource(512) },
             feedbackReturnBuffer    { IN_renderSystem.CreateReadBackBuffer(16 * MEGABYTE) },
             heap                    { IN_renderSystem.CreateHeap(GIGABYTE * 1, 0) },
-            mappedAssets            { IN_allocator }
+            mappedAssets            { IN_allocator },
+            streamContext           { IN_allocator }
         {
 
             renderSystem.SetReadBackEvent(
@@ -329,8 +369,11 @@ namespace FlexKit
         };
 
 
-        gpuTileList     UpdateTileStates    (const gpuTileID* begin, const gpuTileID* end, iAllocator* allocator);
-        BlockAllocation AllocateTiles       (const gpuTileID* begin, const gpuTileID* end);
+        // Feedback in, duplicates count towards a tile's priority
+        BlockAllocation UpdateTileResidency (const gpuTileID* begin, const gpuTileID* end);
+
+        // Written by the update task, only stable while no update is in progress
+        const TileResidencyStats& GetResidencyStats() const { return textureBlockAllocator.residency.GetStats(); }
 
         void                        BindAsset           (const AssetHandle textureAsset, const ResourceHandle  resource);
         std::optional<AssetHandle>  GetResourceAsset    (const ResourceHandle  resource) const;
@@ -370,6 +413,7 @@ namespace FlexKit
         ReadBackResourceHandle      feedbackReturnBuffer; // CPU + GPU
 
         Vector<MappedAsset>         mappedAssets;
+        TextureStreamContext        streamContext;      // Only touched by the update task, one runs at a time
 		TextureBlockAllocator		textureBlockAllocator;
         DeviceHeapHandle            heap;
 
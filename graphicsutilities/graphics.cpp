@@ -4854,9 +4854,11 @@ namespace FlexKit
 	/************************************************************************************************/
 
 
+	// UAVs can still be in flight, the resources are released once the GPU is done with them
 	void RenderSystem::ReleaseUAV(UAVResourceHandle handle)
 	{
-		BufferUAVs.ReleaseResource(handle);
+		for (auto resource : BufferUAVs.RemoveResource(handle))
+			Push_DelayedRelease(this, resource);
 	}
 
 
@@ -4865,7 +4867,8 @@ namespace FlexKit
 
 	void RenderSystem::ReleaseUAV(UAVTextureHandle handle)
 	{
-		Texture2DUAVs.ReleaseResource(handle);
+		for (auto resource : Texture2DUAVs.RemoveResource(handle))
+			Push_DelayedRelease(this, resource);
 	}
 
 
@@ -6561,20 +6564,16 @@ namespace FlexKit
 
 	Pair<TriMeshHandle, bool>	FindMesh(GUID_t guid)
 	{
-		size_t location		= 0;
-		size_t HandleIndex	= 0;
+		size_t location = 0;
 		for (auto Entry : GeometryTable.Guids)
 		{
-			if (Entry == guid) {
-				for ( auto index : GeometryTable.Handles.Indexes)
-				{
-					if (index == location) {
-						return { TriMeshHandle(HandleIndex, GeometryTable.Handles.mType, 0x04), true };
-						break;
-					}
-					++HandleIndex;
-				}
-				break;
+			if (Entry == guid)
+			{
+				// Goes back through the handle table for the slot's current generation, released meshes have no live handle
+				auto handle = GeometryTable.Handles.find(location);
+
+				if (handle != InvalidHandle_t)
+					return { handle, true };
 			}
 			++location;
 		}
@@ -6588,27 +6587,20 @@ namespace FlexKit
 
 	Pair<TriMeshHandle, bool>	FindMesh(const char* ID)
 	{
-		TriMeshHandle HandleOut = InvalidHandle_t;
-		size_t location			= 0;
-		size_t HandleIndex		= 0;
-
+		size_t location = 0;
 		for (auto Entry : GeometryTable.GeometryIDs)
 		{
-			if (!strncmp(Entry, ID, 64)) {
-				for (auto index : GeometryTable.Handles.Indexes)
-				{
-					if (index == location) {
-						HandleOut.INDEX = HandleIndex;
-						break;
-					}
-					++HandleIndex;
-				}
-				break;
+			if (Entry && !strncmp(Entry, ID, 64))
+			{
+				auto handle = GeometryTable.Handles.find(location);
+
+				if (handle != InvalidHandle_t)
+					return { handle, true };
 			}
 			++location;
 		}
 
-		return{ HandleOut, 0 };
+		return { InvalidHandle_t, false };
 	}
 
 
@@ -7878,6 +7870,8 @@ namespace FlexKit
 	// assumes File str should be at most 256 bytes
 	ResourceHandle LoadDDSTextureFromFile(char* file, RenderSystem* RS, CopyContextHandle handle, iAllocator* MemoryOut)
 	{
+		FK_ALLOCATION_TAG("Texture Load");
+
 		Texture2D tex = {};
 		wchar_t	wfile[256];
 		size_t	ConvertedSize = 0;
@@ -7896,10 +7890,18 @@ namespace FlexKit
 
 	ResourceHandle UploadDDSFromAsset(AssetHandle asset, RenderSystem* renderSystem, CopyContextHandle uploadHandle, iAllocator* temp)
 	{
+		FK_ALLOCATION_TAG("Texture Load");
+
 		crnd::crn_texture_info info;
 		auto textureAvailable           = isAssetAvailable(asset);
 		auto RHandle                    = LoadGameAsset(asset);
 		TextureResourceBlob* resource   = reinterpret_cast<TextureResourceBlob*>(FlexKit::GetAsset(RHandle));
+
+		if (!resource)
+			return InvalidHandle_t;
+
+		EXITSCOPE(FreeAsset(RHandle));
+
 		auto buffer                     = resource->GetBuffer();
 		const auto bufferSize           = resource->GetBufferSize();
 
@@ -2609,21 +2609,29 @@ private:
 		}
 
 
-		void ReleaseResource(TY_Handle handle)
+		// Drops the entry and hands its resources to the caller
+		static_vector<ID3D12Resource*, 3> RemoveResource(TY_Handle handle)
 		{
-			size_t idx = handles[handle];
+			const size_t	idx			= handles[handle];
+			auto			removed		= resources[idx].resources;
 			handles.RemoveHandle(handle);
 
-			for (auto resource : resources[idx].resources)
-				resource->Release();
-
-			if (resources.size() > 1 && resources.size() < idx)
+			if (idx + 1 < resources.size())
 			{
 				resources[idx] = resources.back();
 				handles[resources.back().resourceHandle] = idx;
 			}
 
 			resources.pop_back();
+
+			return removed;
+		}
+
+
+		void ReleaseResource(TY_Handle handle)
+		{
+			for (auto resource : RemoveResource(handle))
+				resource->Release();
 		}
 
 
@@ -3730,14 +3738,16 @@ private:
 			return offset + pushBufferBegin;
 		}
 
-		size_t Push(char* _ptr, const size_t size)
+		// reserve keeps room for views bound over more than size bytes, the bytes past size are left as they are
+		size_t Push(const char* _ptr, const size_t size, const size_t reserve = 0)
 		{
-			if (pushBufferUsed + CalculateOffset(size) > pushBufferSize)
+			const size_t alignedSize = CalculateOffset(max(size, reserve) + 255); // rounded up, CalculateOffset rounds down
+			if (pushBufferUsed + alignedSize > pushBufferSize)
 				return -1;
 
 			const size_t offset = pushBufferUsed;
 			memcpy(buffer + pushBufferBegin + offset, _ptr, size);
-			pushBufferUsed += CalculateOffset(offset);
+			pushBufferUsed += alignedSize;
 
 			return offset + pushBufferBegin;
 		}
@@ -164,6 +164,16 @@ float3 GetViewVector(float2 UV)
     return normalize(NearPOS - FarPos);
 }
 
+// Same split as LightClusterGrid::GetSlice, exponential in distance from the camera between MinZ and MaxZ
+uint GetLightClusterSlice(float distance, uint sliceCount)
+{
+    if(distance <= MinZ)
+        return 0;
+
+    const float slice = log(distance / MinZ) / log(MaxZ / MinZ) * sliceCount;
+    return min(uint(slice), sliceCount - 1);
+}
+
 float3 GetWorldSpacePosition(float3 ViewVector, float3 Origin, float Z) 
 {
     return Origin + ViewVector * Z;
@@ -2,8 +2,9 @@
 
 cbuffer ShadingConstants : register(b1)
 {
-    int     LightCount;
     uint2   WH;
+    uint2   ClusterXY;
+    uint    SliceCount;
 }
 
 Texture2D<float4> Albedo	: register(t0);
@@ -12,7 +13,7 @@ Texture2D<float4> Normal    : register(t2);
 Texture2D<float2> Tangent   : register(t3);
 Texture2D<float4> Depth	    : register(t4);
 
-StructuredBuffer<uint>	lightBitBuckets	: register(t5);
+StructuredBuffer<uint>	lightClusters	: register(t5); // offset/count pair per cluster, then the light index lists
 ByteAddressBuffer       pointLights     : register(t6);
 
 struct PointLight
@@ -32,7 +33,7 @@ PointLight ReadPointLight(uint idx)
 
 globallycoherent RWTexture2D<float4> output  : register(u0);
 
-groupshared float3 color[100];
+groupshared float3 color[8][100];
 [numthreads(10, 10, 8)]
 void csmain(uint3 threadID : SV_GROUPTHREADID, uint3 groupID : SV_GROUPID)
 {
@@ -41,9 +42,6 @@ void csmain(uint3 threadID : SV_GROUPTHREADID, uint3 groupID : SV_GROUPID)
     const uint   localPixelID   = threadID.x + threadID.y * 10;// + threadID.z * 100;
     const uint2  globalPixelID  = threadID.xy + groupID * 10;
 
-    AllMemoryBarrier();
-
-    const uint   offset         = (localBucketID.x + localBucketID.y * WH.x/10) * 32;
     const float2 NDS_Cord       = float2(-1, 1) + float2(2, -2) * float2(globalPixelID) / float2(WH);
     const float2 UV             = float2(globalPixelID) / float2(WH);
     const float4 albedo         = Albedo.Load(uint3(globalPixelID, 0));
@@ -53,45 +51,40 @@ void csmain(uint3 threadID : SV_GROUPTHREADID, uint3 groupID : SV_GROUPID)
     const float3 N              = normalize(normal.xyz);
     const float3 V              = GetViewVector(UV);
     const float3 worldPosition  = V * depth * MaxZ + CameraPOS;
-    
+
+    // Depth holds the distance to the camera, the same distance the clusters are sliced by
+    const uint   slice          = GetLightClusterSlice(depth * MaxZ, SliceCount);
+    const uint   clusterID      = localBucketID.x + localBucketID.y * ClusterXY.x + slice * ClusterXY.x * ClusterXY.y;
+    const uint   indexBase      = ClusterXY.x * ClusterXY.y * SliceCount * 2;
+    const uint   lightOffset    = lightClusters[clusterID * 2 + 0];
+    const uint   lightCount     = lightClusters[clusterID * 2 + 1];
+
+    // Each z thread takes every 8th light of the cluster
     float3 localColor = float3(0, 0, 0);
-    for(uint I = 0; I < LightCount / 32; I += 1) // 32 bits
+    for(uint I = threadID.z; I < lightCount; I += 8)
     {
-        const uint lightBitBucket = I;
-
-        for(uint II = 0; II < 4; II++) // increments 1 byte at a time
-        {
-            const uint threadZ          = threadID.z;
-            const uint bitMask          = 1 << (threadZ + II * 8);
-            const uint lightID          = (I * 32 + II * 8) + threadZ;
-            if(lightBitBuckets[offset + lightBitBucket] & bitMask)
-            {
-                PointLight light = ReadPointLight(lightID);
-                const float3 L   = normalize(light.PositionR.xyz - worldPosition);
-                const float  Ld  = length(light.PositionR.xyz - worldPosition);
-                const float  Lr  = light.PositionR.w;
-                const float3 Lk  = light.KI.xyz;
-                const float  Li  = light.KI.w;
-                const float  La  = Li / pow(Ld, 2);
-                localColor += Lk * dot(N, L) * La * saturate(1 - (pow(Ld, 10) / pow(Lr, 10)));
-            }
-        }
+        PointLight light = ReadPointLight(lightClusters[indexBase + lightOffset + I]);
+        const float3 L   = normalize(light.PositionR.xyz - worldPosition);
+        const float  Ld  = length(light.PositionR.xyz - worldPosition);
+        const float  Lr  = light.PositionR.w;
+        const float3 Lk  = light.KI.xyz;
+        const float  Li  = light.KI.w;
+        const float  La  = Li / pow(Ld, 2);
+        localColor += Lk * dot(N, L) * La * saturate(1 - (pow(Ld, 10) / pow(Lr, 10)));
     }
 
+    color[threadID.z][localPixelID] = localColor;
+
+    GroupMemoryBarrierWithGroupSync();
+
     if(threadID.z == 0)
-        color[localPixelID] = localColor;
+    {
+        float3 sum = float3(0, 0, 0);
 
-    GroupMemoryBarrier();
+        [unroll(8)]
+        for(uint I = 0; I < 8; I++)
+            sum += color[I][localPixelID];
 
-    if(threadID.z == 8)
-    {   
-        float3 temp = color[localPixelID];
-        GroupMemoryBarrier();
-        color[localPixelID] = temp + localColor;
-        GroupMemoryBarrier();
+        output[globalPixelID] = float4(sum, 1);
     }
-
-    GroupMemoryBarrier();
-    if(threadID.z == 0)
-        output[globalPixelID] = float4(color[localPixelID], 1);
 }
@@ -22,7 +22,8 @@ cbuffer ShadingConstants : register(b2)
 {
     float lightCount;
     float globalTime;
-    uint2 WH;
+    uint2 WH;           // light cluster tiles
+    uint  SliceCount;
 }
 
 cbuffer Poses : register(b3)
@@ -31,7 +32,7 @@ cbuffer Poses : register(b3)
 }
 
 Texture2D<float4>		        albedoTexture   : register(t0);
-StructuredBuffer<uint>		    lightLists	    : register(t1);
+StructuredBuffer<uint>		    lightClusters   : register(t1); // offset/count pair per cluster, then the light index lists
 ByteAddressBuffer               pointLights     : register(t2);
 TextureCube<float4>             HDRMap          : register(t3);
 Texture2D<float4>		        MRIATexture     : register(t4);
@@ -39,13 +40,17 @@ Texture2D<float4>		        MRIATexture     : register(t4);
 sampler BiLinear : register(s0); // Nearest point
 sampler NearestPoint : register(s1); // Nearest point
 
-bool isLightContributing(uint idx, uint2 xy)
+uint2 GetLightCluster(uint2 xy, float distance)
 {
-    const uint offset       = (xy.x + xy.y * WH[0]) * (1024 / 32);
-    const uint wordOffset   = idx / 32;
-    const uint bitMask      = 0x1 << (idx % 32);
+    const uint slice    = GetLightClusterSlice(distance, SliceCount);
+    const uint cluster  = xy.x + xy.y * WH[0] + slice * WH[0] * WH[1];
 
-    return lightLists[wordOffset + offset] & bitMask;
+    return uint2(lightClusters[cluster * 2 + 0], lightClusters[cluster * 2 + 1]);
+}
+
+uint GetClusterLight(uint2 cluster, uint idx)
+{
+    return lightClusters[WH[0] * WH[1] * SliceCount * 2 + cluster.x + idx];
 }
 
 PointLight ReadPointLight(uint idx)
@@ -91,6 +96,21 @@ Forward_VS_OUT Forward_VS(Vertex In)
     return Out;
 }
 
+// Instanced draws bind their packed per instance transforms to the pose slot, WT is unused
+Forward_VS_OUT ForwardInstanced_VS(Vertex In, uint instanceID : SV_InstanceID)
+{
+    const float4x4 IWT = Poses[instanceID];
+
+    Forward_VS_OUT Out;
+    Out.WPOS	= mul(IWT, float4(In.POS, 1));
+    Out.POS		= mul(PV, mul(IWT, float4(In.POS, 1)));
+    Out.Normal  = normalize(mul(IWT, float4(In.Normal, 0.0f)));
+    Out.Tangent = normalize(mul(IWT, float4(In.Tangent, 0.0f)));
+    Out.UV		= In.UV;
+
+    return Out;
+}
+
 
 struct VertexSkinned
 {
@@ -227,15 +247,13 @@ float4 Forward_PS(Forward_PS_IN IN) : SV_TARGET
     float3 worldV   	        = normalize(CameraPOS - positionW);
 
     const uint2	lightBin	    = IN.POS / 10.0f;// - uint2( 1, 1 );
+    const uint2 cluster         = GetLightCluster(lightBin, length(positionW - CameraPOS.xyz));
     uint        localLightCount = 0;
 
     float3 Color = float3(0, 0, 0);
-    for (int i = 0; i < lightCount; i++)
+    for (uint i = 0; i < cluster.y; i++)
     {
-        if(!isLightContributing(i, lightBin))
-            continue;
-
-        PointLight light	= ReadPointLight(i);
+        PointLight light	= ReadPointLight(GetClusterLight(cluster, i));
         localLightCount++;
 
         const float3 Lc			= light.KI.rgb;